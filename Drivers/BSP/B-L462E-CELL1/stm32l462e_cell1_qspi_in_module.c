@@ -210,6 +210,28 @@ int32_t BSP_QSPI_EraseBlock(uint32_t BlockAddress, BSP_QSPI_Erase_t BlockSize)
   return ret;
 }
 
+/**
+  * @brief  Starts erasing the specified 64K block of the QSPI memory.
+  * @param  BlockAddress Block address to erase
+  * @retval BSP status
+  * @note This function is non blocking meaning that block erase
+  *       operation is started but not completed when the function
+  *       returns. Application has to call BSP_QSPI_GetStatus()
+  *       to know when the device is available again (i.e. erase operation
+  *       completed).
+  */
+int32_t BSP_QSPI_StartEraseBlock64K(uint32_t BlockAddress)
+{
+  int32_t ret = BSP_ERROR_COMPONENT_FAILURE;
+
+  if (W25Q80EW_Start_Erase_Block64K(&hqspi, BlockAddress) == W25Q80EW_QSPI_OK)
+  {
+    ret = BSP_ERROR_NONE;
+  }
+
+  return ret;
+}
+
 /**
   * @brief  Erases the entire QSPI memory.
   * @retval QSPI memory status
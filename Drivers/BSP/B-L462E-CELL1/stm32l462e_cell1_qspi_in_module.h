@@ -43,6 +43,17 @@ extern "C" {
   * @{
   */
 
+/** @defgroup STM32L462E_CELL1_QSPI_INMODULE_Exported_Functions
+  *           STM32L462E_CELL1 QSPI_INMODULE Exported Functions
+  * @{
+  */
+
+int32_t BSP_QSPI_StartEraseBlock64K(uint32_t BlockAddress);
+
+/**
+  * @}
+  */
+
 /**
   * @}
   */
@@ -234,6 +234,32 @@ uint8_t W25Q80EW_Write(QSPI_HandleTypeDef *hqspi, uint8_t *pData, uint32_t Write
   * @retval QSPI memory status
   */
 uint8_t W25Q80EW_Erase_Block64K(QSPI_HandleTypeDef *hqspi, uint32_t BlockAddress)
+{
+  uint8_t ret = W25Q80EW_Start_Erase_Block64K(hqspi, BlockAddress);
+
+  if (ret == W25Q80EW_QSPI_OK)
+  {
+    /* Configure automatic polling mode to wait for end of erase */
+    if (W25Q80EW_AutoPollingMemReady(hqspi, W25Q80EW_SUBBLOCK_ERASE_MAX_TIME) != W25Q80EW_QSPI_OK)
+    {
+      ret = W25Q80EW_QSPI_ERROR;
+    }
+  }
+
+  return (ret);
+}
+
+/**
+  * @brief  Starts erasing the specified block of the QSPI memory.
+  * @param  BlockAddress: Block address to erase
+  * @retval QSPI memory status
+  * @note This function is non blocking meaning that block erase
+  *       operation is started but not completed when the function
+  *       returns. Application has to call W25Q80EW_GetStatus()
+  *       to know when the device is available again (i.e. erase operation
+  *       completed).
+  */
+uint8_t W25Q80EW_Start_Erase_Block64K(QSPI_HandleTypeDef *hqspi, uint32_t BlockAddress)
 {
   uint8_t ret = W25Q80EW_QSPI_OK;
   QSPI_CommandTypeDef sCommand;
@@ -263,14 +289,6 @@ uint8_t W25Q80EW_Erase_Block64K(QSPI_HandleTypeDef *hqspi, uint32_t BlockAddress
     {
       ret = W25Q80EW_QSPI_ERROR;
     }
-    else
-    {
-      /* Configure automatic polling mode to wait for end of erase */
-      if (W25Q80EW_AutoPollingMemReady(hqspi, W25Q80EW_SUBBLOCK_ERASE_MAX_TIME) != W25Q80EW_QSPI_OK)
-      {
-        ret = W25Q80EW_QSPI_ERROR;
-      }
-    }
   }
 
   return (ret);
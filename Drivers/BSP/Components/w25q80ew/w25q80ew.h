@@ -197,6 +197,7 @@ typedef struct
 uint8_t W25Q80EW_Read(QSPI_HandleTypeDef *hqspi, uint8_t *pData, uint32_t ReadAddr, uint32_t Size);
 uint8_t W25Q80EW_Write(QSPI_HandleTypeDef *hqspi, uint8_t *pData, uint32_t WriteAddr, uint32_t Size);
 uint8_t W25Q80EW_Erase_Block64K(QSPI_HandleTypeDef *hqspi, uint32_t BlockAddress);
+uint8_t W25Q80EW_Start_Erase_Block64K(QSPI_HandleTypeDef *hqspi, uint32_t BlockAddress);
 uint8_t W25Q80EW_Erase_Block32K(QSPI_HandleTypeDef *hqspi, uint32_t BlockAddress);
 uint8_t W25Q80EW_Erase_Sector(QSPI_HandleTypeDef *hqspi, uint32_t Sector);
 uint8_t W25Q80EW_Erase_Chip(QSPI_HandleTypeDef *hqspi);
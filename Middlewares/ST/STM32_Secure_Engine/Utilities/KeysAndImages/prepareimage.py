@@ -22,7 +22,7 @@ import numpy
 import elftools
 #import string
 from elftools.elf.elffile import ELFFile
-from struct import pack
+from struct import pack, unpack
 
 def gen_ecdsa_p256(args):
     keys.ECDSA256P1.generate().export_private(args.key)
@@ -191,6 +191,24 @@ def do_header_lib(args):
     magic = args.magic.encode()
     version = args.version
     reserved = b'\0'*args.reserved
+    if 'cfw' in args and args.cfw:
+        # CompressedFwSize is the first field of the reserved area
+        if args.reserved < 4:
+            print("no room for compressed fw size in reserved area")
+            exit(1)
+        reserved = pack('<I', os.path.getsize(args.cfw)) + b'\0'*(args.reserved - 4)
+        if args.pfw:
+            print("compressed fw cannot be a partial fw")
+            exit(1)
+    if 'dfw' in args and args.dfw:
+        # DeltaFwSize follows CompressedFwSize in the reserved area
+        if args.reserved < 8:
+            print("no room for delta fw size in reserved area")
+            exit(1)
+        if args.pfw or args.cfw:
+            print("delta fw cannot be a partial or compressed fw")
+            exit(1)
+        reserved = b'\0'*4 + pack('<I', os.path.getsize(args.dfw)) + b'\0'*(args.reserved - 8)
     if args.nonce and args.iv:
         print("either IV or Nonce Required !!!")
         exit(1)
@@ -204,6 +222,9 @@ def do_header_lib(args):
             nonce = f.read()
     if args.pfw:
         pfwsize = os.path.getsize(args.pfw)
+    elif 'dfw' in args and args.dfw:
+        # the partial fw fields describe the delta patch
+        pfwsize = os.path.getsize(args.dfw)
     else:
         pfwsize = size
     if args.poffset:
@@ -215,6 +236,10 @@ def do_header_lib(args):
         f=open(args.ptag, 'rb')
         pfwtag = f.read()
         f.close()
+    elif 'dtag' in args and args.dtag:
+        f=open(args.dtag, 'rb')
+        pfwtag = f.read()
+        f.close()
     else:
         pfwtag=tag
     print("Magic: "+str(magic)+"!!")
@@ -332,6 +357,12 @@ def do_pack(args):
     if args.pfw:
         #recopy encrypted partial file
         binary=open(args.pfw,'rb')
+    elif args.cfw:
+        #recopy encrypted compressed file
+        binary=open(args.cfw,'rb')
+    elif args.dfw:
+        #recopy encrypted delta patch
+        binary=open(args.dfw,'rb')
     else:
         #recopy encrypted complete file
         binary=open(args.firmware,'rb')
@@ -685,6 +716,326 @@ def do_diff(args):
     with open(args.poffset, 'w') as f:
         f.write(str(first_diff*args.align))
 
+# LZSS stream inflated by sfu_decompress.c : parameters MUST match SFU_DECOMPRESS_WINDOW_BITS / COUNT_BITS
+LZSS_WINDOW_BITS = 11
+LZSS_COUNT_BITS = 5
+LZSS_MIN_MATCH = 2
+LZSS_MAX_CHAIN = 256
+
+def lzss_compress(data):
+    window = 1 << LZSS_WINDOW_BITS
+    max_match = 1 << LZSS_COUNT_BITS
+    out = bytearray([(LZSS_WINDOW_BITS << 4) | LZSS_COUNT_BITS])
+    bits = 0
+    nbits = 0
+    def put(value, count):
+        nonlocal bits, nbits
+        bits = (bits << count) | value
+        nbits += count
+        while nbits >= 8:
+            nbits -= 8
+            out.append((bits >> nbits) & 0xff)
+        bits &= (1 << nbits) - 1
+    # hash chains on LZSS_MIN_MATCH bytes prefixes
+    chains = {}
+    def insert(pos):
+        if pos + LZSS_MIN_MATCH <= len(data):
+            chains.setdefault(data[pos:pos + LZSS_MIN_MATCH], []).append(pos)
+    pos = 0
+    while pos < len(data):
+        best_len = 0
+        best_dist = 0
+        candidates = chains.get(data[pos:pos + LZSS_MIN_MATCH], [])
+        limit = min(max_match, len(data) - pos)
+        for cand in reversed(candidates[-LZSS_MAX_CHAIN:]):
+            dist = pos - cand
+            if dist > window:
+                break
+            length = 0
+            # overlapping copies are allowed, as in the decoder
+            while length < limit and data[cand + length] == data[pos + length]:
+                length += 1
+            if length > best_len:
+                best_len = length
+                best_dist = dist
+                if length == limit:
+                    break
+        if best_len >= LZSS_MIN_MATCH:
+            put(0, 1)
+            put(best_dist - 1, LZSS_WINDOW_BITS)
+            put(best_len - 1, LZSS_COUNT_BITS)
+        else:
+            best_len = 1
+            put(1, 1)
+            put(data[pos], 8)
+        for i in range(pos, pos + best_len):
+            insert(i)
+        pos += best_len
+    if nbits:
+        put(0, 8 - nbits)
+    return bytes(out)
+
+def lzss_decompress(data, size):
+    window_mask = (1 << LZSS_WINDOW_BITS) - 1
+    if data[0] != (LZSS_WINDOW_BITS << 4) | LZSS_COUNT_BITS:
+        raise ValueError("unsupported compressed stream")
+    state = {'pos': 8}
+    def get(count):
+        value = 0
+        for i in range(count):
+            pos = state['pos']
+            value = (value << 1) | ((data[pos >> 3] >> (7 - (pos & 7))) & 1)
+            state['pos'] = pos + 1
+        return value
+    out = bytearray()
+    while len(out) < size:
+        if get(1):
+            out.append(get(8))
+        else:
+            dist = get(LZSS_WINDOW_BITS) + 1
+            count = get(LZSS_COUNT_BITS) + 1
+            for i in range(count):
+                # the window of the decoder is initialized with 0x00
+                out.append(out[len(out) - dist] if dist <= len(out) else 0)
+    return bytes(out[:size])
+
+def do_compress(args):
+    with open(args.infile, 'rb') as f:
+        payload = f.read()
+    compressed = lzss_compress(payload)
+    if lzss_decompress(compressed, len(payload)) != payload:
+        print("compressed stream does not inflate to the input file")
+        exit(1)
+    # padded to the encryption block size
+    if len(compressed) % args.align:
+        compressed += b'\0'*(args.align - len(compressed) % args.align)
+    with open(args.outfile, 'wb') as f:
+        f.write(compressed)
+    size = len(payload)
+    csize = len(compressed)
+    print("Input: "+str(size)+" bytes, compressed: "+str(csize)+" bytes, saved: "+str(size - csize)+" bytes ("
+          +"{:.1f}".format(100.0*(size - csize)/size if size else 0.0)+"%)")
+    if csize >= size:
+        print("warning: compressed image is not smaller than the input file")
+    # Installation without swap area: the stored fw is read and decrypted twice (signature check then
+    # installation) in chunks of args.chunk bytes, the clear fw is written once in the active slot
+    chunks = lambda n: (n + args.chunk - 1) // args.chunk
+    print("Install simulation (chunk "+str(args.chunk)+" bytes):")
+    print("  plain      : dwl slot reads "+str(2*chunks(size))+" chunks ("+str(2*size)+" bytes), active slot writes "
+          +str(chunks(size))+" chunks ("+str(size)+" bytes)")
+    print("  compressed : dwl slot reads "+str(2*chunks(csize))+" chunks ("+str(2*csize)+" bytes), active slot writes "
+          +str(chunks(size))+" chunks ("+str(size)+" bytes), inflated "+str(2*size)+" bytes")
+    if args.read_rate and args.write_rate:
+        # rates in bytes per millisecond (i.e. KB/s)
+        plain_ms = 2.0*size/args.read_rate + 1.0*size/args.write_rate
+        compressed_ms = 2.0*csize/args.read_rate + 1.0*size/args.write_rate
+        if args.inflate_rate:
+            compressed_ms += 2.0*size/args.inflate_rate
+        print("  estimated install time: plain "+"{:.0f}".format(plain_ms)+" ms, compressed "
+              +"{:.0f}".format(compressed_ms)+" ms")
+
+# Delta patch applied by sfu_delta.c : format MUST match SFU_DELTA_MAGIC / SFU_DELTA_HeaderTypeDef
+DELTA_MAGIC = 0x44554653
+DELTA_COPY_FLAG = 0x8000
+DELTA_KEY_LEN = 8
+DELTA_MIN_COPY = 12
+DELTA_MAX_CANDIDATES = 32
+
+def delta_page_ops(old, new, base, start, end, src_end, index, page_size, forbidden):
+    ops = []
+    literal = bytearray()
+    pos = base + start
+    hint = None
+    while pos < base + end:
+        best_len = 0
+        best_src = 0
+        candidates = [] if hint is None else [hint]
+        candidates += index.get(bytes(new[pos:pos + DELTA_KEY_LEN]), [])[-DELTA_MAX_CANDIDATES:]
+        for src in candidates:
+            if src < 0 or src >= src_end or (src // page_size) in forbidden:
+                continue
+            # a copy stays in the page being built and does not read a forbidden page
+            limit = min(base + end - pos, src_end - src)
+            length = 0
+            while length < limit and old[src + length] == new[pos + length]:
+                length += 1
+                if (src + length) % page_size == 0 and ((src + length) // page_size) in forbidden:
+                    break
+            if length > best_len:
+                best_len = length
+                best_src = src
+        if best_len >= DELTA_MIN_COPY:
+            if literal:
+                ops.append(('literal', bytes(literal)))
+                literal = bytearray()
+            ops.append(('copy', best_src, best_len))
+            pos += best_len
+            hint = best_src + best_len
+        else:
+            literal.append(new[pos])
+            pos += 1
+            hint = None if hint is None else hint + 1
+    if literal:
+        ops.append(('literal', bytes(literal)))
+    return ops
+
+def delta_source_pages(ops, page, page_size):
+    pages = set()
+    for op in ops:
+        if op[0] == 'copy':
+            pages.update(range(op[1] // page_size, (op[1] + op[2] - 1) // page_size + 1))
+    pages.discard(page)
+    return pages
+
+def delta_generate(ref, new, page_size, offset, slot_size):
+    nb_pages = slot_size // page_size
+    old_slot = bytearray(b'\xff'*slot_size)
+    old_slot[offset:offset + len(ref)] = ref
+    new_slot = bytearray(b'\xff'*slot_size)
+    new_slot[offset:offset + len(new)] = new
+    src_end = offset + len(ref)
+    index = {}
+    for pos in range(offset, src_end - DELTA_KEY_LEN + 1):
+        index.setdefault(bytes(old_slot[pos:pos + DELTA_KEY_LEN]), []).append(pos)
+    # pages to rewrite : the one of the header (erased to write the new header) and the modified ones
+    bounds = {}
+    for page in range(nb_pages):
+        base = page*page_size
+        start = offset if page == 0 else 0
+        if page != 0 and old_slot[base:base + page_size] == new_slot[base:base + page_size]:
+            continue
+        end = page_size
+        while end > start and new_slot[base + end - 1] == 0xff:
+            end -= 1
+        bounds[page] = (start, end)
+    ops = {}
+    for page, (start, end) in bounds.items():
+        ops[page] = delta_page_ops(old_slot, new_slot, page*page_size, start, end, src_end, index, page_size, set())
+    # a page is rewritten once no other remaining page reads it, cycles are broken with literals
+    remaining = set(bounds)
+    order = []
+    while remaining:
+        readers = dict((page, 0) for page in remaining)
+        for page in remaining:
+            for op in ops[page]:
+                if op[0] == 'copy':
+                    for src in delta_source_pages([op], page, page_size):
+                        if src in readers:
+                            readers[src] += op[2]
+        page = min(remaining, key=lambda p: (readers[p], p))
+        order.append(page)
+        remaining.discard(page)
+        if readers[page]:
+            forbidden = set(order)
+            for other in remaining:
+                if delta_source_pages(ops[other], other, page_size) & forbidden:
+                    start, end = bounds[other]
+                    ops[other] = delta_page_ops(old_slot, new_slot, other*page_size, start, end, src_end, index,
+                                                page_size, forbidden)
+    patch = pack('<IIIII32s12s', DELTA_MAGIC, page_size, len(ref), len(new), len(order),
+                 hashlib.sha256(ref).digest(), b'\0'*12)
+    for page in order:
+        patch += pack('<HHH', page, bounds[page][0], len(ops[page]))
+        for op in ops[page]:
+            if op[0] == 'copy':
+                patch += pack('<HI', op[2] | DELTA_COPY_FLAG, op[1])
+            else:
+                patch += pack('<H', len(op[1])) + op[1]
+    return patch
+
+def delta_apply(slot, patch, stats):
+    magic, page_size, src_size, fw_size, nb_records, src_tag = unpack('<IIIII32s', patch[:52])
+    if magic != DELTA_MAGIC:
+        raise ValueError("not a delta patch")
+    pos = 64
+    written = set()
+    for i in range(nb_records):
+        page, start, nb_ops = unpack('<HHH', patch[pos:pos + 6])
+        pos += 6
+        if page in written or page >= len(slot) // page_size:
+            raise ValueError("invalid page record")
+        buf = bytearray(b'\xff'*page_size)
+        cur = start
+        for j in range(nb_ops):
+            length, = unpack('<H', patch[pos:pos + 2])
+            pos += 2
+            if length & DELTA_COPY_FLAG:
+                length &= ~DELTA_COPY_FLAG
+                src, = unpack('<I', patch[pos:pos + 4])
+                pos += 4
+                if set(range(src // page_size, (src + length - 1) // page_size + 1)) & written:
+                    raise ValueError("copy from a page already rewritten")
+                buf[cur:cur + length] = slot[src:src + length]
+                stats['copied'] += length
+            else:
+                buf[cur:cur + length] = patch[pos:pos + length]
+                pos += length
+                stats['literal'] += length
+            cur += length
+        base = page*page_size
+        slot[base:base + page_size] = b'\xff'*page_size
+        slot[base + start:base + cur] = buf[start:cur]
+        stats['erased'] += 1
+        stats['programmed'] += cur - start
+        written.add(page)
+    return slot
+
+def do_delta(args):
+    with open(args.reference, 'rb') as f:
+        ref = f.read()
+    with open(args.infile, 'rb') as f:
+        new = f.read()
+    slot_size = args.slot_size
+    # the last page of the slot is the backup page of the installation
+    if not slot_size:
+        slot_size = args.offset + max(len(ref), len(new))
+        slot_size += (args.page - slot_size % args.page) % args.page + args.page
+    if slot_size % args.page or args.offset + max(len(ref), len(new)) > slot_size - args.page:
+        print("invalid slot size")
+        exit(1)
+    patch = delta_generate(ref, new, args.page, args.offset, slot_size)
+    # check the patch by applying it on a slot image, as sfu_delta.c does
+    slot = bytearray(b'\xff'*slot_size)
+    slot[args.offset:args.offset + len(ref)] = ref
+    stats = {'copied': 0, 'literal': 0, 'erased': 0, 'programmed': 0}
+    slot = delta_apply(slot, patch, stats)
+    expected = bytearray(b'\xff'*slot_size)
+    expected[args.offset:args.offset + len(new)] = new
+    if slot[args.offset:] != expected[args.offset:] or slot[:args.offset] != b'\xff'*args.offset:
+        print("patch does not rebuild the input file")
+        exit(1)
+    # padded to the encryption block size
+    if len(patch) % args.align:
+        patch += b'\0'*(args.align - len(patch) % args.align)
+    with open(args.outfile, 'wb') as f:
+        f.write(patch)
+    size = len(new)
+    psize = len(patch)
+    print("Input: "+str(size)+" bytes, patch: "+str(psize)+" bytes, saved: "+str(size - psize)+" bytes ("
+          +"{:.1f}".format(100.0*(size - psize)/size if size else 0.0)+"%)")
+    print("Patch: "+str(stats['copied'])+" bytes copied from the installed fw, "+str(stats['literal'])
+          +" bytes of literals")
+    if psize >= size:
+        print("warning: patch is not smaller than the input file")
+    # Installation without swap area: the stored data is read and decrypted twice (signature check then
+    # installation); a full image erases the whole active slot, a patch only erases the pages it rewrites
+    # after having read the installed fw once to authenticate it
+    nb_pages = slot_size // args.page
+    print("Install simulation (page "+str(args.page)+" bytes, slot "+str(nb_pages)+" pages):")
+    print("  full  : dwl slot reads "+str(2*size)+" bytes, active slot erases "+str(nb_pages)+" pages, programs "
+          +str(size)+" bytes")
+    print("  delta : dwl slot reads "+str(2*psize)+" bytes, active slot reads "+str(len(ref) + stats['copied'])
+          +" bytes, erases "+str(stats['erased'])+" pages, programs "+str(stats['programmed'])+" bytes")
+    if args.read_rate and args.write_rate and args.erase_time is not None:
+        # rates in bytes per millisecond (i.e. KB/s)
+        full_ms = 2.0*size/args.read_rate + nb_pages*args.erase_time + 1.0*size/args.write_rate
+        delta_ms = (2.0*psize/args.read_rate + stats['erased']*args.erase_time
+                    + 1.0*stats['programmed']/args.write_rate)
+        if args.flash_read_rate:
+            delta_ms += 1.0*(len(ref) + stats['copied'])/args.flash_read_rate
+        print("  estimated install time: full "+"{:.0f}".format(full_ms)+" ms, delta "
+              +"{:.0f}".format(delta_ms)+" ms")
+
 def do_inject(args):
     if args.key:
       key = keys.load(args.key)
@@ -810,6 +1161,11 @@ subcmds = {
         'pack':do_pack,
         #
         'diff':do_diff,
+        #compress a binary file in the stream format inflated by SBSFU
+        #input file , output file
+        #-a padding of the output (encryption block size)
+        'compress':do_compress,
+        'delta':do_delta,
         #merge appli.elf , header binary and sbsfu elf in a big binary
         #input file appli.elf
         #-h header file
@@ -891,6 +1247,9 @@ def args():
     head.add_argument('--pfw', help ='partial firmware', metavar='filename', required = ('--poffset' in sys.argv) or ('--ptag' in sys.argv))
     head.add_argument('--poffset', help ='file that contains offset at which the partial firmware should be applied', type=str, metavar='filename', required = ('--pfw' in sys.argv) or ('--ptag' in sys.argv))
     head.add_argument('--ptag', metavar='filename', required = ('--pfw' in sys.argv) or ('--poffset' in sys.argv))
+    head.add_argument('--cfw', help ='compressed firmware', metavar='filename', required = False)
+    head.add_argument('--dfw', help ='delta patch', metavar='filename', required = ('--dtag' in sys.argv))
+    head.add_argument('--dtag', help ='tag of the clear delta patch', metavar='filename', required = ('--dfw' in sys.argv))
     head.add_argument("outfile")
     pack = subs.add_parser('pack', help='build header file and compute mac according to key provided')
     pack.add_argument('-k', '--key', metavar='filename', required = True)
@@ -909,6 +1268,9 @@ def args():
     pack.add_argument('--pfw', help ='partial firmware', metavar='filename', required = ('--poffset' in sys.argv) or ('--ptag' in sys.argv))
     pack.add_argument('--poffset', help ='file that contains offset at which the partial firmware should be applied', type=str, metavar='filename', required = ('--pfw' in sys.argv) or ('--ptag' in sys.argv))
     pack.add_argument('--ptag', metavar='filename', required = ('--pfw' in sys.argv) or ('--poffset' in sys.argv))
+    pack.add_argument('--cfw', help ='compressed firmware (-f gives the clear firmware size)', metavar='filename', required = False)
+    pack.add_argument('--dfw', help ='delta patch (-f and -t give the rebuilt firmware size and tag)', metavar='filename', required = ('--dtag' in sys.argv))
+    pack.add_argument('--dtag', help ='tag of the clear delta patch', metavar='filename', required = ('--dfw' in sys.argv))
     pack.add_argument("outfile")
     
     diff = subs.add_parser('diff', help='compute differences between 2 binary files ')
@@ -920,6 +1282,28 @@ def args():
     diff.add_argument('-a', '--align', type=int, metavar='align', default=2, required=False, help="difference binary file alignment in bytes (default: 2)")
     diff.add_argument("outfile")
     
+    comp = subs.add_parser('compress', help='compress a binary file to be inflated by SBSFU during installation')
+    comp.add_argument('-a', '--align', type=int, default=16, help='pad to be a multiple of the given size (default: 16)')
+    comp.add_argument('-c', '--chunk', type=int, default=512, help='SBSFU install chunk size for the simulation (default: 512)')
+    comp.add_argument('--read-rate', type=float, required=False, help='dwl slot read + decrypt rate in KB/s for the simulation')
+    comp.add_argument('--write-rate', type=float, required=False, help='active slot program rate in KB/s for the simulation')
+    comp.add_argument('--inflate-rate', type=float, required=False, help='decompression rate in KB/s for the simulation')
+    comp.add_argument("infile")
+    comp.add_argument("outfile")
+
+    delta = subs.add_parser('delta', help='generate a patch rebuilding a binary file from a reference one, to be applied by SBSFU during installation')
+    delta.add_argument('-r', '--reference', metavar='filename', required=True, help='binary file installed in the active slot')
+    delta.add_argument('-p', '--page', type=int, default=2048, help='active slot page size (default: 2048)')
+    delta.add_argument('-o', '--offset', type=int, default=512, help='offset between start of header and binary (default: 512)')
+    delta.add_argument('-s', '--slot-size', type=auto_int, default=0, help='active slot size (default: pages needed by the largest binary, plus the backup page)')
+    delta.add_argument('-a', '--align', type=int, default=16, help='pad to be a multiple of the given size (default: 16)')
+    delta.add_argument('--read-rate', type=float, required=False, help='dwl slot read + decrypt rate in KB/s for the simulation')
+    delta.add_argument('--write-rate', type=float, required=False, help='active slot program rate in KB/s for the simulation')
+    delta.add_argument('--erase-time', type=float, required=False, help='active slot page erase time in ms for the simulation')
+    delta.add_argument('--flash-read-rate', type=float, required=False, help='active slot read + hash rate in KB/s for the simulation')
+    delta.add_argument("infile")
+    delta.add_argument("outfile")
+
     mrg = subs.add_parser('merge', help='merge elf appli , install header and sbsfu.elf in a contiguous binary')
     mrg.add_argument('-i', '--install', metavar='filename',  help="filename of installed binary header", required = True)
     mrg.add_argument('-s', '--sbsfu', metavar='filename', help="filename of sbsfu elf", required = True)
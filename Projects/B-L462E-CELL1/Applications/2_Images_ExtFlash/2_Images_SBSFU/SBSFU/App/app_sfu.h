@@ -120,6 +120,18 @@ extern "C" {
    must remain encrypted after installation */
 #define SFU_NO_SWAP                                /*!< FW upgrade installation process without swap area */
 
+/* Compressed images : the FW stored in dwl slot can be a compressed stream (see "compress" command of
+   prepareimage.py) which is inflated chunk by chunk while being installed in the active slot.
+   Comment this define to save the code size and the RAM (about 2.5 Kbytes) of the decompressor. */
+#define SFU_IMG_COMPRESSION                        /*!< Compressed FW images can be installed */
+
+/* Delta images : the dwl slot can contain a patch against the FW of the active slot (see "delta" command of
+   prepareimage.py). The patch is applied in place, page by page, in the active slot. The progress is saved before
+   the trailer of the dwl slot, so an interrupted installation is resumed at next reboot : the last page of the active
+   slot is used as backup page and cannot hold FW.
+   Comment this define to save the code size and the RAM (about 2 Kbytes, one flash page) of the patch applier. */
+#define SFU_IMG_DELTA                              /*!< Delta FW images can be installed */
+
 /* Multi-images configuration :
    - Max : 3 Active images and 3 Download area
    - Not necessary same configuration between SFU_NB_MAX_ACTIVE_IMAGE and SFU_NB_MAX_DWL_AREA
@@ -226,6 +238,18 @@ extern "C" {
 #if defined(SFU_NO_SWAP) && defined(ENABLE_IMAGE_STATE_HANDLING)
 #warning "ENABLE_IMAGE_STATE_HANDLING not compatible with SFU_NO_SWAP process"
 #endif
+#if defined(SFU_IMG_COMPRESSION) && !defined(SFU_NO_SWAP)
+#error "SFU_IMG_COMPRESSION is only supported by SFU_NO_SWAP process"
+#endif
+#if defined(SFU_IMG_COMPRESSION) && (SECBOOT_CRYPTO_SCHEME == SECBOOT_AES128_GCM_AES128_GCM_AES128_GCM)
+#error "SFU_IMG_COMPRESSION requires a crypto scheme authenticating the clear FW"
+#endif
+#if defined(SFU_IMG_DELTA) && !defined(SFU_NO_SWAP)
+#error "SFU_IMG_DELTA is only supported by SFU_NO_SWAP process"
+#endif
+#if defined(SFU_IMG_DELTA) && (SECBOOT_CRYPTO_SCHEME == SECBOOT_AES128_GCM_AES128_GCM_AES128_GCM)
+#error "SFU_IMG_DELTA requires a crypto scheme authenticating the clear FW"
+#endif
 
 
 #ifdef __cplusplus
@@ -0,0 +1,229 @@
+/**
+  ******************************************************************************
+  * @file    sfu_decompress.c
+  * @author  MCD Application Team
+  * @brief   Secure Firmware Update decompression module.
+  *          This file provides set of firmware functions to inflate a compressed
+  *          firmware image (LZSS stream) chunk by chunk with a bounded RAM usage.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2017 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "main.h"
+#include "sfu_decompress.h"
+
+#if defined(SFU_IMG_COMPRESSION)
+
+/* Private defines -----------------------------------------------------------*/
+#define SFU_DECOMPRESS_STATE_HEADER   (0U)  /*!< Waiting for the stream parameters byte */
+#define SFU_DECOMPRESS_STATE_TAG      (1U)  /*!< Waiting for the literal / back-reference tag bit */
+#define SFU_DECOMPRESS_STATE_LITERAL  (2U)  /*!< Waiting for a literal byte */
+#define SFU_DECOMPRESS_STATE_DISTANCE (3U)  /*!< Waiting for a back-reference distance */
+#define SFU_DECOMPRESS_STATE_COUNT    (4U)  /*!< Waiting for a back-reference length */
+#define SFU_DECOMPRESS_STATE_COPY     (5U)  /*!< Copying a back-reference */
+
+#define SFU_DECOMPRESS_HEADER  ((SFU_DECOMPRESS_WINDOW_BITS << 4U) | SFU_DECOMPRESS_COUNT_BITS) /*!< Parameters byte */
+#define SFU_DECOMPRESS_WINDOW_MASK  (SFU_DECOMPRESS_WINDOW_SIZE - 1UL)
+
+/* Private function prototypes -----------------------------------------------*/
+static SFU_ErrorStatus GetBits(SFU_DECOMPRESS_ContextTypeDef *pCtx, uint32_t Count, const uint8_t **ppIn,
+                               const uint8_t *pInEnd, uint32_t *pValue);
+static void PutByte(SFU_DECOMPRESS_ContextTypeDef *pCtx, uint8_t Value, uint8_t **ppOut);
+
+/* Functions Definition ------------------------------------------------------*/
+/**
+  * @brief  Initialize the decompression context before processing a new stream.
+  * @param  pCtx pointer to the decompression context
+  * @retval None.
+  */
+void SFU_DECOMPRESS_Init(SFU_DECOMPRESS_ContextTypeDef *pCtx)
+{
+  (void) memset(pCtx, 0, sizeof(*pCtx));
+  pCtx->State = SFU_DECOMPRESS_STATE_HEADER;
+}
+
+/**
+  * @brief  Inflate a part of the compressed stream.
+  * @note   The function returns as soon as the input is exhausted or the output is full, so it has to be called
+  *         again with more input and/or more output space to go on.
+  * @param  pCtx pointer to the decompression context
+  * @param  pIn pointer to the compressed data
+  * @param  pInSize [in] number of compressed bytes available, [out] number of compressed bytes consumed
+  * @param  pOut pointer to the output buffer
+  * @param  pOutSize [in] size of the output buffer, [out] number of bytes produced
+  * @retval SFU_ErrorStatus SFU_SUCCESS if successful, SFU_ERROR if the stream is not supported.
+  */
+SFU_ErrorStatus SFU_DECOMPRESS_Run(SFU_DECOMPRESS_ContextTypeDef *pCtx, const uint8_t *pIn, uint32_t *pInSize,
+                                   uint8_t *pOut, uint32_t *pOutSize)
+{
+  SFU_ErrorStatus e_ret_status = SFU_SUCCESS;
+  const uint8_t *p_in = pIn;
+  const uint8_t *p_in_end = pIn + *pInSize;
+  uint8_t *p_out = pOut;
+  uint8_t *p_out_end = pOut + *pOutSize;
+  uint32_t value = 0U;
+  uint32_t more = 1U;
+
+  while ((more == 1U) && (e_ret_status == SFU_SUCCESS))
+  {
+    switch (pCtx->State)
+    {
+      case SFU_DECOMPRESS_STATE_HEADER:
+        if (GetBits(pCtx, 8U, &p_in, p_in_end, &value) != SFU_SUCCESS)
+        {
+          more = 0U;
+        }
+        else if (value != SFU_DECOMPRESS_HEADER)
+        {
+          /* Stream produced with other parameters */
+          e_ret_status = SFU_ERROR;
+        }
+        else
+        {
+          pCtx->State = SFU_DECOMPRESS_STATE_TAG;
+        }
+        break;
+
+      case SFU_DECOMPRESS_STATE_TAG:
+        if (p_out == p_out_end)
+        {
+          /* Do not consume anything more until there is room for the output */
+          more = 0U;
+        }
+        else if (GetBits(pCtx, 1U, &p_in, p_in_end, &value) != SFU_SUCCESS)
+        {
+          more = 0U;
+        }
+        else
+        {
+          pCtx->State = (value == 1U) ? SFU_DECOMPRESS_STATE_LITERAL : SFU_DECOMPRESS_STATE_DISTANCE;
+        }
+        break;
+
+      case SFU_DECOMPRESS_STATE_LITERAL:
+        if (GetBits(pCtx, 8U, &p_in, p_in_end, &value) != SFU_SUCCESS)
+        {
+          more = 0U;
+        }
+        else
+        {
+          PutByte(pCtx, (uint8_t) value, &p_out);
+          pCtx->State = SFU_DECOMPRESS_STATE_TAG;
+        }
+        break;
+
+      case SFU_DECOMPRESS_STATE_DISTANCE:
+        if (GetBits(pCtx, SFU_DECOMPRESS_WINDOW_BITS, &p_in, p_in_end, &value) != SFU_SUCCESS)
+        {
+          more = 0U;
+        }
+        else
+        {
+          pCtx->CopyDistance = value + 1U;
+          pCtx->State = SFU_DECOMPRESS_STATE_COUNT;
+        }
+        break;
+
+      case SFU_DECOMPRESS_STATE_COUNT:
+        if (GetBits(pCtx, SFU_DECOMPRESS_COUNT_BITS, &p_in, p_in_end, &value) != SFU_SUCCESS)
+        {
+          more = 0U;
+        }
+        else
+        {
+          pCtx->CopyCount = value + 1U;
+          pCtx->State = SFU_DECOMPRESS_STATE_COPY;
+        }
+        break;
+
+      case SFU_DECOMPRESS_STATE_COPY:
+        while ((pCtx->CopyCount > 0U) && (p_out < p_out_end))
+        {
+          PutByte(pCtx, pCtx->Window[(pCtx->WindowPos - pCtx->CopyDistance) & SFU_DECOMPRESS_WINDOW_MASK], &p_out);
+          pCtx->CopyCount--;
+        }
+        if (pCtx->CopyCount == 0U)
+        {
+          pCtx->State = SFU_DECOMPRESS_STATE_TAG;
+        }
+        else
+        {
+          more = 0U;
+        }
+        break;
+
+      default:
+        e_ret_status = SFU_ERROR;
+        break;
+    }
+  }
+
+  *pInSize = (uint32_t)(p_in - pIn);
+  *pOutSize = (uint32_t)(p_out - pOut);
+
+  return e_ret_status;
+}
+
+/**
+  * @brief  Read a field from the compressed stream.
+  * @note   The bits already read are kept in the context when the input is exhausted in the middle of a field.
+  * @param  pCtx pointer to the decompression context
+  * @param  Count number of bits of the field
+  * @param  ppIn pointer to the input pointer, updated with the consumed bytes
+  * @param  pInEnd end of the input
+  * @param  pValue value of the field
+  * @retval SFU_ErrorStatus SFU_SUCCESS if the field is complete, SFU_ERROR if more input is needed.
+  */
+static SFU_ErrorStatus GetBits(SFU_DECOMPRESS_ContextTypeDef *pCtx, uint32_t Count, const uint8_t **ppIn,
+                               const uint8_t *pInEnd, uint32_t *pValue)
+{
+  while (pCtx->FieldBits < Count)
+  {
+    if (pCtx->BitMask == 0U)
+    {
+      if (*ppIn == pInEnd)
+      {
+        return SFU_ERROR;
+      }
+      pCtx->CurrentByte = **ppIn;
+      (*ppIn)++;
+      pCtx->BitMask = 0x80U;
+    }
+    pCtx->FieldValue = (pCtx->FieldValue << 1U) | (((pCtx->CurrentByte & pCtx->BitMask) != 0U) ? 1U : 0U);
+    pCtx->BitMask >>= 1U;
+    pCtx->FieldBits++;
+  }
+
+  *pValue = pCtx->FieldValue;
+  pCtx->FieldValue = 0U;
+  pCtx->FieldBits = 0U;
+  return SFU_SUCCESS;
+}
+
+/**
+  * @brief  Output one byte and keep it in the window.
+  * @param  pCtx pointer to the decompression context
+  * @param  Value byte to output
+  * @param  ppOut pointer to the output pointer, incremented
+  * @retval None.
+  */
+static void PutByte(SFU_DECOMPRESS_ContextTypeDef *pCtx, uint8_t Value, uint8_t **ppOut)
+{
+  pCtx->Window[pCtx->WindowPos] = Value;
+  pCtx->WindowPos = (pCtx->WindowPos + 1U) & SFU_DECOMPRESS_WINDOW_MASK;
+  **ppOut = Value;
+  (*ppOut)++;
+}
+
+#endif /* SFU_IMG_COMPRESSION */
@@ -0,0 +1,70 @@
+/**
+  ******************************************************************************
+  * @file    sfu_decompress.h
+  * @author  MCD Application Team
+  * @brief   This file contains definitions for Secure Firmware Update decompression
+  *          functionalities.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2017 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SFU_DECOMPRESS_H
+#define SFU_DECOMPRESS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "sfu_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+/**
+  * Compressed stream parameters : they MUST match the ones used by the "compress" command of prepareimage.py.
+  * The stream starts with one byte (WINDOW_BITS << 4) | COUNT_BITS, then each item is either :
+  * - tag bit 1 followed by 8 bits : literal byte
+  * - tag bit 0 followed by WINDOW_BITS bits (distance - 1) and COUNT_BITS bits (length - 1) : back-reference
+  * Bits are packed MSB first.
+  */
+#define SFU_DECOMPRESS_WINDOW_BITS  (11U)                                /*!< log2 of the window size */
+#define SFU_DECOMPRESS_COUNT_BITS   (5U)                                 /*!< log2 of the longest back-reference */
+#define SFU_DECOMPRESS_WINDOW_SIZE  (1UL << SFU_DECOMPRESS_WINDOW_BITS)  /*!< 2 Kbytes window */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Decompression context.
+  *         The context holds the whole decoder state, so that the stream can be fed and drained in chunks of any size.
+  */
+typedef struct
+{
+  uint8_t  Window[SFU_DECOMPRESS_WINDOW_SIZE];  /*!< Last bytes produced, referenced by back-references */
+  uint32_t WindowPos;                           /*!< Next position to write in the window */
+  uint32_t CopyDistance;                        /*!< Distance of the back-reference being copied */
+  uint32_t CopyCount;                           /*!< Number of bytes of the back-reference still to copy */
+  uint32_t FieldValue;                          /*!< Bits of the field being read */
+  uint32_t FieldBits;                           /*!< Number of bits of the field already read */
+  uint32_t CurrentByte;                         /*!< Input byte being consumed */
+  uint32_t BitMask;                             /*!< Next bit of CurrentByte to consume, 0 if none */
+  uint32_t State;                               /*!< Decoder state */
+} SFU_DECOMPRESS_ContextTypeDef;
+
+/* Exported functions ------------------------------------------------------- */
+void SFU_DECOMPRESS_Init(SFU_DECOMPRESS_ContextTypeDef *pCtx);
+SFU_ErrorStatus SFU_DECOMPRESS_Run(SFU_DECOMPRESS_ContextTypeDef *pCtx, const uint8_t *pIn, uint32_t *pInSize,
+                                   uint8_t *pOut, uint32_t *pOutSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SFU_DECOMPRESS_H */
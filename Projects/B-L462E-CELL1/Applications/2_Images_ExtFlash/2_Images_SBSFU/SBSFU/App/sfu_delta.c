@@ -0,0 +1,281 @@
+/**
+  ******************************************************************************
+  * @file    sfu_delta.c
+  * @author  MCD Application Team
+  * @brief   Secure Firmware Update delta patch module.
+  *          This file provides set of firmware functions to rebuild a firmware image
+  *          in place, page by page, from the current slot content and a delta patch.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2017 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "main.h"
+#include "sfu_delta.h"
+
+#if defined(SFU_IMG_DELTA)
+
+/* Private defines -----------------------------------------------------------*/
+#define SFU_DELTA_HEADER_LEN  (64U)  /*!< Size of the patch header in the patch */
+#define SFU_DELTA_RECORD_LEN  (6U)   /*!< Size of a page record header in the patch */
+
+#define SFU_DELTA_MODE_BUILD   (0U)  /*!< Record built from the slot content and rewritten */
+#define SFU_DELTA_MODE_RESTORE (1U)  /*!< Record rewritten from the backup page */
+#define SFU_DELTA_MODE_SKIP    (2U)  /*!< Record already applied, only parsed */
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t GetLe16(const uint8_t *pBuffer);
+static uint32_t GetLe32(const uint8_t *pBuffer);
+static SFU_ErrorStatus ApplyRecord(const SFU_DELTA_IoTypeDef *pIo, const SFU_DELTA_HeaderTypeDef *pHeader,
+                                   uint32_t SlotSize, uint8_t *pPage, uint8_t *pWritten, uint32_t Record,
+                                   uint32_t Mode);
+
+/* Functions Definition ------------------------------------------------------*/
+/**
+  * @brief  Read and check the header at the beginning of the patch.
+  * @param  pIo pointer to the input / output functions
+  * @param  pHeader pointer to the header to populate
+  * @retval SFU_ErrorStatus SFU_SUCCESS if successful, SFU_ERROR otherwise.
+  */
+SFU_ErrorStatus SFU_DELTA_ReadHeader(const SFU_DELTA_IoTypeDef *pIo, SFU_DELTA_HeaderTypeDef *pHeader)
+{
+  SFU_ErrorStatus e_ret_status;
+  uint8_t header[SFU_DELTA_HEADER_LEN];
+
+  e_ret_status = pIo->ReadPatch(pIo->pCtx, header, sizeof(header));
+  if (e_ret_status == SFU_SUCCESS)
+  {
+    pHeader->Magic = GetLe32(&header[0U]);
+    pHeader->PageSize = GetLe32(&header[4U]);
+    pHeader->SourceFwSize = GetLe32(&header[8U]);
+    pHeader->FwSize = GetLe32(&header[12U]);
+    pHeader->NbRecords = GetLe32(&header[16U]);
+    (void) memcpy(pHeader->SourceFwTag, &header[20U], SFU_DELTA_TAG_LEN);
+    (void) memcpy(pHeader->Reserved, &header[20U + SFU_DELTA_TAG_LEN], sizeof(pHeader->Reserved));
+
+    /* The operation lengths are coded on 15 bits */
+    if ((pHeader->Magic != SFU_DELTA_MAGIC) || (pHeader->PageSize == 0U) ||
+        (pHeader->PageSize > (uint32_t)(SFU_DELTA_COPY_FLAG)))
+    {
+      e_ret_status = SFU_ERROR;
+    }
+  }
+
+  return e_ret_status;
+}
+
+/**
+  * @brief  Rebuild the slot by applying the page records following the patch header.
+  * @note   Each page is built in RAM, from the patch and from the current content of the slot, before being
+  *         rewritten. A record reading a page already rewritten is rejected, so that a malformed patch cannot
+  *         produce an image built from the new content.
+  * @note   When resuming, the records already applied are only parsed. The interrupted record is built again if it
+  *         does not read its own page, which is then the only one it may have modified, or restored from the backup
+  *         page otherwise.
+  * @param  pIo pointer to the input / output functions
+  * @param  pHeader pointer to the patch header
+  * @param  SlotSize size (bytes) of the slot to rebuild
+  * @param  pPage pointer to a buffer of pHeader->PageSize bytes
+  * @param  AppliedRecords number of records whose SFU_DELTA_STEP_APPLIED step has been saved
+  * @param  BackupValid 1 if the SFU_DELTA_STEP_BACKED_UP step of record AppliedRecords has been saved, 0 otherwise
+  * @retval SFU_ErrorStatus SFU_SUCCESS if successful, SFU_ERROR otherwise.
+  */
+SFU_ErrorStatus SFU_DELTA_Apply(const SFU_DELTA_IoTypeDef *pIo, const SFU_DELTA_HeaderTypeDef *pHeader,
+                                uint32_t SlotSize, uint8_t *pPage, uint32_t AppliedRecords, uint32_t BackupValid)
+{
+  SFU_ErrorStatus e_ret_status = SFU_SUCCESS;
+  uint8_t written[SFU_DELTA_MAX_NB_PAGES / 8U];
+  uint32_t mode;
+  uint32_t i;
+
+  if (((SlotSize % pHeader->PageSize) != 0U) || ((SlotSize / pHeader->PageSize) > SFU_DELTA_MAX_NB_PAGES) ||
+      ((SlotSize / pHeader->PageSize) < 2U) || (AppliedRecords > pHeader->NbRecords))
+  {
+    return SFU_ERROR;
+  }
+
+  /* The backup page is never rewritten by a record nor read by a copy */
+  (void) memset(written, 0x00, sizeof(written));
+  i = (SlotSize / pHeader->PageSize) - 1U;
+  written[i / 8U] |= (uint8_t)(1U << (i % 8U));
+
+  for (i = 0U; (i < pHeader->NbRecords) && (e_ret_status == SFU_SUCCESS); i++)
+  {
+    if (i < AppliedRecords)
+    {
+      mode = SFU_DELTA_MODE_SKIP;
+    }
+    else if ((i == AppliedRecords) && (BackupValid == 1U))
+    {
+      mode = SFU_DELTA_MODE_RESTORE;
+    }
+    else
+    {
+      mode = SFU_DELTA_MODE_BUILD;
+    }
+    e_ret_status = ApplyRecord(pIo, pHeader, SlotSize, pPage, written, i, mode);
+  }
+
+  return e_ret_status;
+}
+
+/**
+  * @brief  Build and write one page.
+  * @param  pIo pointer to the input / output functions
+  * @param  pHeader pointer to the patch header
+  * @param  SlotSize size (bytes) of the slot to rebuild
+  * @param  pPage pointer to a buffer of pHeader->PageSize bytes
+  * @param  pWritten bitmap of the pages already rewritten, updated
+  * @param  Record index of the record
+  * @param  Mode SFU_DELTA_MODE_BUILD, SFU_DELTA_MODE_RESTORE or SFU_DELTA_MODE_SKIP
+  * @retval SFU_ErrorStatus SFU_SUCCESS if successful, SFU_ERROR otherwise.
+  */
+static SFU_ErrorStatus ApplyRecord(const SFU_DELTA_IoTypeDef *pIo, const SFU_DELTA_HeaderTypeDef *pHeader,
+                                   uint32_t SlotSize, uint8_t *pPage, uint8_t *pWritten, uint32_t Record,
+                                   uint32_t Mode)
+{
+  SFU_ErrorStatus e_ret_status;
+  uint8_t record[SFU_DELTA_RECORD_LEN];
+  uint8_t operation[4U];
+  uint32_t page_index;
+  uint32_t nb_ops;
+  uint32_t position;
+  uint32_t length;
+  uint32_t offset;
+  uint32_t page;
+  uint32_t backup_index = (SlotSize / pHeader->PageSize) - 1U;
+  uint32_t self_read = 0U;
+
+  e_ret_status = pIo->ReadPatch(pIo->pCtx, record, sizeof(record));
+  if (e_ret_status != SFU_SUCCESS)
+  {
+    return e_ret_status;
+  }
+
+  page_index = GetLe16(&record[0U]);
+  position = GetLe16(&record[2U]);
+  nb_ops = GetLe16(&record[4U]);
+  if ((page_index >= (SlotSize / pHeader->PageSize)) || (position > pHeader->PageSize) ||
+      ((pWritten[page_index / 8U] & (1U << (page_index % 8U))) != 0U))
+  {
+    return SFU_ERROR;
+  }
+
+  (void) memset(pPage, 0xFF, pHeader->PageSize);
+  while ((nb_ops > 0U) && (e_ret_status == SFU_SUCCESS))
+  {
+    e_ret_status = pIo->ReadPatch(pIo->pCtx, operation, 2U);
+    if (e_ret_status == SFU_SUCCESS)
+    {
+      length = GetLe16(&operation[0U]) & ~(uint32_t)SFU_DELTA_COPY_FLAG;
+      if ((length == 0U) || (length > (pHeader->PageSize - position)))
+      {
+        e_ret_status = SFU_ERROR;
+      }
+      else if ((GetLe16(&operation[0U]) & SFU_DELTA_COPY_FLAG) != 0U)
+      {
+        /* Copy : the source must not have been rewritten yet */
+        e_ret_status = pIo->ReadPatch(pIo->pCtx, operation, 4U);
+        offset = GetLe32(&operation[0U]);
+        if ((e_ret_status == SFU_SUCCESS) && ((offset > SlotSize) || (length > (SlotSize - offset))))
+        {
+          e_ret_status = SFU_ERROR;
+        }
+        for (page = offset / pHeader->PageSize;
+             (e_ret_status == SFU_SUCCESS) && (page <= ((offset + length - 1U) / pHeader->PageSize)); page++)
+        {
+          if ((pWritten[page / 8U] & (1U << (page % 8U))) != 0U)
+          {
+            e_ret_status = SFU_ERROR;
+          }
+          else if (page == page_index)
+          {
+            self_read = 1U;
+          }
+          else
+          {
+            /* Nothing to do */
+          }
+        }
+        /* The slot content is only needed to build the page */
+        if ((e_ret_status == SFU_SUCCESS) && (Mode == SFU_DELTA_MODE_BUILD))
+        {
+          e_ret_status = pIo->ReadSource(pIo->pCtx, offset, &pPage[position], length);
+        }
+      }
+      else
+      {
+        /* Literal */
+        e_ret_status = pIo->ReadPatch(pIo->pCtx, &pPage[position], length);
+      }
+      position += length;
+      nb_ops--;
+    }
+  }
+
+  if ((e_ret_status == SFU_SUCCESS) && (Mode == SFU_DELTA_MODE_RESTORE))
+  {
+    /* The page may have been partially rewritten : its content was saved in the backup page */
+    e_ret_status = pIo->ReadSource(pIo->pCtx, backup_index * pHeader->PageSize, pPage, pHeader->PageSize);
+  }
+  else if ((e_ret_status == SFU_SUCCESS) && (Mode == SFU_DELTA_MODE_BUILD) && (self_read == 1U))
+  {
+    /* The page content cannot be built again once its rewriting has started : save it first */
+    e_ret_status = pIo->WritePage(pIo->pCtx, backup_index, pPage, 0U, pHeader->PageSize);
+    if (e_ret_status == SFU_SUCCESS)
+    {
+      e_ret_status = pIo->SaveProgress(pIo->pCtx, Record, SFU_DELTA_STEP_BACKED_UP);
+    }
+  }
+  else
+  {
+    /* Nothing to do */
+  }
+
+  if ((e_ret_status == SFU_SUCCESS) && (Mode != SFU_DELTA_MODE_SKIP))
+  {
+    e_ret_status = pIo->WritePage(pIo->pCtx, page_index, pPage, GetLe16(&record[2U]), position);
+    if (e_ret_status == SFU_SUCCESS)
+    {
+      e_ret_status = pIo->SaveProgress(pIo->pCtx, Record, SFU_DELTA_STEP_APPLIED);
+    }
+  }
+  if (e_ret_status == SFU_SUCCESS)
+  {
+    pWritten[page_index / 8U] |= (uint8_t)(1U << (page_index % 8U));
+  }
+
+  return e_ret_status;
+}
+
+/**
+  * @brief  Read a 16 bits little endian value.
+  * @param  pBuffer pointer to the value
+  * @retval the value.
+  */
+static uint32_t GetLe16(const uint8_t *pBuffer)
+{
+  return (uint32_t)pBuffer[0U] | ((uint32_t)pBuffer[1U] << 8U);
+}
+
+/**
+  * @brief  Read a 32 bits little endian value.
+  * @param  pBuffer pointer to the value
+  * @retval the value.
+  */
+static uint32_t GetLe32(const uint8_t *pBuffer)
+{
+  return GetLe16(&pBuffer[0U]) | (GetLe16(&pBuffer[2U]) << 16U);
+}
+
+#endif /* SFU_IMG_DELTA */
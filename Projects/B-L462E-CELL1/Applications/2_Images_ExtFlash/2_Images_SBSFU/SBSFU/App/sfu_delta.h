@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file    sfu_delta.h
+  * @author  MCD Application Team
+  * @brief   This file contains definitions for Secure Firmware Update delta patch
+  *          functionalities.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2017 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file in
+  * the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SFU_DELTA_H
+#define SFU_DELTA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "sfu_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+/**
+  * Delta patch format : it MUST match the one generated by the "delta" command of prepareimage.py.
+  * All the fields are little endian.
+  * The patch starts with a SFU_DELTA_HeaderTypeDef, followed by NbRecords page records :
+  * - PageIndex (2 bytes) : index of the page of the slot to rebuild
+  * - Start (2 bytes)     : offset in the page of the first byte to program, the bytes before are left erased
+  * - NbOps (2 bytes)     : number of operations producing the page content from Start
+  * Each operation starts with a length (2 bytes) :
+  * - bit 15 set   : copy of (length & 0x7FFF) bytes from the slot, at the offset given by the next 4 bytes
+  * - bit 15 clear : literal, the (length) next bytes of the patch
+  * The bytes not produced by the operations up to the end of the page are left erased.
+  * The records are ordered so that a page is never read after being rewritten, the pages without record are kept.
+  * The last page of the slot is used as a backup of the pages whose record copies bytes from the page itself : it must
+  * not be part of the FW to patch nor of the rebuilt FW.
+  *
+  * Resuming an interrupted installation : SaveProgress is called once a page is saved in the backup page and once it
+  * is rewritten. Given these steps, SFU_DELTA_Apply() skips the records already applied and finishes the interrupted
+  * one from the backup page if its own content was needed.
+  */
+#define SFU_DELTA_MAGIC          (0x44554653UL)  /*!< "SFUD" */
+#define SFU_DELTA_TAG_LEN        (32U)           /*!< SHA256 of the FW to patch */
+#define SFU_DELTA_MAX_NB_PAGES   (256U)          /*!< Maximum number of pages of the rebuilt slot */
+#define SFU_DELTA_COPY_FLAG      (0x8000U)       /*!< Copy operation flag in the operation length */
+
+#define SFU_DELTA_STEP_BACKED_UP (0U)            /*!< Page built by the record saved in the backup page */
+#define SFU_DELTA_STEP_APPLIED   (1U)            /*!< Page of the record rewritten */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Delta patch header
+  */
+typedef struct
+{
+  uint32_t Magic;                            /*!< SFU_DELTA_MAGIC */
+  uint32_t PageSize;                         /*!< Size (bytes) of the pages of the rebuilt slot */
+  uint32_t SourceFwSize;                     /*!< Size (bytes) of the FW to patch */
+  uint32_t FwSize;                           /*!< Size (bytes) of the FW rebuilt by the patch */
+  uint32_t NbRecords;                        /*!< Number of page records */
+  uint8_t  SourceFwTag[SFU_DELTA_TAG_LEN];   /*!< Tag of the FW to patch */
+  uint8_t  Reserved[12U];                    /*!< Reserved for future use : header size of 64 bytes */
+} SFU_DELTA_HeaderTypeDef;
+
+/**
+  * @brief  Delta patch input / output functions.
+  *         Offsets are relative to the beginning of the slot being rebuilt.
+  */
+typedef struct
+{
+  SFU_ErrorStatus(*ReadPatch)(void *pCtx, uint8_t *pBuffer, uint32_t Size);         /*!< Read next patch bytes */
+  SFU_ErrorStatus(*ReadSource)(void *pCtx, uint32_t Offset, uint8_t *pBuffer,
+                               uint32_t Size);                                     /*!< Read current slot content */
+  SFU_ErrorStatus(*WritePage)(void *pCtx, uint32_t PageIndex, const uint8_t *pPage,
+                              uint32_t Start, uint32_t End);                       /*!< Erase a page, then program
+                                                                                        the bytes [Start, End) */
+  SFU_ErrorStatus(*SaveProgress)(void *pCtx, uint32_t Record, uint32_t Step);        /*!< Persist the completion of
+                                                                                        a SFU_DELTA_STEP_xxx step */
+  void *pCtx;                                                                      /*!< Context of the functions */
+} SFU_DELTA_IoTypeDef;
+
+/* Exported functions ------------------------------------------------------- */
+SFU_ErrorStatus SFU_DELTA_ReadHeader(const SFU_DELTA_IoTypeDef *pIo, SFU_DELTA_HeaderTypeDef *pHeader);
+SFU_ErrorStatus SFU_DELTA_Apply(const SFU_DELTA_IoTypeDef *pIo, const SFU_DELTA_HeaderTypeDef *pHeader,
+                                uint32_t SlotSize, uint8_t *pPage, uint32_t AppliedRecords, uint32_t BackupValid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SFU_DELTA_H */
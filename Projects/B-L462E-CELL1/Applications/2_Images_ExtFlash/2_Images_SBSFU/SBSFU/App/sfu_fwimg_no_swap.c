@@ -33,6 +33,8 @@
 #include "sfu_fwimg_internal.h"
 #include "sfu_trace.h"
 #include "sfu_boot.h"
+#include "sfu_decompress.h"
+#include "sfu_delta.h"
 
 
 #if  defined(SFU_NO_SWAP)
@@ -49,11 +51,439 @@
 #define TRAILER_HDR_TEST(A)  ((uint8_t *)(TRAILER_BEGIN(A) + SE_FW_HEADER_TOT_LEN))
 #define TRAILER_SWAP_ADDR(A) ((uint8_t *)(TRAILER_BEGIN(A) + SE_FW_HEADER_TOT_LEN + SE_FW_HEADER_TOT_LEN))
 
+#if defined(SFU_IMG_DELTA)
+/* Delta patch installation progress, just before the trailer. Each entry is programmed once the corresponding step is
+   completed, an entry still erased means the step is not done :
+   - entry 0                : the active slot is being patched (the FW to patch is not complete anymore)
+   - entry 1 + 2 * record   : SFU_DELTA_STEP_BACKED_UP step of the record
+   - entry 2 + 2 * record   : SFU_DELTA_STEP_APPLIED step of the record */
+#define DELTA_PROGRESS_ENTRY_LEN   (sizeof(SFU_LL_FLASH_write_t))
+#define DELTA_PROGRESS_LEN         ((1U + (2U * SFU_DELTA_MAX_NB_PAGES)) * DELTA_PROGRESS_ENTRY_LEN)
+#define DELTA_PROGRESS_BEGIN(A)    ((uint8_t *)(TRAILER_BEGIN(A) - DELTA_PROGRESS_LEN))
+#define DELTA_PROGRESS_ENTRY(A, I) ((uint8_t *)(DELTA_PROGRESS_BEGIN(A) + ((I) * DELTA_PROGRESS_ENTRY_LEN)))
+#define DELTA_PROGRESS_STARTED     (0U)
+#define DELTA_PROGRESS_STEP(R, S)  (1U + (2U * (R)) + (S))
+#endif /* SFU_IMG_DELTA */
+
+#if defined(SFU_IMG_COMPRESSION) || defined(SFU_IMG_DELTA)
+/* Private types -------------------------------------------------------------*/
+/**
+  * @brief  Stored FW stream : the data stored after the header (compressed FW or delta patch) is read and decrypted
+  *         chunk by chunk from the dwl slot. Kept in a static variable as the decompression window does not fit in
+  *         the stack.
+  */
+typedef struct
+{
+#if defined(SFU_IMG_COMPRESSION)
+  SFU_DECOMPRESS_ContextTypeDef Decompress;               /*!< Decompression context */
+#endif /* SFU_IMG_COMPRESSION */
+  uint8_t  InBuffer[SFU_IMG_CHUNK_SIZE] __attribute__((aligned(8))); /*!< Decrypted stored data */
+  uint32_t InPos;                                         /*!< Next byte of InBuffer to consume */
+  uint32_t InLen;                                         /*!< Number of valid bytes in InBuffer */
+  uint32_t SrcAddress;                                    /*!< Address of the next encrypted chunk to read */
+  uint32_t SrcEnd;                                        /*!< End address of the stored data */
+} SFU_IMG_StoredStreamTypeDef;
+
+#if defined(SFU_IMG_DELTA)
+/**
+  * @brief  Context of the delta patch input / output functions
+  */
+typedef struct
+{
+  SE_StatusTypeDef *pSeStatus;                            /*!< SE status of the patch decryption */
+  uint32_t ActiveSlot;                                    /*!< Slot being rebuilt */
+  uint32_t DwlSlot;                                       /*!< Slot holding the patch and the progress entries */
+} SFU_IMG_DeltaIoCtxTypeDef;
+#endif /* SFU_IMG_DELTA */
+
+/* Private variables ---------------------------------------------------------*/
+static SFU_IMG_StoredStreamTypeDef StoredStream;
+#if defined(SFU_IMG_DELTA)
+static uint8_t DeltaPage[FLASH_PAGE_SIZE] __attribute__((aligned(8)));
+#endif /* SFU_IMG_DELTA */
+#endif /* SFU_IMG_COMPRESSION || SFU_IMG_DELTA */
+
 #endif /* defined(SFU_NO_SWAP) */
 
 /* Functions Definition : helper ---------------------------------------------*/
 #if  defined(SFU_NO_SWAP)
 
+/**
+  * @brief  Size of the data stored in dwl slot after the header
+  * @param  pFwImageHeader pointer to fw header
+  * @retval size (bytes) of the FW, of the compressed FW or of the delta patch.
+  */
+static uint32_t StoredFwSize(SE_FwRawHeaderTypeDef *pFwImageHeader)
+{
+  uint32_t size = pFwImageHeader->FwSize;
+
+#if defined(SFU_IMG_COMPRESSION)
+  if (pFwImageHeader->CompressedFwSize != 0U)
+  {
+    size = pFwImageHeader->CompressedFwSize;
+  }
+#endif /* SFU_IMG_COMPRESSION */
+#if defined(SFU_IMG_DELTA)
+  if (pFwImageHeader->DeltaFwSize != 0U)
+  {
+    size = pFwImageHeader->DeltaFwSize;
+  }
+#endif /* SFU_IMG_DELTA */
+
+  return size;
+}
+
+#if defined(SFU_IMG_COMPRESSION) || defined(SFU_IMG_DELTA)
+/**
+  * @brief  Start reading the data stored in dwl slot after the header
+  * @note   The decryption process must be initialized by the caller.
+  * @param  DwlSlot identification of the downloaded area
+  * @param  Size size (bytes) of the stored data
+  * @retval None.
+  */
+static void StoredStreamInit(uint32_t DwlSlot, uint32_t Size)
+{
+  StoredStream.InPos = 0U;
+  StoredStream.InLen = 0U;
+  StoredStream.SrcAddress = SlotStartAdd[DwlSlot] + SFU_IMG_IMAGE_OFFSET;
+  StoredStream.SrcEnd = StoredStream.SrcAddress + Size;
+}
+
+/**
+  * @brief  Read and decrypt the next chunk of stored data once the previous one is consumed
+  * @param  pSeStatus pointer to the SE status
+  * @retval SFU_SUCCESS if decrypted data is available, SFU_ERROR otherwise (including the end of the stored data).
+  */
+static SFU_ErrorStatus StoredStreamFill(SE_StatusTypeDef *pSeStatus)
+{
+  SFU_ErrorStatus e_ret_status = SFU_SUCCESS;
+  uint8_t fw_encrypted_chunk[SFU_IMG_CHUNK_SIZE] __attribute__((aligned(8)));
+  uint32_t size;
+
+  if (StoredStream.InPos == StoredStream.InLen)
+  {
+    if (StoredStream.SrcAddress < StoredStream.SrcEnd)
+    {
+      size = StoredStream.SrcEnd - StoredStream.SrcAddress;
+      if (size > SFU_IMG_CHUNK_SIZE)
+      {
+        size = SFU_IMG_CHUNK_SIZE;
+      }
+      e_ret_status = SFU_LL_FLASH_Read(fw_encrypted_chunk, (uint8_t *) StoredStream.SrcAddress, size);
+    }
+    else
+    {
+      /* The stored data ends before the size expected by the caller */
+      size = 0U;
+      e_ret_status = SFU_ERROR;
+    }
+    if (e_ret_status == SFU_SUCCESS)
+    {
+      StoredStream.InLen = size;
+      if (SE_Decrypt_Append(pSeStatus, fw_encrypted_chunk, (int32_t)size, StoredStream.InBuffer,
+                            (int32_t *)&StoredStream.InLen) != SE_SUCCESS)
+      {
+        e_ret_status = SFU_ERROR;
+      }
+      StoredStream.InPos = 0U;
+      StoredStream.SrcAddress += size;
+    }
+  }
+
+  return e_ret_status;
+}
+#endif /* SFU_IMG_COMPRESSION || SFU_IMG_DELTA */
+
+#if defined(SFU_IMG_COMPRESSION)
+/**
+  * @brief  Start reading the compressed FW stored in dwl slot
+  * @note   The decryption process must be initialized by the caller.
+  * @param  DwlSlot identification of the downloaded area
+  * @param  pFwImageHeader pointer to fw header
+  * @retval None.
+  */
+static void CompressedStreamInit(uint32_t DwlSlot, SE_FwRawHeaderTypeDef *pFwImageHeader)
+{
+  SFU_DECOMPRESS_Init(&StoredStream.Decompress);
+  StoredStreamInit(DwlSlot, pFwImageHeader->CompressedFwSize);
+}
+
+/**
+  * @brief  Read the next bytes of the decompressed FW
+  * @param  pSeStatus pointer to the SE status
+  * @param  pBuffer pointer to the buffer to fill
+  * @param  Size number of bytes to read
+  * @retval SFU_SUCCESS if Size bytes have been read, SFU_ERROR otherwise (including a truncated or corrupted stream).
+  */
+static SFU_ErrorStatus CompressedStreamRead(SE_StatusTypeDef *pSeStatus, uint8_t *pBuffer, uint32_t Size)
+{
+  SFU_ErrorStatus e_ret_status = SFU_SUCCESS;
+  uint32_t produced = 0U;
+  uint32_t in_size;
+  uint32_t out_size;
+
+  while ((e_ret_status == SFU_SUCCESS) && (produced < Size))
+  {
+    /* Refill the decrypted compressed data */
+    e_ret_status = StoredStreamFill(pSeStatus);
+
+    /* Inflate */
+    if (e_ret_status == SFU_SUCCESS)
+    {
+      in_size = StoredStream.InLen - StoredStream.InPos;
+      out_size = Size - produced;
+      e_ret_status = SFU_DECOMPRESS_Run(&StoredStream.Decompress,
+                                        &StoredStream.InBuffer[StoredStream.InPos], &in_size,
+                                        &pBuffer[produced], &out_size);
+      StoredStream.InPos += in_size;
+      produced += out_size;
+    }
+  }
+
+  return e_ret_status;
+}
+#endif /* SFU_IMG_COMPRESSION */
+
+#if defined(SFU_IMG_DELTA)
+/**
+  * @brief  Read the next bytes of the delta patch (SFU_DELTA_IoTypeDef callback)
+  * @param  pCtx pointer to the SFU_IMG_DeltaIoCtxTypeDef context
+  * @param  pBuffer pointer to the buffer to fill
+  * @param  Size number of bytes to read
+  * @retval SFU_SUCCESS if Size bytes have been read, SFU_ERROR otherwise (including a truncated patch).
+  */
+static SFU_ErrorStatus DeltaReadPatch(void *pCtx, uint8_t *pBuffer, uint32_t Size)
+{
+  SFU_IMG_DeltaIoCtxTypeDef *p_ctx = (SFU_IMG_DeltaIoCtxTypeDef *)pCtx;
+  SFU_ErrorStatus e_ret_status = SFU_SUCCESS;
+  uint32_t read = 0U;
+  uint32_t size;
+
+  while ((e_ret_status == SFU_SUCCESS) && (read < Size))
+  {
+    e_ret_status = StoredStreamFill(p_ctx->pSeStatus);
+    if (e_ret_status == SFU_SUCCESS)
+    {
+      size = StoredStream.InLen - StoredStream.InPos;
+      if (size > (Size - read))
+      {
+        size = Size - read;
+      }
+      (void) memcpy(&pBuffer[read], &StoredStream.InBuffer[StoredStream.InPos], size);
+      StoredStream.InPos += size;
+      read += size;
+    }
+  }
+
+  return e_ret_status;
+}
+
+/**
+  * @brief  Read the current content of the active slot (SFU_DELTA_IoTypeDef callback)
+  * @param  pCtx pointer to the SFU_IMG_DeltaIoCtxTypeDef context
+  * @param  Offset offset in the active slot
+  * @param  pBuffer pointer to the buffer to fill
+  * @param  Size number of bytes to read
+  * @retval SFU_SUCCESS if successful, SFU_ERROR otherwise.
+  */
+static SFU_ErrorStatus DeltaReadSource(void *pCtx, uint32_t Offset, uint8_t *pBuffer, uint32_t Size)
+{
+  SFU_IMG_DeltaIoCtxTypeDef *p_ctx = (SFU_IMG_DeltaIoCtxTypeDef *)pCtx;
+  SFU_ErrorStatus e_ret_status;
+
+  e_ret_status = SFU_LL_FLASH_Read(pBuffer, (uint8_t *)(SlotStartAdd[p_ctx->ActiveSlot] + Offset), Size);
+  STATUS_FWIMG(e_ret_status == SFU_ERROR, SFU_IMG_FLASH_READ_FAILED);
+
+  return e_ret_status;
+}
+
+/**
+  * @brief  Rewrite a page of the active slot (SFU_DELTA_IoTypeDef callback)
+  * @note   The header area is never programmed here : it is written by SFU_IMG_Validation() once the whole
+  *         patch is applied.
+  * @param  pCtx pointer to the SFU_IMG_DeltaIoCtxTypeDef context
+  * @param  PageIndex index of the page in the active slot
+  * @param  pPage pointer to the page content
+  * @param  Start offset in the page of the first byte to program
+  * @param  End offset in the page of the end of the bytes to program
+  * @retval SFU_SUCCESS if successful, SFU_ERROR otherwise.
+  */
+static SFU_ErrorStatus DeltaWritePage(void *pCtx, uint32_t PageIndex, const uint8_t *pPage, uint32_t Start,
+                                      uint32_t End)
+{
+  SFU_IMG_DeltaIoCtxTypeDef *p_ctx = (SFU_IMG_DeltaIoCtxTypeDef *)pCtx;
+  SFU_ErrorStatus e_ret_status = SFU_SUCCESS;
+  SFU_FLASH_StatusTypeDef flash_if_status;
+  uint32_t page_address = SlotStartAdd[p_ctx->ActiveSlot] + (PageIndex * FLASH_PAGE_SIZE);
+  uint32_t write_end = End;
+
+  (void) SFU_LL_SECU_IWDG_Refresh();
+
+  /* Programming starts on the flash programming granularity, out of the header area */
+  if ((Start % sizeof(SFU_LL_FLASH_write_t)) != 0U)
+  {
+    e_ret_status = SFU_ERROR;
+  }
+  else if ((page_address == SlotHeaderAdd[p_ctx->ActiveSlot]) && (Start < SFU_IMG_IMAGE_OFFSET))
+  {
+    e_ret_status = SFU_ERROR;
+  }
+  else
+  {
+    /* Nothing to check */
+  }
+
+  if (e_ret_status == SFU_SUCCESS)
+  {
+    e_ret_status = SFU_LL_FLASH_Erase_Size(&flash_if_status, (uint8_t *) page_address, FLASH_PAGE_SIZE);
+    STATUS_FWIMG(e_ret_status == SFU_ERROR, SFU_IMG_FLASH_ERASE_FAILED);
+  }
+
+  /* Last bytes : complete to the flash programming granularity with the erased value of the page buffer */
+  while ((write_end % sizeof(SFU_LL_FLASH_write_t)) != 0U)
+  {
+    write_end++;
+  }
+  if ((e_ret_status == SFU_SUCCESS) && (write_end > Start))
+  {
+    /* Destination has to be in internal flash to keep confidentiality : SFU_LL_FLASH_INT_Write() */
+    e_ret_status = SFU_LL_FLASH_INT_Write(&flash_if_status, (uint8_t *)(page_address + Start), &pPage[Start],
+                                          write_end - Start);
+    STATUS_FWIMG(e_ret_status == SFU_ERROR, SFU_IMG_FLASH_WRITE_FAILED);
+  }
+
+  return e_ret_status;
+}
+
+/**
+  * @brief  Save the completion of a patching step in the progress entries of dwl slot
+  * @param  DwlSlot identification of the downloaded area
+  * @param  Entry index of the progress entry
+  * @retval SFU_SUCCESS if successful, SFU_ERROR otherwise.
+  */
+static SFU_ErrorStatus DeltaSaveEntry(uint32_t DwlSlot, uint32_t Entry)
+{
+  SFU_ErrorStatus e_ret_status;
+  SFU_FLASH_StatusTypeDef flash_if_status;
+  uint8_t done[DELTA_PROGRESS_ENTRY_LEN] __attribute__((aligned(8)));
+
+  (void) memset(done, 0x00, sizeof(done));
+  e_ret_status = SFU_LL_FLASH_Write(&flash_if_status, DELTA_PROGRESS_ENTRY(DwlSlot, Entry), done, sizeof(done));
+  STATUS_FWIMG(e_ret_status == SFU_ERROR, SFU_IMG_FLASH_WRITE_FAILED);
+
+  return e_ret_status;
+}
+
+/**
+  * @brief  Check if a patching step has been saved in the progress entries of dwl slot
+  * @param  DwlSlot identification of the downloaded area
+  * @param  Entry index of the progress entry
+  * @retval 1 if the entry has been programmed, 0 if it is erased (or cannot be read).
+  */
+static uint32_t DeltaEntrySaved(uint32_t DwlSlot, uint32_t Entry)
+{
+  uint8_t entry[DELTA_PROGRESS_ENTRY_LEN];
+  uint32_t i;
+  uint32_t saved = 0U;
+
+  if (SFU_LL_FLASH_Read(entry, DELTA_PROGRESS_ENTRY(DwlSlot, Entry), sizeof(entry)) == SFU_SUCCESS)
+  {
+    /* An entry whose programming has been interrupted is not erased either : the step was already done */
+    for (i = 0U; i < sizeof(entry); i++)
+    {
+      if (entry[i] != 0xFFU)
+      {
+        saved = 1U;
+      }
+    }
+  }
+
+  return saved;
+}
+
+/**
+  * @brief  Save the completion of a record step (SFU_DELTA_IoTypeDef callback)
+  * @param  pCtx pointer to the SFU_IMG_DeltaIoCtxTypeDef context
+  * @param  Record index of the record
+  * @param  Step SFU_DELTA_STEP_BACKED_UP or SFU_DELTA_STEP_APPLIED
+  * @retval SFU_SUCCESS if successful, SFU_ERROR otherwise.
+  */
+static SFU_ErrorStatus DeltaSaveProgress(void *pCtx, uint32_t Record, uint32_t Step)
+{
+  SFU_IMG_DeltaIoCtxTypeDef *p_ctx = (SFU_IMG_DeltaIoCtxTypeDef *)pCtx;
+
+  return DeltaSaveEntry(p_ctx->DwlSlot, DELTA_PROGRESS_STEP(Record, Step));
+}
+
+/**
+  * @brief  Verify that the FW of the active slot is the one the delta patch applies to
+  * @note   The whole FW is authenticated, before the active slot is modified. When an interrupted installation is
+  *         resumed, the progress entries are relied on instead.
+  * @param  ActiveSlot identification of the active image
+  * @param  pFwImageHeader pointer to fw header
+  * @param  pDeltaHeader pointer to the delta patch header
+  * @retval SFU_SUCCESS if successful, a SFU_ErrorStatus error otherwise.
+  */
+static SFU_ErrorStatus VerifyDeltaSource(uint32_t ActiveSlot, SE_FwRawHeaderTypeDef *pFwImageHeader,
+                                         SFU_DELTA_HeaderTypeDef *pDeltaHeader)
+{
+  SFU_ErrorStatus  e_ret_status = SFU_ERROR;
+  SE_StatusTypeDef e_se_status;
+  SE_ErrorStatus   se_ret_status;
+  uint8_t fw_chunk[SFU_IMG_CHUNK_SIZE] __attribute__((aligned(8)));
+  uint8_t fw_authenticated_chunk[SFU_IMG_CHUNK_SIZE] __attribute__((aligned(8)));
+  uint32_t fw_authenticated_chunk_size;
+  uint32_t fw_index;
+  uint32_t size;
+  uint32_t fw_tag_len;
+  uint8_t fw_tag_output[SE_TAG_LEN];
+
+  if ((pDeltaHeader->SourceFwSize + SFU_IMG_IMAGE_OFFSET) > SLOT_SIZE(ActiveSlot))
+  {
+    return e_ret_status;
+  }
+
+  se_ret_status = SE_AuthenticateFW_Init(&e_se_status, pFwImageHeader, SE_FW_IMAGE_COMPLETE);
+  e_ret_status = SFU_SUCCESS;
+  for (fw_index = 0U; (e_ret_status == SFU_SUCCESS) && (se_ret_status == SE_SUCCESS) &&
+       (fw_index < pDeltaHeader->SourceFwSize); fw_index += size)
+  {
+    (void) SFU_LL_SECU_IWDG_Refresh();
+
+    size = pDeltaHeader->SourceFwSize - fw_index;
+    if (size > SFU_IMG_CHUNK_SIZE)
+    {
+      size = SFU_IMG_CHUNK_SIZE;
+    }
+    e_ret_status = SFU_LL_FLASH_Read(fw_chunk, (uint8_t *)(SlotStartAdd[ActiveSlot] + SFU_IMG_IMAGE_OFFSET + fw_index),
+                                     size);
+    if (e_ret_status == SFU_SUCCESS)
+    {
+      fw_authenticated_chunk_size = sizeof(fw_authenticated_chunk);
+      se_ret_status = SE_AuthenticateFW_Append(&e_se_status, fw_chunk, (int32_t)size, fw_authenticated_chunk,
+                                               (int32_t *)&fw_authenticated_chunk_size);
+    }
+  }
+
+  if ((e_ret_status == SFU_SUCCESS) && (se_ret_status == SE_SUCCESS))
+  {
+    e_ret_status = SFU_ERROR;
+    fw_tag_len = sizeof(fw_tag_output);
+    se_ret_status = SE_AuthenticateFW_Finish(&e_se_status, fw_tag_output, (int32_t *)&fw_tag_len);
+    if ((se_ret_status == SE_SUCCESS) && (fw_tag_len == SE_TAG_LEN))
+    {
+      e_ret_status = MemoryCompare(fw_tag_output, pDeltaHeader->SourceFwTag, SE_TAG_LEN);
+    }
+  }
+  else
+  {
+    e_ret_status = SFU_ERROR;
+  }
+
+  return e_ret_status;
+}
+#endif /* SFU_IMG_DELTA */
+
 /**
   * @brief  Write Trailer Headers : TEST + VALID + SWAP
   * @param  DwlSlot identification of the downloaded area
@@ -364,6 +794,8 @@ static SFU_ErrorStatus VerifyFwSignatureBeforeDecrypt(uint32_t DwlSlot, SE_FwRaw
   uint32_t size;
   uint32_t fw_tag_len;
   uint8_t fw_tag_output[SE_TAG_LEN];
+  uint32_t fw_size;
+  uint8_t *p_fw_tag;
 
   /* Verify header presence */
   if ((pFwImageHeader == NULL))
@@ -371,6 +803,17 @@ static SFU_ErrorStatus VerifyFwSignatureBeforeDecrypt(uint32_t DwlSlot, SE_FwRaw
     return e_ret_status;
   }
 
+  fw_size = pFwImageHeader->FwSize;
+  p_fw_tag = pFwImageHeader->FwTag;
+#if defined(SFU_IMG_DELTA)
+  /* The delta patch is authenticated with the partial FW fields : the rebuilt FW is verified once installed */
+  if (pFwImageHeader->DeltaFwSize != 0U)
+  {
+    fw_size = pFwImageHeader->PartialFwSize;
+    p_fw_tag = pFwImageHeader->PartialFwTag;
+  }
+#endif /* SFU_IMG_DELTA */
+
   /* Decryption process initialization
      ================================= */
   se_ret_status = SE_Decrypt_Init(&e_se_status, pFwImageHeader, SE_FW_IMAGE_COMPLETE);
@@ -383,38 +826,55 @@ static SFU_ErrorStatus VerifyFwSignatureBeforeDecrypt(uint32_t DwlSlot, SE_FwRaw
     /* Skip header : no decryption needed */
     fw_index = SFU_IMG_IMAGE_OFFSET;
 
+#if defined(SFU_IMG_COMPRESSION)
+    /* The tag is computed on the decompressed FW */
+    if (pFwImageHeader->CompressedFwSize != 0U)
+    {
+      CompressedStreamInit(DwlSlot, pFwImageHeader);
+    }
+#endif /* SFU_IMG_COMPRESSION */
+
     e_ret_status = SFU_SUCCESS;
     while ((e_ret_status == SFU_SUCCESS) && (se_ret_status == SE_SUCCESS) &&
-           (fw_index < (pFwImageHeader->FwSize + SFU_IMG_IMAGE_OFFSET)))
+           (fw_index < (fw_size + SFU_IMG_IMAGE_OFFSET)))
     {
       /* Set size of reading/decryption */
       size = SFU_IMG_CHUNK_SIZE;
 
       /* Last pass ? */
-      if (((pFwImageHeader->FwSize + SFU_IMG_IMAGE_OFFSET) - fw_index) < size)
+      if (((fw_size + SFU_IMG_IMAGE_OFFSET) - fw_index) < size)
       {
         /* Default chunk size can be troncated at end of file */
-        size = pFwImageHeader->FwSize + SFU_IMG_IMAGE_OFFSET - fw_index;
+        size = fw_size + SFU_IMG_IMAGE_OFFSET - fw_index;
       }
 
       /* read then decrypt phase
        ======================= */
-      e_ret_status = SFU_LL_FLASH_Read(fw_encrypted_chunk, (uint8_t *)(SlotStartAdd[DwlSlot] + fw_index), size);
-      if (e_ret_status == SFU_SUCCESS)
+#if defined(SFU_IMG_COMPRESSION)
+      if (pFwImageHeader->CompressedFwSize != 0U)
       {
-        fw_decrypted_chunk_size = size;
-        se_ret_status = SE_Decrypt_Append(&e_se_status, fw_encrypted_chunk, (int32_t)size, fw_decrypted_chunk,
-                                          (int32_t *)&fw_decrypted_chunk_size);
-
-        if (se_ret_status == SE_SUCCESS)
+        e_ret_status = CompressedStreamRead(&e_se_status, fw_decrypted_chunk, size);
+      }
+      else
+#endif /* SFU_IMG_COMPRESSION */
+      {
+        e_ret_status = SFU_LL_FLASH_Read(fw_encrypted_chunk, (uint8_t *)(SlotStartAdd[DwlSlot] + fw_index), size);
+        if (e_ret_status == SFU_SUCCESS)
         {
+          fw_decrypted_chunk_size = size;
+          se_ret_status = SE_Decrypt_Append(&e_se_status, fw_encrypted_chunk, (int32_t)size, fw_decrypted_chunk,
+                                            (int32_t *)&fw_decrypted_chunk_size);
+        }
+      }
+
+      if ((e_ret_status == SFU_SUCCESS) && (se_ret_status == SE_SUCCESS))
+      {
 #if (SECBOOT_CRYPTO_SCHEME != SECBOOT_AES128_GCM_AES128_GCM_AES128_GCM)
-          fw_authenticated_chunk_size = sizeof(fw_authenticated_chunk);
-          se_ret_status = SE_AuthenticateFW_Append(&e_se_status, fw_decrypted_chunk, (int32_t)size,
-                                                   fw_authenticated_chunk, (int32_t *)&fw_authenticated_chunk_size);
+        fw_authenticated_chunk_size = sizeof(fw_authenticated_chunk);
+        se_ret_status = SE_AuthenticateFW_Append(&e_se_status, fw_decrypted_chunk, (int32_t)size,
+                                                 fw_authenticated_chunk, (int32_t *)&fw_authenticated_chunk_size);
 #endif /* (SECBOOT_CRYPTO_SCHEME != SECBOOT_AES128_GCM_AES128_GCM_AES128_GCM) */
-          fw_index += size;
-        }
+        fw_index += size;
       }
     }
   }
@@ -438,7 +898,7 @@ static SFU_ErrorStatus VerifyFwSignatureBeforeDecrypt(uint32_t DwlSlot, SE_FwRaw
       if ((se_ret_status == SE_SUCCESS) && (fw_tag_len == SE_TAG_LEN))
       {
         /* Firmware tag verification */
-        if (MemoryCompare(fw_tag_output, pFwImageHeader->FwTag, SE_TAG_LEN) == SFU_SUCCESS)
+        if (MemoryCompare(fw_tag_output, p_fw_tag, SE_TAG_LEN) == SFU_SUCCESS)
         {
           e_ret_status = SFU_SUCCESS;
         }
@@ -454,6 +914,176 @@ static SFU_ErrorStatus VerifyFwSignatureBeforeDecrypt(uint32_t DwlSlot, SE_FwRaw
   return e_ret_status;
 }
 
+#if defined(SFU_IMG_DELTA)
+/**
+  * @brief  Rebuild the new FW image in the active slot from its current content and the delta patch of dwl slot
+  * @note   The active slot is patched in place. The progress saved in dwl slot allows an interrupted installation to be
+  *         resumed : the records already applied are skipped, and the last page of the active slot keeps a copy of
+  *         the page being rewritten when it cannot be built again.
+  * @param  ActiveSlot identification of the active image
+  * @param  DwlSlot identification of the downloaded area
+  * @param  pFwImageHeader pointer to fw header
+  * @retval SFU_SUCCESS if successful, a SFU_ErrorStatus error otherwise.
+  */
+#if defined(__ICCARM__)
+#pragma inline=never
+#endif
+static SFU_ErrorStatus PatchImageFromDwlSlotToActiveSlot(uint32_t ActiveSlot, uint32_t DwlSlot,
+                                                         SE_FwRawHeaderTypeDef *pFwImageHeader)
+{
+  SFU_ErrorStatus  e_ret_status = SFU_ERROR;
+  SE_StatusTypeDef e_se_status;
+  SFU_IMG_DeltaIoCtxTypeDef delta_ctx;
+  SFU_DELTA_IoTypeDef delta_io;
+  SFU_DELTA_HeaderTypeDef delta_header;
+  SFU_FLASH_StatusTypeDef flash_if_status;
+  uint32_t fw_tag_len;
+  uint8_t fw_tag_output[SE_TAG_LEN];
+  uint8_t fw_header_active_slot[SE_FW_HEADER_TOT_LEN];
+  uint32_t started;
+  uint32_t applied_records = 0U;
+  uint32_t backup_valid = 0U;
+
+  /* The header is written in the first page of the slot, once this page has been rebuilt.
+     The last page of the slot is the backup page : it cannot hold FW */
+  if ((SlotHeaderAdd[ActiveSlot] != SlotStartAdd[ActiveSlot]) ||
+      ((pFwImageHeader->FwSize + SFU_IMG_IMAGE_OFFSET) > (SLOT_SIZE(ActiveSlot) - FLASH_PAGE_SIZE)))
+  {
+    return e_ret_status;
+  }
+
+  delta_ctx.pSeStatus = &e_se_status;
+  delta_ctx.ActiveSlot = ActiveSlot;
+  delta_ctx.DwlSlot = DwlSlot;
+  delta_io.ReadPatch = DeltaReadPatch;
+  delta_io.ReadSource = DeltaReadSource;
+  delta_io.WritePage = DeltaWritePage;
+  delta_io.SaveProgress = DeltaSaveProgress;
+  delta_io.pCtx = &delta_ctx;
+
+  /* Decryption process initialization
+     ================================= */
+  if (SE_Decrypt_Init(&e_se_status, pFwImageHeader, SE_FW_IMAGE_COMPLETE) == SE_SUCCESS)
+  {
+    StoredStreamInit(DwlSlot, pFwImageHeader->DeltaFwSize);
+    e_ret_status = SFU_DELTA_ReadHeader(&delta_io, &delta_header);
+  }
+
+  /* The patch must rebuild the FW described by the header, with the page size of the active slot, and leave the
+     backup page out of the FW to patch */
+  if ((e_ret_status == SFU_SUCCESS) &&
+      ((delta_header.PageSize != FLASH_PAGE_SIZE) || (delta_header.FwSize != pFwImageHeader->FwSize) ||
+       ((delta_header.SourceFwSize + SFU_IMG_IMAGE_OFFSET) > (SLOT_SIZE(ActiveSlot) - FLASH_PAGE_SIZE)) ||
+       (delta_header.NbRecords > SFU_DELTA_MAX_NB_PAGES)))
+  {
+    e_ret_status = SFU_ERROR;
+  }
+
+  /* Progress of an interrupted installation
+     ======================================= */
+  started = DeltaEntrySaved(DwlSlot, DELTA_PROGRESS_STARTED);
+  if ((e_ret_status == SFU_SUCCESS) && (started == 1U))
+  {
+    while ((applied_records < delta_header.NbRecords) &&
+           (DeltaEntrySaved(DwlSlot, DELTA_PROGRESS_STEP(applied_records, SFU_DELTA_STEP_APPLIED)) == 1U))
+    {
+      applied_records++;
+    }
+    if (applied_records < delta_header.NbRecords)
+    {
+      backup_valid = DeltaEntrySaved(DwlSlot, DELTA_PROGRESS_STEP(applied_records, SFU_DELTA_STEP_BACKED_UP));
+    }
+#if defined(SFU_VERBOSE_DEBUG_MODE)
+    TRACE("\r\n\t  Resuming the patch after %d page records.", applied_records);
+#endif /* SFU_VERBOSE_DEBUG_MODE */
+  }
+
+  /* The patch must apply to the FW of the active slot : only checked before the slot is modified
+     ============================================================================================= */
+  if ((e_ret_status == SFU_SUCCESS) && (started == 0U))
+  {
+    e_ret_status = VerifyDeltaSource(ActiveSlot, pFwImageHeader, &delta_header);
+#if defined(SFU_VERBOSE_DEBUG_MODE)
+    if (e_ret_status != SFU_SUCCESS)
+    {
+      TRACE("\r\n\t  The patch does not apply to the active FW!");
+    }
+#endif /* SFU_VERBOSE_DEBUG_MODE */
+    if (e_ret_status == SFU_SUCCESS)
+    {
+      e_ret_status = DeltaSaveEntry(DwlSlot, DELTA_PROGRESS_STARTED);
+    }
+  }
+
+  /* Page by page rebuild
+     ==================== */
+  if (e_ret_status == SFU_SUCCESS)
+  {
+    e_ret_status = SFU_DELTA_Apply(&delta_io, &delta_header, SLOT_SIZE(ActiveSlot), DeltaPage, applied_records,
+                                   backup_valid);
+#if defined(SFU_VERBOSE_DEBUG_MODE)
+    TRACE("\r\n\t  %d page records applied.", delta_header.NbRecords);
+#endif /* SFU_VERBOSE_DEBUG_MODE */
+  }
+
+  /* The backup page must be left erased, as the rest of the slot after the FW */
+  if (e_ret_status == SFU_SUCCESS)
+  {
+    e_ret_status = SFU_LL_FLASH_Erase_Size(&flash_if_status, (uint8_t *)(SlotStartAdd[ActiveSlot] +
+                                                                           SLOT_SIZE(ActiveSlot) - FLASH_PAGE_SIZE),
+                                           FLASH_PAGE_SIZE);
+    STATUS_FWIMG(e_ret_status == SFU_ERROR, SFU_IMG_FLASH_ERASE_FAILED);
+  }
+
+  /*
+   * Save the new active FW header : its area must have been erased by the patch, unless a previous run was interrupted
+   * after having written it
+   */
+  if (e_ret_status == SFU_SUCCESS)
+  {
+    e_ret_status = SFU_LL_FLASH_Read(fw_header_active_slot, (uint8_t *) SlotHeaderAdd[ActiveSlot],
+                                     sizeof(fw_header_active_slot));
+    STATUS_FWIMG(e_ret_status == SFU_ERROR, SFU_IMG_FLASH_READ_FAILED);
+  }
+  if (e_ret_status == SFU_SUCCESS)
+  {
+    if (memcmp(fw_header_active_slot, (uint8_t *) pFwImageHeader, SE_FW_AUTH_LEN) == 0)
+    {
+      /* Already written */
+    }
+    else if (SFU_LL_FLASH_Compare((uint8_t *) SlotHeaderAdd[ActiveSlot], 0x00000000U, 0xFFFFFFFFU,
+                                  SE_FW_HEADER_TOT_LEN) == SFU_SUCCESS)
+    {
+      e_ret_status = SFU_IMG_Validation(ActiveSlot, pFwImageHeader);
+      if (e_ret_status != SFU_SUCCESS)
+      {
+#if defined(SFU_VERBOSE_DEBUG_MODE)
+        TRACE("\r\n\t  Header writing failure!");
+#endif /* SFU_VERBOSE_DEBUG_MODE */
+      }
+    }
+    else
+    {
+      e_ret_status = SFU_ERROR;
+    }
+  }
+
+  if (e_ret_status == SFU_SUCCESS)
+  {
+    /* Do the Finalization */
+    fw_tag_len = sizeof(fw_tag_output);
+    if (SE_Decrypt_Finish(&e_se_status, fw_tag_output, (int32_t *)&fw_tag_len) != SE_SUCCESS)
+    {
+      e_ret_status = SFU_ERROR;
+#if defined(SFU_VERBOSE_DEBUG_MODE)
+      TRACE("\r\n\t  Decrypt fails at Finalization stage.");
+#endif /* SFU_VERBOSE_DEBUG_MODE */
+    }
+  }
+  return e_ret_status;
+}
+#endif /* SFU_IMG_DELTA */
+
 /**
   * @brief  Decrypt Image from dwl slot to active slot
   * @param  ActiveSlot identification of the active image
@@ -475,6 +1105,7 @@ static SFU_ErrorStatus DecryptImageFromDwlSlotToActiveSlot(uint32_t ActiveSlot,
   uint8_t fw_decrypted_chunk[SFU_IMG_CHUNK_SIZE] __attribute__((aligned(8)));
   uint32_t fw_index;
   uint32_t size;
+  uint32_t write_size;
   uint32_t fw_decrypted_chunk_size;
   uint32_t fw_tag_len;
   uint8_t fw_tag_output[SE_TAG_LEN];
@@ -487,6 +1118,14 @@ static SFU_ErrorStatus DecryptImageFromDwlSlotToActiveSlot(uint32_t ActiveSlot,
     return e_ret_status;
   }
 
+#if defined(SFU_IMG_DELTA)
+  /* Delta image : the active slot is patched instead of being rewritten */
+  if (pFwImageHeader->DeltaFwSize != 0U)
+  {
+    return PatchImageFromDwlSlotToActiveSlot(ActiveSlot, DwlSlot, pFwImageHeader);
+  }
+#endif /* SFU_IMG_DELTA */
+
   /* Control the firwmare size vs slot size */
   if ((pFwImageHeader->FwSize + SFU_IMG_IMAGE_OFFSET) > SLOT_SIZE(ActiveSlot))
   {
@@ -534,6 +1173,13 @@ static SFU_ErrorStatus DecryptImageFromDwlSlotToActiveSlot(uint32_t ActiveSlot,
      */
     fw_index = SFU_IMG_IMAGE_OFFSET;
 
+#if defined(SFU_IMG_COMPRESSION)
+    if (pFwImageHeader->CompressedFwSize != 0U)
+    {
+      CompressedStreamInit(DwlSlot, pFwImageHeader);
+    }
+#endif /* SFU_IMG_COMPRESSION */
+
     while ((e_ret_status == SFU_SUCCESS) && (se_ret_status == SE_SUCCESS) &&
            (fw_index < (pFwImageHeader->FwSize + SFU_IMG_IMAGE_OFFSET)))
     {
@@ -555,26 +1201,44 @@ static SFU_ErrorStatus DecryptImageFromDwlSlotToActiveSlot(uint32_t ActiveSlot,
 
       /* read then decrypt phase
        ======================= */
-      e_ret_status = SFU_LL_FLASH_Read(fw_encrypted_chunk, (uint8_t *)(SlotStartAdd[DwlSlot] + fw_index), size);
-      if (e_ret_status == SFU_SUCCESS)
+#if defined(SFU_IMG_COMPRESSION)
+      if (pFwImageHeader->CompressedFwSize != 0U)
       {
-        fw_decrypted_chunk_size = size;
-        se_ret_status = SE_Decrypt_Append(&e_se_status, fw_encrypted_chunk, (int32_t)size, fw_decrypted_chunk,
-                                          (int32_t *)&fw_decrypted_chunk_size);
+        e_ret_status = CompressedStreamRead(&e_se_status, fw_decrypted_chunk, size);
+        write_size = size;
 
-        /*
-        * writing phase
-        * =============== */
-        if (se_ret_status == SE_SUCCESS)
+        /* Last chunk : complete to the flash programming granularity */
+        while ((write_size % sizeof(SFU_LL_FLASH_write_t)) != 0U)
         {
-          /* Destination has to be in internal flash to keep confidentiality : SFU_LL_FLASH_INT_Write() */
-          e_ret_status = SFU_LL_FLASH_INT_Write(&flash_if_status, (uint8_t *)(SlotStartAdd[ActiveSlot] + fw_index),
-                                            fw_decrypted_chunk, size);
-          STATUS_FWIMG(e_ret_status == SFU_ERROR, SFU_IMG_FLASH_WRITE_FAILED);
-
-          /* Update pointer */
-          fw_index += size;
+          fw_decrypted_chunk[write_size] = 0xFFU;
+          write_size++;
+        }
+      }
+      else
+#endif /* SFU_IMG_COMPRESSION */
+      {
+        e_ret_status = SFU_LL_FLASH_Read(fw_encrypted_chunk, (uint8_t *)(SlotStartAdd[DwlSlot] + fw_index), size);
+        if (e_ret_status == SFU_SUCCESS)
+        {
+          fw_decrypted_chunk_size = size;
+          se_ret_status = SE_Decrypt_Append(&e_se_status, fw_encrypted_chunk, (int32_t)size, fw_decrypted_chunk,
+                                            (int32_t *)&fw_decrypted_chunk_size);
         }
+        write_size = size;
+      }
+
+      /*
+      * writing phase
+      * =============== */
+      if ((e_ret_status == SFU_SUCCESS) && (se_ret_status == SE_SUCCESS))
+      {
+        /* Destination has to be in internal flash to keep confidentiality : SFU_LL_FLASH_INT_Write() */
+        e_ret_status = SFU_LL_FLASH_INT_Write(&flash_if_status, (uint8_t *)(SlotStartAdd[ActiveSlot] + fw_index),
+                                              fw_decrypted_chunk, write_size);
+        STATUS_FWIMG(e_ret_status == SFU_ERROR, SFU_IMG_FLASH_WRITE_FAILED);
+
+        /* Update pointer */
+        fw_index += size;
       }
     }
   }
@@ -633,7 +1297,7 @@ static SFU_ErrorStatus InstallNewVersion(uint32_t ActiveSlot, uint32_t DwlSlot,
   /*
    * Control if there is no additional code beyond the firmware image (malicious SW)
    */
-  e_ret_status = VerifySlot((uint8_t *) SlotStartAdd[DwlSlot], SLOT_SIZE(DwlSlot), pTestHeader->FwSize);
+  e_ret_status = VerifySlot((uint8_t *) SlotStartAdd[DwlSlot], SLOT_SIZE(DwlSlot), StoredFwSize(pTestHeader));
   if (e_ret_status != SFU_SUCCESS)
   {
     SFU_EXCPT_SetError(SFU_EXCPT_ADDITIONAL_CODE_ERR);
@@ -691,11 +1355,63 @@ static SFU_ErrorStatus FirmwareToInstall(uint32_t DwlSlot, SE_FwRawHeaderTypeDef
   e_ret_status = CheckAndGetFWHeader(DwlSlot, pFwImageHeader);
   if (e_ret_status == SFU_SUCCESS)
   {
-    end_of_test_image = (SlotStartAdd[DwlSlot] + pFwImageHeader->FwSize +
+    end_of_test_image = (SlotStartAdd[DwlSlot] + StoredFwSize(pFwImageHeader) +
                          SFU_IMG_IMAGE_OFFSET);
+#if defined(SFU_IMG_DELTA)
+    /* The progress of the patch installation is saved before the trailer */
+    if (pFwImageHeader->DeltaFwSize != 0U)
+    {
+      trailer_begin = (uint32_t) DELTA_PROGRESS_BEGIN(DwlSlot);
+    }
+#endif /* SFU_IMG_DELTA */
 
+#if defined(SFU_IMG_COMPRESSION)
+    /* A compressed image always contains the complete FW */
+    if ((pFwImageHeader->CompressedFwSize != 0U) &&
+        ((pFwImageHeader->PartialFwOffset != 0U) || (pFwImageHeader->PartialFwSize != pFwImageHeader->FwSize)))
+    {
+      e_ret_status = SFU_ERROR;
+
+#if defined(SFU_VERBOSE_DEBUG_MODE)
+      TRACE("\r\n\t  A compressed image cannot be a partial image!");
+#endif /* SFU_VERBOSE_DEBUG_MODE */
+    }
+#else
+    /* A compressed image cannot be installed without the decompressor */
+    if (pFwImageHeader->CompressedFwSize != 0U)
+    {
+      e_ret_status = SFU_ERROR;
+
+#if defined(SFU_VERBOSE_DEBUG_MODE)
+      TRACE("\r\n\t  Compressed images are not supported!");
+#endif /* SFU_VERBOSE_DEBUG_MODE */
+    }
+#endif /* SFU_IMG_COMPRESSION */
+#if defined(SFU_IMG_DELTA)
+    /* The partial FW fields of a delta image describe the whole patch */
+    else if ((pFwImageHeader->DeltaFwSize != 0U) &&
+             ((pFwImageHeader->CompressedFwSize != 0U) || (pFwImageHeader->PartialFwOffset != 0U) ||
+              (pFwImageHeader->PartialFwSize != pFwImageHeader->DeltaFwSize)))
+    {
+      e_ret_status = SFU_ERROR;
+
+#if defined(SFU_VERBOSE_DEBUG_MODE)
+      TRACE("\r\n\t  Inconsistent delta image header!");
+#endif /* SFU_VERBOSE_DEBUG_MODE */
+    }
+#else
+    /* A delta image cannot be installed without the patch applier */
+    else if (pFwImageHeader->DeltaFwSize != 0U)
+    {
+      e_ret_status = SFU_ERROR;
+
+#if defined(SFU_VERBOSE_DEBUG_MODE)
+      TRACE("\r\n\t  Delta images are not supported!");
+#endif /* SFU_VERBOSE_DEBUG_MODE */
+    }
+#endif /* SFU_IMG_DELTA */
     /* Check if there is enough room for the trailers */
-    if (trailer_begin < end_of_test_image)
+    else if (trailer_begin < end_of_test_image)
     {
       /*
        * This error causes is not memorized in the BootInfo area because there won't be any error handling
@@ -803,6 +1519,7 @@ SFU_IMG_ImgInstallStateTypeDef SFU_IMG_CheckPendingInstallation(uint32_t *pDwlSl
 /**
   * @brief Resume installation : not required but present for compatibility with swap process
   *        If installation procedure is interrupted (e.g.: switch off) it will be restarted from begin at next reboot.
+  *        A delta image installation is continued from the progress saved in dwl slot.
   * @param  ActiveSlot identification of the active image
   * @param  DwlSlot identification of the downloaded area
   * @retval SFU_ErrorStatus SFU_SUCCESS
@@ -1544,6 +1544,18 @@ static SFU_ErrorStatus PrepareCandidateImageForInstall(uint32_t DwlSlot, SE_FwRa
   SFU_ErrorStatus e_ret_status = SFU_ERROR;
   SE_StatusTypeDef e_se_status;
 
+  /*
+    * Compressed and delta images can only be installed by the installation process without swap area
+    */
+  if ((pFwImageHeader->CompressedFwSize != 0U) || (pFwImageHeader->DeltaFwSize != 0U))
+  {
+#if defined(SFU_VERBOSE_DEBUG_MODE)
+    TRACE("\r\n\t  Compressed and delta images are not supported!");
+#endif /* SFU_VERBOSE_DEBUG_MODE */
+    SFU_EXCPT_SetError(SFU_EXCPT_DECRYPT_ERR);
+    return e_ret_status;
+  }
+
   /*
     * Control if there is no additional code beyond the firmware image (malicious SW)
     */
@@ -124,6 +124,9 @@ typedef uint32_t SE_FwStateTypeDef;
   * @note This structure MUST contain a field named 'PartialFwOffset'
   * @note This structure MUST contain a field named 'PartialFwSize'
   * @note This structure MUST contain a field named 'PartialFwTag' (to control intergrity of partial FW)
+  * @note This structure MUST contain a field named 'CompressedFwSize' (0 when the FW is not compressed)
+  * @note This structure MUST contain a field named 'DeltaFwSize' (0 when the FW is not a delta patch, else
+  *       'PartialFwSize' and 'PartialFwTag' describe the patch)
   * @note This structure MUST contain a field named 'HeaderSignature' (to control authentication of the header)
   * @note This structure MUST contain a field named 'FwImageState' (not part of the authentified header)
   * @note This structure MUST contain a field named 'PrevHeaderFingerprint' (not part of the authentified header)
@@ -145,7 +148,9 @@ typedef struct
   uint8_t  FwTag[SE_TAG_LEN];      /*!< Firmware Tag*/
   uint8_t  PartialFwTag[SE_TAG_LEN];/*!< Partial firmware Tag */
   uint8_t  Nonce[SE_NONCE_LEN];    /*!< Nonce used to encrypt firmware*/
-  uint8_t  Reserved[112U];         /*!< Reserved for future use: 112 extra bytes to have a header size of 192 bytes */
+  uint32_t CompressedFwSize;       /*!< Size (bytes) of the compressed firmware stored after the header, 0 if the firmware is not compressed */
+  uint32_t DeltaFwSize;            /*!< Size (bytes) of the delta patch stored after the header, 0 if the header is not followed by a delta patch */
+  uint8_t  Reserved[104U];         /*!< Reserved for future use: 104 extra bytes to have a header size of 192 bytes */
   uint8_t  HeaderSignature[SE_HEADER_SIGN_LEN]; /*!< Signature of the full header message */
   uint8_t  FwImageState[3U][32U];  /*!< Firmware image state - see SE_FwStateTypeDef for details */
   uint8_t  PrevHeaderFingerprint[SE_FW_HEADER_FINGERPRINT_LEN]; /*!< Fingerprint of previous FW header (if this is an update, else 32*0x00) */
@@ -163,7 +168,9 @@ typedef struct
   uint8_t  FwTag[SE_TAG_LEN];      /*!< Firmware Tag*/
   uint8_t  PartialFwTag[SE_TAG_LEN];/*!< Partial firmware Tag */
   uint8_t  InitVector[SE_IV_LEN];  /*!< IV used to encrypt firmware */
-  uint8_t  Reserved[28U];          /*!< Reserved for future use: 28 extra bytes to have a header size of 192 bytes */
+  uint32_t CompressedFwSize;       /*!< Size (bytes) of the compressed firmware stored after the header, 0 if the firmware is not compressed */
+  uint32_t DeltaFwSize;            /*!< Size (bytes) of the delta patch stored after the header, 0 if the header is not followed by a delta patch */
+  uint8_t  Reserved[20U];          /*!< Reserved for future use: 20 extra bytes to have a header size of 192 bytes */
   uint8_t  HeaderSignature[SE_HEADER_SIGN_LEN];  /*!< Signature of the full header message */
   uint8_t  FwImageState[3U][32U];  /*!< Firmware image state - see SE_FwStateTypeDef for details */
   uint8_t  PrevHeaderFingerprint[SE_FW_HEADER_FINGERPRINT_LEN]; /*!< Fingerprint of previous FW header (if this is an update, else 32*0x00) */
@@ -181,7 +188,9 @@ typedef struct
   uint32_t PartialFwSize;          /*!< Size of partial firmware */
   uint8_t  FwTag[SE_TAG_LEN];      /*!< Firmware Tag*/
   uint8_t  PartialFwTag[SE_TAG_LEN];/*!< Partial firmware Tag */
-  uint8_t  Reserved[44U];          /*!< Reserved for future use: 44 extra bytes to have a header size of 192 bytes */
+  uint32_t CompressedFwSize;       /*!< Size (bytes) of the compressed firmware stored after the header, 0 if the firmware is not compressed */
+  uint32_t DeltaFwSize;            /*!< Size (bytes) of the delta patch stored after the header, 0 if the header is not followed by a delta patch */
+  uint8_t  Reserved[36U];          /*!< Reserved for future use: 36 extra bytes to have a header size of 192 bytes */
   uint8_t  HeaderSignature[SE_HEADER_SIGN_LEN];  /*!< Signature of the full header message */
   uint8_t  FwImageState[3U][32U];  /*!< Firmware image state - see SE_FwStateTypeDef for details */
   uint8_t  PrevHeaderFingerprint[SE_FW_HEADER_FINGERPRINT_LEN]; /*!< Fingerprint of previous FW header (if this is an update, else 32*0x00) */
@@ -199,7 +208,9 @@ typedef struct
   uint32_t PartialFwSize;          /*!< Size of partial firmware */
   uint8_t  FwTag[SE_TAG_LEN];      /*!< Firmware Tag*/
   uint8_t  PartialFwTag[SE_TAG_LEN];/*!< Partial firmware Tag */
-  uint8_t  Reserved[44U];           /*!< Reserved for future use: 44 extra bytes to have a header size of 192 bytes*/
+  uint32_t CompressedFwSize;       /*!< Size (bytes) of the compressed firmware stored after the header, 0 if the firmware is not compressed */
+  uint32_t DeltaFwSize;            /*!< Size (bytes) of the delta patch stored after the header, 0 if the header is not followed by a delta patch */
+  uint8_t  Reserved[36U];           /*!< Reserved for future use: 36 extra bytes to have a header size of 192 bytes*/
   uint8_t  Certificates[2048U - 192U - 3U * 32U - 32U]; /*!< 2k - Header - FwImageState - PreHedareFingerprint */
   uint8_t  HeaderSignature[SE_HEADER_SIGN_LEN];  /*!< Signature of the full header message */
   uint8_t  FwImageState[3U][32U];  /*!< Firmware image state - see SE_FwStateTypeDef for details */
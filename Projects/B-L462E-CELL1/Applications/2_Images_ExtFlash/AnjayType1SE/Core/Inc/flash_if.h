@@ -40,6 +40,8 @@ HAL_StatusTypeDef FLASH_If_Init(void);
 HAL_StatusTypeDef FLASH_If_Write(void *pDestination, const void *pSource, uint32_t uLength);
 HAL_StatusTypeDef FLASH_If_Read(void *pDestination, const void *pSource, uint32_t uLength);
 HAL_StatusTypeDef FLASH_If_Erase_Size(void *pStart, uint32_t uLength);
+HAL_StatusTypeDef FLASH_If_Erase_Lazy(void *pStart, uint32_t uLength);
+HAL_StatusTypeDef FLASH_If_Erase_Lazy_Flush(void);
 HAL_StatusTypeDef FLASH_INT_Init(void);
 HAL_StatusTypeDef FLASH_INT_If_Write(void *pDestination, const void *pSource, uint32_t uLength);
 HAL_StatusTypeDef FLASH_INT_If_Read(void *pDestination, const void *pSource, uint32_t uLength);
@@ -0,0 +1,25 @@
+/*
+ * Copyright ##year## AVSystem <avsystem@avsystem.com>
+ * AVSystem Anjay LwM2M SDK
+ * ALL RIGHTS RESERVED
+ */
+
+#pragma once
+
+#include <anjay/anjay.h>
+
+/*
+ * Restores the Server and Attribute Storage objects and the registration
+ * state from the snapshot kept in flash. Shall be called after the objects
+ * are installed, but before the Anjay scheduler is first run. Returns 0 on
+ * success, or -1 if there is no valid snapshot for the current firmware and
+ * configuration; the objects are then left as they were, and a snapshot
+ * written by another firmware is erased.
+ */
+int persistence_restore(anjay_t *anjay);
+
+/*
+ * Writes a snapshot of the current client state to flash. Intended to be
+ * called right before a planned reboot.
+ */
+int persistence_store(anjay_t *anjay);
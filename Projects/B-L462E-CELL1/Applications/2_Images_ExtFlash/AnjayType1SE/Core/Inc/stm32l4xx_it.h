@@ -59,6 +59,7 @@ void EXTI15_10_IRQHandler(void);
 void TIM6_DAC_IRQHandler(void);
 void QUADSPI_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void DMA1_Channel3_IRQHandler(void);
 
 /* USER CODE END EFP */
 
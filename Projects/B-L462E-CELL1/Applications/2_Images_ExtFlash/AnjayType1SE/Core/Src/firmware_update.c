@@ -3,7 +3,11 @@
  * AVSystem Anjay LwM2M SDK
  * ALL RIGHTS RESERVED
  */
+#include <stddef.h>
+#include <string.h>
+
 #include <anjay/fw_update.h>
+#include <avsystem/commons/avs_defs.h>
 #include <avsystem/commons/avs_log.h>
 
 #define SFU_APP_NEW_IMAGE_C
@@ -39,19 +43,273 @@ static struct {
 } fw_image_dwl_area;
 static uint32_t flash_offset;
 
-static int fw_stream_open(void *user_ptr, const char *package_uri,
+/*
+ * Downloaded data is collected into whole flash pages before programming,
+ * so that each QSPI page is programmed once regardless of the size of
+ * blocks handed in by the downloader. The buffer also keeps source data
+ * aligned for the internal flash driver. It holds the bytes that directly
+ * precede flash_offset.
+ */
+#define FW_WRITE_BUFFER_SIZE 256U /*!< QSPI page size */
+
+static uint64_t write_buffer[FW_WRITE_BUFFER_SIZE / sizeof(uint64_t)];
+static uint32_t write_buffer_fill;
+
+/*
+ * Download progress journal.
+ *
+ * Kept in the erase block directly following the download slot, so that
+ * a download interrupted by a connection loss or a reboot can be resumed
+ * instead of being restarted from the first byte. The block starts with
+ * a header describing the download (Package URI and ETag), followed by an
+ * append-only log of committed offsets. A record is only appended after
+ * the data it covers has been written to the download slot; the last
+ * valid record is the resume point.
+ *
+ * A record is appended once per FW_JOURNAL_COMMIT_INTERVAL bytes rather
+ * than after every page, so that journaling adds one small program operation
+ * per 16 pages instead of doubling their number. This bounds the replay
+ * window: after a reboot, up to FW_JOURNAL_COMMIT_INTERVAL bytes past the
+ * resume point that had already been written are downloaded and programmed
+ * again. Being the same data (the ETag is checked on resume), reprogramming
+ * them leaves the NOR flash content unchanged, and the lazy erase never
+ * reaches back into the block holding the resume point.
+ *
+ * The journal outlives downloads interrupted by a connection loss. It is
+ * invalidated once the download is finished, cancelled or failed for any
+ * other reason, and overwritten when a download of another package starts.
+ */
+#define FW_JOURNAL_BLOCK_SIZE    0x10000U /*!< 64 Kbytes, one erase block */
+#define FW_JOURNAL_MAGIC         0x4C4A5746U /*!< "FWJL" */
+#define FW_JOURNAL_MAX_ETAG_SIZE 31U
+#define FW_JOURNAL_MAX_URI_SIZE  256U
+#define FW_JOURNAL_COMMIT_INTERVAL (16U * FW_WRITE_BUFFER_SIZE) /*!< 4 Kbytes */
+
+typedef struct {
+  uint32_t magic;
+  uint32_t crc;
+  uint8_t  etag_size;
+  uint8_t  etag[FW_JOURNAL_MAX_ETAG_SIZE];
+  char     uri[FW_JOURNAL_MAX_URI_SIZE];
+} fw_journal_header_t;
+
+typedef struct {
+  uint32_t offset;
+  uint32_t offset_inverted;
+} fw_journal_record_t;
+
+#define FW_JOURNAL_MAX_RECORDS \
+  ((FW_JOURNAL_BLOCK_SIZE - sizeof(fw_journal_header_t)) \
+   / sizeof(fw_journal_record_t))
+
+static fw_journal_header_t journal_header;
+static uint32_t journal_records_count;
+static bool journal_active;
+
+static uint32_t journal_header_crc(const fw_journal_header_t *header) {
+  return calculate_crc32(&header->etag_size,
+                         sizeof(*header) - offsetof(fw_journal_header_t,
+                                                    etag_size));
+}
+
+static uint32_t journal_addr(void) {
+  /* First erase block past the end of the download slot */
+  return (SlotEndAdd[SLOT_DWL_1] + FW_JOURNAL_BLOCK_SIZE)
+         & ~(FW_JOURNAL_BLOCK_SIZE - 1U);
+}
+
+static uint32_t journal_record_addr(uint32_t index) {
+  return journal_addr() + sizeof(fw_journal_header_t)
+         + index * sizeof(fw_journal_record_t);
+}
+
+static int journal_append(uint32_t offset) {
+  const fw_journal_record_t record = {
+    .offset = offset,
+    .offset_inverted = ~offset
+  };
+
+  if (FLASH_If_Write((void *) journal_record_addr(journal_records_count),
+                     &record, sizeof(record)) != HAL_OK) {
+    return -1;
+  }
+  ++journal_records_count;
+  return 0;
+}
+
+/* Erases the journal block and writes the header held in journal_header */
+static int journal_write_header(void) {
+  journal_active = false;
+  journal_records_count = 0U;
+
+  if (FLASH_If_Erase_Size((void *) journal_addr(), FW_JOURNAL_BLOCK_SIZE)
+          != HAL_OK
+      || FLASH_If_Write((void *) journal_addr(), &journal_header,
+                        sizeof(journal_header)) != HAL_OK) {
+    avs_log(fw_update, WARNING, "Could not write download journal");
+    return -1;
+  }
+  journal_active = true;
+  return 0;
+}
+
+static void journal_invalidate(void) {
+  static const uint32_t zero = 0U;
+  uint32_t magic;
+
+  journal_active = false;
+  /* Clearing the magic does not require erasing the whole block */
+  if (FLASH_If_Read(&magic, (void *) journal_addr(), sizeof(magic)) == HAL_OK
+      && magic == FW_JOURNAL_MAGIC) {
+    (void) FLASH_If_Write((void *) journal_addr(), &zero, sizeof(zero));
+  }
+}
+
+static void journal_start(const char *package_uri,
                           const struct anjay_etag *package_etag) {
-  (void)user_ptr;
-  (void)package_uri;
-  (void)package_etag;
+  size_t uri_length = package_uri ? strlen(package_uri) : 0U;
+
+  if (!package_uri || !package_etag
+      || package_etag->size > FW_JOURNAL_MAX_ETAG_SIZE
+      || uri_length >= FW_JOURNAL_MAX_URI_SIZE) {
+    avs_log(fw_update, INFO, "Download will not be resumable");
+    journal_invalidate();
+    return;
+  }
+
+  memset(&journal_header, 0, sizeof(journal_header));
+  journal_header.magic = FW_JOURNAL_MAGIC;
+  journal_header.etag_size = package_etag->size;
+  memcpy(journal_header.etag, package_etag->value, package_etag->size);
+  memcpy(journal_header.uri, package_uri, uri_length);
+  journal_header.crc = journal_header_crc(&journal_header);
+
+  (void) journal_write_header();
+}
+
+static void journal_commit(uint32_t offset) {
+  if (!journal_active) {
+    return;
+  }
+  if (journal_records_count >= FW_JOURNAL_MAX_RECORDS) {
+    /* Record log full - start over with just the header */
+    if (journal_write_header()) {
+      return;
+    }
+  }
+  if (journal_append(offset)) {
+    avs_log(fw_update, WARNING, "Could not commit download progress");
+    journal_invalidate();
+  }
+}
+
+/*
+ * Loads the journal left over by an interrupted download. Returns the last
+ * committed offset, or -1 if there is nothing to resume.
+ */
+static int32_t journal_load(void) {
+  fw_journal_record_t records[16];
+  int32_t offset = 0;
+  uint32_t index = 0U;
+
+  if (FLASH_If_Read(&journal_header, (void *) journal_addr(),
+                    sizeof(journal_header)) != HAL_OK
+      || journal_header.magic != FW_JOURNAL_MAGIC
+      || journal_header.crc != journal_header_crc(&journal_header)
+      || journal_header.etag_size > FW_JOURNAL_MAX_ETAG_SIZE
+      || journal_header.uri[FW_JOURNAL_MAX_URI_SIZE - 1U] != '\0') {
+    return -1;
+  }
+
+  while (index < FW_JOURNAL_MAX_RECORDS) {
+    uint32_t chunk = AVS_MIN(FW_JOURNAL_MAX_RECORDS - index,
+                             (uint32_t) AVS_ARRAY_SIZE(records));
+    uint32_t i;
+
+    if (FLASH_If_Read(records, (void *) journal_record_addr(index),
+                      chunk * sizeof(records[0])) != HAL_OK) {
+      return -1;
+    }
+    for (i = 0U; i < chunk; ++i) {
+      /* Erased or torn records terminate the log */
+      if (records[i].offset != ~records[i].offset_inverted
+          || records[i].offset > (uint32_t) INT32_MAX) {
+        break;
+      }
+      offset = (int32_t) records[i].offset;
+    }
+    index += i;
+    if (i < chunk) {
+      break;
+    }
+  }
+
+  journal_records_count = index;
+  journal_active = true;
+  return offset;
+}
+
+static int write_buffer_flush(void) {
+  uint8_t *buffer = (uint8_t *) write_buffer;
+  uint32_t length = write_buffer_fill;
+
+  if (!length) {
+    return 0;
+  }
+  /* Pad a partial page with the erased value to a programmable length */
+  while (length % FLASH_IF_MIN_WRITE_LEN) {
+    buffer[length++] = 0xFFU;
+  }
+  if (FLASH_If_Write((void *) (fw_image_dwl_area.download_addr + flash_offset
+                               - write_buffer_fill),
+                     buffer, length) != HAL_OK) {
+    return -1;
+  }
+  write_buffer_fill = 0U;
+  if (flash_offset % FW_JOURNAL_COMMIT_INTERVAL == 0U) {
+    journal_commit(flash_offset);
+  }
+  return 0;
+}
 
+static int write_buffer_append(const uint8_t *data, size_t length) {
+  while (length) {
+    /* The buffer always ends at the page boundary following its start */
+    uint32_t capacity = FW_WRITE_BUFFER_SIZE
+                        - (flash_offset - write_buffer_fill)
+                              % FW_WRITE_BUFFER_SIZE;
+    uint32_t chunk = AVS_MIN(capacity - write_buffer_fill, (uint32_t) length);
+
+    memcpy((uint8_t *) write_buffer + write_buffer_fill, data, chunk);
+    write_buffer_fill += chunk;
+    flash_offset += chunk;
+    data += chunk;
+    length -= chunk;
+
+    if (write_buffer_fill == capacity && write_buffer_flush()) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void init_dwl_area(void) {
   /* Get Info about the download area */
   fw_image_dwl_area.download_addr = SlotStartAdd[SLOT_DWL_1];
   fw_image_dwl_area.max_size_in_bytes = (uint32_t) SLOT_SIZE(SLOT_DWL_1);
   fw_image_dwl_area.image_offset_in_bytes = SFU_IMG_IMAGE_OFFSET;
+}
+
+static int fw_stream_open(void *user_ptr, const char *package_uri,
+                          const struct anjay_etag *package_etag) {
+  (void)user_ptr;
+
+  init_dwl_area();
 
-  /* Cleanup the memory for the firmware download */
-  if (FLASH_If_Erase_Size((void *)(fw_image_dwl_area.download_addr),
+  /* Cleanup the memory for the firmware download. Blocks are erased as the
+   * writes reach them, so that opening the stream does not stall the
+   * transfer for the few seconds a full slot erase takes. */
+  if (FLASH_If_Erase_Lazy((void *)(fw_image_dwl_area.download_addr),
                           fw_image_dwl_area.max_size_in_bytes) != HAL_OK) {
     avs_log(fw_update, INFO, "Init not successfull :(");
 
@@ -60,7 +318,11 @@ static int fw_stream_open(void *user_ptr, const char *package_uri,
 
   avs_log(fw_update, INFO, "Init successfull");
 
+  /* Only journal the download once the slot is set up to be erased */
+  journal_start(package_uri, package_etag);
+
   flash_offset = 0U;
+  write_buffer_fill = 0U;
   update_initialized = true;
 
   return 0;
@@ -71,38 +333,68 @@ static int fw_stream_write(void *user_ptr, const void *data, size_t length) {
 
   assert(update_initialized);
 
-  if (FLASH_If_Write((void *) (fw_image_dwl_area.download_addr + flash_offset),
-                     data, length) != HAL_OK) {
+  if (length > fw_image_dwl_area.max_size_in_bytes - flash_offset) {
+    avs_log(fw_update, ERROR, "Firmware image too large");
     return -1;
   }
   avs_log(fw_update, INFO, "Max size %lu bytes, downloaded %lu bytes.", fw_image_dwl_area.max_size_in_bytes, flash_offset);
 
-  flash_offset += length;
-
-  return 0;
+  return write_buffer_append((const uint8_t *) data, length);
 }
 
 static int fw_stream_finish(void *user_ptr) {
+  int result;
+
   (void)user_ptr;
 
   assert(update_initialized);
 
+  result = write_buffer_flush();
+  journal_invalidate();
+  update_initialized = false;
+
+  if (result) {
+    avs_log(fw_update, ERROR, "Could not write the last page of the image");
+    return -1;
+  }
+  /* SBSFU requires the rest of the slot to be blank */
+  if (FLASH_If_Erase_Lazy_Flush() != HAL_OK) {
+    avs_log(fw_update, ERROR, "Could not erase the rest of download slot");
+    return -1;
+  }
+
   /* Read header in download slot */
   (void) FLASH_If_Read(fw_header_dwl_slot,
                        (void *) fw_image_dwl_area.download_addr,
                        SE_FW_HEADER_TOT_LEN);
 
-  update_initialized = false;
-
   return 0;
 }
 
 static void fw_reset(void *user_ptr) {
   (void)user_ptr;
 
+  journal_invalidate();
+  write_buffer_fill = 0U;
   update_initialized = false;
 }
 
+static int fw_suspend(void *user_ptr, size_t *out_resume_offset) {
+  (void)user_ptr;
+
+  assert(update_initialized);
+
+  /* The stream stays open at the end of the last page written to flash, and
+   * the buffered bytes after it are downloaded again. The journal is kept as
+   * well, in case the device reboots before the download is resumed. */
+  flash_offset -= write_buffer_fill;
+  write_buffer_fill = 0U;
+  *out_resume_offset = flash_offset;
+  avs_log(fw_update, INFO, "Download interrupted, resumable from offset %lu",
+          (unsigned long) flash_offset);
+  return 0;
+}
+
 static int fw_perform_upgrade(void *anjay) {
   (void) anjay;
 
@@ -123,13 +415,39 @@ static const anjay_fw_update_handlers_t handlers = {
     .stream_write = fw_stream_write,
     .stream_finish = fw_stream_finish,
     .reset = fw_reset,
-    .perform_upgrade = fw_perform_upgrade};
+    .perform_upgrade = fw_perform_upgrade,
+    .suspend = fw_suspend};
 
 int fw_update_install(anjay_t *anjay) {
   anjay_fw_update_initial_state_t state = {0};
+  struct {
+    uint8_t size;
+    uint8_t value[FW_JOURNAL_MAX_ETAG_SIZE];
+  } resume_etag;
+  int32_t resume_offset;
 
   if (just_updated) {
     state.result = ANJAY_FW_UPDATE_INITIAL_SUCCESS;
+  } else if ((resume_offset = journal_load()) >= 0) {
+    /* stream_open is not called when resuming, so reopen the stream here */
+    init_dwl_area();
+    flash_offset = (uint32_t) resume_offset;
+    write_buffer_fill = 0U;
+    (void) FLASH_If_Erase_Lazy(
+        (void *) (fw_image_dwl_area.download_addr + flash_offset),
+        fw_image_dwl_area.max_size_in_bytes - flash_offset);
+    update_initialized = true;
+
+    resume_etag.size = journal_header.etag_size;
+    memcpy(resume_etag.value, journal_header.etag, journal_header.etag_size);
+
+    state.result = ANJAY_FW_UPDATE_INITIAL_DOWNLOADING;
+    state.persisted_uri = journal_header.uri;
+    state.resume_offset = flash_offset;
+    state.resume_etag = (const struct anjay_etag *) &resume_etag;
+
+    avs_log(fw_update, INFO, "Resuming download of %s from offset %lu",
+            journal_header.uri, (unsigned long) flash_offset);
   }
 
   return anjay_fw_update_install(anjay, &handlers, anjay, &state);
@@ -141,6 +459,9 @@ bool fw_update_requested(void) { return update_requested; }
 
 void fw_update_reboot(void) {
   avs_log(fota, INFO, "Rebooting to perform a firmware upgrade...");
+#ifdef AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+  avs_log_deferred_flush();
+#endif // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
   HAL_Delay(1000U);
   NVIC_SystemReset();
 }
@@ -53,11 +53,21 @@
 
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
-
+/* Area registered with FLASH_If_Erase_Lazy(): [erased_end, end) still has to
+   be erased before it is written to. In external flash, the erase of the unit
+   right before erased_end may still be in progress */
+static struct
+{
+  uint32_t erased_end;
+  uint32_t end;
+} lazy_erase;
 
 /* Private function prototypes -----------------------------------------------*/
 static uint32_t GetPage(uint32_t uAddr);
 static HAL_StatusTypeDef FLASH_INT_If_Clear_Error(void);
+static uint32_t GetEraseUnit(uint32_t uAddr);
+static HAL_StatusTypeDef FLASH_If_Lazy_Erase_Up_To(uint32_t uEnd);
+static void FLASH_If_Lazy_Erase_Ahead(uint32_t uWriteEnd);
 
 /* Public functions : wrapper ---------------------------------------------------------*/
 
@@ -96,6 +106,40 @@ HAL_StatusTypeDef FLASH_If_Erase_Size(void *pStart, uint32_t uLength)
   }
 }
 
+/**
+  * @brief  Registers an area to be erased lazily, one erase unit at a time,
+  *         right before FLASH_If_Write() first reaches each unit.
+  * @note   If pStart is not aligned to an erase unit, the unit containing it
+  *         is assumed to be already erased up to pStart and partially written
+  *         (e.g. when resuming an interrupted download).
+  * @note   In external flash, the erase of the next unit is started in the
+  *         background as soon as the previous one is reached by a write, so
+  *         that it overlaps with receiving the data that is written next.
+  * @param  pStart: flash address of the area
+  * @param  uLength: number of bytes
+  * @retval HAL status.
+  */
+HAL_StatusTypeDef FLASH_If_Erase_Lazy(void *pStart, uint32_t uLength)
+{
+  uint32_t unit = GetEraseUnit((uint32_t) pStart);
+
+  lazy_erase.erased_end = ((uint32_t) pStart + unit - 1U) & ~(unit - 1U);
+  lazy_erase.end = (uint32_t) pStart + uLength;
+  FLASH_If_Lazy_Erase_Ahead((uint32_t) pStart);
+  return HAL_OK;
+}
+
+/**
+  * @brief  Erases the part of the lazily erased area that has not been written
+  *         to, so that the whole area is in a well defined state.
+  * @param  none
+  * @retval HAL status.
+  */
+HAL_StatusTypeDef FLASH_If_Erase_Lazy_Flush(void)
+{
+  return FLASH_If_Lazy_Erase_Up_To(lazy_erase.end);
+}
+
 /**
   * @brief  Depending on destination address, this function will call internal or external (OSPI/QSPI) flash driver
   * @param  pDestination: flash address to write
@@ -105,15 +149,31 @@ HAL_StatusTypeDef FLASH_If_Erase_Size(void *pStart, uint32_t uLength)
   */
 HAL_StatusTypeDef FLASH_If_Write(void *pDestination, const void *pSource, uint32_t uLength)
 {
+  HAL_StatusTypeDef e_ret_status;
+  uint32_t in_lazy_area = ((uint32_t) pDestination < lazy_erase.end);
+
+  /* Erase the units of a lazily erased area this write is about to reach */
+  if (in_lazy_area
+      && (FLASH_If_Lazy_Erase_Up_To((uint32_t) pDestination + uLength) != HAL_OK))
+  {
+    return HAL_ERROR;
+  }
+
   /* Check Flash destination address */
   if ((uint32_t) pDestination < EXTERNAL_FLASH_ADDRESS)
   {
-    return FLASH_INT_If_Write(pDestination, pSource, uLength);
+    e_ret_status = FLASH_INT_If_Write(pDestination, pSource, uLength);
   }
   else
   {
-    return FLASH_EXT_If_Write(pDestination, pSource, uLength);
+    e_ret_status = FLASH_EXT_If_Write(pDestination, pSource, uLength);
+  }
+
+  if (in_lazy_area && (e_ret_status == HAL_OK))
+  {
+    FLASH_If_Lazy_Erase_Ahead((uint32_t) pDestination + uLength);
   }
+  return e_ret_status;
 }
 
 /**
@@ -366,6 +426,12 @@ HAL_StatusTypeDef FLASH_EXT_If_Write(void  *pDestination, const void *pSource, u
     return HAL_ERROR;
   }
 
+  /* the memory ignores the write enable command while a block erase started
+     by FLASH_If_Lazy_Erase_Ahead() is in progress */
+  while (BSP_QSPI_GetStatus() !=  BSP_ERROR_NONE)
+  {
+  }
+
   /* flash address to write is the offset from begin of external flash */
   if (BSP_QSPI_Write((uint8_t *) pSource, (uint32_t) pDestination - EXTERNAL_FLASH_ADDRESS, uLength) != BSP_ERROR_NONE)
   {
@@ -442,6 +508,70 @@ HAL_StatusTypeDef FLASH_INT_If_Clear_Error(void)
   return ret;
 }
 
+/**
+  * @brief  Gets the erase granularity at a given address
+  * @param  uAddr: Address of the FLASH Memory
+  * @retval Size of the smallest erasable unit, in bytes
+  */
+static uint32_t GetEraseUnit(uint32_t uAddr)
+{
+  return (uAddr < EXTERNAL_FLASH_ADDRESS) ? FLASH_PAGE_SIZE : ERASE_BLOC_SIZE;
+}
+
+/**
+  * @brief  Makes sure the lazily erased area is erased up to a given address
+  * @param  uEnd: end address (exclusive) of the range that has to be erased
+  * @retval HAL Status.
+  */
+static HAL_StatusTypeDef FLASH_If_Lazy_Erase_Up_To(uint32_t uEnd)
+{
+  HAL_StatusTypeDef e_ret_status = HAL_OK;
+  uint32_t unit;
+
+  if (uEnd > lazy_erase.end)
+  {
+    uEnd = lazy_erase.end;
+  }
+  if (uEnd > lazy_erase.erased_end)
+  {
+    unit = GetEraseUnit(lazy_erase.erased_end);
+    uEnd = (uEnd + unit - 1U) & ~(unit - 1U);
+    e_ret_status = FLASH_If_Erase_Size((void *) lazy_erase.erased_end, uEnd - lazy_erase.erased_end);
+    if (e_ret_status == HAL_OK)
+    {
+      lazy_erase.erased_end = uEnd;
+    }
+  }
+  return e_ret_status;
+}
+
+/**
+  * @brief  Starts erasing the next unit of the lazily erased area in external
+  *         flash, if a write has just reached the last unit already erased.
+  *         Completion is waited for before the next operation on the memory.
+  * @param  uWriteEnd: end address (exclusive) of the last write
+  * @retval None
+  */
+static void FLASH_If_Lazy_Erase_Ahead(uint32_t uWriteEnd)
+{
+  uint32_t next = lazy_erase.erased_end;
+
+  if ((next < EXTERNAL_FLASH_ADDRESS) || (next >= lazy_erase.end)
+      || (uWriteEnd + ERASE_BLOC_SIZE <= next))
+  {
+    return;
+  }
+  /* the previous erase, if any, has to be completed before a new one */
+  while (BSP_QSPI_GetStatus() !=  BSP_ERROR_NONE)
+  {
+  }
+  /* on failure, the unit is erased synchronously once a write reaches it */
+  if (BSP_QSPI_StartEraseBlock64K(next - EXTERNAL_FLASH_ADDRESS) == BSP_ERROR_NONE)
+  {
+    lazy_erase.erased_end = next + ERASE_BLOC_SIZE;
+  }
+}
+
 /**
   * @brief  Gets the page of a given address
   * @param  uAddr: Address of the FLASH Memory
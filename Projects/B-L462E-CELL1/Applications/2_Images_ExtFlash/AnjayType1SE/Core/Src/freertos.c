@@ -37,6 +37,7 @@
 #include "lwm2m.h"
 
 #include "firmware_update.h"
+#include "persistence.h"
 
 #include "stdio.h"
 /* USER CODE END Includes */
@@ -49,6 +50,7 @@
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 #define IWDG_KEY_RELOAD 0x0000AAAAu
+#define LOG_FLUSH_SIGNAL 0x01
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -58,7 +60,12 @@
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN Variables */
-
+#ifdef AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+#define LOG_FLUSH_THREAD_STACK_SIZE 512
+osThreadId logFlushTaskHandle;
+static uint32_t logFlushTaskBuffer[LOG_FLUSH_THREAD_STACK_SIZE];
+static osStaticThreadDef_t logFlushTaskControlBlock;
+#endif // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
 /* USER CODE END Variables */
 osThreadId keepAliveTaskHandle;
 
@@ -71,10 +78,28 @@ log_handler(avs_log_level_t level, const char *module, const char *message) {
     traceIF_uartPrintForce(DBG_CHAN_APPLICATION, (uint8_t *) "\r\n", 2);
 }
 
+#ifdef AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+// Formats and prints messages recorded by avs_log, so that the UART output
+// does not slow down the threads that log them
+static void log_flush_thread(void const *argument) {
+    (void) argument;
+    while (true) {
+        osSignalWait(LOG_FLUSH_SIGNAL, osWaitForever);
+        avs_log_deferred_flush();
+    }
+}
+
+// Called by avs_log for every recorded message; may run in an ISR
+static void log_flush_notify(void) {
+    (void) osSignalSet(logFlushTaskHandle, LOG_FLUSH_SIGNAL);
+}
+#endif // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+
 static void maybe_reboot_for_upgrade(avs_sched_t *sched, const void *data) {
-    (void) data;
+    anjay_t *anjay = *(anjay_t *const *) data;
 
     if (fw_update_requested()) {
+        (void) persistence_store(anjay);
         fw_update_reboot();
         return;
     } else {
@@ -86,7 +111,7 @@ static void maybe_reboot_for_upgrade(avs_sched_t *sched, const void *data) {
             }
         };
         AVS_SCHED_DELAYED(sched, NULL, avs_time_real_diff(next_full_second, now),
-                          maybe_reboot_for_upgrade, NULL, NULL);
+                          maybe_reboot_for_upgrade, &anjay, sizeof(anjay));
     }
 }
 
@@ -104,7 +129,7 @@ static int setup_firmware_update_object(anjay_t *anjay) {
     };
 
     AVS_SCHED_DELAYED(anjay_get_scheduler(anjay), NULL, avs_time_real_diff(next_full_second, now),
-                      maybe_reboot_for_upgrade, NULL, NULL);
+                      maybe_reboot_for_upgrade, &anjay, sizeof(anjay));
 
     return 0;
 }
@@ -164,12 +189,23 @@ void MX_FREERTOS_Init(void) {
   keepAliveTaskHandle = osThreadCreate(osThread(keepAliveTask), NULL);
 
   /* USER CODE BEGIN RTOS_THREADS */
+#ifdef AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+  osThreadStaticDef(logFlushTask, log_flush_thread, osPriorityLow, 0,
+                    LOG_FLUSH_THREAD_STACK_SIZE, logFlushTaskBuffer,
+                    &logFlushTaskControlBlock);
+  logFlushTaskHandle = osThreadCreate(osThread(logFlushTask), NULL);
+  avs_log_set_deferred_notify(log_flush_notify);
+  /* flush whatever has been logged before the thread was created */
+  (void) osSignalSet(logFlushTaskHandle, LOG_FLUSH_SIGNAL);
+#endif // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
   cellular_init();
   anjay_t *anjay = lwm2m_init();
+  (void) persistence_restore(anjay);
   setup_firmware_update_object(anjay);
 
   cellular_start();
   lwm2m_start();
+  lwm2m_notify_start(NULL);
   /* USER CODE END RTOS_THREADS */
 
 }
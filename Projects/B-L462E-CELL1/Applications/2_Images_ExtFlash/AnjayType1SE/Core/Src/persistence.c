@@ -0,0 +1,232 @@
+/*
+ * Copyright ##year## AVSystem <avsystem@avsystem.com>
+ * AVSystem Anjay LwM2M SDK
+ * ALL RIGHTS RESERVED
+ */
+#include <stddef.h>
+#include <string.h>
+
+#include <anjay/attr_storage.h>
+#include <anjay/core.h>
+#include <anjay/server.h>
+#include <avsystem/commons/avs_log.h>
+#include <avsystem/commons/avs_memory.h>
+#include <avsystem/commons/avs_stream_inbuf.h>
+#include <avsystem/commons/avs_stream_membuf.h>
+
+#include "flash_if.h"
+#include "se_def.h"
+#include "se_interface_application.h"
+#include "sfu_fwimg_regions.h"
+#include "stm32l4xx_hal.h"
+
+#if defined(__CC_ARM) || defined(__ARMCC_VERSION)
+#include "mapping_fwimg.h"
+#include "mapping_sbsfu.h"
+#elif defined(__ICCARM__) || defined(__GNUC__)
+#include "mapping_export.h"
+#endif /* __CC_ARM || __ARMCC_VERSION */
+
+#include "anjay_client_config.h"
+#include "persistence.h"
+#include "utils.h"
+
+/*
+ * Client state snapshot.
+ *
+ * Kept in the second erase block past the end of the download slot; the
+ * first one holds the download journal (see firmware_update.c). The block
+ * starts with a header, followed by the Server and Attribute Storage object
+ * state and the registration state, each serialized by the respective Anjay
+ * persistence API. Restoring the registration state allows the client to
+ * confirm the previous registration with an Update after a reboot, instead
+ * of performing a Register.
+ *
+ * The QSPI flash is not protected against reading, so nothing secret is
+ * stored there: the Security object, which holds the PSK, is always taken
+ * from the compiled-in configuration, and the DTLS session (with its master
+ * secret) is not persisted, so a full handshake is performed after a reboot.
+ *
+ * The snapshot is only written before planned reboots, so that the block
+ * is not worn out by periodic writes. After an unexpected reset, the last
+ * snapshot is still used; if the registration has gone stale in the
+ * meantime, the server rejects the Update and the client falls back to a
+ * regular Register.
+ *
+ * A snapshot is only valid for the firmware and client configuration that
+ * wrote it: the header holds a fingerprint of both, and a snapshot with a
+ * different one is ignored, so that a new server URI is not overridden by
+ * the stored objects. The PSK is left out of the fingerprint, which would
+ * otherwise leak information about it.
+ */
+#define PERSISTENCE_BLOCK_SIZE 0x10000U /*!< 64 Kbytes, one erase block */
+#define PERSISTENCE_MAGIC      0x54534341U /*!< "ACST" */
+
+typedef struct {
+  uint32_t magic;
+  uint32_t crc;         /*!< CRC-32 of the snapshot data */
+  uint32_t length;      /*!< Snapshot data length in bytes */
+  uint32_t fingerprint; /*!< See persistence_fingerprint() */
+} persistence_header_t;
+
+#define PERSISTENCE_MAX_DATA_SIZE \
+  (PERSISTENCE_BLOCK_SIZE - sizeof(persistence_header_t))
+
+static uint32_t persistence_addr(void) {
+  /* Second erase block past the end of the download slot */
+  return ((SlotEndAdd[SLOT_DWL_1] + PERSISTENCE_BLOCK_SIZE)
+          & ~(PERSISTENCE_BLOCK_SIZE - 1U))
+         + PERSISTENCE_BLOCK_SIZE;
+}
+
+/* CRC-32 of the active firmware identification and client configuration */
+static uint32_t persistence_fingerprint(void) {
+  static const char config[] = ANJAY_CLIENT_CONFIG_ENDPOINT_NAME "\n"
+                               ANJAY_CLIENT_CONFIG_SERVER_URI "\n"
+                               ANJAY_CLIENT_CONFIG_PSK_IDENTITY;
+  SE_StatusTypeDef se_status;
+  SE_APP_ActiveFwInfo_t fw_info;
+  struct {
+    uint32_t config_crc;
+    uint32_t fw_size;
+    uint32_t fw_version;
+  } fingerprint;
+
+  if (SE_APP_GetActiveFwInfo(&se_status, SLOT_ACTIVE_1, &fw_info)
+      != SE_SUCCESS) {
+    memset(&fw_info, 0, sizeof(fw_info));
+  }
+  fingerprint.config_crc = calculate_crc32(config, sizeof(config) - 1U);
+  fingerprint.fw_size = fw_info.ActiveFwSize;
+  fingerprint.fw_version = fw_info.ActiveFwVersion;
+  return calculate_crc32(&fingerprint, sizeof(fingerprint));
+}
+
+/* Serializes the objects that persistence_restore() may modify */
+static avs_error_t persist_objects(anjay_t *anjay, avs_stream_t *stream) {
+  avs_error_t err;
+
+  (void) (avs_is_err((err = anjay_server_object_persist(anjay, stream)))
+          || avs_is_err((err = anjay_attr_storage_persist(anjay, stream))));
+  return err;
+}
+
+static avs_error_t restore_objects(anjay_t *anjay, avs_stream_t *stream) {
+  avs_error_t err;
+
+  (void) (avs_is_err((err = anjay_server_object_restore(anjay, stream)))
+          || avs_is_err((err = anjay_attr_storage_restore(anjay, stream))));
+  return err;
+}
+
+int persistence_restore(anjay_t *anjay) {
+  persistence_header_t header;
+  void *data;
+  avs_stream_inbuf_t stream = AVS_STREAM_INBUF_STATIC_INITIALIZER;
+  avs_stream_t *backup;
+  avs_error_t err;
+
+  if (FLASH_If_Read(&header, (void *) persistence_addr(), sizeof(header))
+          != HAL_OK
+      || header.magic != PERSISTENCE_MAGIC
+      || header.length > PERSISTENCE_MAX_DATA_SIZE) {
+    avs_log(persistence, INFO, "No client state snapshot in flash");
+    return -1;
+  }
+  if (header.fingerprint != persistence_fingerprint()) {
+    /* Also gets rid of snapshots written by older firmware, which included
+     * the Security object and the DTLS session */
+    avs_log(persistence, INFO,
+            "Client state snapshot was written by another firmware or "
+            "configuration, erasing it");
+    (void) FLASH_If_Erase_Size((void *) persistence_addr(),
+                               PERSISTENCE_BLOCK_SIZE);
+    return -1;
+  }
+  if (!(data = avs_malloc(header.length))) {
+    avs_log(persistence, ERROR, "Out of memory");
+    return -1;
+  }
+  if (FLASH_If_Read(data, (void *) (persistence_addr() + sizeof(header)),
+                    header.length) != HAL_OK
+      || calculate_crc32(data, header.length) != header.crc) {
+    avs_log(persistence, WARNING, "Client state snapshot is corrupted");
+    avs_free(data);
+    return -1;
+  }
+
+  /* Each object is restored on its own: the current (default) state is kept
+   * aside, so that the client is not left with only some of the objects
+   * restored if a later step fails */
+  if (!(backup = avs_stream_membuf_create())
+      || avs_is_err(persist_objects(anjay, backup))) {
+    avs_log(persistence, ERROR, "Could not back up client state");
+    avs_stream_cleanup(&backup);
+    avs_free(data);
+    return -1;
+  }
+
+  avs_stream_inbuf_set_buffer(&stream, data, header.length);
+  (void) (avs_is_err((err = restore_objects(anjay, (avs_stream_t *) &stream)))
+          || avs_is_err((err = anjay_registration_state_restore(
+                             anjay, (avs_stream_t *) &stream))));
+  avs_free(data);
+  if (avs_is_err(err)) {
+    avs_log(persistence, WARNING, "Could not restore client state");
+    if (avs_is_err(restore_objects(anjay, backup))) {
+      avs_log(persistence, ERROR, "Could not roll back client state");
+    }
+  } else {
+    avs_log(persistence, INFO, "Client state restored");
+  }
+  avs_stream_cleanup(&backup);
+  return avs_is_err(err) ? -1 : 0;
+}
+
+int persistence_store(anjay_t *anjay) {
+  persistence_header_t header;
+  avs_stream_t *stream;
+  void *data = NULL;
+  size_t length = 0;
+  avs_error_t err;
+  int result = -1;
+
+  if (!(stream = avs_stream_membuf_create())) {
+    avs_log(persistence, ERROR, "Out of memory");
+    return -1;
+  }
+  (void) (avs_is_err((err = persist_objects(anjay, stream)))
+          || avs_is_err((err = anjay_registration_state_persist(anjay, stream)))
+          || avs_is_err((err = avs_stream_membuf_take_ownership(stream, &data,
+                                                                &length))));
+  avs_stream_cleanup(&stream);
+  if (avs_is_err(err) || length > PERSISTENCE_MAX_DATA_SIZE) {
+    avs_log(persistence, WARNING, "Could not serialize client state");
+    goto finish;
+  }
+
+  memset(&header, 0, sizeof(header));
+  header.magic = PERSISTENCE_MAGIC;
+  header.crc = calculate_crc32(data, length);
+  header.length = (uint32_t) length;
+  header.fingerprint = persistence_fingerprint();
+
+  /* The data is written before the header, so that an interrupted write
+   * leaves no valid header behind */
+  if (FLASH_If_Erase_Size((void *) persistence_addr(), PERSISTENCE_BLOCK_SIZE)
+          != HAL_OK
+      || FLASH_If_Write((void *) (persistence_addr() + sizeof(header)), data,
+                        (uint32_t) length) != HAL_OK
+      || FLASH_If_Write((void *) persistence_addr(), &header, sizeof(header))
+             != HAL_OK) {
+    avs_log(persistence, WARNING, "Could not write client state snapshot");
+    goto finish;
+  }
+  avs_log(persistence, INFO, "Client state snapshot written (%lu bytes)",
+          (unsigned long) length);
+  result = 0;
+
+finish:
+  avs_free(data);
+  return result;
+}
@@ -22,6 +22,7 @@
 #include "stm32l4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "plf_ipc_config.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -62,6 +63,9 @@ extern UART_HandleTypeDef huart3;
 extern TIM_HandleTypeDef htim6;
 
 /* USER CODE BEGIN EV */
+#if (IPC_USE_DMA_RX == 1U)
+extern DMA_HandleTypeDef hdma_usart3_rx;
+#endif /* IPC_USE_DMA_RX == 1U */
 
 /* USER CODE END EV */
 
@@ -249,5 +253,14 @@ void QUADSPI_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+#if (IPC_USE_DMA_RX == 1U)
+/**
+  * @brief This function handles DMA1 channel3 global interrupt (USART3 RX).
+  */
+void DMA1_Channel3_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_usart3_rx);
+}
+#endif /* IPC_USE_DMA_RX == 1U */
 
 /* USER CODE END 1 */
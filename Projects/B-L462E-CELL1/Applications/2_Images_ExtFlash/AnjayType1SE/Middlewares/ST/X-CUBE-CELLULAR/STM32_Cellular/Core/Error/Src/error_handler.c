@@ -19,6 +19,8 @@
 /* Includes ------------------------------------------------------------------*/
 #include "error_handler.h"
 #include "plf_config.h"
+/* for AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE and avs_log_deferred_flush() */
+#include <avsystem/commons/avs_log.h>
 
 /* Private macros ------------------------------------------------------------*/
 #if (USE_TRACE_ERROR_HANDLER == 1U)
@@ -105,6 +107,10 @@ void ERROR_Handler(dbg_channels_t chan, int32_t errorId, error_gravity_t gravity
   /* endless loop if error is fatal */
   if (gravity == ERROR_FATAL)
   {
+#if defined(AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE)
+    /* print the messages still waiting in the deferred log buffer */
+    avs_log_deferred_flush();
+#endif /* defined(AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE) */
     HAL_Delay(1000U);
     NVIC_SystemReset();
     /* Infinite loop is done in NVIC_SystemReset(); */
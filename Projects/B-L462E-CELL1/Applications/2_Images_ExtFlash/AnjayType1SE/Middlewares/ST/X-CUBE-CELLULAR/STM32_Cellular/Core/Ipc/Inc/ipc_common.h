@@ -36,6 +36,8 @@ extern "C" {
 * - IPC_RXBUF_THRESHOLD: if free space in RX queue is < to this value, the interface (UART,..) will be paused
 *   until enough free space (ie previous msg have been read)
 * - IPC_USE_UART: set to 1 is IPC uses UART (ONLY UART IS SUPPORTED ACTUALLY)
+* - IPC_USE_DMA_RX: (optional) set to 1 to receive from the UART with circular DMA and idle line detection
+* - IPC_RXDMA_BUFSIZE: size of the circular RX DMA buffer, needed only if IPC_USE_DMA_RX is set to 1
 * - IPC_USE_SPI: 0
 * - IPC_USE_I2C: 0
 * - DBG_IPC_RX_FIFO: set to 1 for additional debug information
@@ -43,6 +45,14 @@ extern "C" {
 
 /* Exported constants --------------------------------------------------------*/
 
+#if !defined(IPC_USE_DMA_RX)
+#define IPC_USE_DMA_RX (0U)
+#endif /* !defined(IPC_USE_DMA_RX) */
+
+#if (IPC_USE_DMA_RX == 1U) && !defined(IPC_RXDMA_BUFSIZE)
+#define IPC_RXDMA_BUFSIZE ((uint16_t) 256U)
+#endif /* (IPC_USE_DMA_RX == 1U) && !defined(IPC_RXDMA_BUFSIZE) */
+
 #if (USER_DEFINED_IPC_MAX_DEVICES != 0)
 #define IPC_MAX_DEVICES  ((uint8_t) USER_DEFINED_IPC_MAX_DEVICES)
 #else
@@ -81,6 +91,7 @@ typedef struct
 {
   uint32_t          total_RXchar;
   uint32_t          cpt_RXPause;
+  uint32_t          cpt_RXOverflow; /* characters dropped because the queue was full */
   uint32_t          free_bytes;
   dbg_msg_info_t    msg_info_queue[DBG_QUEUE_SIZE];
   uint16_t          queue_pos;
@@ -207,6 +218,10 @@ typedef struct
   IPC_State_t              state;
   IPC_PhysicalInterface_t  phy_int;
   IPC_CHAR_t               RxChar[1];    /* RX DMA buffer (1 char) - common buffer for one physical interface  */
+#if (IPC_USE_DMA_RX == 1U)
+  IPC_CHAR_t               RxDmaBuf[IPC_RXDMA_BUFSIZE]; /* RX circular DMA buffer - common for one physical interface */
+  uint16_t                 RxDmaPos;     /* position in RxDmaBuf up to which received data has been processed */
+#endif /* IPC_USE_DMA_RX == 1U */
   IPC_Handle_t             *h_current_channel;   /* current active IPC channel */
   IPC_Handle_t             *h_inactive_channel;  /* other IPC channel (exists if not NULL), currently not active */
 } IPC_ClientDescription_t;
@@ -38,6 +38,7 @@ extern "C" {
 /* Exported functions ------------------------------------------------------- */
 void IPC_RXFIFO_init(IPC_Handle_t *const hipc);
 void IPC_RXFIFO_writeCharacter(IPC_Handle_t *const hipc, uint8_t rxChar);
+void IPC_RXFIFO_writeCharacters(IPC_Handle_t *const hipc, const uint8_t *pData, uint16_t size);
 int16_t IPC_RXFIFO_read(IPC_Handle_t *const hipc, IPC_RxMessage_t *pMsg);
 #if (IPC_USE_STREAM_MODE == 1U)
 void IPC_RXFIFO_stream_init(IPC_Handle_t *const hipc);
@@ -59,6 +59,9 @@ void IPC_UART_DumpRXQueue(const IPC_Handle_t *const hipc, uint8_t readable);
 void IPC_UART_RxCpltCallback(UART_HandleTypeDef *UartHandle);
 void IPC_UART_TxCpltCallback(UART_HandleTypeDef *UartHandle);
 void IPC_UART_ErrorCallback(UART_HandleTypeDef *UartHandle);
+#if (IPC_USE_DMA_RX == 1U)
+void IPC_UART_RxEventCallback(UART_HandleTypeDef *UartHandle, uint16_t Size);
+#endif /* IPC_USE_DMA_RX == 1U */
 
 #ifdef __cplusplus
 }
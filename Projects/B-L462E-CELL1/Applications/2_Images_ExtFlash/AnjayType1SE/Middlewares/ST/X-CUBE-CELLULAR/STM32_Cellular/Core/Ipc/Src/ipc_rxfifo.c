@@ -66,7 +66,9 @@
 
 /* Private function prototypes -----------------------------------------------*/
 static void RXFIFO_incrementTail(IPC_Handle_t *const hipc, uint16_t inc_size);
-static void RXFIFO_incrementHead(IPC_Handle_t *const hipc);
+static void RXFIFO_incrementHead(IPC_Handle_t *const hipc, uint16_t inc_size);
+static void RXFIFO_writeData(IPC_Handle_t *const hipc, const uint8_t *pData, uint16_t size);
+static void RXFIFO_completeMsg(IPC_Handle_t *const hipc);
 static void RXFIFO_updateMsgHeader(IPC_Handle_t *const hipc);
 static void RXFIFO_prepareNextMsgHeader(IPC_Handle_t *const hipc);
 static void RXFIFO_rearm_RX_IT(IPC_Handle_t *const hipc);
@@ -90,6 +92,7 @@ void IPC_RXFIFO_init(IPC_Handle_t *const hipc)
   /* init debug infos */
   hipc->dbgRxQueue.total_RXchar = 0U;
   hipc->dbgRxQueue.cpt_RXPause = 0U;
+  hipc->dbgRxQueue.cpt_RXOverflow = 0U;
   hipc->dbgRxQueue.free_bytes = IPC_RXBUF_MAXSIZE;
   hipc->dbgRxQueue.queue_pos = 0U;
   hipc->dbgRxQueue.msg_info_queue[0].start_pos = hipc->RxQueue.index_read;
@@ -118,7 +121,7 @@ void IPC_RXFIFO_writeCharacter(IPC_Handle_t *const hipc, uint8_t rxChar)
     hipc->dbgRxQueue.msg_info_queue[hipc->dbgRxQueue.queue_pos].size = hipc->RxQueue.current_msg_size;
 #endif /* DBG_IPC_RX_FIFO == 1U */
 
-    RXFIFO_incrementHead(hipc);
+    RXFIFO_incrementHead(hipc, 1U);
 
     if (hipc->State != IPC_STATE_PAUSED)
     {
@@ -129,22 +132,43 @@ void IPC_RXFIFO_writeCharacter(IPC_Handle_t *const hipc, uint8_t rxChar)
     /* check if the char received is an end of message */
     if ((*hipc->CheckEndOfMsgCallback)(rxChar) == 1U)
     {
-      hipc->RxQueue.nb_unread_msg++;
-
-      /* update header for message received */
-      RXFIFO_updateMsgHeader(hipc);
-
-      /* save start position of next message */
-      hipc->RxQueue.current_msg_index = hipc->RxQueue.index_write;
-
-      /* reset current msg size */
-      hipc->RxQueue.current_msg_size = 0U;
+      RXFIFO_completeMsg(hipc);
+    }
+  }
+}
 
-      /* reserve place for next msg header */
-      RXFIFO_prepareNextMsgHeader(hipc);
+/**
+  * @brief  Write a block of characters in the IPC RX FIFO.
+  * @note   This function is called by UART callback when a chunk of data has been received by DMA.
+  * @note   It is used in IPC normal mode (signalling/socket). Characters are copied to the FIFO in runs
+  *         ending at each end of message, instead of one by one.
+  * @param  hipc IPC handle.
+  * @param  pData characters to write.
+  * @param  size number of characters to write.
+  * @retval none.
+  */
+void IPC_RXFIFO_writeCharacters(IPC_Handle_t *const hipc, const uint8_t *pData, uint16_t size)
+{
+  uint16_t idx;
+  uint16_t run_start = 0U;
+  uint8_t end_of_msg;
 
-      /* msg received: call client callback */
-      (* hipc->RxClientCallback)((IPC_Handle_t *)hipc);
+  if (hipc != NULL)
+  {
+    for (idx = 0U; idx < size; idx++)
+    {
+      end_of_msg = (*hipc->CheckEndOfMsgCallback)(pData[idx]);
+      if ((end_of_msg == 1U) || (idx == (size - 1U)))
+      {
+        RXFIFO_writeData(hipc, &pData[run_start], idx + 1U - run_start);
+        run_start = idx + 1U;
+
+        /* the header of the next message needs room too, if there is none the message is dropped */
+        if ((end_of_msg == 1U) && (IPC_RXFIFO_getFreeBytes(hipc) >= IPC_RXMSG_HEADER_SIZE))
+        {
+          RXFIFO_completeMsg(hipc);
+        }
+      }
     }
   }
 }
@@ -449,13 +473,14 @@ static void RXFIFO_incrementTail(IPC_Handle_t *const hipc, uint16_t inc_size)
 /**
   * @brief  Increment IPC RX FIFO Head for next message Header.
   * @param  hipc IPC handle.
+  * @param  inc_size Size to increment.
   * @retval none.
   */
-static void RXFIFO_incrementHead(IPC_Handle_t *const hipc)
+static void RXFIFO_incrementHead(IPC_Handle_t *const hipc, uint16_t inc_size)
 {
   uint16_t free_bytes;
 
-  hipc->RxQueue.index_write = (hipc->RxQueue.index_write + 1U) % IPC_RXBUF_MAXSIZE;
+  hipc->RxQueue.index_write = (hipc->RxQueue.index_write + inc_size) % IPC_RXBUF_MAXSIZE;
   free_bytes = IPC_RXFIFO_getFreeBytes(hipc);
 
 #if (DBG_IPC_RX_FIFO == 1U)
@@ -472,6 +497,90 @@ static void RXFIFO_incrementHead(IPC_Handle_t *const hipc)
   }
 }
 
+/**
+  * @brief  Append data to the current message in IPC RX FIFO.
+  * @param  hipc IPC handle.
+  * @param  pData data to append.
+  * @param  size size of data to append.
+  * @retval none.
+  */
+static void RXFIFO_writeData(IPC_Handle_t *const hipc, const uint8_t *pData, uint16_t size)
+{
+  uint16_t first_part = IPC_RXBUF_MAXSIZE - hipc->RxQueue.index_write;
+  uint16_t free_bytes = IPC_RXFIFO_getFreeBytes(hipc);
+  uint16_t write_size = size;
+
+  /* never overwrite unread messages and keep room for the header of the next message:
+   * characters that do not fit are dropped
+   */
+  if (free_bytes <= IPC_RXMSG_HEADER_SIZE)
+  {
+    write_size = 0U;
+  }
+  else if (write_size > (free_bytes - IPC_RXMSG_HEADER_SIZE))
+  {
+    write_size = free_bytes - IPC_RXMSG_HEADER_SIZE;
+  }
+  else
+  {
+    /* enough space for all data */
+  }
+
+#if (DBG_IPC_RX_FIFO == 1U)
+  hipc->dbgRxQueue.cpt_RXOverflow += (uint32_t)size - (uint32_t)write_size;
+#endif /* DBG_IPC_RX_FIFO == 1U */
+
+  if (write_size > 0U)
+  {
+    if (write_size > first_part)
+    {
+      /* data is split in 2 parts in the circular buffer */
+      (void) memcpy((void *) & (hipc->RxQueue.data[hipc->RxQueue.index_write]), (const void *)pData,
+                    (size_t) first_part);
+      (void) memcpy((void *) & (hipc->RxQueue.data[0]), (const void *) &pData[first_part],
+                    (size_t)(write_size - first_part));
+    }
+    else
+    {
+      (void) memcpy((void *) & (hipc->RxQueue.data[hipc->RxQueue.index_write]), (const void *)pData,
+                    (size_t) write_size);
+    }
+
+    hipc->RxQueue.current_msg_size += write_size;
+
+#if (DBG_IPC_RX_FIFO == 1U)
+    hipc->dbgRxQueue.msg_info_queue[hipc->dbgRxQueue.queue_pos].size = hipc->RxQueue.current_msg_size;
+#endif /* DBG_IPC_RX_FIFO == 1U */
+
+    RXFIFO_incrementHead(hipc, write_size);
+  }
+}
+
+/**
+  * @brief  Close current message and notify the client.
+  * @param  hipc IPC handle.
+  * @retval none.
+  */
+static void RXFIFO_completeMsg(IPC_Handle_t *const hipc)
+{
+  hipc->RxQueue.nb_unread_msg++;
+
+  /* update header for message received */
+  RXFIFO_updateMsgHeader(hipc);
+
+  /* save start position of next message */
+  hipc->RxQueue.current_msg_index = hipc->RxQueue.index_write;
+
+  /* reset current msg size */
+  hipc->RxQueue.current_msg_size = 0U;
+
+  /* reserve place for next msg header */
+  RXFIFO_prepareNextMsgHeader(hipc);
+
+  /* msg received: call client callback */
+  (* hipc->RxClientCallback)((IPC_Handle_t *)hipc);
+}
+
 /**
   * @brief  Update current message Header.
   * @param  hipc IPC handle.
@@ -515,7 +624,7 @@ static void RXFIFO_prepareNextMsgHeader(IPC_Handle_t *const hipc)
   {
     /* clean data and increment head */
     hipc->RxQueue.data[hipc->RxQueue.index_write] = 0U;
-    RXFIFO_incrementHead(hipc);
+    RXFIFO_incrementHead(hipc, 1U);
   }
 }
 
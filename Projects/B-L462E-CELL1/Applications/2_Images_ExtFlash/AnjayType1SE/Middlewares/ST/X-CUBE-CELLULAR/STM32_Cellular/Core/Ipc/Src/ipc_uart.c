@@ -65,6 +65,11 @@ static uint8_t find_Device_Id(const UART_HandleTypeDef *huart);
 static IPC_Status_t change_ipc_channel(IPC_Handle_t *const hipc);
 static void set_rearm_error(void);
 static void check_UART_rearm_RX_IT(IPC_Handle_t *const hipc);
+static HAL_StatusTypeDef start_RX(UART_HandleTypeDef *huart, uint8_t device_id);
+#if (IPC_USE_DMA_RX == 1U)
+static void write_DMA_chunk(uint8_t device_id, uint16_t start, uint16_t end);
+static void process_DMA_data(uint8_t device_id, uint16_t dma_pos);
+#endif /* IPC_USE_DMA_RX == 1U */
 
 /* Functions Definition ------------------------------------------------------*/
 /**
@@ -219,10 +224,10 @@ IPC_Status_t IPC_UART_open(IPC_Handle_t *const hipc,
 #endif /* IPC_USE_STREAM_MODE == 1U */
 
     /* start RX IT */
-    uart_status = HAL_UART_Receive_IT(hipc->Interface.h_uart, (uint8_t *)IPC_DevicesList[device].RxChar, 1U);
+    uart_status = start_RX(hipc->Interface.h_uart, (uint8_t)device);
     if (uart_status != HAL_OK)
     {
-      PRINT_DBG("HAL_UART_Receive_IT error")
+      PRINT_DBG("HAL_UART_Receive error")
       retval = IPC_ERROR;
     }
     else
@@ -336,7 +341,7 @@ IPC_Status_t IPC_UART_reset(IPC_Handle_t *const hipc)
 
     /* rearm IT */
     HAL_StatusTypeDef uart_status;
-    uart_status = HAL_UART_Receive_IT(hipc->Interface.h_uart, (uint8_t *)IPC_DevicesList[device_id].RxChar, 1U);
+    uart_status = start_RX(hipc->Interface.h_uart, device_id);
     if (uart_status != HAL_OK)
     {
       set_rearm_error();
@@ -481,17 +486,24 @@ IPC_Status_t IPC_UART_receive(IPC_Handle_t *const hipc, IPC_RxMessage_t *const p
         PRINT_DBG("free bytes after msg read=%d", free_bytes)
 #endif /* DBG_IPC_RX_FIFO == 1U */
 
+#if (IPC_USE_DMA_RX == 1U)
+        /* up to a whole DMA buffer can be received before reception is stopped again,
+         * resume only when there is enough space for it
+         */
+        if ((hipc->State == IPC_STATE_PAUSED) && (IPC_RXFIFO_getFreeBytes(hipc) > IPC_RXBUF_THRESHOLD))
+#else
         if (hipc->State == IPC_STATE_PAUSED)
+#endif /* IPC_USE_DMA_RX == 1U */
         {
 #if (DBG_IPC_RX_FIFO == 1U)
           /* dump_RX_dbg_infos(hipc, 1, 1); */
-          PRINT_INFO("Resume IPC (paused %d times) %d unread msg", hipc->dbgRxQueue.cpt_RXPause, unread_msg_size)
+          PRINT_INFO("Resume IPC (paused %d times, %d chars dropped) %d unread msg", hipc->dbgRxQueue.cpt_RXPause,
+                     hipc->dbgRxQueue.cpt_RXOverflow, unread_msg_size)
 #endif /* DBG_IPC_RX_FIFO == 1U */
 
           hipc->State = IPC_STATE_ACTIVE;
           HAL_StatusTypeDef uart_status;
-          uart_status = HAL_UART_Receive_IT(hipc->Interface.h_uart,
-                                            (uint8_t *)IPC_DevicesList[hipc->Device_ID].RxChar, 1U);
+          uart_status = start_RX(hipc->Interface.h_uart, hipc->Device_ID);
           if (uart_status != HAL_OK)
           {
             set_rearm_error();
@@ -587,7 +599,7 @@ void IPC_UART_rearm_RX_IT(IPC_Handle_t *const hipc)
     if (hipc->Interface.interface_type == IPC_INTERFACE_UART)
     {
       HAL_StatusTypeDef uart_status;
-      uart_status = HAL_UART_Receive_IT(hipc->Interface.h_uart, (uint8_t *)IPC_DevicesList[hipc->Device_ID].RxChar, 1U);
+      uart_status = start_RX(hipc->Interface.h_uart, hipc->Device_ID);
       if (uart_status != HAL_OK)
       {
         set_rearm_error();
@@ -681,6 +693,38 @@ void IPC_UART_RxCpltCallback(UART_HandleTypeDef *UartHandle)
   }
 }
 
+#if (IPC_USE_DMA_RX == 1U)
+/**
+  * @brief  IPC uart RX event callback (called under IT !).
+  * @note   Called by HAL on DMA half transfer, DMA transfer complete and UART idle line.
+  * @param  UartHandle Ptr to the HAL UART handle.
+  * @param  Size Position in the RX DMA buffer up to which data has been received.
+  * @retval none
+  */
+void IPC_UART_RxEventCallback(UART_HandleTypeDef *UartHandle, uint16_t Size)
+{
+  /* Warning ! this function is called under IT */
+  uint8_t device_id = find_Device_Id(UartHandle);
+  if (device_id < IPC_MAX_DEVICES)
+  {
+    if (IPC_DevicesList[device_id].h_current_channel != NULL)
+    {
+      process_DMA_data(device_id, Size);
+
+      if (IPC_DevicesList[device_id].h_current_channel->State == IPC_STATE_PAUSED)
+      {
+        /* RX queue almost full: stop reception until messages are read (see IPC_UART_receive)
+         * and write in the queue the characters received in the meantime
+         */
+        (void)HAL_UART_AbortReceive(UartHandle);
+        process_DMA_data(device_id,
+                         IPC_RXDMA_BUFSIZE - (uint16_t)__HAL_DMA_GET_COUNTER(UartHandle->hdmarx));
+      }
+    }
+  }
+}
+#endif /* IPC_USE_DMA_RX == 1U */
+
 /**
   * @brief  IPC uart TX callback (called under IT !).
   * @param  UartHandle Ptr to the HAL UART handle.
@@ -804,8 +848,7 @@ static void check_UART_rearm_RX_IT(IPC_Handle_t *const hipc)
       if (error_during_rearm_RX_IT == 1U)
       {
         HAL_StatusTypeDef uart_status;
-        uart_status = HAL_UART_Receive_IT(hipc->Interface.h_uart,
-                                          (uint8_t *)IPC_DevicesList[hipc->Device_ID].RxChar, 1U);
+        uart_status = start_RX(hipc->Interface.h_uart, hipc->Device_ID);
         if (uart_status == HAL_OK)
         {
           /* clear the error if the IT was successfully rearmed */
@@ -820,3 +863,84 @@ static void check_UART_rearm_RX_IT(IPC_Handle_t *const hipc)
   }
 }
 
+/**
+  * brief  Start reception on an UART.
+  * param  huart Handle to the HAL UART structure.
+  * param  device_id IPC device identifier.
+  * retval HAL status
+  */
+static HAL_StatusTypeDef start_RX(UART_HandleTypeDef *huart, uint8_t device_id)
+{
+  HAL_StatusTypeDef uart_status;
+
+#if (IPC_USE_DMA_RX == 1U)
+  if (huart->RxState == HAL_UART_STATE_BUSY_RX)
+  {
+    /* circular DMA reception is still running, nothing to rearm */
+    uart_status = HAL_OK;
+  }
+  else
+  {
+    IPC_DevicesList[device_id].RxDmaPos = 0U;
+    uart_status = HAL_UARTEx_ReceiveToIdle_DMA(huart, (uint8_t *)IPC_DevicesList[device_id].RxDmaBuf,
+                                               IPC_RXDMA_BUFSIZE);
+  }
+#else
+  uart_status = HAL_UART_Receive_IT(huart, (uint8_t *)IPC_DevicesList[device_id].RxChar, 1U);
+#endif /* IPC_USE_DMA_RX == 1U */
+
+  return (uart_status);
+}
+
+#if (IPC_USE_DMA_RX == 1U)
+/**
+  * brief  Write to the RX queue a chunk of the RX DMA buffer.
+  * param  device_id IPC device identifier.
+  * param  start Position of the first character in the RX DMA buffer.
+  * param  end Position following the last character in the RX DMA buffer.
+  * retval none
+  */
+static void write_DMA_chunk(uint8_t device_id, uint16_t start, uint16_t end)
+{
+  IPC_Handle_t *hipc = IPC_DevicesList[device_id].h_current_channel;
+
+  if (end > start)
+  {
+    if (hipc->Mode == IPC_MODE_UART_CHARACTER)
+    {
+      IPC_RXFIFO_writeCharacters(hipc, (const uint8_t *)&IPC_DevicesList[device_id].RxDmaBuf[start], end - start);
+    }
+    else
+    {
+      for (uint16_t idx = start; idx < end; idx++)
+      {
+        hipc->RxFifoWrite(hipc, (uint8_t)IPC_DevicesList[device_id].RxDmaBuf[idx]);
+      }
+    }
+  }
+}
+
+/**
+  * brief  Write to the RX queue the characters received by DMA since last call.
+  * param  device_id IPC device identifier.
+  * param  dma_pos Position in the RX DMA buffer up to which data has been received.
+  * retval none
+  */
+static void process_DMA_data(uint8_t device_id, uint16_t dma_pos)
+{
+  uint16_t start = IPC_DevicesList[device_id].RxDmaPos;
+  uint16_t end = (dma_pos > IPC_RXDMA_BUFSIZE) ? IPC_RXDMA_BUFSIZE : dma_pos;
+
+  if (end < start)
+  {
+    /* DMA buffer is circular: received data wraps around the end of the buffer */
+    write_DMA_chunk(device_id, start, IPC_RXDMA_BUFSIZE);
+    start = 0U;
+  }
+  write_DMA_chunk(device_id, start, end);
+
+  /* restart from the beginning once the end of the buffer has been reached */
+  IPC_DevicesList[device_id].RxDmaPos = (end == IPC_RXDMA_BUFSIZE) ? 0U : end;
+}
+#endif /* IPC_USE_DMA_RX == 1U */
+
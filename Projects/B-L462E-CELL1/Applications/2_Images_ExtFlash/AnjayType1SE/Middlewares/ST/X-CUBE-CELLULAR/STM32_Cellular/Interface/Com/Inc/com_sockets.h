@@ -192,6 +192,15 @@ extern "C" {
   * @{
   */
 
+/**
+  * @brief  Data ready callback
+  * @note   Called when data is received on a socket or when the remote host closes it,
+  *         the next com_recv/com_recvfrom on this socket will not block
+  * @param  sock      - socket handle obtained with com_socket
+  * @param  p_ctx     - context provided at the callback registration
+  */
+typedef void (* com_sockets_data_ready_cb_t)(int32_t sock, void *p_ctx);
+
 /**
   * @}
   */
@@ -449,6 +458,17 @@ int32_t com_getpeername(int32_t sock,
   */
 int32_t com_getsockname(int32_t sock,
                         com_sockaddr_t *name, int32_t *namelen);
+
+/**
+  * @brief  Data ready callback registration
+  * @note   Register the callback called, from the COM internal context, when data is received
+  *         on any socket; only one callback can be registered, NULL unregisters it
+  * @note   NOT SUPPORTED when USE_SOCKETS_TYPE = USE_SOCKETS_LWIP (use lwip_poll)
+  * @param  cb        - callback to register or NULL
+  * @param  p_ctx     - context provided to the callback
+  * @retval int32_t   - ok or error value
+  */
+int32_t com_set_data_ready_cb(com_sockets_data_ready_cb_t cb, void *p_ctx);
 /**
   * @}
   */
@@ -33,6 +33,7 @@ extern "C" {
 
 #include "com_common.h"
 #include "com_sockets_addr_compat.h"
+#include "com_sockets.h"
 
 /* Exported constants --------------------------------------------------------*/
 
@@ -340,6 +341,16 @@ int32_t com_getpeername_ip_modem(int32_t sock,
 int32_t com_getsockname_ip_modem(int32_t sock,
                                  com_sockaddr_t *name, int32_t *namelen);
 
+/**
+  * @brief  Data ready callback registration
+  * @note   Register the callback called when data is received on any socket
+  *         or when a socket is closed by the remote host
+  * @param  cb        - callback to register or NULL
+  * @param  p_ctx     - context provided to the callback
+  * @retval int32_t   - ok or error value
+  */
+int32_t com_set_data_ready_cb_ip_modem(com_sockets_data_ready_cb_t cb, void *p_ctx);
+
 /**
   * @}
   */
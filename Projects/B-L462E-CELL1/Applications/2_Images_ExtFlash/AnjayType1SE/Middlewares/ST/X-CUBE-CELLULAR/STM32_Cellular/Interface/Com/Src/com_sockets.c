@@ -406,6 +406,30 @@ int32_t com_getsockname(int32_t sock,
   return (result);
 }
 
+/**
+  * @brief  Data ready callback registration
+  * @note   Register the callback called, from the COM internal context, when data is received
+  *         on any socket; only one callback can be registered, NULL unregisters it
+  * @note   NOT SUPPORTED when USE_SOCKETS_TYPE = USE_SOCKETS_LWIP (use lwip_poll)
+  * @param  cb        - callback to register or NULL
+  * @param  p_ctx     - context provided to the callback
+  * @retval int32_t   - ok or error value
+  */
+int32_t com_set_data_ready_cb(com_sockets_data_ready_cb_t cb, void *p_ctx)
+{
+  int32_t result;
+
+#if (USE_SOCKETS_TYPE == USE_SOCKETS_MODEM)
+  result = com_set_data_ready_cb_ip_modem(cb, p_ctx);
+#else
+  UNUSED(cb);
+  UNUSED(p_ctx);
+  result = COM_SOCKETS_ERR_UNSUPPORTED;
+#endif /* USE_SOCKETS_TYPE == USE_SOCKETS_MODEM */
+
+  return (result);
+}
+
 
 /*** Ping functionalities *****************************************************/
 
@@ -168,6 +168,10 @@ static int32_t ping_socket_id; /* Ping socket id */
 /* Network status is managed through Datacache */
 static bool com_sockets_network_is_up;
 
+/* Application callback called when data is received on a socket */
+static com_sockets_data_ready_cb_t com_data_ready_cb;
+static void *p_com_data_ready_ctx;
+
 #if (USE_LOW_POWER == 1)
 /* Timer to check inactivity on socket and maybe to go in data idle mode */
 static osTimerId ComTimerInactivityId;
@@ -943,10 +947,19 @@ static void com_ip_modem_data_received_cb(socket_handle_t sock)
         PRINT_DBG("cb socket %ld MSGput %lu queue %p", p_socket_desc->id, msg_queue, p_socket_desc->queue)
         (void)rtosalMessageQueuePut(p_socket_desc->queue, msg_queue, 0U);
       }
-      else
+      else if (com_data_ready_cb == NULL)
       {
         PRINT_INFO("cb socket data ready called: socket_state:%i NOK", p_socket_desc->state)
       }
+      else
+      {
+        /* Nobody is waiting on the socket: data will be read on application request */
+      }
+      /* Application informed whatever the socket state, e.g to stop waiting before to call com_recv */
+      if (com_data_ready_cb != NULL)
+      {
+        com_data_ready_cb(p_socket_desc->id, p_com_data_ready_ctx);
+      }
     }
     else
     {
@@ -993,6 +1006,11 @@ static void com_ip_modem_closing_cb(socket_handle_t sock)
       PRINT_DBG("cb socket %ld MSGput %lu queue %p", p_socket_desc->id, msg_queue, p_socket_desc->queue)
       (void)rtosalMessageQueuePut(p_socket_desc->queue, msg_queue, 0U);
     }
+    /* Next com_recv will report the closing: application must not wait for data anymore */
+    if (com_data_ready_cb != NULL)
+    {
+      com_data_ready_cb(p_socket_desc->id, p_com_data_ready_ctx);
+    }
   }
   else
   {
@@ -2632,6 +2650,24 @@ int32_t com_getsockname_ip_modem(int32_t sock, com_sockaddr_t *name, int32_t *na
   return (COM_SOCKETS_ERR_UNSUPPORTED);
 }
 
+/**
+  * @brief  Data ready callback registration
+  * @note   Register the callback called when data is received on any socket
+  *         or when a socket is closed by the remote host
+  * @param  cb        - callback to register or NULL
+  * @param  p_ctx     - context provided to the callback
+  * @retval int32_t   - ok or error value
+  */
+int32_t com_set_data_ready_cb_ip_modem(com_sockets_data_ready_cb_t cb, void *p_ctx)
+{
+  (void)rtosalMutexAcquire(ComSocketsMutexHandle, RTOSAL_WAIT_FOREVER);
+  com_data_ready_cb = cb;
+  p_com_data_ready_ctx = p_ctx;
+  (void)rtosalMutexRelease(ComSocketsMutexHandle);
+
+  return (COM_SOCKETS_ERR_OK);
+}
+
 
 /*** Ping functionalities *****************************************************/
 
@@ -2932,6 +2968,10 @@ bool com_init_ip_modem(void)
   /* Inititalize Network status */
   com_sockets_network_is_up = false; /* Network status update by Datacache see com_socket_datacache_cb() */
 
+  /* No application callback registered */
+  com_data_ready_cb = NULL;
+  p_com_data_ready_ctx = NULL;
+
 #if (USE_COM_PING == 1)
   ping_socket_id = COM_SOCKET_INVALID_ID;
 #endif /* USE_COM_PING == 1 */
@@ -95,14 +95,48 @@
   */
 
 
+/** @defgroup AT_CUSTOM_ALTAIR_T1SC_SOCKET_Private_Variables AT_CUSTOM ALTAIR_T1SC SOCKET Private Variables
+  * @{
+  */
+
+/* ASCII digit of each nibble value (lower case, as expected by the modem) */
+static const uint8_t hex_digits[16] =
+{
+  (uint8_t)'0', (uint8_t)'1', (uint8_t)'2', (uint8_t)'3', (uint8_t)'4', (uint8_t)'5', (uint8_t)'6', (uint8_t)'7',
+  (uint8_t)'8', (uint8_t)'9', (uint8_t)'a', (uint8_t)'b', (uint8_t)'c', (uint8_t)'d', (uint8_t)'e', (uint8_t)'f'
+};
+
+/* nibble value of each ASCII character, 0xFF if the character is not an hexadecimal digit */
+static const uint8_t hex_values[256] =
+{
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0x00U, 0x01U, 0x02U, 0x03U, 0x04U, 0x05U, 0x06U, 0x07U, 0x08U, 0x09U, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0x0AU, 0x0BU, 0x0CU, 0x0DU, 0x0EU, 0x0FU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0x0AU, 0x0BU, 0x0CU, 0x0DU, 0x0EU, 0x0FU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU,
+  0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU
+};
+
+/**
+  * @}
+  */
+
 /** @defgroup AT_CUSTOM_ALTAIR_T1SC_SOCKET_Private_Functions_Prototypes
   *  AT_CUSTOM ALTAIR_T1SC SOCKET Private Functions Prototypes
   * @{
   */
-static uint8_t convertToASCII(uint8_t nbr);
-static void convertCharToHEX(uint8_t val, uint8_t *p_msd, uint8_t *p_lsd);
-static at_status_t convertDigitToValue(uint8_t digit, uint8_t *res);
-static at_status_t convertHEXToChar(uint8_t MSD, uint8_t LSD, uint8_t *res);
+static void encodeHEX(const uint8_t *p_src, uint16_t size, uint8_t *p_dst);
+static at_status_t decodeHEX(const uint8_t *p_src, uint16_t size, uint8_t *p_dst);
 /**
   * @}
   */
@@ -434,25 +468,13 @@ at_status_t fCmdBuild_SOCKETDATA_SEND(atparser_context_t *p_atp_ctxt, atcustom_m
                      socketID,
                      str_size);
 
-      /* now copy the buffer */
+      /* now convert the buffer directly in the command parameters
+       * each char is converted to its hexadecimal value (example 'A' is converted to '41') - ASCII
+       */
       uint16_t cmd_params_size = (uint16_t) strlen((CRC_CHAR_t *)&p_atp_ctxt->current_atcmd.params);
-      for (uint16_t idx = 0U; idx < str_size; idx++)
-      {
-        /* char by char */
-        uint8_t onechar = p_modem_ctxt->SID_ctxt.socketSendData_struct.p_buffer_addr_send[idx];
-        PRINT_DBG("[ %c -> HEX= %2x / DEC= %2d]", onechar, onechar, onechar)
-
-        /* convert this char to its hexadecimal value (example 'A' is converted to '65') - ASCII */
-        uint8_t ms;
-        uint8_t ls;
-        convertCharToHEX(onechar, &ms, &ls);
-        (void) memcpy((void *) &p_atp_ctxt->current_atcmd.params[cmd_params_size + (2U * idx)],
-                      (const CS_CHAR_t *)&ms,
-                      1);
-        (void) memcpy((void *) &p_atp_ctxt->current_atcmd.params[cmd_params_size + (1U + (2U * idx))],
-                      (const CS_CHAR_t *)&ls,
-                      1);
-      }
+      encodeHEX((const uint8_t *)p_modem_ctxt->SID_ctxt.socketSendData_struct.p_buffer_addr_send,
+                str_size,
+                (uint8_t *)&p_atp_ctxt->current_atcmd.params[cmd_params_size]);
 
       /* Don't use strlen for next instruction due to data buffer */
       cmd_params_size += (2U * str_size);
@@ -892,29 +914,19 @@ at_action_rsp_t fRspAnalyze_SOCKETDATA(at_context_t *p_at_ctxt, atcustom_modem_c
       /* check that received data size does not exceed client buffer size */
       if (data_size <= p_modem_ctxt->socket_ctxt.socketReceivedata.max_buffer_size)
       {
-        uint16_t idx;
-        for (idx = 0U; ((idx < data_size) && (retval != ATACTION_RSP_ERROR)); idx++)
+        /* convert received buffer from HEX to ASCII format, directly from the IPC message to client buffer
+        * example: if we receive 48545450, take digits 2 by 2 and convert them
+        *          to their hexa value
+        *           => 48 = 0x48 = H
+        *           => 54 = 0x54 = T
+        *           => 54 = 0x54 = T
+        *           => 50 = 0x50 = P
+        */
+        if (decodeHEX((const uint8_t *)&p_msg_in->buffer[element_infos->str_start_idx + 1U],
+                      data_size,
+                      (uint8_t *)p_modem_ctxt->socket_ctxt.socketReceivedata.p_buffer_addr_rcv) != ATSTATUS_OK)
         {
-          /* convert received buffer from HEX to ASCII format
-          * example: if we receive 48545450, take digits 2 by 2 and convert them
-          *          to their hexa value
-          *           => 48 = 0x48 = H
-          *           => 54 = 0x54 = T
-          *           => 54 = 0x54 = T
-          *           => 50 = 0x50 = P
-          */
-          uint8_t conVal;
-          if (convertHEXToChar((uint8_t)p_msg_in->buffer[element_infos->str_start_idx + 1U + (idx * 2U)],
-                               (uint8_t)p_msg_in->buffer[element_infos->str_start_idx + 2U + (idx * 2U)],
-                               &conVal) == ATSTATUS_OK)
-          {
-            /* recopy data to client buffer */
-            p_modem_ctxt->socket_ctxt.socketReceivedata.p_buffer_addr_rcv[idx] = conVal;
-          }
-          else
-          {
-            retval = ATACTION_RSP_ERROR;
-          }
+          retval = ATACTION_RSP_ERROR;
         }
 
         /* finally, update buffer client size */
@@ -1235,101 +1247,82 @@ void clear_ping_resp_struct(atcustom_modem_context_t *p_modem_ctxt)
   */
 
 /**
-  * @brief  Convert a number to its ASCII value.
-  * @param  nbr Number to convert.
-  * @retval corresponding ASCII value.
+  * @brief  Convert a buffer to its HEX representation
+  *         for example 'A' is converted to '41'. Output is not null terminated.
+  * @note   4 characters are converted per loop iteration, without any branch.
+  * @param  p_src ptr to buffer to convert.
+  * @param  size size of buffer to convert.
+  * @param  p_dst ptr to HEX output (size of 2 * size).
+  * @retval none.
   */
-static uint8_t convertToASCII(uint8_t nbr)
+static void encodeHEX(const uint8_t *p_src, uint16_t size, uint8_t *p_dst)
 {
-  uint8_t ascii;
+  uint16_t idx = 0U;
 
-  if (nbr <= 9U)
+  for (; (idx + 4U) <= size; idx += 4U)
   {
-    ascii = nbr + 48U;
+    uint8_t *p_out = &p_dst[2U * idx];
+    p_out[0] = hex_digits[p_src[idx] >> 4];
+    p_out[1] = hex_digits[p_src[idx] & 0x0FU];
+    p_out[2] = hex_digits[p_src[idx + 1U] >> 4];
+    p_out[3] = hex_digits[p_src[idx + 1U] & 0x0FU];
+    p_out[4] = hex_digits[p_src[idx + 2U] >> 4];
+    p_out[5] = hex_digits[p_src[idx + 2U] & 0x0FU];
+    p_out[6] = hex_digits[p_src[idx + 3U] >> 4];
+    p_out[7] = hex_digits[p_src[idx + 3U] & 0x0FU];
   }
-  else
+
+  for (; idx < size; idx++)
   {
-    ascii = nbr + 87U; /* 87 = 97 -10 (where 97 correspond to 'a') */
+    p_dst[2U * idx] = hex_digits[p_src[idx] >> 4];
+    p_dst[(2U * idx) + 1U] = hex_digits[p_src[idx] & 0x0FU];
   }
-  return (ascii);
-}
-
-/**
-  * @brief  Convert a character to its HEX value
-  *         for example 'A' is converted to '65' where msd='6' and lsd='5'
-  * @param  val Character to convert.
-  * @param  p_msb ptr to Most significant Digit of HEX value
-  * @param  p_lsb ptr to Less significant Digit of HEX value
-  * @retval none.
-  */
-static void convertCharToHEX(uint8_t val, uint8_t *p_msd, uint8_t *p_lsd)
-{
-  *p_msd = convertToASCII(val / 16U);
-  *p_lsd = convertToASCII(val % 16U);
 }
 
 /**
-  * @brief  Convert an hexa number (from 0 to F) to its ASCII value
-  * @param  digit Value to convert.
-  * @param  p_res ptr to converted value.
+  * @brief  Convert a HEX string to its Char values
+  *         for example '41' is converted to 'A'. Upper and lower case digits are accepted.
+  * @note   4 characters are converted per loop iteration. Invalid digits are accumulated
+  *         and checked only once at the end of the conversion.
+  * @param  p_src ptr to HEX string to convert (size of 2 * size).
+  * @param  size number of characters to produce.
+  * @param  p_dst ptr to converted characters.
   * @retval at_status_t.
   */
-static at_status_t convertDigitToValue(uint8_t digit, uint8_t *p_res)
+static at_status_t decodeHEX(const uint8_t *p_src, uint16_t size, uint8_t *p_dst)
 {
   at_status_t retval = ATSTATUS_OK;
+  uint16_t idx = 0U;
+  uint8_t invalid = 0U;
 
-  if ((digit >= 48U) && (digit <= 57U))
+  for (; (idx + 4U) <= size; idx += 4U)
   {
-    /* 0 to 9 */
-    *p_res = digit - 48U;
+    const uint8_t *p_in = &p_src[2U * idx];
+    uint8_t v0 = hex_values[p_in[0]];
+    uint8_t v1 = hex_values[p_in[1]];
+    uint8_t v2 = hex_values[p_in[2]];
+    uint8_t v3 = hex_values[p_in[3]];
+    uint8_t v4 = hex_values[p_in[4]];
+    uint8_t v5 = hex_values[p_in[5]];
+    uint8_t v6 = hex_values[p_in[6]];
+    uint8_t v7 = hex_values[p_in[7]];
+    invalid |= v0 | v1 | v2 | v3 | v4 | v5 | v6 | v7;
+    p_dst[idx] = (uint8_t)(v0 << 4) | (v1 & 0x0FU);
+    p_dst[idx + 1U] = (uint8_t)(v2 << 4) | (v3 & 0x0FU);
+    p_dst[idx + 2U] = (uint8_t)(v4 << 4) | (v5 & 0x0FU);
+    p_dst[idx + 3U] = (uint8_t)(v6 << 4) | (v7 & 0x0FU);
   }
-  else if ((digit >= 97U) && (digit <= 102U))
-  {
-    /* a to f */
-    *p_res = digit - 87U; /* 87 = -97+10 */
-  }
-  else if ((digit >= 65U) && (digit <= 70U))
-  {
-    /* A to F */
-    *p_res = digit - 55U; /* 55 = -65+10*/
-  }
-  else
-  {
-    *p_res = 0;
-    retval = ATSTATUS_ERROR;
-  }
-  return (retval);
-}
-
-/**
-  * @brief  Convert a HEX to its Char value
-  *         for example '65' (where msd='6' and lsd='5') is converted to 'A'
-  * @param  msd Most significant Digit of HEX value .
-  * @param  lsd Less significant Digit of HEX value.
-  * @param  p_conv ptr to converted Character value.
-  * @retval at_status_t.
-  */
-static at_status_t convertHEXToChar(uint8_t msd, uint8_t lsd, uint8_t *p_conv)
-{
-  at_status_t retval = ATSTATUS_OK;
-  uint8_t convMSD;
-  uint8_t convLSD;
 
-  /* convert Most significant digit */
-  if (convertDigitToValue(msd, &convMSD) == ATSTATUS_OK)
+  for (; idx < size; idx++)
   {
-    /* convert Less significant digit */
-    if (convertDigitToValue(lsd, &convLSD) == ATSTATUS_OK)
-    {
-      /* compute converted char value */
-      *p_conv = (convMSD << 4) + convLSD;
-    }
-    else
-    {
-      retval = ATSTATUS_ERROR;
-    }
+    uint8_t msd = hex_values[p_src[2U * idx]];
+    uint8_t lsd = hex_values[p_src[(2U * idx) + 1U]];
+    invalid |= msd | lsd;
+    p_dst[idx] = (uint8_t)(msd << 4) | (lsd & 0x0FU);
   }
-  else
+
+  /* valid digits are all lower than 0x10 */
+  if ((invalid & 0xF0U) != 0U)
   {
     retval = ATSTATUS_ERROR;
   }
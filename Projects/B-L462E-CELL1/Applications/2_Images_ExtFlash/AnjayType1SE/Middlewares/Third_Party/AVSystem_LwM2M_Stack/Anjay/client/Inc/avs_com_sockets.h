@@ -0,0 +1,45 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AVS_COM_SOCKETS_H
+#define AVS_COM_SOCKETS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <avsystem/commons/avs_socket.h>
+
+// Waits until data can be received on at least one of @p sockets, which are
+// avs_net sockets created on top of the com_sockets backend (possibly wrapped
+// in (D)TLS layers). out_ready[i] is set according to the state of
+// sockets[i]; closed sockets are never reported as ready.
+//
+// Returns the number of ready sockets, 0 if @p timeout_ms elapsed or the wait
+// has been interrupted with avs_com_sockets_interrupt_wait(), or a negative
+// value on error, in which case it may return before @p timeout_ms elapses.
+// Negative @p timeout_ms means no timeout. Shall not be called from more than
+// one thread at a time.
+int avs_com_sockets_wait(avs_net_socket_t *const *sockets,
+                         size_t count,
+                         bool *out_ready,
+                         int timeout_ms);
+
+// Makes the pending or next avs_com_sockets_wait() call return as soon as
+// possible. May be called from any thread; interrupts requested before the
+// waiting thread gets to handle the previous one are coalesced.
+void avs_com_sockets_interrupt_wait(void);
+
+#endif // AVS_COM_SOCKETS_H
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef AVS_POOL_ALLOCATOR_H
+#define AVS_POOL_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size classes served from static pools by avs_malloc() and friends when
+// AVS_COMMONS_UTILS_WITH_STANDARD_ALLOCATOR is disabled, as X(block_size,
+// block_count) entries sorted by block size. Block sizes must be multiples of
+// sizeof(avs_max_align_t).
+//
+// Anjay and avs_coap mostly allocate small nodes of fixed size (AVS_LIST
+// elements, scheduler jobs, observation entries, rbtree nodes), which would
+// otherwise fragment the heap over a long uptime. Requests that do not fit
+// in any class, or that find all fitting classes exhausted, fall back to the
+// system malloc().
+#ifndef AVS_POOL_ALLOCATOR_CLASSES
+#    define AVS_POOL_ALLOCATOR_CLASSES(X) \
+        X(16, 64)                         \
+        X(32, 64)                         \
+        X(64, 32)                         \
+        X(128, 16)
+#endif // AVS_POOL_ALLOCATOR_CLASSES
+
+typedef struct {
+    // Size of a single block in this class
+    size_t block_size;
+    // Number of blocks in this class
+    size_t block_count;
+    // Number of blocks currently allocated
+    size_t in_use;
+    // Highest value of in_use seen so far
+    size_t peak_in_use;
+    // Number of allocations served by this class
+    uint32_t allocs;
+    // Number of requests that matched this class, but had to be served by a
+    // larger class or the system heap because it was exhausted
+    uint32_t overflows;
+} avs_pool_allocator_class_stats_t;
+
+// Returns the number of configured size classes.
+size_t avs_pool_allocator_class_count(void);
+
+// Fills @p out_stats with statistics of size class number @p class_idx.
+//
+// Returns 0 on success, or a negative value if @p class_idx is out of range.
+int avs_pool_allocator_class_stats(size_t class_idx,
+                                   avs_pool_allocator_class_stats_t *out_stats);
+
+// Returns the number of blocks currently allocated from the system heap.
+size_t avs_pool_allocator_heap_blocks(void);
+
+// Logs statistics of all size classes and of the system heap fallback.
+void avs_pool_allocator_log_stats(void);
+
+#endif // AVS_POOL_ALLOCATOR_H
@@ -22,4 +22,8 @@
 int device_object_install(anjay_t *anjay);
 void device_object_update(anjay_t *anjay);
 
+// Stores the current value of the sampled Resources (Memory Free) in their
+// sample buffers; called periodically by the notify thread
+void device_object_sample(anjay_t *anjay);
+
 #endif // DEVICE_OBJECT_H
@@ -156,7 +156,7 @@ a lot of data that needs to be copied, this should be set high. */
 #    define MEMP_NUM_PBUF 10
 /* MEMP_NUM_UDP_PCB: the number of UDP protocol control blocks. One
    per active UDP "connection". */
-#    define MEMP_NUM_UDP_PCB 2 /* needed for DNS */
+#    define MEMP_NUM_UDP_PCB 3 /* needed for DNS and main loop wake-ups */
 /* MEMP_NUM_TCP_PCB: the number of simulatenously active TCP
    connections. */
 #    define MEMP_NUM_TCP_PCB 2 /* needed for HTTP Client */
@@ -175,6 +175,14 @@ a lot of data that needs to be copied, this should be set high. */
    timeouts. */
 #    define MEMP_NUM_SYS_TIMEOUT 10
 
+/* ---------- Loopback options ---------- */
+/* LWIP_NETIF_LOOPBACK: provide the 127.0.0.1 interface, used by the LwM2M
+   main loop to wake itself up from poll() when requested by other threads. */
+#    define LWIP_NETIF_LOOPBACK 1
+/* LWIP_LOOPBACK_MAX_PBUFS: wake-up requests are coalesced, so there is at most
+   one datagram in flight at a time. */
+#    define LWIP_LOOPBACK_MAX_PBUFS 2
+
 /* ---------- Pbuf options ---------- */
 /* PBUF_POOL_SIZE: the number of buffers in the pbuf pool. */
 #    define PBUF_POOL_SIZE 12
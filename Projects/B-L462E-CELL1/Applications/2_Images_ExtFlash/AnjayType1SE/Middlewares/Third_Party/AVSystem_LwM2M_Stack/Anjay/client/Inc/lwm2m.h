@@ -23,6 +23,13 @@ anjay_t * lwm2m_init(void);
 
 void lwm2m_start(void);
 
+// Starts a thread that calls process_fcn (if not NULL) every
+// LWM2M_NOTIFY_PERIOD_MS, and samples the Device object's Memory Free every
+// LWM2M_SAMPLE_PERIOD_MS, both with the Anjay mutex held. Without process_fcn,
+// the thread only wakes up for sampling. Besides calling
+// anjay_notify_changed(), process_fcn may store sensor readings with
+// anjay_sample_buffer_add_double(); these are then reported in batches, one
+// timestamped SenML record per sample, with the next notification.
 void lwm2m_notify_start(void (* process_fcn)());
 
 #endif // LWM2M_H
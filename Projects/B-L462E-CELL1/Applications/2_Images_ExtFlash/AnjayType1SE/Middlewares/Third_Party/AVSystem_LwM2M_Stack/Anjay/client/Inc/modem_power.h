@@ -0,0 +1,73 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MODEM_POWER_H
+#define MODEM_POWER_H
+
+#include <stdbool.h>
+
+#include "plf_config.h"
+
+#if (USE_LOW_POWER == 1)
+
+// The modem is put into idle mode with the low power support of the cellular
+// middleware, and stays attached to the network
+
+// Time the modem is given to leave idle mode and reattach before the next
+// scheduled LwM2M job, e.g. an Update or a pmax notification
+#    define MODEM_POWER_WAKEUP_LEAD_MS 5000
+
+// Idle periods shorter than this are not worth the cost of waking up
+#    define MODEM_POWER_MIN_IDLE_MS 30000
+
+#else // USE_LOW_POWER == 1
+
+// Without the low power support, the modem is switched off instead, and has
+// to boot and attach to the network again when woken up
+
+// Time the modem is given to power on and attach before the next scheduled
+// LwM2M job
+#    define MODEM_POWER_WAKEUP_LEAD_MS 60000
+
+// Switching the modem off only pays off for longer idle periods
+#    define MODEM_POWER_MIN_IDLE_MS 600000
+
+#endif // USE_LOW_POWER == 1
+
+// Decides whether the radio is needed, to be called by the LwM2M main loop
+// before each wait. @p sockets_open tells if Anjay has any socket to listen
+// on; in queue mode the server socket is closed once the CoAP
+// MAX_TRANSMIT_WAIT period since the last exchange has passed. @p wait_ms is
+// the time to the next scheduled Anjay job, negative if there is none.
+//
+// Puts the modem into idle mode when no socket is open and nothing is due
+// for at least MODEM_POWER_MIN_IDLE_MS, and wakes it up if a socket has been
+// opened or the next job is closer than MODEM_POWER_WAKEUP_LEAD_MS.
+//
+// Returns the time the main loop may wait before calling this function
+// again, negative meaning no timeout.
+int modem_power_update(bool sockets_open, int wait_ms);
+
+// Wakes the modem up regardless of the scheduled jobs, e.g. before leaving
+// the main loop.
+void modem_power_wakeup(void);
+
+// Tells if the modem has been put into idle mode by modem_power_update().
+// Without USE_LOW_POWER, the network is reported as down in that state, and
+// the main loop has to keep running to wake the modem up when a job is due.
+bool modem_power_idle(void);
+
+#endif // MODEM_POWER_H
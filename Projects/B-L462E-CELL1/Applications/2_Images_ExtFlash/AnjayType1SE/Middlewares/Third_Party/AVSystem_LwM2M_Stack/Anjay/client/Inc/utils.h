@@ -18,6 +18,7 @@
 #define UTILS_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct {
     // 96 bits as hex + NULL-byte
@@ -26,4 +27,10 @@ typedef struct {
 
 void get_uid(device_id_t *out_id);
 void init_modem_pins();
+
+/**
+ * Calculates the standard CRC-32 (as used e.g. by zlib) of @p length bytes
+ * at @p data.
+ */
+uint32_t calculate_crc32(const void *data, size_t length);
 #endif // UTILS_H
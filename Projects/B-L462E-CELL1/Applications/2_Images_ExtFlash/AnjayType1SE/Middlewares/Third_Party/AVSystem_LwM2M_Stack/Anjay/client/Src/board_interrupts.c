@@ -68,6 +68,14 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
     }
 }
 
+#if (IPC_USE_DMA_RX == 1U)
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+    if (huart->Instance == MODEM_UART_INSTANCE) {
+        IPC_UART_RxEventCallback(huart, Size);
+    }
+}
+#endif /* IPC_USE_DMA_RX == 1U */
+
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
     if (huart->Instance == MODEM_UART_INSTANCE) {
         IPC_UART_TxCpltCallback(huart);
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_UTILS) \
+        && !defined(AVS_COMMONS_UTILS_WITH_STANDARD_ALLOCATOR)
+
+#    include <stdbool.h>
+#    include <stdlib.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_defs.h>
+#    include <avsystem/commons/avs_log.h>
+#    include <avsystem/commons/avs_memory.h>
+
+#    include "FreeRTOS.h"
+#    include "task.h"
+
+#    include "avs_pool_allocator.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#    define LOG(level, ...) avs_log(pool_allocator, level, __VA_ARGS__)
+
+typedef struct {
+    // Singly linked list of freed blocks, the link is stored in the block
+    void *free_list;
+    // Blocks in [next_unused, end) have never been allocated
+    uint8_t *next_unused;
+    uint8_t *start;
+    uint8_t *end;
+    avs_pool_allocator_class_stats_t stats;
+} pool_class_t;
+
+#    define POOL_ARENA(BlockSize, BlockCount)                        \
+        AVS_STATIC_ASSERT((BlockSize) % sizeof(avs_max_align_t) == 0 \
+                                  && (BlockSize) >= sizeof(void *),  \
+                          pool_block_size_##BlockSize##_valid);      \
+        static avs_max_align_t                                       \
+                g_arena_##BlockSize[(BlockSize) * (BlockCount)       \
+                                    / sizeof(avs_max_align_t)];
+
+AVS_POOL_ALLOCATOR_CLASSES(POOL_ARENA)
+
+#    define POOL_CLASS(BlockSize, BlockCount)                            \
+        {                                                                \
+            .next_unused = (uint8_t *) g_arena_##BlockSize,              \
+            .start = (uint8_t *) g_arena_##BlockSize,                    \
+            .end = (uint8_t *) g_arena_##BlockSize                       \
+                   + (BlockSize) * (BlockCount),                         \
+            .stats = {                                                   \
+                .block_size = (BlockSize),                               \
+                .block_count = (BlockCount)                              \
+            }                                                            \
+        },
+
+static pool_class_t g_classes[] = { AVS_POOL_ALLOCATOR_CLASSES(POOL_CLASS) };
+
+static size_t g_heap_blocks;
+
+// Critical sections are used instead of a mutex, because avs_mutex_t itself
+// is allocated with avs_calloc(). Pool operations only take a few
+// instructions. There is nothing to lock against before the scheduler starts.
+static void pool_lock(void) {
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+        taskENTER_CRITICAL();
+    }
+}
+
+static void pool_unlock(void) {
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+        taskEXIT_CRITICAL();
+    }
+}
+
+static pool_class_t *find_class(void *ptr) {
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(g_classes); ++i) {
+        if ((uint8_t *) ptr >= g_classes[i].start
+                && (uint8_t *) ptr < g_classes[i].end) {
+            return &g_classes[i];
+        }
+    }
+    return NULL;
+}
+
+static void *class_alloc(pool_class_t *cls) {
+    void *result = NULL;
+    if (cls->free_list) {
+        result = cls->free_list;
+        cls->free_list = *(void **) result;
+    } else if (cls->next_unused < cls->end) {
+        result = cls->next_unused;
+        cls->next_unused += cls->stats.block_size;
+    }
+    if (result) {
+        ++cls->stats.allocs;
+        if (++cls->stats.in_use > cls->stats.peak_in_use) {
+            cls->stats.peak_in_use = cls->stats.in_use;
+        }
+    } else {
+        ++cls->stats.overflows;
+    }
+    return result;
+}
+
+static void *pool_alloc(size_t size, bool zero) {
+    void *result = NULL;
+    size_t i = 0;
+    while (i < AVS_ARRAY_SIZE(g_classes)
+           && g_classes[i].stats.block_size < size) {
+        ++i;
+    }
+    if (i < AVS_ARRAY_SIZE(g_classes)) {
+        pool_lock();
+        for (; !result && i < AVS_ARRAY_SIZE(g_classes); ++i) {
+            result = class_alloc(&g_classes[i]);
+        }
+        pool_unlock();
+        if (result) {
+            if (zero) {
+                memset(result, 0, size);
+            }
+            return result;
+        }
+    }
+
+    if ((result = zero ? calloc(1, size) : malloc(size))) {
+        pool_lock();
+        ++g_heap_blocks;
+        pool_unlock();
+    }
+    return result;
+}
+
+void *avs_malloc(size_t size) {
+    return pool_alloc(size, false);
+}
+
+void avs_free(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    pool_lock();
+    pool_class_t *cls = find_class(ptr);
+    if (cls) {
+        *(void **) ptr = cls->free_list;
+        cls->free_list = ptr;
+        --cls->stats.in_use;
+    } else {
+        --g_heap_blocks;
+    }
+    pool_unlock();
+    if (!cls) {
+        // outside of the critical section, as the heap has its own locking
+        free(ptr);
+    }
+}
+
+void *avs_calloc(size_t nmemb, size_t size) {
+    if (size && nmemb > SIZE_MAX / size) {
+        return NULL;
+    }
+    return pool_alloc(nmemb * size, true);
+}
+
+void *avs_realloc(void *ptr, size_t size) {
+    if (!ptr) {
+        return avs_malloc(size);
+    }
+    if (!size) {
+        avs_free(ptr);
+        return NULL;
+    }
+    pool_lock();
+    pool_class_t *cls = find_class(ptr);
+    size_t block_size = cls ? cls->stats.block_size : 0;
+    pool_unlock();
+    if (!cls) {
+        // block sizes are not tracked for the heap, so such blocks stay there
+        return realloc(ptr, size);
+    }
+    if (size <= block_size) {
+        return ptr;
+    }
+    void *result = avs_malloc(size);
+    if (result) {
+        memcpy(result, ptr, block_size);
+        avs_free(ptr);
+    }
+    return result;
+}
+
+size_t avs_pool_allocator_class_count(void) {
+    return AVS_ARRAY_SIZE(g_classes);
+}
+
+int avs_pool_allocator_class_stats(
+        size_t class_idx, avs_pool_allocator_class_stats_t *out_stats) {
+    if (class_idx >= AVS_ARRAY_SIZE(g_classes)) {
+        return -1;
+    }
+    pool_lock();
+    *out_stats = g_classes[class_idx].stats;
+    pool_unlock();
+    return 0;
+}
+
+size_t avs_pool_allocator_heap_blocks(void) {
+    pool_lock();
+    size_t result = g_heap_blocks;
+    pool_unlock();
+    return result;
+}
+
+void avs_pool_allocator_log_stats(void) {
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(g_classes); ++i) {
+        avs_pool_allocator_class_stats_t stats;
+        avs_pool_allocator_class_stats(i, &stats);
+        LOG(INFO,
+            "%lu B blocks: %lu/%lu in use, peak %lu, %lu allocs, %lu overflows",
+            (unsigned long) stats.block_size, (unsigned long) stats.in_use,
+            (unsigned long) stats.block_count,
+            (unsigned long) stats.peak_in_use, (unsigned long) stats.allocs,
+            (unsigned long) stats.overflows);
+    }
+    LOG(INFO, "%lu blocks allocated from the heap",
+        (unsigned long) avs_pool_allocator_heap_blocks());
+}
+
+#endif // defined(AVS_COMMONS_WITH_AVS_UTILS) &&
+       // !defined(AVS_COMMONS_UTILS_WITH_STANDARD_ALLOCATOR)
@@ -0,0 +1,1215 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avs_commons_init.h>
+
+#if defined(AVS_COMMONS_WITH_AVS_NET) \
+        && !defined(AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET)
+
+#    include <errno.h>
+#    include <stdint.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_addrinfo.h>
+#    include <avsystem/commons/avs_errno_map.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_socket_v_table.h>
+#    include <avsystem/commons/avs_utils.h>
+
+#    include "avs_net_global.h"
+#    include "avs_net_impl.h"
+
+#    include "cmsis_os_misrac2012.h"
+#    include "com_sockets.h"
+
+#    if (USE_SOCKETS_TYPE != USE_SOCKETS_MODEM)
+#        include "lwip/sockets.h"
+#    endif // USE_SOCKETS_TYPE != USE_SOCKETS_MODEM
+
+#    include "avs_com_sockets.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/*
+ * avs_net socket backend calling the X-CUBE-CELLULAR com_sockets API directly,
+ * so that the data of each datagram is moved exactly once, between the
+ * com_sockets layer and the buffer provided by the caller.
+ *
+ * Only IPv4 is supported, as com_sockets does not support anything else in
+ * the modem socket mode. Waiting for incoming data is done by
+ * avs_com_sockets_wait(): with sockets running on the modem, readiness is
+ * signalled by the data received URC callback, with LwIP running on the MCU
+ * lwip_poll() is used.
+ */
+
+#    if (USE_SOCKETS_TYPE == USE_SOCKETS_MODEM)
+// com_ip_modem uses the value directly as the message queue timeout
+#        define COM_RCVTIMEO_FOREVER ((uint32_t) osWaitForever)
+#    else // USE_SOCKETS_TYPE == USE_SOCKETS_MODEM
+// LWIP_SO_SNDRCVTIMEO_NONSTANDARD: value in ms, 0 means no timeout
+#        define COM_RCVTIMEO_FOREVER ((uint32_t) 0)
+#    endif // USE_SOCKETS_TYPE == USE_SOCKETS_MODEM
+
+static avs_error_t
+connect_net(avs_net_socket_t *net_socket, const char *host, const char *port);
+static avs_error_t send_net(avs_net_socket_t *net_socket,
+                            const void *buffer,
+                            size_t buffer_length);
+static avs_error_t send_to_net(avs_net_socket_t *socket,
+                               const void *buffer,
+                               size_t buffer_length,
+                               const char *host,
+                               const char *port);
+static avs_error_t receive_net(avs_net_socket_t *net_socket_,
+                               size_t *out,
+                               void *buffer,
+                               size_t buffer_length);
+static avs_error_t receive_from_net(avs_net_socket_t *net_socket,
+                                    size_t *out,
+                                    void *message_buffer,
+                                    size_t buffer_size,
+                                    char *host,
+                                    size_t host_size,
+                                    char *port,
+                                    size_t port_size);
+static avs_error_t
+bind_net(avs_net_socket_t *net_socket, const char *localaddr, const char *port);
+static avs_error_t accept_net(avs_net_socket_t *server_net_socket,
+                              avs_net_socket_t *new_net_socket);
+static avs_error_t close_net(avs_net_socket_t *net_socket);
+static avs_error_t shutdown_net(avs_net_socket_t *net_socket);
+static avs_error_t cleanup_net(avs_net_socket_t **net_socket);
+static const void *system_socket_net(avs_net_socket_t *net_socket);
+static avs_error_t interface_name_net(avs_net_socket_t *socket,
+                                      avs_net_socket_interface_name_t *if_name);
+static avs_error_t remote_host_net(avs_net_socket_t *socket,
+                                   char *out_buffer,
+                                   size_t out_buffer_size);
+static avs_error_t remote_hostname_net(avs_net_socket_t *socket,
+                                       char *out_buffer,
+                                       size_t out_buffer_size);
+static avs_error_t remote_port_net(avs_net_socket_t *socket,
+                                   char *out_buffer,
+                                   size_t out_buffer_size);
+static avs_error_t local_host_net(avs_net_socket_t *socket,
+                                  char *out_buffer,
+                                  size_t out_buffer_size);
+static avs_error_t local_port_net(avs_net_socket_t *socket,
+                                  char *out_buffer,
+                                  size_t out_buffer_size);
+static avs_error_t get_opt_net(avs_net_socket_t *net_socket,
+                               avs_net_socket_opt_key_t option_key,
+                               avs_net_socket_opt_value_t *out_option_value);
+static avs_error_t set_opt_net(avs_net_socket_t *net_socket,
+                               avs_net_socket_opt_key_t option_key,
+                               avs_net_socket_opt_value_t option_value);
+
+static const avs_net_socket_v_table_t net_vtable = {
+    .connect = connect_net,
+    .send = send_net,
+    .send_to = send_to_net,
+    .receive = receive_net,
+    .receive_from = receive_from_net,
+    .bind = bind_net,
+    .accept = accept_net,
+    .close = close_net,
+    .shutdown = shutdown_net,
+    .cleanup = cleanup_net,
+    .get_system_socket = system_socket_net,
+    .get_interface_name = interface_name_net,
+    .get_remote_host = remote_host_net,
+    .get_remote_hostname = remote_hostname_net,
+    .get_remote_port = remote_port_net,
+    .get_local_host = local_host_net,
+    .get_local_port = local_port_net,
+    .get_opt = get_opt_net,
+    .set_opt = set_opt_net
+};
+
+typedef struct {
+    const avs_net_socket_v_table_t *const operations;
+    int32_t handle;
+    avs_net_socket_type_t type;
+    avs_net_socket_state_t state;
+    com_sockaddr_in_t remote_addr;
+    char remote_hostname[NET_MAX_HOSTNAME_SIZE];
+    char remote_port[NET_PORT_SIZE];
+    char local_port[NET_PORT_SIZE];
+    avs_net_socket_configuration_t configuration;
+
+    uint64_t bytes_received;
+    uint64_t bytes_sent;
+
+    avs_time_duration_t recv_timeout;
+    // COM_SO_RCVTIMEO value last set on the handle; setsockopt() is only
+    // called when the timeout actually changes
+    bool com_recv_timeout_set;
+    uint32_t com_recv_timeout;
+} net_socket_impl_t;
+
+struct avs_net_addrinfo_struct {
+    com_sockaddr_in_t addr;
+    bool returned;
+};
+
+#    if (USE_SOCKETS_TYPE == USE_SOCKETS_MODEM)
+// Handles of the sockets with data received since the last
+// avs_com_sockets_wait() that reported them; com_ip_modem handles are small
+// integers (below CELLULAR_MAX_SOCKETS)
+static uint32_t g_ready_handles;
+static bool g_wait_interrupted;
+static osMutexId g_ready_mtx;
+static osSemaphoreId g_ready_sem;
+osMutexDef(com_sockets_ready_mtx);
+osSemaphoreDef(com_sockets_ready_sem);
+#    else  // USE_SOCKETS_TYPE == USE_SOCKETS_MODEM
+// Loopback UDP socket used to interrupt lwip_poll() in avs_com_sockets_wait()
+static int32_t g_wakeup_handle = COM_SOCKET_INVALID_ID;
+static com_sockaddr_in_t g_wakeup_addr;
+// Only accessed with g_wakeup_mtx locked
+static bool g_wakeup_pending;
+static osMutexId g_wakeup_mtx;
+osMutexDef(com_sockets_wakeup_mtx);
+// Array passed to lwip_poll(), kept between avs_com_sockets_wait() calls and
+// only grown when more sockets are waited for than ever before
+static struct pollfd *g_pollfds;
+static size_t g_pollfds_capacity;
+#    endif // USE_SOCKETS_TYPE == USE_SOCKETS_MODEM
+
+static avs_error_t failure_from_com(int32_t result) {
+#    if (USE_SOCKETS_TYPE == USE_SOCKETS_MODEM)
+    switch (result) {
+    case COM_SOCKETS_ERR_TIMEOUT:
+    case COM_SOCKETS_ERR_WOULDBLOCK:
+        return avs_errno(AVS_ETIMEDOUT);
+    case COM_SOCKETS_ERR_DESCRIPTOR:
+        return avs_errno(AVS_EBADF);
+    case COM_SOCKETS_ERR_PARAMETER:
+        return avs_errno(AVS_EINVAL);
+    case COM_SOCKETS_ERR_NOMEMORY:
+        return avs_errno(AVS_ENOMEM);
+    case COM_SOCKETS_ERR_CLOSING:
+        return avs_errno(AVS_ECONNRESET);
+    case COM_SOCKETS_ERR_LOCKED:
+        return avs_errno(AVS_EADDRINUSE);
+    case COM_SOCKETS_ERR_INPROGRESS:
+        return avs_errno(AVS_EINPROGRESS);
+    case COM_SOCKETS_ERR_NONAME:
+        return avs_errno(AVS_EADDRNOTAVAIL);
+    case COM_SOCKETS_ERR_NONETWORK:
+        return avs_errno(AVS_ENETUNREACH);
+    case COM_SOCKETS_ERR_UNSUPPORTED:
+        return avs_errno(AVS_ENOTSUP);
+    case COM_SOCKETS_ERR_STATE:
+        return avs_errno(AVS_EISCONN);
+    default:
+        return avs_errno(AVS_EIO);
+    }
+#    else  // USE_SOCKETS_TYPE == USE_SOCKETS_MODEM
+    // com_*_lwip_mcu() return the LwIP socket API results as they are
+    (void) result;
+    avs_errno_t error = avs_map_errno(errno);
+    if (error == AVS_EAGAIN) {
+        // nothing received before SO_RCVTIMEO elapsed or with MSG_DONTWAIT
+        error = AVS_ETIMEDOUT;
+    }
+    return avs_errno(error == AVS_NO_ERROR ? AVS_EIO : error);
+#    endif // USE_SOCKETS_TYPE == USE_SOCKETS_MODEM
+}
+
+static int port_from_string(uint16_t *out, const char *port_str) {
+    uint32_t value = 0;
+    if (!port_str || !*port_str) {
+        *out = 0;
+        return 0;
+    }
+    for (; *port_str; ++port_str) {
+        if (*port_str < '0' || *port_str > '9'
+                || (value = value * 10 + (uint32_t) (*port_str - '0'))
+                               > UINT16_MAX) {
+            return -1;
+        }
+    }
+    *out = (uint16_t) value;
+    return 0;
+}
+
+static int ipv4_from_string(uint8_t out[4], const char *host) {
+    for (size_t i = 0; i < 4; ++i) {
+        if (i > 0 && *host++ != '.') {
+            return -1;
+        }
+        uint32_t value = 0;
+        size_t digits = 0;
+        for (; *host >= '0' && *host <= '9'; ++host) {
+            value = value * 10 + (uint32_t) (*host - '0');
+            if (++digits > 3 || value > UINT8_MAX) {
+                return -1;
+            }
+        }
+        if (!digits) {
+            return -1;
+        }
+        out[i] = (uint8_t) value;
+    }
+    return *host ? -1 : 0;
+}
+
+static avs_error_t addr_to_string(const com_sockaddr_in_t *addr,
+                                  char *host,
+                                  size_t host_size,
+                                  char *port,
+                                  size_t port_size) {
+    // sin_addr is in network byte order, i.e. the bytes are in textual order
+    uint8_t ip[4];
+    memcpy(ip, &addr->sin_addr.s_addr, sizeof(ip));
+    if ((host
+         && avs_simple_snprintf(host, host_size, "%u.%u.%u.%u", ip[0], ip[1],
+                                ip[2], ip[3])
+                    < 0)
+            || (port
+                && avs_simple_snprintf(port, port_size, "%u",
+                                       (unsigned) COM_NTOHS(addr->sin_port))
+                           < 0)) {
+        return avs_errno(AVS_ERANGE);
+    }
+    return AVS_OK;
+}
+
+avs_net_addrinfo_t *avs_net_addrinfo_resolve_ex(
+        avs_net_socket_type_t socket_type,
+        avs_net_af_t family,
+        const char *host,
+        const char *port_str,
+        int flags,
+        const avs_net_resolved_endpoint_t *preferred_endpoint) {
+    // at most one address is ever resolved, so there is nothing to prefer
+    (void) socket_type;
+    (void) preferred_endpoint;
+    if (avs_is_err(_avs_net_ensure_global_state())) {
+        LOG(ERROR, _("avs_net global state initialization error"));
+        return NULL;
+    }
+    if (family != AVS_NET_AF_UNSPEC && family != AVS_NET_AF_INET4) {
+        LOG(DEBUG, _("Unsupported avs_net_af_t: ") "%d", (int) family);
+        return NULL;
+    }
+
+    uint16_t port;
+    if (port_from_string(&port, port_str)) {
+        LOG(ERROR, _("Invalid port: ") "%s", port_str);
+        return NULL;
+    }
+
+    avs_net_addrinfo_t *ctx =
+            (avs_net_addrinfo_t *) avs_calloc(1, sizeof(avs_net_addrinfo_t));
+    if (!ctx) {
+        LOG(ERROR, _("Out of memory"));
+        return NULL;
+    }
+
+    if (!host || !*host) {
+        host = "0.0.0.0";
+    }
+    uint8_t ip[4];
+    if (!ipv4_from_string(ip, host)) {
+        memcpy(&ctx->addr.sin_addr.s_addr, ip, sizeof(ip));
+    } else if ((flags & AVS_NET_ADDRINFO_RESOLVE_F_PASSIVE)
+               || com_gethostbyname((const com_char_t *) host,
+                                    (com_sockaddr_t *) &ctx->addr)
+                          != COM_SOCKETS_ERR_OK) {
+        LOG(DEBUG, _("cannot resolve ") "%s", host);
+        avs_net_addrinfo_delete(&ctx);
+        return NULL;
+    }
+    ctx->addr.sin_len = (uint8_t) sizeof(ctx->addr);
+    ctx->addr.sin_family = (uint8_t) COM_AF_INET;
+    ctx->addr.sin_port = COM_HTONS(port);
+    return ctx;
+}
+
+void avs_net_addrinfo_delete(avs_net_addrinfo_t **ctx) {
+    avs_free(*ctx);
+    *ctx = NULL;
+}
+
+int avs_net_addrinfo_next(avs_net_addrinfo_t *ctx,
+                          avs_net_resolved_endpoint_t *out) {
+    AVS_STATIC_ASSERT(sizeof(ctx->addr) <= sizeof(out->data),
+                      com_sockaddr_in_fits_in_resolved_endpoint);
+    if (ctx->returned) {
+        return AVS_NET_ADDRINFO_END;
+    }
+    out->size = (uint8_t) sizeof(ctx->addr);
+    memcpy(out->data.buf, &ctx->addr, sizeof(ctx->addr));
+    ctx->returned = true;
+    return 0;
+}
+
+void avs_net_addrinfo_rewind(avs_net_addrinfo_t *ctx) {
+    ctx->returned = false;
+}
+
+avs_error_t
+avs_net_resolved_endpoint_get_host_port(const avs_net_resolved_endpoint_t *endp,
+                                        char *host,
+                                        size_t hostlen,
+                                        char *serv,
+                                        size_t servlen) {
+    com_sockaddr_in_t addr;
+    if (endp->size != sizeof(addr)) {
+        return avs_errno(AVS_EINVAL);
+    }
+    memcpy(&addr, endp->data.buf, sizeof(addr));
+    return addr_to_string(&addr, host, hostlen, serv, servlen);
+}
+
+static avs_error_t resolve(net_socket_impl_t *net_socket,
+                           com_sockaddr_in_t *out,
+                           const char *host,
+                           const char *port,
+                           int flags,
+                           const avs_net_resolved_endpoint_t *preferred) {
+    avs_net_addrinfo_t *info =
+            avs_net_addrinfo_resolve_ex(net_socket->type, AVS_NET_AF_INET4,
+                                        host, port, flags, preferred);
+    if (!info) {
+        return avs_errno(AVS_EADDRNOTAVAIL);
+    }
+    *out = info->addr;
+    avs_net_addrinfo_delete(&info);
+    return AVS_OK;
+}
+
+static void mark_handle_not_ready(int32_t handle) {
+#    if (USE_SOCKETS_TYPE == USE_SOCKETS_MODEM)
+    if (handle >= 0 && handle < 32) {
+        osMutexWait(g_ready_mtx, osWaitForever);
+        g_ready_handles &= ~((uint32_t) 1 << handle);
+        osMutexRelease(g_ready_mtx);
+    }
+#    else  // USE_SOCKETS_TYPE == USE_SOCKETS_MODEM
+    (void) handle;
+#    endif // USE_SOCKETS_TYPE == USE_SOCKETS_MODEM
+}
+
+static avs_error_t open_handle(net_socket_impl_t *net_socket) {
+    if (net_socket->handle != COM_SOCKET_INVALID_ID) {
+        return AVS_OK;
+    }
+    bool udp = (net_socket->type == AVS_NET_UDP_SOCKET);
+    errno = 0;
+    int32_t handle = com_socket(COM_AF_INET,
+                                udp ? COM_SOCK_DGRAM : COM_SOCK_STREAM,
+                                udp ? COM_IPPROTO_UDP : COM_IPPROTO_TCP);
+    if (handle < 0) {
+        LOG(ERROR, _("cannot create socket"));
+        return failure_from_com(handle);
+    }
+    // handles are reused, forget about anything received on a previous one
+    mark_handle_not_ready(handle);
+    net_socket->handle = handle;
+    net_socket->com_recv_timeout_set = false;
+    return AVS_OK;
+}
+
+static const void *system_socket_net(avs_net_socket_t *net_socket_) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (net_socket->handle != COM_SOCKET_INVALID_ID) {
+        return &net_socket->handle;
+    } else {
+        return NULL;
+    }
+}
+
+static void close_net_raw(net_socket_impl_t *net_socket) {
+    if (net_socket->handle != COM_SOCKET_INVALID_ID) {
+        (void) com_closesocket(net_socket->handle);
+        mark_handle_not_ready(net_socket->handle);
+        net_socket->handle = COM_SOCKET_INVALID_ID;
+        net_socket->state = AVS_NET_SOCKET_STATE_CLOSED;
+    }
+    net_socket->remote_hostname[0] = '\0';
+    net_socket->remote_port[0] = '\0';
+    net_socket->local_port[0] = '\0';
+}
+
+static avs_error_t close_net(avs_net_socket_t *net_socket_) {
+    close_net_raw((net_socket_impl_t *) net_socket_);
+    return AVS_OK;
+}
+
+static avs_error_t cleanup_net(avs_net_socket_t **net_socket) {
+    close_net(*net_socket);
+    avs_free(*net_socket);
+    *net_socket = NULL;
+    return AVS_OK;
+}
+
+static avs_error_t shutdown_net(avs_net_socket_t *net_socket_) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    // com_sockets has no shutdown(); the handle is released right away
+    close_net_raw(net_socket);
+    net_socket->state = AVS_NET_SOCKET_STATE_SHUTDOWN;
+    return AVS_OK;
+}
+
+static void cache_remote_hostname(net_socket_impl_t *net_socket,
+                                  const char *remote_hostname) {
+    if (avs_simple_snprintf(net_socket->remote_hostname,
+                            sizeof(net_socket->remote_hostname), "%s",
+                            remote_hostname)
+            < 0) {
+        LOG(WARNING, _("Remote hostname ") "%s" _(" is too long, not storing"),
+            remote_hostname);
+        net_socket->remote_hostname[0] = '\0';
+    }
+}
+
+static avs_error_t
+connect_net(avs_net_socket_t *net_socket_, const char *host, const char *port) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (net_socket->handle != COM_SOCKET_INVALID_ID
+            && (net_socket->type != AVS_NET_UDP_SOCKET
+                || net_socket->state != AVS_NET_SOCKET_STATE_BOUND)) {
+        LOG(ERROR, _("socket is already connected or bound"));
+        return avs_errno(AVS_EISCONN);
+    }
+
+    LOG(TRACE, _("connecting to [") "%s" _("]:") "%s", host, port);
+
+    com_sockaddr_in_t addr;
+    avs_error_t err;
+    if (avs_is_err((err = resolve(
+                            net_socket, &addr, host, port, 0,
+                            net_socket->configuration.preferred_endpoint)))
+            || avs_is_err((err = open_handle(net_socket)))) {
+        LOG(ERROR, _("cannot establish connection to [") "%s" _("]:") "%s",
+            host, port);
+        return err;
+    }
+    errno = 0;
+    int32_t result = com_connect(net_socket->handle,
+                                 (const com_sockaddr_t *) &addr,
+                                 (int32_t) sizeof(addr));
+    if (result != COM_SOCKETS_ERR_OK) {
+        err = failure_from_com(result);
+        LOG(ERROR, _("cannot establish connection to [") "%s" _("]:") "%s",
+            host, port);
+        close_net_raw(net_socket);
+        return err;
+    }
+
+    net_socket->remote_addr = addr;
+    cache_remote_hostname(net_socket, host);
+    (void) addr_to_string(&addr, NULL, 0, net_socket->remote_port,
+                          sizeof(net_socket->remote_port));
+    if (net_socket->configuration.preferred_endpoint) {
+        net_socket->configuration.preferred_endpoint->size =
+                (uint8_t) sizeof(addr);
+        memcpy(net_socket->configuration.preferred_endpoint->data.buf, &addr,
+               sizeof(addr));
+    }
+    net_socket->state = AVS_NET_SOCKET_STATE_CONNECTED;
+    LOG(TRACE, _("connected to [") "%s" _("]:") "%s", host, port);
+    return AVS_OK;
+}
+
+static avs_error_t bind_net(avs_net_socket_t *net_socket_,
+                            const char *localaddr,
+                            const char *port) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    if (net_socket->handle != COM_SOCKET_INVALID_ID) {
+        LOG(ERROR, _("socket is already connected or bound"));
+        return avs_errno(AVS_EISCONN);
+    }
+
+    com_sockaddr_in_t addr;
+    avs_error_t err;
+    if (avs_is_err((err = resolve(net_socket, &addr, localaddr, port,
+                                  AVS_NET_ADDRINFO_RESOLVE_F_PASSIVE, NULL)))
+            || avs_is_err((err = open_handle(net_socket)))) {
+        return err;
+    }
+    errno = 0;
+    int32_t result = com_bind(net_socket->handle,
+                              (const com_sockaddr_t *) &addr,
+                              (int32_t) sizeof(addr));
+    if (result != COM_SOCKETS_ERR_OK) {
+        err = failure_from_com(result);
+        LOG(ERROR, _("cannot bind to [") "%s" _("]:") "%s",
+            localaddr ? localaddr : "", port ? port : "");
+        close_net_raw(net_socket);
+        return err;
+    }
+
+    // com_ip_modem cannot report the local address, remember the requested
+    // port so that it can be reused e.g. after a reconnection
+    (void) addr_to_string(&addr, NULL, 0, net_socket->local_port,
+                          sizeof(net_socket->local_port));
+    net_socket->state = AVS_NET_SOCKET_STATE_BOUND;
+    return AVS_OK;
+}
+
+static avs_error_t accept_net(avs_net_socket_t *server_net_socket,
+                              avs_net_socket_t *new_net_socket) {
+    (void) server_net_socket;
+    (void) new_net_socket;
+    LOG(ERROR, _("accept is not supported by com_sockets"));
+    return avs_errno(AVS_ENOTSUP);
+}
+
+static avs_error_t send_net(avs_net_socket_t *net_socket_,
+                            const void *buffer,
+                            size_t buffer_length) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    const com_char_t *data = (const com_char_t *) buffer;
+    size_t bytes_sent = 0;
+
+    if (net_socket->handle == COM_SOCKET_INVALID_ID) {
+        return avs_errno(AVS_EBADF);
+    }
+    /* send at least one datagram, even if zero-length - hence do..while */
+    do {
+        int32_t chunk = (int32_t) AVS_MIN(buffer_length - bytes_sent,
+                                          (size_t) INT32_MAX);
+        errno = 0;
+        int32_t result = com_send(net_socket->handle, data + bytes_sent, chunk,
+                                  COM_MSG_WAIT);
+        if (result < 0) {
+            LOG(ERROR, _("send failed"));
+            return failure_from_com(result);
+        } else if (buffer_length != 0 && result == 0) {
+            LOG(ERROR, _("send returned 0"));
+            break;
+        }
+        bytes_sent += (size_t) result;
+        net_socket->bytes_sent += (size_t) result;
+        /* call send() multiple times only if the socket is stream-oriented */
+    } while (net_socket->type == AVS_NET_TCP_SOCKET
+             && bytes_sent < buffer_length);
+
+    if (bytes_sent < buffer_length) {
+        LOG(ERROR, _("sending fail (") "%lu" _("/") "%lu" _(")"),
+            (unsigned long) bytes_sent, (unsigned long) buffer_length);
+        return avs_errno(AVS_EIO);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t send_to_net(avs_net_socket_t *net_socket_,
+                               const void *buffer,
+                               size_t buffer_length,
+                               const char *host,
+                               const char *port) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    com_sockaddr_in_t addr;
+    avs_error_t err;
+    if (buffer_length > INT32_MAX) {
+        return avs_errno(AVS_EMSGSIZE);
+    }
+    if (avs_is_err((err = resolve(net_socket, &addr, host, port, 0, NULL)))
+            || avs_is_err((err = open_handle(net_socket)))) {
+        return err;
+    }
+    errno = 0;
+    int32_t result = com_sendto(net_socket->handle,
+                                (const com_char_t *) buffer,
+                                (int32_t) buffer_length, COM_MSG_WAIT,
+                                (const com_sockaddr_t *) &addr,
+                                (int32_t) sizeof(addr));
+    if (result < 0) {
+        return failure_from_com(result);
+    }
+    net_socket->bytes_sent += (size_t) result;
+    if ((size_t) result != buffer_length) {
+        LOG(ERROR, _("send_to fail (") "%lu" _("/") "%lu" _(")"),
+            (unsigned long) result, (unsigned long) buffer_length);
+        return avs_errno(AVS_EIO);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t apply_recv_timeout(net_socket_impl_t *net_socket,
+                                      int32_t *out_flags) {
+    int64_t timeout_ms = -1;
+    if (avs_time_duration_valid(net_socket->recv_timeout)
+            && avs_time_duration_to_scalar(&timeout_ms, AVS_TIME_MS,
+                                           net_socket->recv_timeout)) {
+        return avs_errno(AVS_EINVAL);
+    }
+    if (avs_time_duration_valid(net_socket->recv_timeout) && timeout_ms <= 0) {
+        // non-blocking receive, used e.g. to drain data already received
+        *out_flags = COM_MSG_DONTWAIT;
+        return AVS_OK;
+    }
+    uint32_t value = (timeout_ms < 0 || timeout_ms >= (int64_t) INT32_MAX)
+                             ? COM_RCVTIMEO_FOREVER
+                             : (uint32_t) timeout_ms;
+    *out_flags = COM_MSG_WAIT;
+    if (!net_socket->com_recv_timeout_set
+            || net_socket->com_recv_timeout != value) {
+        errno = 0;
+        int32_t result = com_setsockopt(net_socket->handle, COM_SOL_SOCKET,
+                                        COM_SO_RCVTIMEO, &value,
+                                        (int32_t) sizeof(value));
+        if (result != COM_SOCKETS_ERR_OK) {
+            return failure_from_com(result);
+        }
+        net_socket->com_recv_timeout_set = true;
+        net_socket->com_recv_timeout = value;
+    }
+    return AVS_OK;
+}
+
+static avs_error_t receive_impl(net_socket_impl_t *net_socket,
+                                size_t *out,
+                                void *buffer,
+                                size_t buffer_length,
+                                com_sockaddr_in_t *src_addr) {
+    *out = 0;
+    if (net_socket->handle == COM_SOCKET_INVALID_ID) {
+        return avs_errno(AVS_EBADF);
+    }
+    if (buffer_length == 0) {
+        return avs_errno(AVS_EINVAL);
+    }
+    int32_t flags;
+    avs_error_t err = apply_recv_timeout(net_socket, &flags);
+    if (avs_is_err(err)) {
+        return err;
+    }
+
+    int32_t length = (int32_t) AVS_MIN(buffer_length, (size_t) INT32_MAX);
+    int32_t result;
+    errno = 0;
+    if (src_addr) {
+        int32_t src_addr_length = (int32_t) sizeof(*src_addr);
+        result = com_recvfrom(net_socket->handle, (com_char_t *) buffer, length,
+                              flags, (com_sockaddr_t *) src_addr,
+                              &src_addr_length);
+    } else {
+        result = com_recv(net_socket->handle, (com_char_t *) buffer, length,
+                          flags);
+    }
+    if (result < 0) {
+        return failure_from_com(result);
+    }
+#    if (USE_SOCKETS_TYPE == USE_SOCKETS_MODEM)
+    if (result == 0) {
+        // com_ip_modem reports "no data available" this way
+        return avs_errno(AVS_ETIMEDOUT);
+    }
+#    endif // USE_SOCKETS_TYPE == USE_SOCKETS_MODEM
+    *out = (size_t) result;
+    net_socket->bytes_received += (size_t) result;
+    if (net_socket->type == AVS_NET_UDP_SOCKET
+            && (size_t) result == buffer_length) {
+        /* Buffer entirely filled - data possibly truncated. This will
+         * incorrectly reject packets that have exactly buffer_length
+         * bytes, but com_sockets has no means of reporting truncation. */
+        return avs_errno(AVS_EMSGSIZE);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t receive_net(avs_net_socket_t *net_socket_,
+                               size_t *out,
+                               void *buffer,
+                               size_t buffer_length) {
+    return receive_impl((net_socket_impl_t *) net_socket_, out, buffer,
+                        buffer_length, NULL);
+}
+
+static avs_error_t receive_from_net(avs_net_socket_t *net_socket_,
+                                    size_t *out,
+                                    void *message_buffer,
+                                    size_t buffer_size,
+                                    char *host,
+                                    size_t host_size,
+                                    char *port,
+                                    size_t port_size) {
+    host[0] = '\0';
+    port[0] = '\0';
+
+    com_sockaddr_in_t src_addr;
+    memset(&src_addr, 0, sizeof(src_addr));
+    avs_error_t err =
+            receive_impl((net_socket_impl_t *) net_socket_, out, message_buffer,
+                         buffer_size, &src_addr);
+    if (avs_is_ok(err)
+            || (err.category == AVS_ERRNO_CATEGORY
+                && err.code == AVS_EMSGSIZE)) {
+        avs_error_t sub_err =
+                addr_to_string(&src_addr, host, host_size, port, port_size);
+        if (avs_is_ok(err)) {
+            err = sub_err;
+        }
+    }
+    return err;
+}
+
+static avs_error_t
+interface_name_net(avs_net_socket_t *socket_,
+                   avs_net_socket_interface_name_t *if_name) {
+    net_socket_impl_t *socket = (net_socket_impl_t *) socket_;
+    if (!socket->configuration.interface_name[0]) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+    memcpy(*if_name, socket->configuration.interface_name, sizeof(*if_name));
+    return AVS_OK;
+}
+
+static avs_error_t remote_host_net(avs_net_socket_t *socket_,
+                                   char *out_buffer,
+                                   size_t out_buffer_size) {
+    net_socket_impl_t *socket = (net_socket_impl_t *) socket_;
+    if (socket->state != AVS_NET_SOCKET_STATE_CONNECTED) {
+        return avs_errno(AVS_ENOTCONN);
+    }
+    return addr_to_string(&socket->remote_addr, out_buffer, out_buffer_size,
+                          NULL, 0);
+}
+
+static avs_error_t remote_hostname_net(avs_net_socket_t *socket_,
+                                       char *out_buffer,
+                                       size_t out_buffer_size) {
+    net_socket_impl_t *socket = (net_socket_impl_t *) socket_;
+    if (!socket->remote_hostname[0]) {
+        return avs_errno(socket->handle == COM_SOCKET_INVALID_ID ? AVS_EBADF
+                                                                 : AVS_ENOBUFS);
+    }
+    if (avs_simple_snprintf(out_buffer, out_buffer_size, "%s",
+                            socket->remote_hostname)
+            < 0) {
+        return avs_errno(AVS_ERANGE);
+    } else {
+        return AVS_OK;
+    }
+}
+
+static avs_error_t remote_port_net(avs_net_socket_t *socket_,
+                                   char *out_buffer,
+                                   size_t out_buffer_size) {
+    net_socket_impl_t *socket = (net_socket_impl_t *) socket_;
+    if (!socket->remote_port[0]) {
+        return avs_errno(socket->handle == COM_SOCKET_INVALID_ID ? AVS_EBADF
+                                                                 : AVS_ENOBUFS);
+    }
+    if (avs_simple_snprintf(out_buffer, out_buffer_size, "%s",
+                            socket->remote_port)
+            < 0) {
+        return avs_errno(AVS_ERANGE);
+    } else {
+        return AVS_OK;
+    }
+}
+
+static avs_error_t get_local_addr(net_socket_impl_t *socket,
+                                  com_sockaddr_in_t *out) {
+    if (socket->handle == COM_SOCKET_INVALID_ID) {
+        return avs_errno(AVS_EBADF);
+    }
+    int32_t addr_length = (int32_t) sizeof(*out);
+    errno = 0;
+    int32_t result = com_getsockname(socket->handle, (com_sockaddr_t *) out,
+                                     &addr_length);
+    return result == COM_SOCKETS_ERR_OK ? AVS_OK : failure_from_com(result);
+}
+
+static avs_error_t local_host_net(avs_net_socket_t *socket_,
+                                  char *out_buffer,
+                                  size_t out_buffer_size) {
+    com_sockaddr_in_t addr;
+    avs_error_t err = get_local_addr((net_socket_impl_t *) socket_, &addr);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    return addr_to_string(&addr, out_buffer, out_buffer_size, NULL, 0);
+}
+
+static avs_error_t local_port_net(avs_net_socket_t *socket_,
+                                  char *out_buffer,
+                                  size_t out_buffer_size) {
+    net_socket_impl_t *socket = (net_socket_impl_t *) socket_;
+    com_sockaddr_in_t addr;
+    avs_error_t err = get_local_addr(socket, &addr);
+    if (avs_is_ok(err)) {
+        return addr_to_string(&addr, NULL, 0, out_buffer, out_buffer_size);
+    }
+    if (!socket->local_port[0] || !strcmp(socket->local_port, "0")) {
+        return err;
+    }
+    if (avs_simple_snprintf(out_buffer, out_buffer_size, "%s",
+                            socket->local_port)
+            < 0) {
+        return avs_errno(AVS_ERANGE);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t get_mtu(net_socket_impl_t *net_socket, int *out_mtu) {
+    if (net_socket->configuration.forced_mtu > 0) {
+        *out_mtu = net_socket->configuration.forced_mtu;
+    } else {
+        // com_sockets cannot query the path MTU, assume the IPv4 minimum
+        *out_mtu = 576;
+    }
+    return AVS_OK;
+}
+
+static avs_error_t get_inner_mtu(net_socket_impl_t *net_socket, int *out_mtu) {
+    if (net_socket->type != AVS_NET_UDP_SOCKET) {
+        LOG(ERROR,
+            _("get_opt_net: inner MTU calculation unimplemented for TCP"));
+        return avs_errno(AVS_ENOTSUP);
+    }
+    (void) get_mtu(net_socket, out_mtu);
+    *out_mtu -= 28; /* 20 for IP + 8 for UDP */
+    if (*out_mtu < 0) {
+        *out_mtu = 0;
+    }
+    return AVS_OK;
+}
+
+static avs_error_t get_opt_net(avs_net_socket_t *net_socket_,
+                               avs_net_socket_opt_key_t option_key,
+                               avs_net_socket_opt_value_t *out_option_value) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    switch (option_key) {
+    case AVS_NET_SOCKET_OPT_RECV_TIMEOUT:
+        out_option_value->recv_timeout = net_socket->recv_timeout;
+        return AVS_OK;
+    case AVS_NET_SOCKET_OPT_STATE:
+        out_option_value->state = net_socket->state;
+        return AVS_OK;
+    case AVS_NET_SOCKET_OPT_ADDR_FAMILY:
+        out_option_value->addr_family = AVS_NET_AF_INET4;
+        return AVS_OK;
+    case AVS_NET_SOCKET_OPT_MTU:
+        return get_mtu(net_socket, &out_option_value->mtu);
+    case AVS_NET_SOCKET_OPT_INNER_MTU:
+        return get_inner_mtu(net_socket, &out_option_value->mtu);
+    case AVS_NET_SOCKET_OPT_BYTES_RECEIVED:
+        out_option_value->bytes_received = net_socket->bytes_received;
+        return AVS_OK;
+    case AVS_NET_SOCKET_OPT_BYTES_SENT:
+        out_option_value->bytes_sent = net_socket->bytes_sent;
+        return AVS_OK;
+    default:
+        LOG(DEBUG,
+            _("get_opt_net: unknown or unsupported option key: ")
+                    _("(avs_net_socket_opt_key_t) ") "%d",
+            (int) option_key);
+        return avs_errno(AVS_EINVAL);
+    }
+}
+
+static avs_error_t set_opt_net(avs_net_socket_t *net_socket_,
+                               avs_net_socket_opt_key_t option_key,
+                               avs_net_socket_opt_value_t option_value) {
+    net_socket_impl_t *net_socket = (net_socket_impl_t *) net_socket_;
+    switch (option_key) {
+    case AVS_NET_SOCKET_OPT_RECV_TIMEOUT:
+        // applied lazily, on the next receive
+        net_socket->recv_timeout = option_value.recv_timeout;
+        return AVS_OK;
+    default:
+        LOG(DEBUG,
+            _("set_opt_net: unknown or unsupported option key: ")
+                    _("(avs_net_socket_opt_key_t) ") "%d",
+            (int) option_key);
+        return avs_errno(AVS_EINVAL);
+    }
+}
+
+static avs_error_t create_net_socket(avs_net_socket_t **socket,
+                                     avs_net_socket_type_t socket_type,
+                                     const void *socket_configuration) {
+    const avs_net_socket_v_table_t *const VTABLE_PTR = &net_vtable;
+    const avs_net_socket_configuration_t *configuration =
+            (const avs_net_socket_configuration_t *) socket_configuration;
+    if (configuration && configuration->address_family != AVS_NET_AF_UNSPEC
+            && configuration->address_family != AVS_NET_AF_INET4) {
+        LOG(ERROR, _("only IPv4 is supported by com_sockets"));
+        return avs_errno(AVS_EINVAL);
+    }
+    net_socket_impl_t *net_socket =
+            (net_socket_impl_t *) avs_calloc(1, sizeof(net_socket_impl_t));
+    if (!net_socket) {
+        return avs_errno(AVS_ENOMEM);
+    }
+
+    memcpy((void *) (intptr_t) &net_socket->operations, &VTABLE_PTR,
+           sizeof(VTABLE_PTR));
+    net_socket->handle = COM_SOCKET_INVALID_ID;
+    net_socket->type = socket_type;
+    net_socket->recv_timeout = AVS_NET_SOCKET_DEFAULT_RECV_TIMEOUT;
+    if (configuration) {
+        memcpy(&net_socket->configuration, configuration,
+               sizeof(*configuration));
+    }
+
+    *socket = (avs_net_socket_t *) net_socket;
+    return AVS_OK;
+}
+
+avs_error_t _avs_net_create_tcp_socket(avs_net_socket_t **socket,
+                                       const void *socket_configuration) {
+    return create_net_socket(socket, AVS_NET_TCP_SOCKET, socket_configuration);
+}
+
+avs_error_t _avs_net_create_udp_socket(avs_net_socket_t **socket,
+                                       const void *socket_configuration) {
+    return create_net_socket(socket, AVS_NET_UDP_SOCKET, socket_configuration);
+}
+
+#    if (USE_SOCKETS_TYPE == USE_SOCKETS_MODEM)
+static void data_ready_cb(int32_t handle, void *arg) {
+    (void) arg;
+    if (handle >= 0 && handle < 32) {
+        osMutexWait(g_ready_mtx, osWaitForever);
+        g_ready_handles |= (uint32_t) 1 << handle;
+        osMutexRelease(g_ready_mtx);
+        (void) osSemaphoreRelease(g_ready_sem);
+    }
+}
+
+avs_error_t _avs_net_initialize_global_compat_state(void) {
+    if (!(g_ready_mtx = osMutexCreate(osMutex(com_sockets_ready_mtx)))) {
+        return avs_errno(AVS_ENOMEM);
+    }
+    if (!(g_ready_sem =
+                  osSemaphoreCreate(osSemaphore(com_sockets_ready_sem), 1))) {
+        osMutexDelete(g_ready_mtx);
+        g_ready_mtx = NULL;
+        return avs_errno(AVS_ENOMEM);
+    }
+    // depending on the allocation scheme, a binary semaphore may be created
+    // either taken or given
+    (void) osSemaphoreWait(g_ready_sem, 0);
+    g_ready_handles = 0;
+    g_wait_interrupted = false;
+    if (com_set_data_ready_cb(data_ready_cb, NULL) != COM_SOCKETS_ERR_OK) {
+        _avs_net_cleanup_global_compat_state();
+        return avs_errno(AVS_ENOTSUP);
+    }
+    return AVS_OK;
+}
+
+void _avs_net_cleanup_global_compat_state(void) {
+    (void) com_set_data_ready_cb(NULL, NULL);
+    if (g_ready_sem) {
+        osSemaphoreDelete(g_ready_sem);
+        g_ready_sem = NULL;
+    }
+    if (g_ready_mtx) {
+        osMutexDelete(g_ready_mtx);
+        g_ready_mtx = NULL;
+    }
+}
+
+static int get_ready(avs_net_socket_t *const *sockets,
+                     size_t count,
+                     bool *out_ready,
+                     bool *out_interrupted) {
+    int ready_count = 0;
+    uint32_t reported = 0;
+    osMutexWait(g_ready_mtx, osWaitForever);
+    for (size_t i = 0; i < count; ++i) {
+        const int32_t *handle =
+                (const int32_t *) avs_net_socket_get_system(sockets[i]);
+        out_ready[i] = (handle && *handle >= 0 && *handle < 32
+                        && (g_ready_handles & ((uint32_t) 1 << *handle)));
+        if (out_ready[i]) {
+            reported |= (uint32_t) 1 << *handle;
+            ++ready_count;
+        }
+    }
+    // readiness is edge-triggered: the caller is expected to receive until
+    // there is no more data
+    g_ready_handles &= ~reported;
+    *out_interrupted = g_wait_interrupted;
+    g_wait_interrupted = false;
+    osMutexRelease(g_ready_mtx);
+    return ready_count;
+}
+
+int avs_com_sockets_wait(avs_net_socket_t *const *sockets,
+                         size_t count,
+                         bool *out_ready,
+                         int timeout_ms) {
+    if (avs_is_err(_avs_net_ensure_global_state())) {
+        return -1;
+    }
+    bool interrupted;
+    int ready_count = get_ready(sockets, count, out_ready, &interrupted);
+    if (ready_count || interrupted || timeout_ms == 0) {
+        return ready_count;
+    }
+    (void) osSemaphoreWait(g_ready_sem, timeout_ms < 0 ? osWaitForever
+                                                       : (uint32_t) timeout_ms);
+    return get_ready(sockets, count, out_ready, &interrupted);
+}
+
+void avs_com_sockets_interrupt_wait(void) {
+    if (!g_ready_mtx) {
+        return;
+    }
+    osMutexWait(g_ready_mtx, osWaitForever);
+    g_wait_interrupted = true;
+    osMutexRelease(g_ready_mtx);
+    (void) osSemaphoreRelease(g_ready_sem);
+}
+#    else // USE_SOCKETS_TYPE == USE_SOCKETS_MODEM
+avs_error_t _avs_net_initialize_global_compat_state(void) {
+    if (!(g_wakeup_mtx = osMutexCreate(osMutex(com_sockets_wakeup_mtx)))) {
+        return avs_errno(AVS_ENOMEM);
+    }
+    return AVS_OK;
+}
+
+void _avs_net_cleanup_global_compat_state(void) {
+    if (g_wakeup_handle != COM_SOCKET_INVALID_ID) {
+        (void) com_closesocket(g_wakeup_handle);
+        g_wakeup_handle = COM_SOCKET_INVALID_ID;
+    }
+    if (g_wakeup_mtx) {
+        osMutexDelete(g_wakeup_mtx);
+        g_wakeup_mtx = NULL;
+    }
+    avs_free(g_pollfds);
+    g_pollfds = NULL;
+    g_pollfds_capacity = 0;
+}
+
+// the loopback interface is only usable once LwIP is up, so the socket is
+// created on the first wait instead of during global state initialization
+static int wakeup_init(void) {
+    int32_t handle = com_socket(COM_AF_INET, COM_SOCK_DGRAM, COM_IPPROTO_UDP);
+    if (handle < 0) {
+        return -1;
+    }
+    com_sockaddr_in_t addr;
+    int32_t addr_len = (int32_t) sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_len = (uint8_t) sizeof(addr);
+    addr.sin_family = (uint8_t) COM_AF_INET;
+    addr.sin_addr.s_addr = PP_HTONL(INADDR_LOOPBACK);
+    if (com_bind(handle, (const com_sockaddr_t *) &addr, addr_len)
+            || com_getsockname(handle, (com_sockaddr_t *) &addr, &addr_len)) {
+        (void) com_closesocket(handle);
+        return -1;
+    }
+    osMutexWait(g_wakeup_mtx, osWaitForever);
+    g_wakeup_addr = addr;
+    g_wakeup_handle = handle;
+    osMutexRelease(g_wakeup_mtx);
+    return 0;
+}
+
+static bool wakeup_pending(void) {
+    osMutexWait(g_wakeup_mtx, osWaitForever);
+    const bool result = g_wakeup_pending;
+    osMutexRelease(g_wakeup_mtx);
+    return result;
+}
+
+static void wakeup_drain(void) {
+    // cleared before draining, so that a wake-up requested in the meantime
+    // results in another datagram instead of being lost
+    osMutexWait(g_wakeup_mtx, osWaitForever);
+    g_wakeup_pending = false;
+    osMutexRelease(g_wakeup_mtx);
+    com_char_t buf[8];
+    while (com_recv(g_wakeup_handle, buf, (int32_t) sizeof(buf),
+                    COM_MSG_DONTWAIT)
+           > 0) {
+    }
+}
+
+int avs_com_sockets_wait(avs_net_socket_t *const *sockets,
+                         size_t count,
+                         bool *out_ready,
+                         int timeout_ms) {
+    if (avs_is_err(_avs_net_ensure_global_state())
+            || (g_wakeup_handle == COM_SOCKET_INVALID_ID && wakeup_init())) {
+        return -1;
+    }
+    if (count + 1 > g_pollfds_capacity) {
+        struct pollfd *pollfds = (struct pollfd *) avs_realloc(
+                g_pollfds, (count + 1) * sizeof(*g_pollfds));
+        if (!pollfds) {
+            return -1;
+        }
+        g_pollfds = pollfds;
+        g_pollfds_capacity = count + 1;
+    }
+    struct pollfd *const pollfds = g_pollfds;
+    for (size_t i = 0; i < count; ++i) {
+        const int32_t *handle =
+                (const int32_t *) avs_net_socket_get_system(sockets[i]);
+        // negative descriptors are ignored by lwip_poll()
+        pollfds[i].fd = handle ? (int) *handle : -1;
+        pollfds[i].events = POLLIN;
+        pollfds[i].revents = 0;
+    }
+    pollfds[count].fd = (int) g_wakeup_handle;
+    pollfds[count].events = POLLIN;
+    pollfds[count].revents = 0;
+
+    // a wake-up requested before the wakeup socket existed did not send a
+    // datagram; only check the sockets without blocking in that case
+    const bool interrupted = wakeup_pending();
+    int result = lwip_poll(pollfds, (nfds_t) (count + 1),
+                           interrupted ? 0 : timeout_ms);
+    if (interrupted || (result > 0 && pollfds[count].revents)) {
+        wakeup_drain();
+    }
+    if (result <= 0) {
+        return result;
+    }
+    int ready_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if ((out_ready[i] = (pollfds[i].revents != 0))) {
+            ++ready_count;
+        }
+    }
+    return ready_count;
+}
+
+void avs_com_sockets_interrupt_wait(void) {
+    // creates g_wakeup_mtx if no wait has been started yet
+    if (avs_is_err(_avs_net_ensure_global_state())) {
+        return;
+    }
+    osMutexWait(g_wakeup_mtx, osWaitForever);
+    if (!g_wakeup_pending) {
+        // remembered even if the wakeup socket does not exist yet
+        g_wakeup_pending = true;
+        if (g_wakeup_handle != COM_SOCKET_INVALID_ID) {
+            const com_char_t dummy = 0;
+            (void) com_sendto(g_wakeup_handle, &dummy, 1, COM_MSG_DONTWAIT,
+                              (const com_sockaddr_t *) &g_wakeup_addr,
+                              (int32_t) sizeof(g_wakeup_addr));
+        }
+    }
+    osMutexRelease(g_wakeup_mtx);
+}
+#    endif // USE_SOCKETS_TYPE == USE_SOCKETS_MODEM
+
+#endif // defined(AVS_COMMONS_WITH_AVS_NET) &&
+       // !defined(AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET)
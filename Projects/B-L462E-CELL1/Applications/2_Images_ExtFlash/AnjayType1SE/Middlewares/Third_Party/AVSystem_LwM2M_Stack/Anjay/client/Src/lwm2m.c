@@ -18,12 +18,16 @@
 
 #include <anjay/anjay.h>
 #include <anjay/attr_storage.h>
+#include <anjay/fw_update.h>
 #include <anjay/security.h>
 #include <anjay/server.h>
 
 #include <avsystem/commons/avs_list.h>
 #include <avsystem/commons/avs_log.h>
+#include <avsystem/commons/avs_memory.h>
 #include <avsystem/commons/avs_prng.h>
+#include <avsystem/commons/avs_sched.h>
+#include <avsystem/commons/avs_time.h>
 
 #include "cellular_service_datacache.h"
 #include "cmsis_os_misrac2012.h"
@@ -34,11 +38,21 @@
 #include "anjay_client_config.h"
 
 #include "device_object.h"
+#include "modem_power.h"
 
-#include "lwip/sockets.h"
+#include "avs_com_sockets.h"
+#include "avs_pool_allocator.h"
 
 #define LOG(level, ...) avs_log(app, level, __VA_ARGS__)
 
+// Interval between retries of setting up the list of polled sockets after
+// running out of memory, or of waiting for them after an error
+#define POLLED_SOCKETS_RETRY_MS 1000
+
+// Interval between dumps of allocator statistics, for tracking memory usage
+// over a long uptime
+#define POOL_STATS_INTERVAL_S 3600
+
 static anjay_t *g_anjay;
 static avs_crypto_prng_ctx_t *g_prng_ctx;
 
@@ -59,6 +73,43 @@ static osMessageQId status_msg_queue;
 
 static volatile bool g_network_up;
 
+// Sockets waited for by main_loop(). The arrays are kept between iterations
+// and only grow when Anjay has more sockets open than ever before.
+static avs_net_socket_t **g_polled_sockets;
+static bool *g_ready;
+static size_t g_polled_sockets_capacity;
+static size_t g_polled_sockets_count;
+
+static int refresh_polled_sockets(void) {
+    AVS_LIST(avs_net_socket_t *const) sockets = anjay_get_sockets(g_anjay);
+    size_t count = AVS_LIST_SIZE(sockets);
+    if (count > g_polled_sockets_capacity) {
+        avs_net_socket_t **polled_sockets = (avs_net_socket_t **) avs_realloc(
+                g_polled_sockets, count * sizeof(*g_polled_sockets));
+        if (polled_sockets) {
+            g_polled_sockets = polled_sockets;
+        }
+        bool *ready = (bool *) avs_realloc(g_ready, count * sizeof(*g_ready));
+        if (ready) {
+            g_ready = ready;
+        }
+        if (!polled_sockets || !ready) {
+            LOG(ERROR, "out of memory, cannot poll %lu sockets",
+                (unsigned long) count);
+            g_polled_sockets_count = 0;
+            return -1;
+        }
+        g_polled_sockets_capacity = count;
+    }
+    size_t i = 0;
+    AVS_LIST(avs_net_socket_t *const) sock;
+    AVS_LIST_FOREACH(sock, sockets) {
+        g_polled_sockets[i++] = *sock;
+    }
+    g_polled_sockets_count = count;
+    return 0;
+}
+
 static void dc_cellular_callback(dc_com_event_id_t dc_event_id,
                                  const void *user_arg) {
     (void) user_arg;
@@ -74,6 +125,7 @@ static void dc_cellular_callback(dc_com_event_id_t dc_event_id,
         } else {
             g_network_up = false;
             LOG(INFO, "network is down");
+            avs_com_sockets_interrupt_wait();
         }
     } else if (dc_event_id == DC_CELLULAR_CONFIG) {
         dc_cellular_params_t dc_cellular_params;
@@ -87,68 +139,161 @@ static void dc_cellular_callback(dc_com_event_id_t dc_event_id,
 }
 
 void main_loop(void) {
-    while (g_network_up) {
-        AVS_LIST(avs_net_socket_t *const) sockets = NULL;
+    // without USE_LOW_POWER, the network goes down while the modem is
+    // switched off by modem_power_update(); the loop keeps running then, so
+    // that the modem is switched on again before the next job is due
+    while (g_network_up || modem_power_idle()) {
+        // no artificial upper bound - other threads use
+        // avs_com_sockets_interrupt_wait() if they need the loop to react
+        // earlier
+        int wait_ms = -1;
+        bool sockets_polled = true;
         LOCKED(g_anjay_mtx) {
-            sockets = anjay_get_sockets(g_anjay);
-        }
-
-        size_t numsocks = AVS_LIST_SIZE(sockets);
-        struct pollfd pollfds[numsocks];
-        size_t i = 0;
-        AVS_LIST(avs_net_socket_t *const) sock;
-        AVS_LIST_FOREACH(sock, sockets) {
-            pollfds[i].fd = *(const int *) avs_net_socket_get_system(*sock);
-            pollfds[i].events = POLLIN;
-            pollfds[i].revents = 0;
-            ++i;
+            sockets_polled = !refresh_polled_sockets();
+            if (anjay_sched_time_to_next_ms(g_anjay, &wait_ms)) {
+                wait_ms = -1;
+            }
         }
-
-        const int max_wait_time_ms = 1000;
-        int wait_ms = max_wait_time_ms;
-        LOCKED(g_anjay_mtx) {
-            wait_ms = anjay_sched_calculate_wait_time_ms(g_anjay,
-                                                         max_wait_time_ms);
+        if (!sockets_polled
+                && (wait_ms < 0 || wait_ms > POLLED_SOCKETS_RETRY_MS)) {
+            wait_ms = POLLED_SOCKETS_RETRY_MS;
         }
-
-        if (poll(pollfds, numsocks, wait_ms) > 0) {
-            int socket_id = 0;
-            AVS_LIST(avs_net_socket_t *const) socket = NULL;
-            AVS_LIST_FOREACH(socket, sockets) {
-                if (pollfds[socket_id].revents) {
+        wait_ms = modem_power_update(g_polled_sockets_count > 0, wait_ms);
+
+        int ready_count = avs_com_sockets_wait(
+                g_polled_sockets, g_polled_sockets_count, g_ready, wait_ms);
+        if (ready_count < 0) {
+            // the wait returned immediately; sleep instead, so that the loop
+            // does not spin until the error goes away
+            LOG(WARNING, "waiting for sockets failed");
+            if (wait_ms < 0 || wait_ms > POLLED_SOCKETS_RETRY_MS) {
+                wait_ms = POLLED_SOCKETS_RETRY_MS;
+            }
+            osDelay((uint32_t) wait_ms);
+        } else if (ready_count > 0) {
+            for (size_t i = 0; i < g_polled_sockets_count; ++i) {
+                if (g_ready[i]) {
                     LOCKED(g_anjay_mtx) {
-                        if (anjay_serve(g_anjay, *socket)) {
+                        if (anjay_serve(g_anjay, g_polled_sockets[i])) {
                             LOG(ERROR, "anjay_serve() failed");
                         }
                     }
                 }
-                ++socket_id;
             }
         }
 
         LOCKED(g_anjay_mtx) {
             anjay_sched_run(g_anjay);
+            device_object_update(g_anjay);
         }
     }
+    modem_power_wakeup();
 }
 
 static void lwm2m_thread(void const *user_arg) {
     (void) user_arg;
 
-    (void) osMessageGet(status_msg_queue, RTOS_WAIT_FOREVER);
-
-    // TODO handle connection lost
-    main_loop();
+    bool reconnect = false;
+    while (true) {
+        (void) osMessageGet(status_msg_queue, RTOS_WAIT_FOREVER);
+        if (!g_network_up) {
+            continue;
+        }
+        if (reconnect) {
+            // the PDP context may come back with a different address;
+            // sessions using a DTLS connection ID are only rebound to it,
+            // the rest are reconnected with a new handshake
+            LOCKED(g_anjay_mtx) {
+                if (anjay_transport_schedule_reconnect(
+                            g_anjay, ANJAY_TRANSPORT_SET_ALL)) {
+                    LOG(ERROR, "could not schedule reconnect");
+                }
+                // a firmware download interrupted by the network loss
+                // continues from where it stopped
+                if (anjay_fw_update_pull_reconnect(g_anjay)) {
+                    LOG(ERROR, "could not resume firmware download");
+                }
+            }
+        }
+        reconnect = true;
+        main_loop();
+    }
 }
 
 
+#ifndef AVS_COMMONS_UTILS_WITH_STANDARD_ALLOCATOR
+static void log_pool_stats_if_due(void) {
+    static avs_time_monotonic_t next_dump;
+    avs_time_monotonic_t now = avs_time_monotonic_now();
+    if (!avs_time_monotonic_before(now, next_dump)) {
+        avs_pool_allocator_log_stats();
+        next_dump = avs_time_monotonic_add(
+                now,
+                avs_time_duration_from_scalar(POOL_STATS_INTERVAL_S,
+                                              AVS_TIME_S));
+    }
+}
+#endif // AVS_COMMONS_UTILS_WITH_STANDARD_ALLOCATOR
+
 static void lwm2m_notify_thread(void const *process_fcn) {
+    avs_time_monotonic_t next_sample = avs_time_monotonic_now();
+    avs_time_monotonic_t next_process = next_sample;
     while (true) {
+        avs_time_monotonic_t now = avs_time_monotonic_now();
+        bool sample_due = !avs_time_monotonic_before(now, next_sample);
+        bool process_due =
+                process_fcn && !avs_time_monotonic_before(now, next_process);
+        bool wakeup = false;
         LOCKED(g_anjay_mtx) {
-            device_object_update(g_anjay);
-            ((void (*)())process_fcn)();
+            avs_sched_t *sched = anjay_get_scheduler(g_anjay);
+            avs_time_monotonic_t before = avs_sched_time_of_next(sched);
+            if (sample_due) {
+                device_object_sample(g_anjay);
+                // a download may also fail, e.g. on a timeout, while the
+                // network stays up; it is then retried once per period
+                if (g_network_up && anjay_fw_update_pull_reconnect(g_anjay)) {
+                    LOG(ERROR, "could not resume firmware download");
+                }
+            }
+            if (process_due) {
+                ((void (*)()) process_fcn)();
+            }
+            // anjay_notify_changed() and similar calls schedule jobs; the main
+            // loop only needs to know if one of them is due earlier than
+            // whatever it is currently waiting for
+            avs_time_monotonic_t after = avs_sched_time_of_next(sched);
+            wakeup = avs_time_monotonic_valid(after)
+                     && (!avs_time_monotonic_valid(before)
+                         || avs_time_monotonic_before(after, before));
+        }
+        if (wakeup) {
+            avs_com_sockets_interrupt_wait();
+        }
+#ifndef AVS_COMMONS_UTILS_WITH_STANDARD_ALLOCATOR
+        log_pool_stats_if_due();
+#endif // AVS_COMMONS_UTILS_WITH_STANDARD_ALLOCATOR
+
+        if (sample_due) {
+            next_sample = avs_time_monotonic_add(
+                    now, avs_time_duration_from_scalar(LWM2M_SAMPLE_PERIOD_MS,
+                                                       AVS_TIME_MS));
+        }
+        if (process_due) {
+            next_process = avs_time_monotonic_add(
+                    now, avs_time_duration_from_scalar(LWM2M_NOTIFY_PERIOD_MS,
+                                                       AVS_TIME_MS));
+        }
+        avs_time_monotonic_t next = next_sample;
+        if (process_fcn && avs_time_monotonic_before(next_process, next)) {
+            next = next_process;
+        }
+        int64_t delay_ms;
+        if (!avs_time_duration_to_scalar(
+                    &delay_ms, AVS_TIME_MS,
+                    avs_time_monotonic_diff(next, avs_time_monotonic_now()))
+                && delay_ms > 0) {
+            osDelay((uint32_t) delay_ms);
         }
-        osDelay(1000);
     }
 }
 
@@ -174,6 +319,13 @@ entropy_callback(unsigned char *out_buf, size_t out_buf_len, void *user_ptr) {
     return 0;
 }
 
+static bool use_connection_id(anjay_ssid_t ssid, void *arg) {
+    (void) arg;
+    // Bootstrap sessions are short-lived, while the session with the
+    // management server has to survive NAT rebinding without a new handshake
+    return ssid != ANJAY_SSID_BOOTSTRAP;
+}
+
 static int setup_security_object() {
     if (anjay_security_object_install(g_anjay)) {
         return -1;
@@ -201,14 +353,26 @@ static int setup_server_object() {
     if (anjay_server_object_install(g_anjay)) {
         return -1;
     }
+#ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    // Server Object Resources only change through writes, which Anjay reports
+    // by itself; the Device Object does not qualify, as e.g. Memory Free is
+    // never reported
+    if (anjay_observe_incremental_read_enable(g_anjay, 1)) {
+        LOG(WARNING, "could not enable incremental reads of Server Object");
+    }
+#endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
 
+    // Queue mode lets Anjay close the socket once the exchange with the server
+    // is over, so that the modem may be put into idle mode (or switched off,
+    // if USE_LOW_POWER is disabled) until the next Update or notification;
+    // see modem_power_update()
     const anjay_server_instance_t server_instance = {
         .ssid = 1,
-        .lifetime = 60,
+        .lifetime = 3600,
         .default_min_period = -1,
         .default_max_period = -1,
         .disable_timeout = -1,
-        .binding = "U"
+        .binding = "UQ"
     };
 
     anjay_iid_t server_instance_id = ANJAY_ID_INVALID;
@@ -262,6 +426,7 @@ anjay_t * lwm2m_init(void) {
         .in_buffer_size = 2048,
         .out_buffer_size = 2048,
         .msg_cache_size = 2048,
+        .use_connection_id_clb = use_connection_id,
         .prng_ctx = g_prng_ctx
     };
 
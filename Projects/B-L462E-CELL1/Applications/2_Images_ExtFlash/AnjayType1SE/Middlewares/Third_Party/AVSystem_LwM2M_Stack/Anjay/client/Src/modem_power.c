@@ -0,0 +1,114 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+
+#include <avsystem/commons/avs_log.h>
+#include <avsystem/commons/avs_time.h>
+
+#include "plf_config.h"
+
+#include "modem_power.h"
+
+#if (USE_LOW_POWER == 1)
+#    include "cellular_service_power.h"
+#else // USE_LOW_POWER == 1
+#    include "cellular_control_api.h"
+#endif // USE_LOW_POWER == 1
+
+#define LOG(level, ...) avs_log(modem_power, level, __VA_ARGS__)
+
+static bool g_modem_idle;
+
+// Time spent with the radio available, for judging the effect of the
+// observation and lifetime settings on power consumption
+static avs_time_monotonic_t g_radio_on_since;
+static avs_time_duration_t g_radio_on_total;
+
+#if (USE_LOW_POWER == 1)
+static void request_idle(void) {
+    if (CSP_DataIdle() != CELLULAR_OK) {
+        // may fail if the modem is already entering low power mode
+        LOG(DEBUG, "idle mode request failed");
+    }
+}
+
+static void request_wakeup(void) {
+    if (CSP_DataWakeup(HOST_WAKEUP) != CELLULAR_OK) {
+        LOG(DEBUG, "wakeup request failed");
+    }
+}
+#else // USE_LOW_POWER == 1
+static void request_idle(void) {
+    // detaches from the network and powers the modem off
+    if (cellular_modem_stop() != CELLULAR_SUCCESS) {
+        LOG(WARNING, "modem stop request failed");
+    }
+}
+
+static void request_wakeup(void) {
+    // powers the modem on; the network is reported as up once attached
+    if (cellular_connect() != CELLULAR_SUCCESS) {
+        LOG(WARNING, "modem start request failed");
+    }
+}
+#endif // USE_LOW_POWER == 1
+
+static void enter_idle(void) {
+    avs_time_monotonic_t now = avs_time_monotonic_now();
+    if (avs_time_monotonic_valid(g_radio_on_since)) {
+        g_radio_on_total = avs_time_duration_add(
+                g_radio_on_total,
+                avs_time_monotonic_diff(now, g_radio_on_since));
+    }
+    g_radio_on_since = AVS_TIME_MONOTONIC_INVALID;
+    g_modem_idle = true;
+    request_idle();
+    LOG(INFO, "modem idle, radio on for %s s in total",
+        AVS_TIME_DURATION_AS_STRING(g_radio_on_total));
+}
+
+void modem_power_wakeup(void) {
+    if (!avs_time_monotonic_valid(g_radio_on_since)) {
+        g_radio_on_since = avs_time_monotonic_now();
+    }
+    if (g_modem_idle) {
+        g_modem_idle = false;
+        request_wakeup();
+        LOG(INFO, "modem woken up");
+    }
+}
+
+bool modem_power_idle(void) {
+    return g_modem_idle;
+}
+
+int modem_power_update(bool sockets_open, int wait_ms) {
+    if (sockets_open
+            || (wait_ms >= 0 && wait_ms <= MODEM_POWER_WAKEUP_LEAD_MS)) {
+        modem_power_wakeup();
+        return wait_ms;
+    }
+    if (!g_modem_idle) {
+        if (wait_ms >= 0
+                && wait_ms < MODEM_POWER_WAKEUP_LEAD_MS
+                                     + MODEM_POWER_MIN_IDLE_MS) {
+            return wait_ms;
+        }
+        enter_idle();
+    }
+    return wait_ms < 0 ? wait_ms : wait_ms - MODEM_POWER_WAKEUP_LEAD_MS;
+}
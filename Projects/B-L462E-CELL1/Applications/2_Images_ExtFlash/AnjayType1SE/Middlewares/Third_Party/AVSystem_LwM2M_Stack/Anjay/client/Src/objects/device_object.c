@@ -22,10 +22,12 @@
 #include <avsystem/commons/avs_log.h>
 #include <avsystem/commons/avs_memory.h>
 
+#include "cmsis_os_misrac2012.h"
 #include "main.h"
 #include "stm32l4xx.h"
 #include "stm32l4xx_hal_cortex.h"
 
+#include "persistence.h"
 #include "utils.h"
 
 /**
@@ -65,6 +67,14 @@
  */
 #define RID_REBOOT 4
 
+/**
+ * Memory Free: R, Single, Optional
+ * type: integer, range: N/A, unit: KB
+ * Estimated current available amount of storage space which can store
+ * data and software in the LwM2M Device (expressed in kilobytes).
+ */
+#define RID_MEMORY_FREE 10
+
 /**
  * Error Code: R, Multiple, Mandatory
  * type: integer, range: 0..8, unit: N/A
@@ -104,6 +114,10 @@
  */
 #define RID_SOFTWARE_VERSION 19
 
+// Number of Memory Free samples buffered for the next notification, i.e. the
+// samples of the last 8 minutes at the default LWM2M_SAMPLE_PERIOD_MS
+#define MEMORY_FREE_SAMPLES 16
+
 typedef struct device_object_struct {
     const anjay_dm_object_def_t *def;
 
@@ -134,6 +148,8 @@ static int list_resources(anjay_t *anjay,
     anjay_dm_emit_res(ctx, RID_FIRMWARE_VERSION, ANJAY_DM_RES_R,
                       ANJAY_DM_RES_PRESENT);
     anjay_dm_emit_res(ctx, RID_REBOOT, ANJAY_DM_RES_E, ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, RID_MEMORY_FREE, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
     anjay_dm_emit_res(ctx, RID_ERROR_CODE, ANJAY_DM_RES_RM,
                       ANJAY_DM_RES_PRESENT);
     anjay_dm_emit_res(ctx, RID_SUPPORTED_BINDING_AND_MODES, ANJAY_DM_RES_R,
@@ -143,6 +159,12 @@ static int list_resources(anjay_t *anjay,
     return 0;
 }
 
+// Free FreeRTOS heap, which also backs the allocations that do not fit in the
+// avs_malloc() pools
+static int64_t memory_free_kb(void) {
+    return (int64_t) (xPortGetFreeHeapSize() / 1024U);
+}
+
 static int resource_read(anjay_t *anjay,
                          const anjay_dm_object_def_t *const *obj_ptr,
                          anjay_iid_t iid,
@@ -173,6 +195,10 @@ static int resource_read(anjay_t *anjay,
         assert(riid == ANJAY_ID_INVALID);
         return anjay_ret_string(ctx, "2.13.0");
 
+    case RID_MEMORY_FREE:
+        assert(riid == ANJAY_ID_INVALID);
+        return anjay_ret_i64(ctx, memory_free_kb());
+
     case RID_ERROR_CODE:
         assert(riid == 0);
         return anjay_ret_i32(ctx, 0);
@@ -252,7 +278,27 @@ static const anjay_dm_object_def_t **OBJ_DEF_PTR = &DEVICE_OBJECT.def;
 
 int device_object_install(anjay_t *anjay) {
     get_uid(&DEVICE_OBJECT.serial_number);
-    return anjay_register_object(anjay, OBJ_DEF_PTR);
+    if (anjay_register_object(anjay, OBJ_DEF_PTR)) {
+        return -1;
+    }
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    // Memory Free is sampled by device_object_sample(), so that observing it
+    // with a long pmax reports its whole history
+    if (anjay_sample_buffer_enable(anjay, OBJ_DEF.oid, 0, RID_MEMORY_FREE,
+                                   MEMORY_FREE_SAMPLES)) {
+        avs_log(device, WARNING, "could not enable Memory Free sampling");
+    }
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    return 0;
+}
+
+void device_object_sample(anjay_t *anjay) {
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    (void) anjay_sample_buffer_add_int(anjay, OBJ_DEF.oid, 0, RID_MEMORY_FREE,
+                                       memory_free_kb());
+#else  // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    (void) anjay;
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
 }
 
 void device_object_update(anjay_t *anjay) {
@@ -264,6 +310,10 @@ void device_object_update(anjay_t *anjay) {
 
     if (obj->reboot) {
         avs_log(device, INFO, "Rebooting...");
+        (void) persistence_store(anjay);
+#ifdef AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+        avs_log_deferred_flush();
+#endif // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
         HAL_NVIC_SystemReset();
     }
 }
@@ -32,6 +32,19 @@ void get_uid(device_id_t *out_id) {
                 sizeof(uid_words));
 }
 
+uint32_t calculate_crc32(const void *data, size_t length) {
+    const uint8_t *bytes = (const uint8_t *) data;
+    uint32_t crc = 0xFFFFFFFFU;
+
+    while (length--) {
+        crc ^= *bytes++;
+        for (int i = 0; i < 8; ++i) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
 void init_modem_pins() {
 	GPIO_InitTypeDef GPIO_InitStruct = {0};
 
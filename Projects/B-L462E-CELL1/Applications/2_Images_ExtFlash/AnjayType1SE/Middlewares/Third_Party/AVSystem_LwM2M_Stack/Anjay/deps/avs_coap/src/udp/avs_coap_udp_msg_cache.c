@@ -41,15 +41,42 @@ VISIBILITY_SOURCE_BEGIN
 
 typedef struct endpoint {
     uint16_t refcount;
+    // hash of addr and port, see endpoint_hash()
+    uint32_t hash;
     char addr[AVS_ADDRSTRLEN];
     char port[sizeof("65535")];
 } endpoint_t;
 
+/**
+ * Slot of the (endpoint, message ID) -> cache entry index.
+ *
+ * The index is an open-addressing hash table with linear probing. Entries are
+ * referred to by their position in a virtual, never-rewinding stream of bytes
+ * that passed through the buffer: position of the first byte currently in the
+ * buffer is @ref avs_coap_udp_response_cache::head_pos. This keeps the index
+ * valid when the buffer gets defragmented.
+ */
+typedef struct {
+    // 0 for an empty slot; hash_key() never returns 0
+    uint32_t hash;
+    uint32_t pos;
+} index_slot_t;
+
+#    define INDEX_INITIAL_SIZE 16
+
 struct avs_coap_udp_response_cache {
-    AVS_LIST(endpoint_t) endpoints; // sorted by id
+    AVS_LIST(endpoint_t) endpoints;
 
     // priority queue of cache_entry_t, sorted by expiration_time
     avs_buffer_t *buffer;
+    // virtual position of avs_buffer_data(buffer), see index_slot_t
+    uint32_t head_pos;
+
+    // number of entries in the buffer, and thus used index slots
+    size_t entry_count;
+    // power of two, or 0 if the index is not allocated yet
+    size_t index_size;
+    index_slot_t *index;
 };
 
 typedef struct cache_entry {
@@ -89,24 +116,56 @@ void avs_coap_udp_response_cache_release(
     if (cache_ptr && *cache_ptr) {
         avs_buffer_free(&(*cache_ptr)->buffer);
         AVS_LIST_CLEAR(&(*cache_ptr)->endpoints);
+        avs_free((*cache_ptr)->index);
         avs_free(*cache_ptr);
         *cache_ptr = NULL;
     }
 }
 
+static uint32_t hash_bytes(uint32_t hash, const char *str) {
+    // FNV-1a, including the terminating nullbyte
+    do {
+        hash = (hash ^ (uint8_t) *str) * 16777619U;
+    } while (*str++);
+    return hash;
+}
+
+static uint32_t endpoint_hash(const char *remote_addr,
+                              const char *remote_port) {
+    return hash_bytes(hash_bytes(2166136261U, remote_addr), remote_port);
+}
+
+/**
+ * Finds an endpoint without taking a reference to it. Endpoints are interned,
+ * so entries for the same remote host always point to the same endpoint_t, and
+ * the textual address is only compared once per lookup, not once per entry.
+ */
+static endpoint_t *
+cache_endpoint_find(const avs_coap_udp_response_cache_t *cache,
+                    uint32_t hash,
+                    const char *remote_addr,
+                    const char *remote_port) {
+    AVS_LIST(endpoint_t) ep;
+    AVS_LIST_FOREACH(ep, cache->endpoints) {
+        if (ep->hash == hash && !strcmp(remote_addr, ep->addr)
+                && !strcmp(remote_port, ep->port)) {
+            return ep;
+        }
+    }
+    return NULL;
+}
+
 static endpoint_t *cache_endpoint_add_ref(avs_coap_udp_response_cache_t *cache,
                                           const char *remote_addr,
                                           const char *remote_port) {
     assert(remote_addr);
     assert(remote_port);
 
-    AVS_LIST(endpoint_t) *ep_ptr;
-    AVS_LIST_FOREACH_PTR(ep_ptr, &cache->endpoints) {
-        if (!strcmp(remote_addr, (*ep_ptr)->addr)
-                && !strcmp(remote_port, (*ep_ptr)->port)) {
-            ++(*ep_ptr)->refcount;
-            return *ep_ptr;
-        }
+    uint32_t hash = endpoint_hash(remote_addr, remote_port);
+    endpoint_t *ep = cache_endpoint_find(cache, hash, remote_addr, remote_port);
+    if (ep) {
+        ++ep->refcount;
+        return ep;
     }
 
     AVS_LIST(endpoint_t) new_ep = AVS_LIST_NEW_ELEMENT(endpoint_t);
@@ -130,6 +189,7 @@ static endpoint_t *cache_endpoint_add_ref(avs_coap_udp_response_cache_t *cache,
     }
 
     new_ep->refcount = 1;
+    new_ep->hash = hash;
     AVS_LIST_INSERT(&cache->endpoints, new_ep);
 
     LOG(TRACE, _("added cache endpoint: ") "%s:%s", new_ep->addr, new_ep->port);
@@ -159,6 +219,56 @@ static size_t padding_bytes_after_msg(size_t msg_size) {
     }
 }
 
+static uint32_t hash_key(const endpoint_t *endpoint, uint16_t msg_id) {
+    uint32_t hash = (endpoint->hash ^ msg_id) * 2654435761U;
+    hash ^= hash >> 16;
+    return hash ? hash : 1;
+}
+
+static void index_insert_slot(index_slot_t *index,
+                              size_t index_size,
+                              uint32_t hash,
+                              uint32_t pos) {
+    const size_t mask = index_size - 1;
+    size_t i = hash & mask;
+    while (index[i].hash) {
+        i = (i + 1) & mask;
+    }
+    index[i].hash = hash;
+    index[i].pos = pos;
+}
+
+/**
+ * Makes sure that the index can hold @p count entries while staying at most
+ * half full, so that probe sequences stay short.
+ */
+static int index_reserve(avs_coap_udp_response_cache_t *cache, size_t count) {
+    if (count * 2 <= cache->index_size) {
+        return 0;
+    }
+    size_t new_size =
+            cache->index_size ? cache->index_size * 2 : INDEX_INITIAL_SIZE;
+    while (count * 2 > new_size) {
+        new_size *= 2;
+    }
+    index_slot_t *new_index =
+            (index_slot_t *) avs_calloc(new_size, sizeof(index_slot_t));
+    if (!new_index) {
+        LOG(DEBUG, _("out of memory"));
+        return -1;
+    }
+    for (size_t i = 0; i < cache->index_size; ++i) {
+        if (cache->index[i].hash) {
+            index_insert_slot(new_index, new_size, cache->index[i].hash,
+                              cache->index[i].pos);
+        }
+    }
+    avs_free(cache->index);
+    cache->index = new_index;
+    cache->index_size = new_size;
+    return 0;
+}
+
 static void cache_put_entry(avs_coap_udp_response_cache_t *cache,
                             const avs_time_monotonic_t *expiration_time,
                             endpoint_t *endpoint,
@@ -176,6 +286,15 @@ static void cache_put_entry(avs_coap_udp_response_cache_t *cache,
 
     assert(avs_buffer_data_size(cache->buffer) % AVS_ALIGNOF(cache_entry_t)
            == 0);
+    assert((cache->entry_count + 1) * 2 <= cache->index_size);
+    index_insert_slot(cache->index, cache->index_size,
+                      hash_key(endpoint, _avs_coap_udp_header_get_id(
+                                                 &msg->header)),
+                      cache->head_pos
+                              + (uint32_t) avs_buffer_data_size(
+                                        cache->buffer));
+    ++cache->entry_count;
+
     int res;
     res = avs_buffer_append_bytes(cache->buffer, &entry,
                                   offsetof(cache_entry_t, data));
@@ -246,6 +365,57 @@ static const cache_entry_t *entry_next(const cache_entry_t *entry) {
     return result;
 }
 
+static uint32_t entry_pos(const avs_coap_udp_response_cache_t *cache,
+                          const cache_entry_t *entry) {
+    return cache->head_pos
+           + (uint32_t) ((const char *) entry - avs_buffer_data(cache->buffer));
+}
+
+static const cache_entry_t *
+entry_at(const avs_coap_udp_response_cache_t *cache, uint32_t pos) {
+    const cache_entry_t *result =
+            (const cache_entry_t *) (avs_buffer_data(cache->buffer)
+                                     + (uint32_t) (pos - cache->head_pos));
+    assert(entry_valid(cache, result));
+    return result;
+}
+
+/**
+ * Removes @p entry from the index. Must be called before the entry is
+ * consumed from the buffer and before its endpoint reference is dropped.
+ */
+static void index_remove(avs_coap_udp_response_cache_t *cache,
+                         const cache_entry_t *entry) {
+    const size_t mask = cache->index_size - 1;
+    const uint32_t pos = entry_pos(cache, entry);
+    size_t i = hash_key(entry->endpoint, entry_id(entry)) & mask;
+    while (cache->index[i].pos != pos || !cache->index[i].hash) {
+        assert(cache->index[i].hash);
+        i = (i + 1) & mask;
+    }
+
+    // backward shift deletion: move subsequent slots of the probe sequence
+    // into the hole, unless that would put them before their home slot
+    for (size_t j = (i + 1) & mask; cache->index[j].hash;
+         j = (j + 1) & mask) {
+        size_t home = cache->index[j].hash & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            cache->index[i] = cache->index[j];
+            i = j;
+        }
+    }
+    cache->index[i].hash = 0;
+    --cache->entry_count;
+}
+
+static void cache_consume_bytes(avs_coap_udp_response_cache_t *cache,
+                                size_t bytes) {
+    int res = avs_buffer_consume_bytes(cache->buffer, bytes);
+    assert(!res);
+    (void) res;
+    cache->head_pos += (uint32_t) bytes;
+}
+
 static void cache_free_bytes(avs_coap_udp_response_cache_t *cache,
                              size_t bytes_required) {
     assert(bytes_required <= avs_buffer_capacity(cache->buffer));
@@ -261,14 +431,13 @@ static void cache_free_bytes(avs_coap_udp_response_cache_t *cache,
             _("msg_cache: dropping msg (id = ") "%u" _(
                     ") to make room for a new one (size = ") "%lu" _(")"),
             entry_id(entry), (unsigned long) bytes_required);
+        index_remove(cache, entry);
         cache_endpoint_del_ref(cache, entry->endpoint);
         bytes_free += entry_size(entry);
     }
 
-    size_t expired_bytes = (uintptr_t) entry - (uintptr_t) entry_first(cache);
-    int res = avs_buffer_consume_bytes(cache->buffer, expired_bytes);
-    assert(!res);
-    (void) res;
+    cache_consume_bytes(cache, (uintptr_t) entry
+                                       - (uintptr_t) entry_first(cache));
 }
 
 static void cache_drop_expired(avs_coap_udp_response_cache_t *cache,
@@ -279,16 +448,15 @@ static void cache_drop_expired(avs_coap_udp_response_cache_t *cache,
         if (entry_expired(entry, now)) {
             LOG(TRACE, _("msg_cache: dropping expired msg (id = ") "%u" _(")"),
                 entry_id(entry));
+            index_remove(cache, entry);
             cache_endpoint_del_ref(cache, entry->endpoint);
         } else {
             break;
         }
     }
 
-    size_t expired_bytes = (uintptr_t) entry - (uintptr_t) entry_first(cache);
-    int res = avs_buffer_consume_bytes(cache->buffer, expired_bytes);
-    assert(!res);
-    (void) res;
+    cache_consume_bytes(cache, (uintptr_t) entry
+                                       - (uintptr_t) entry_first(cache));
 }
 
 static const cache_entry_t *
@@ -296,13 +464,24 @@ find_entry(const avs_coap_udp_response_cache_t *cache,
            const char *remote_addr,
            const char *remote_port,
            uint16_t msg_id) {
-    for (const cache_entry_t *entry = entry_first(cache);
-         entry_valid(cache, entry);
-         entry = entry_next(entry)) {
-        if (entry_id(entry) == msg_id
-                && !strcmp(entry->endpoint->addr, remote_addr)
-                && !strcmp(entry->endpoint->port, remote_port)) {
-            return entry;
+    if (!cache->entry_count) {
+        return NULL;
+    }
+    const endpoint_t *endpoint =
+            cache_endpoint_find(cache, endpoint_hash(remote_addr, remote_port),
+                                remote_addr, remote_port);
+    if (!endpoint) {
+        return NULL;
+    }
+
+    const size_t mask = cache->index_size - 1;
+    const uint32_t hash = hash_key(endpoint, msg_id);
+    for (size_t i = hash & mask; cache->index[i].hash; i = (i + 1) & mask) {
+        if (cache->index[i].hash == hash) {
+            const cache_entry_t *entry = entry_at(cache, cache->index[i].pos);
+            if (entry->endpoint == endpoint && entry_id(entry) == msg_id) {
+                return entry;
+            }
         }
     }
 
@@ -338,6 +517,10 @@ int _avs_coap_udp_response_cache_add(
         return AVS_COAP_MSG_CACHE_DUPLICATE;
     }
 
+    if (index_reserve(cache, cache->entry_count + 1)) {
+        return -1;
+    }
+
     endpoint_t *ep = cache_endpoint_add_ref(cache, remote_addr, remote_port);
     if (!ep) {
         return -1;
@@ -387,4 +570,8 @@ size_t _avs_coap_udp_response_cache_overhead(const avs_coap_udp_msg_t *msg) {
            + padding_bytes_after_msg(_avs_coap_udp_msg_size(msg));
 }
 
+#    ifdef AVS_UNIT_TESTING
+#        include "tests/udp/msg_cache_index.c"
+#    endif // AVS_UNIT_TESTING
+
 #endif // WITH_AVS_COAP_UDP
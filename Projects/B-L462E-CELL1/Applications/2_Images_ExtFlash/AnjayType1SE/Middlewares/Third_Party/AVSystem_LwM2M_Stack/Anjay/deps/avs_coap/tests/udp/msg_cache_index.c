@@ -0,0 +1,241 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_unit_test.h>
+
+/*
+ * Checks the (endpoint, message ID) index of the response cache against
+ * a model of the cache contents. All entries share the same lifetime, so
+ * the cache drops them in the order they were added.
+ */
+
+#define INDEX_TEST_MAX_ADDS 4096
+#define INDEX_TEST_MAX_PAYLOAD 48
+
+static const char *const INDEX_TEST_ADDRS[] = { "10.0.0.1", "10.0.0.2",
+                                                "fe80::1" };
+static const char *const INDEX_TEST_PORTS[] = { "5683", "56830" };
+
+#define INDEX_TEST_ENDPOINTS                 \
+    (AVS_ARRAY_SIZE(INDEX_TEST_ADDRS)        \
+     * AVS_ARRAY_SIZE(INDEX_TEST_PORTS))
+
+typedef struct {
+    unsigned endpoint;
+    uint16_t id;
+    size_t payload_size;
+    size_t cost;
+    bool cached;
+} index_test_entry_t;
+
+static struct {
+    index_test_entry_t entries[INDEX_TEST_MAX_ADDS];
+    size_t count;
+    // oldest entry that may still be cached
+    size_t oldest;
+    size_t bytes_used;
+    uint32_t random;
+} g_index_test;
+
+static uint32_t index_test_random(uint32_t range) {
+    g_index_test.random = g_index_test.random * 1103515245u + 12345u;
+    return (g_index_test.random >> 8) % range;
+}
+
+static const char *index_test_addr(unsigned endpoint) {
+    return INDEX_TEST_ADDRS[endpoint / AVS_ARRAY_SIZE(INDEX_TEST_PORTS)];
+}
+
+static const char *index_test_port(unsigned endpoint) {
+    return INDEX_TEST_PORTS[endpoint % AVS_ARRAY_SIZE(INDEX_TEST_PORTS)];
+}
+
+// the payload identifies the entry, so that a lookup returning a wrong one
+// is detected
+static void index_test_payload(uint8_t *out, const index_test_entry_t *entry) {
+    for (size_t i = 0; i < entry->payload_size; ++i) {
+        out[i] = (uint8_t) (entry->endpoint * 31 + entry->id + i);
+    }
+}
+
+static avs_coap_udp_msg_t index_test_msg(const index_test_entry_t *entry,
+                                         uint8_t *payload_buf) {
+    index_test_payload(payload_buf, entry);
+    return (avs_coap_udp_msg_t) {
+        .header = _avs_coap_udp_header_init(AVS_COAP_UDP_TYPE_ACKNOWLEDGEMENT,
+                                            0, AVS_COAP_CODE_CONTENT,
+                                            entry->id),
+        .options = avs_coap_options_create_empty(NULL, 0),
+        .payload = payload_buf,
+        .payload_size = entry->payload_size
+    };
+}
+
+// Every used slot must be reachable from its home slot without crossing an
+// empty one, and must point at an entry with a matching key
+static void assert_index_valid(const avs_coap_udp_response_cache_t *cache) {
+    size_t used = 0;
+    const size_t mask = cache->index_size - 1;
+    for (size_t i = 0; i < cache->index_size; ++i) {
+        if (!cache->index[i].hash) {
+            continue;
+        }
+        ++used;
+        for (size_t j = cache->index[i].hash & mask; j != i;
+             j = (j + 1) & mask) {
+            AVS_UNIT_ASSERT_TRUE(cache->index[j].hash);
+        }
+        const cache_entry_t *entry = entry_at(cache, cache->index[i].pos);
+        AVS_UNIT_ASSERT_EQUAL(hash_key(entry->endpoint, entry_id(entry)),
+                              cache->index[i].hash);
+    }
+    AVS_UNIT_ASSERT_EQUAL(used, cache->entry_count);
+    AVS_UNIT_ASSERT_TRUE(cache->entry_count * 2 <= cache->index_size
+                         || !cache->index_size);
+}
+
+static void assert_cached(avs_coap_udp_response_cache_t *cache,
+                          const index_test_entry_t *entry) {
+    avs_coap_udp_cached_response_t response;
+    AVS_UNIT_ASSERT_SUCCESS(_avs_coap_udp_response_cache_get(
+            cache, index_test_addr(entry->endpoint),
+            index_test_port(entry->endpoint), entry->id, &response));
+    uint8_t expected[INDEX_TEST_MAX_PAYLOAD];
+    index_test_payload(expected, entry);
+    AVS_UNIT_ASSERT_EQUAL(response.msg.payload_size, entry->payload_size);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(response.msg.payload, expected,
+                                      entry->payload_size);
+}
+
+static bool index_test_find_cached(unsigned endpoint, uint16_t id) {
+    for (size_t i = g_index_test.oldest; i < g_index_test.count; ++i) {
+        const index_test_entry_t *entry = &g_index_test.entries[i];
+        if (entry->cached && entry->endpoint == endpoint && entry->id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void index_test_add(avs_coap_udp_response_cache_t *cache,
+                           size_t capacity) {
+    index_test_entry_t *entry = &g_index_test.entries[g_index_test.count];
+    entry->endpoint = index_test_random(INDEX_TEST_ENDPOINTS);
+    entry->id = (uint16_t) index_test_random(256);
+    entry->payload_size = index_test_random(INDEX_TEST_MAX_PAYLOAD + 1);
+
+    uint8_t payload[INDEX_TEST_MAX_PAYLOAD];
+    avs_coap_udp_msg_t msg = index_test_msg(entry, payload);
+    int result = _avs_coap_udp_response_cache_add(
+            cache, index_test_addr(entry->endpoint),
+            index_test_port(entry->endpoint), &msg,
+            &AVS_COAP_DEFAULT_UDP_TX_PARAMS);
+    if (index_test_find_cached(entry->endpoint, entry->id)) {
+        AVS_UNIT_ASSERT_EQUAL(result, AVS_COAP_MSG_CACHE_DUPLICATE);
+        return;
+    }
+    AVS_UNIT_ASSERT_SUCCESS(result);
+
+    entry->cost = _avs_coap_udp_response_cache_overhead(&msg)
+                  + _avs_coap_udp_msg_size(&msg);
+    while (capacity - g_index_test.bytes_used < entry->cost) {
+        index_test_entry_t *dropped =
+                &g_index_test.entries[g_index_test.oldest++];
+        if (dropped->cached) {
+            dropped->cached = false;
+            g_index_test.bytes_used -= dropped->cost;
+        }
+    }
+    entry->cached = true;
+    g_index_test.bytes_used += entry->cost;
+    ++g_index_test.count;
+}
+
+static void index_test_run(size_t capacity, uint32_t seed, size_t adds) {
+    memset(&g_index_test, 0, sizeof(g_index_test));
+    g_index_test.random = seed;
+    avs_coap_udp_response_cache_t *cache =
+            avs_coap_udp_response_cache_create(capacity);
+    AVS_UNIT_ASSERT_NOT_NULL(cache);
+
+    while (g_index_test.count < adds) {
+        index_test_add(cache, capacity);
+        assert_index_valid(cache);
+    }
+
+    size_t cached = 0;
+    for (size_t i = 0; i < g_index_test.count; ++i) {
+        const index_test_entry_t *entry = &g_index_test.entries[i];
+        if (entry->cached) {
+            assert_cached(cache, entry);
+            ++cached;
+        }
+    }
+    AVS_UNIT_ASSERT_EQUAL(cache->entry_count, cached);
+
+    // IDs that were never used, or whose entries have been dropped
+    for (unsigned endpoint = 0; endpoint < INDEX_TEST_ENDPOINTS; ++endpoint) {
+        for (uint16_t id = 0; id < 300; ++id) {
+            if (!index_test_find_cached(endpoint, id)) {
+                avs_coap_udp_cached_response_t response;
+                AVS_UNIT_ASSERT_FAILED(_avs_coap_udp_response_cache_get(
+                        cache, index_test_addr(endpoint),
+                        index_test_port(endpoint), id, &response));
+            }
+        }
+    }
+    avs_coap_udp_response_cache_release(&cache);
+}
+
+AVS_UNIT_TEST(udp_msg_cache_index, small_cache_drops_oldest_entries) {
+    // a few entries at a time, so that most of them get dropped
+    index_test_run(256, 1, INDEX_TEST_MAX_ADDS);
+}
+
+AVS_UNIT_TEST(udp_msg_cache_index, large_cache_grows_the_index) {
+    // hundreds of entries, most of them in the cache at the same time
+    index_test_run(32768, 2, 2000);
+}
+
+AVS_UNIT_TEST(udp_msg_cache_index, same_id_from_different_endpoints) {
+    avs_coap_udp_response_cache_t *cache =
+            avs_coap_udp_response_cache_create(1024);
+    AVS_UNIT_ASSERT_NOT_NULL(cache);
+    memset(&g_index_test, 0, sizeof(g_index_test));
+    for (unsigned endpoint = 0; endpoint < INDEX_TEST_ENDPOINTS; ++endpoint) {
+        index_test_entry_t *entry = &g_index_test.entries[endpoint];
+        entry->endpoint = endpoint;
+        entry->id = 42;
+        entry->payload_size = endpoint;
+        uint8_t payload[INDEX_TEST_MAX_PAYLOAD];
+        avs_coap_udp_msg_t msg = index_test_msg(entry, payload);
+        AVS_UNIT_ASSERT_SUCCESS(_avs_coap_udp_response_cache_add(
+                cache, index_test_addr(endpoint), index_test_port(endpoint),
+                &msg, &AVS_COAP_DEFAULT_UDP_TX_PARAMS));
+        AVS_UNIT_ASSERT_EQUAL(_avs_coap_udp_response_cache_add(
+                                      cache, index_test_addr(endpoint),
+                                      index_test_port(endpoint), &msg,
+                                      &AVS_COAP_DEFAULT_UDP_TX_PARAMS),
+                              AVS_COAP_MSG_CACHE_DUPLICATE);
+    }
+    for (unsigned endpoint = 0; endpoint < INDEX_TEST_ENDPOINTS; ++endpoint) {
+        assert_cached(cache, &g_index_test.entries[endpoint]);
+    }
+    // endpoints are interned: one per address and port
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(cache->endpoints),
+                          INDEX_TEST_ENDPOINTS);
+    avs_coap_udp_response_cache_release(&cache);
+}
@@ -150,6 +150,52 @@ void avs_log_set_extended_handler(avs_log_extended_handler_t *log_handler);
  */
 void avs_log_reset(void);
 
+#ifdef AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+/**
+ * Formats all messages recorded in deferred mode (see
+ * <c>AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE</c>) and passes them to the log
+ * handler, in the order in which they were logged. If any messages have been
+ * dropped because the buffer was full since the last call, a warning with their
+ * number is passed to the handler as well.
+ *
+ * This function is intended to be called from a low-priority thread, when woken
+ * up by the function set with @ref avs_log_set_deferred_notify, or
+ * periodically. The log handler is called from within this function, without
+ * any lock held. Calls made while another one is in progress return 0 right
+ * away.
+ *
+ * Messages that cannot be recorded (i.e. ones using <c>%n</c> or wide
+ * character conversions, or ones with arguments too long to fit in half of the
+ * buffer) are still formatted and passed to the log handler immediately, and
+ * thus may appear before some earlier messages.
+ *
+ * @returns Number of recorded messages passed to the log handler.
+ */
+size_t avs_log_deferred_flush(void);
+
+/**
+ * Returns the total number of messages dropped in deferred mode because the
+ * buffer was full.
+ */
+uint32_t avs_log_deferred_dropped(void);
+
+/**
+ * Function called whenever a message has been recorded in deferred mode, or
+ * dropped because the buffer was full, e.g. to wake up the thread that calls
+ * @ref avs_log_deferred_flush.
+ *
+ * It is called from the thread that logs the message, so it shall return
+ * quickly and shall not log anything itself.
+ */
+typedef void avs_log_deferred_notify_t(void);
+
+/**
+ * Sets the function called whenever a message has been recorded in deferred
+ * mode. NULL, which is the default, disables the notifications.
+ */
+void avs_log_set_deferred_notify(avs_log_deferred_notify_t *notify);
+#endif // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+
 /**
  * @name Logging subsystem internals
  */
@@ -577,6 +577,22 @@ typedef enum {
      * socket or is not configured to use DANE, will yield an error.
      */
     AVS_NET_SOCKET_OPT_DANE_TLSA_ARRAY,
+
+    /**
+     * Used to check whether the DTLS connection_id extension has been
+     * negotiated during the last handshake, with a non-empty CID chosen by the
+     * peer. The value is passed in the <c>flag</c> field of the
+     * @ref avs_net_socket_opt_value_t union. If the socket is in any other
+     * state than @ref AVS_NET_SOCKET_STATE_CONNECTED, the behaviour is
+     * undefined.
+     *
+     * If this flag is <c>true</c>, the peer identifies the session by the CID
+     * instead of the client's address, and @ref avs_net_socket_connect may be
+     * called again on the connected socket: the underlying UDP socket is then
+     * recreated (e.g. after a change of the local address), but the DTLS
+     * session is kept as is, without any handshake.
+     */
+    AVS_NET_SOCKET_OPT_CONNECTION_ID_USED,
 } avs_net_socket_opt_key_t;
 
 typedef enum {
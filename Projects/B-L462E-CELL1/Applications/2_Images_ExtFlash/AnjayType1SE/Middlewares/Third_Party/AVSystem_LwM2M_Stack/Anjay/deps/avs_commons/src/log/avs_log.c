@@ -23,6 +23,10 @@
 #    include <stdio.h>
 #    include <string.h>
 
+#    ifdef AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+#        include <stdatomic.h>
+#    endif // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+
 #    include <avsystem/commons/avs_list.h>
 #    include <avsystem/commons/avs_log.h>
 
@@ -300,12 +304,678 @@ static void log_with_buffer_unlocked_v(char *log_buf,
     }
 }
 
+#    ifdef AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+// In deferred mode, messages are not formatted by the thread that logs them.
+// Instead, each one is stored in a ring buffer as a record that contains the
+// call site data, the format string pointer and the binary values of the
+// arguments. Strings passed for %s are copied, as they may not outlive the
+// call. Records are formatted and passed to the log handler by
+// avs_log_deferred_flush().
+//
+// The ring buffer is lock-free for any number of producers and a single
+// consumer. Producers reserve space by advancing head with compare-and-swap,
+// and commit a record by storing its size into its first word. The consumer
+// zeroes every record it has processed before advancing tail, so a zero first
+// word always means that the record has not been committed yet.
+
+AVS_STATIC_ASSERT((AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+                   & (AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE - 1))
+                          == 0,
+                  deferred_buffer_size_is_a_power_of_two);
+
+// Set in the first word of a record that only fills the space up to the end of
+// the buffer, so that the next record is contiguous
+#        define DEFERRED_PADDING 0x80000000UL
+
+typedef struct {
+    atomic_uint_least32_t state;
+    avs_log_level_t level;
+    unsigned line;
+    const char *module;
+    const char *file;
+    const char *msg;
+} deferred_record_t;
+
+AVS_STATIC_ASSERT(AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+                          >= 2 * sizeof(deferred_record_t),
+                  deferred_buffer_size_is_sane);
+
+static struct {
+    atomic_uint_least32_t head;
+    atomic_uint_least32_t tail;
+    atomic_uint_least32_t dropped;
+    atomic_flag flushing;
+    _Atomic(avs_log_deferred_notify_t *) notify;
+    // the fields below are only accessed while holding the flushing flag
+    uint32_t dropped_reported;
+    char line_buf[AVS_COMMONS_LOG_MAX_LINE_LENGTH];
+    union {
+        deferred_record_t align;
+        char bytes[AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE];
+    } buf;
+} g_deferred = {
+    .flushing = ATOMIC_FLAG_INIT
+};
+
+typedef enum {
+    ARG_NONE,
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_LDOUBLE,
+    ARG_PTR,
+    ARG_STR,
+    ARG_UNSUPPORTED
+} deferred_arg_type_t;
+
+typedef struct {
+    // one past the conversion specifier character
+    const char *end;
+    // number of '*' field width and precision arguments
+    unsigned stars;
+    // true if the precision is given by the last '*' argument
+    bool precision_star;
+    // literal precision, or -1 if there is none
+    int precision;
+    deferred_arg_type_t type;
+} deferred_conv_t;
+
+// Longest conversion specification that can be deferred, e.g. "%-+08.3lld"
+#        define DEFERRED_MAX_CONV_LENGTH 16
+
+static const char *skip_width(const char *p, deferred_conv_t *conv) {
+    if (*p == '*') {
+        ++conv->stars;
+        return p + 1;
+    }
+    while (*p >= '0' && *p <= '9') {
+        ++p;
+    }
+    return p;
+}
+
+// Parses the conversion specification that starts with the '%' at @p spec.
+static void parse_conv(const char *spec, deferred_conv_t *out_conv) {
+    deferred_arg_type_t int_type = ARG_INT;
+    bool is_long = false;
+    bool is_long_double = false;
+    const char *p = spec + 1;
+
+    out_conv->stars = 0;
+    out_conv->precision_star = false;
+    out_conv->precision = -1;
+    out_conv->type = ARG_UNSUPPORTED;
+    while (*p && strchr("-+ #0", *p)) {
+        ++p;
+    }
+    p = skip_width(p, out_conv);
+    if (*p == '.') {
+        ++p;
+        out_conv->precision_star = (*p == '*');
+        out_conv->precision = 0;
+        for (const char *digit = p; *digit >= '0' && *digit <= '9'; ++digit) {
+            // anything above the line length limits nothing, don't overflow
+            if (out_conv->precision <= AVS_COMMONS_LOG_MAX_LINE_LENGTH) {
+                out_conv->precision =
+                        out_conv->precision * 10 + (*digit - '0');
+            }
+        }
+        p = skip_width(p, out_conv);
+    }
+    switch (*p) {
+    case 'h':
+        p += (p[1] == 'h') ? 2 : 1;
+        break;
+    case 'l':
+        if (p[1] == 'l') {
+            int_type = ARG_LLONG;
+            p += 2;
+        } else {
+            int_type = ARG_LONG;
+            is_long = true;
+            ++p;
+        }
+        break;
+    case 'j':
+        int_type = ARG_INTMAX;
+        ++p;
+        break;
+    case 'z':
+        int_type = ARG_SIZE;
+        ++p;
+        break;
+    case 't':
+        int_type = ARG_PTRDIFF;
+        ++p;
+        break;
+    case 'L':
+        is_long_double = true;
+        ++p;
+        break;
+    default:
+        break;
+    }
+
+    out_conv->end = *p ? p + 1 : p;
+    if (out_conv->end - spec > DEFERRED_MAX_CONV_LENGTH) {
+        return;
+    }
+    switch (*p) {
+    case '%':
+        if (p == spec + 1) {
+            out_conv->type = ARG_NONE;
+        }
+        break;
+    case 'c':
+    case 's':
+        // wide characters are not supported
+        if (!is_long) {
+            out_conv->type = (*p == 'c') ? ARG_INT : ARG_STR;
+        }
+        break;
+    case 'd':
+    case 'i':
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X':
+        out_conv->type = int_type;
+        break;
+    case 'a':
+    case 'A':
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+        out_conv->type = is_long_double ? ARG_LDOUBLE : ARG_DOUBLE;
+        break;
+    case 'p':
+        out_conv->type = ARG_PTR;
+        break;
+    default:
+        // %n and non-standard conversions
+        break;
+    }
+}
+
+static int pack_bytes(char *out,
+                      size_t out_size,
+                      size_t *inout_offset,
+                      const void *data,
+                      size_t size) {
+    if (out) {
+        if (size > out_size - *inout_offset) {
+            return -1;
+        }
+        memcpy(out + *inout_offset, data, size);
+    }
+    *inout_offset += size;
+    return 0;
+}
+
+// Stores the values of arguments referenced by @p msg into @p out, or only
+// calculates their size if @p out is NULL. Returns that size, or -1 if the
+// message cannot be deferred or the arguments do not fit in @p out_size bytes.
+static int pack_args(char *out, size_t out_size, const char *msg, va_list ap) {
+#        define PACK_ARG(Type)                                   \
+            do {                                                 \
+                Type value__ = va_arg(ap, Type);                 \
+                if (pack_bytes(out, out_size, &offset, &value__, \
+                               sizeof(value__))) {               \
+                    return -1;                                   \
+                }                                                \
+            } while (0)
+
+    size_t offset = 0;
+    const char *p = msg;
+    while ((p = strchr(p, '%'))) {
+        deferred_conv_t conv;
+        parse_conv(p, &conv);
+        int precision = conv.precision;
+        for (unsigned i = 0; i < conv.stars; ++i) {
+            int star = va_arg(ap, int);
+            if (pack_bytes(out, out_size, &offset, &star, sizeof(star))) {
+                return -1;
+            }
+            if (conv.precision_star && i + 1 == conv.stars) {
+                precision = star;
+            }
+        }
+        switch (conv.type) {
+        case ARG_NONE:
+            break;
+        case ARG_INT:
+            PACK_ARG(int);
+            break;
+        case ARG_LONG:
+            PACK_ARG(long);
+            break;
+        case ARG_LLONG:
+            PACK_ARG(long long);
+            break;
+        case ARG_INTMAX:
+            PACK_ARG(intmax_t);
+            break;
+        case ARG_SIZE:
+            PACK_ARG(size_t);
+            break;
+        case ARG_PTRDIFF:
+            PACK_ARG(ptrdiff_t);
+            break;
+        case ARG_DOUBLE:
+            PACK_ARG(double);
+            break;
+        case ARG_LDOUBLE:
+            PACK_ARG(long double);
+            break;
+        case ARG_PTR:
+            PACK_ARG(void *);
+            break;
+        case ARG_STR: {
+            const char *str = va_arg(ap, const char *);
+            if (!str) {
+                str = "(null)";
+            }
+            // nothing longer than a whole line would ever be printed, and
+            // with a precision, str does not need to be terminated at all;
+            // a negative precision is taken as if it was omitted
+            size_t max_len = AVS_COMMONS_LOG_MAX_LINE_LENGTH - 1;
+            if (precision >= 0 && (size_t) precision < max_len) {
+                max_len = (size_t) precision;
+            }
+            const char *nul = (const char *) memchr(str, '\0', max_len);
+            size_t len = nul ? (size_t) (nul - str) : max_len;
+            if (pack_bytes(out, out_size, &offset, str, len)
+                    || pack_bytes(out, out_size, &offset, "", 1)) {
+                return -1;
+            }
+            break;
+        }
+        case ARG_UNSUPPORTED:
+            return -1;
+        }
+        p = conv.end;
+    }
+    return (int) offset;
+
+#        undef PACK_ARG
+}
+
+static int unpack_bytes(const char *args,
+                        size_t args_size,
+                        size_t *inout_offset,
+                        void *out,
+                        size_t size) {
+    if (size > args_size - *inout_offset) {
+        return -1;
+    }
+    memcpy(out, args + *inout_offset, size);
+    *inout_offset += size;
+    return 0;
+}
+
+static void append_bytes(char *buf,
+                         size_t buf_size,
+                         size_t *inout_len,
+                         const char *data,
+                         size_t size) {
+    if (*inout_len + 1 < buf_size) {
+        size_t to_copy = AVS_MIN(size, buf_size - *inout_len - 1);
+        memcpy(buf + *inout_len, data, to_copy);
+        buf[*inout_len + to_copy] = '\0';
+    }
+    *inout_len += size;
+}
+
+// Recreates @p spec with '*' field width and precision replaced by the values
+// stored in @p stars, so that it may be passed to snprintf() with just the
+// converted value.
+static void rebuild_conv(char *out,
+                         size_t out_size,
+                         const char *spec,
+                         const deferred_conv_t *conv,
+                         const int *stars) {
+    size_t len = 0;
+    unsigned star = 0;
+    for (const char *p = spec; p < conv->end; ++p) {
+        if (*p != '*') {
+            append_bytes(out, out_size, &len, p, 1);
+        } else if (p[-1] == '.' && stars[star] < 0) {
+            // negative precision is taken as if it was omitted
+            out[--len] = '\0';
+            ++star;
+        } else {
+            char num[sizeof("-2147483648")];
+            int num_len = snprintf(num, sizeof(num), "%d", stars[star++]);
+            append_bytes(out, out_size, &len, num, (size_t) num_len);
+        }
+    }
+}
+
+// Formats @p msg using the argument values stored by pack_args(). Returns the
+// length of the whole formatted message, which may be larger than the part
+// stored in @p buf, as for snprintf().
+static size_t format_args(char *buf,
+                          size_t buf_size,
+                          const char *msg,
+                          const char *args,
+                          size_t args_size) {
+#        define UNPACK_ARG(Type)                                             \
+            do {                                                             \
+                Type value__;                                                \
+                if (unpack_bytes(args, args_size, &offset, &value__,         \
+                                 sizeof(value__))) {                         \
+                    return len;                                              \
+                }                                                            \
+                result = snprintf(len < buf_size ? buf + len : NULL,         \
+                                  len < buf_size ? buf_size - len : 0, spec, \
+                                  value__);                                  \
+            } while (0)
+
+    size_t len = 0;
+    size_t offset = 0;
+    const char *p = msg;
+    if (buf_size) {
+        buf[0] = '\0';
+    }
+    while (*p) {
+        const char *conv_start = strchr(p, '%');
+        if (!conv_start) {
+            append_bytes(buf, buf_size, &len, p, strlen(p));
+            break;
+        }
+        append_bytes(buf, buf_size, &len, p, (size_t) (conv_start - p));
+
+        deferred_conv_t conv;
+        parse_conv(conv_start, &conv);
+        int stars[2];
+        for (unsigned i = 0; i < conv.stars; ++i) {
+            if (unpack_bytes(args, args_size, &offset, &stars[i],
+                             sizeof(stars[i]))) {
+                return len;
+            }
+        }
+        char spec[DEFERRED_MAX_CONV_LENGTH + 2 * sizeof("-2147483648")];
+        rebuild_conv(spec, sizeof(spec), conv_start, &conv, stars);
+
+        int result = 0;
+        switch (conv.type) {
+        case ARG_NONE:
+            append_bytes(buf, buf_size, &len, "%", 1);
+            break;
+        case ARG_INT:
+            UNPACK_ARG(int);
+            break;
+        case ARG_LONG:
+            UNPACK_ARG(long);
+            break;
+        case ARG_LLONG:
+            UNPACK_ARG(long long);
+            break;
+        case ARG_INTMAX:
+            UNPACK_ARG(intmax_t);
+            break;
+        case ARG_SIZE:
+            UNPACK_ARG(size_t);
+            break;
+        case ARG_PTRDIFF:
+            UNPACK_ARG(ptrdiff_t);
+            break;
+        case ARG_DOUBLE:
+            UNPACK_ARG(double);
+            break;
+        case ARG_LDOUBLE:
+            UNPACK_ARG(long double);
+            break;
+        case ARG_PTR:
+            UNPACK_ARG(void *);
+            break;
+        case ARG_STR: {
+            const char *str = args + offset;
+            const char *str_end =
+                    (const char *) memchr(str, '\0', args_size - offset);
+            if (!str_end) {
+                return len;
+            }
+            offset += (size_t) (str_end - str) + 1;
+            result = snprintf(len < buf_size ? buf + len : NULL,
+                              len < buf_size ? buf_size - len : 0, spec, str);
+            break;
+        }
+        case ARG_UNSUPPORTED:
+            return len;
+        }
+        if (result > 0) {
+            len += (size_t) result;
+        }
+        p = conv.end;
+    }
+    return len;
+
+#        undef UNPACK_ARG
+}
+
+typedef struct {
+    avs_log_handler_t *normal;
+    avs_log_extended_handler_t *extended;
+} deferred_handler_t;
+
+static void emit_deferred(const deferred_handler_t *handler,
+                          avs_log_level_t level,
+                          const char *module,
+                          const char *file,
+                          unsigned line,
+                          const char *msg,
+                          const char *args,
+                          size_t args_size) {
+    char *buf = g_deferred.line_buf;
+    size_t buf_size = sizeof(g_deferred.line_buf);
+    size_t len = 0;
+
+    if (!handler->extended) {
+        int result = snprintf(buf, buf_size, "%s [%s] [%s:%u]: ",
+                              level_as_string(level), module, file, line);
+        if (result < 0) {
+            return;
+        }
+        len = (size_t) result;
+    }
+    if (len < buf_size) {
+        len += format_args(buf + len, buf_size - len, msg, args, args_size);
+    }
+    if (len >= buf_size) {
+        memcpy(buf + buf_size - sizeof("..."), "...", sizeof("..."));
+    }
+
+    if (handler->extended) {
+        handler->extended(level, module, file, line, buf);
+    } else {
+        handler->normal(level, module, buf);
+    }
+}
+
+static atomic_uint_least32_t *deferred_state_at(uint32_t position) {
+    return (atomic_uint_least32_t *) &g_deferred.buf
+            .bytes[position % AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE];
+}
+
+static deferred_record_t *deferred_reserve(uint32_t size) {
+    uint_least32_t head =
+            atomic_load_explicit(&g_deferred.head, memory_order_relaxed);
+    uint32_t padding;
+    do {
+        uint32_t space_to_end =
+                AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+                - (uint32_t) head % AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE;
+        padding = (space_to_end < size) ? space_to_end : 0;
+        // acquire pairs with the release in avs_log_deferred_flush(), so that
+        // the zeroing of the space being reserved is visible here
+        uint32_t tail = (uint32_t) atomic_load_explicit(&g_deferred.tail,
+                                                        memory_order_acquire);
+        if ((uint32_t) head - tail + padding + size
+                > AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE) {
+            return NULL;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(
+            &g_deferred.head, &head, (uint32_t) head + padding + size,
+            memory_order_relaxed, memory_order_relaxed));
+
+    if (padding) {
+        atomic_store_explicit(deferred_state_at((uint32_t) head),
+                              padding | DEFERRED_PADDING, memory_order_release);
+    }
+    return (deferred_record_t *) deferred_state_at((uint32_t) head + padding);
+}
+
+static void deferred_notify(void) {
+    avs_log_deferred_notify_t *notify =
+            atomic_load_explicit(&g_deferred.notify, memory_order_acquire);
+    if (notify) {
+        notify();
+    }
+}
+
+void avs_log_set_deferred_notify(avs_log_deferred_notify_t *notify) {
+    atomic_store_explicit(&g_deferred.notify, notify, memory_order_release);
+}
+
+// Returns 0 if the message has been recorded or dropped because the buffer is
+// full, or -1 if it needs to be formatted right away.
+static int log_deferred(avs_log_level_t level,
+                        const char *module,
+                        const char *file,
+                        unsigned line,
+                        const char *msg,
+                        va_list ap) {
+    va_list ap_copy;
+    va_copy(ap_copy, ap);
+    int args_size = pack_args(NULL, 0, msg, ap_copy);
+    va_end(ap_copy);
+    if (args_size < 0) {
+        return -1;
+    }
+
+    const size_t align = AVS_ALIGNOF(deferred_record_t);
+    size_t size = (sizeof(deferred_record_t) + (size_t) args_size + align - 1)
+                  / align * align;
+    if (size > AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE / 2) {
+        return -1;
+    }
+    deferred_record_t *record = deferred_reserve((uint32_t) size);
+    if (!record) {
+        atomic_fetch_add_explicit(&g_deferred.dropped, 1, memory_order_relaxed);
+        deferred_notify();
+        return 0;
+    }
+
+    uint32_t state = (uint32_t) size;
+    record->level = level;
+    record->line = line;
+    record->module = module;
+    record->file = file;
+    record->msg = msg;
+    if (pack_args((char *) record + sizeof(*record), size - sizeof(*record),
+                  msg, ap)
+            < 0) {
+        // some string argument got longer since its size was calculated
+        state |= DEFERRED_PADDING;
+        atomic_fetch_add_explicit(&g_deferred.dropped, 1, memory_order_relaxed);
+    }
+    atomic_store_explicit(&record->state, state, memory_order_release);
+    deferred_notify();
+    return 0;
+}
+
+size_t avs_log_deferred_flush(void) {
+    if (atomic_flag_test_and_set_explicit(&g_deferred.flushing,
+                                          memory_order_acquire)) {
+        return 0;
+    }
+
+    // the handler is called without holding the log mutex, so that threads
+    // that log are not blocked by its output
+    deferred_handler_t handler = { NULL, NULL };
+    if (LOG_LOCK()) {
+        atomic_flag_clear_explicit(&g_deferred.flushing, memory_order_release);
+        return 0;
+    }
+    if (g_log.is_extended_handler) {
+        handler.extended = g_log.handler.extended;
+    } else {
+        handler.normal = g_log.handler.normal;
+    }
+    LOG_UNLOCK();
+
+    size_t emitted = 0;
+    uint32_t tail = (uint32_t) atomic_load_explicit(&g_deferred.tail,
+                                                    memory_order_relaxed);
+    while (tail
+           != (uint32_t) atomic_load_explicit(&g_deferred.head,
+                                              memory_order_relaxed)) {
+        atomic_uint_least32_t *state_ptr = deferred_state_at(tail);
+        uint32_t state = (uint32_t) atomic_load_explicit(state_ptr,
+                                                         memory_order_acquire);
+        if (!state) {
+            // reserved, but not committed yet
+            break;
+        }
+        uint32_t size = state & ~DEFERRED_PADDING;
+        if (!(state & DEFERRED_PADDING)) {
+            const deferred_record_t *record =
+                    (const deferred_record_t *) state_ptr;
+            emit_deferred(&handler, record->level, record->module,
+                          record->file, record->line, record->msg,
+                          (const char *) record + sizeof(*record),
+                          size - sizeof(*record));
+            ++emitted;
+        }
+        memset((char *) state_ptr, 0, size);
+        tail += size;
+        atomic_store_explicit(&g_deferred.tail, tail, memory_order_release);
+    }
+
+    uint32_t dropped = (uint32_t) atomic_load_explicit(&g_deferred.dropped,
+                                                       memory_order_relaxed);
+    if (dropped != g_deferred.dropped_reported) {
+        unsigned long count =
+                (unsigned long) (dropped - g_deferred.dropped_reported);
+        g_deferred.dropped_reported = dropped;
+        emit_deferred(&handler, AVS_LOG_WARNING, "avs_log", __FILE__, __LINE__,
+                      "%lu messages dropped, deferred log buffer full",
+                      (const char *) &count, sizeof(count));
+    }
+
+    atomic_flag_clear_explicit(&g_deferred.flushing, memory_order_release);
+    return emitted;
+}
+
+uint32_t avs_log_deferred_dropped(void) {
+    return (uint32_t) atomic_load_explicit(&g_deferred.dropped,
+                                           memory_order_relaxed);
+}
+#    endif // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+
 void avs_log_internal_forced_v__(avs_log_level_t level,
                                  const char *module,
                                  const char *file,
                                  unsigned line,
                                  const char *msg,
                                  va_list ap) {
+#    ifdef AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+    va_list ap_copy;
+    va_copy(ap_copy, ap);
+    int result = log_deferred(level, module, file, line, msg, ap_copy);
+    va_end(ap_copy);
+    if (!result) {
+        return;
+    }
+#    endif // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
 #    ifdef AVS_COMMONS_LOG_USE_GLOBAL_BUFFER
     if (LOG_LOCK()) {
         return;
@@ -359,6 +1029,9 @@ void avs_log_internal_l__(avs_log_level_t level,
 
 #    ifdef AVS_UNIT_TESTING
 #        include "tests/log/test_log.c"
+#        ifdef AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+#            include "tests/log/test_log_deferred.c"
+#        endif // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
 #    endif
 
 #endif // AVS_COMMONS_WITH_AVS_LOG
@@ -28,6 +28,7 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 /* Required non-common static method implementations */
 static bool is_ssl_started(ssl_socket_t *socket);
 static bool is_session_resumed(ssl_socket_t *socket);
+static bool is_connection_id_used(ssl_socket_t *socket);
 static avs_error_t start_ssl(ssl_socket_t *socket, const char *host);
 static void close_ssl_raw(ssl_socket_t *socket);
 static avs_error_t
@@ -141,8 +142,15 @@ connect_ssl(avs_net_socket_t *socket_, const char *host, const char *port) {
         (void *) socket, host, port);
 
     if (is_ssl_started(socket)) {
-        LOG(ERROR, _("SSL socket already connected"));
-        return avs_errno(AVS_EISCONN);
+        if (!is_connection_id_used(socket)) {
+            LOG(ERROR, _("SSL socket already connected"));
+            return avs_errno(AVS_EISCONN);
+        }
+        // The peer identifies the session by the connection ID, so only the
+        // underlying socket needs to be recreated
+        LOG(DEBUG, _("reconnecting backend socket, keeping DTLS session"));
+        (void) avs_net_socket_close(socket->backend_socket);
+        return avs_net_socket_connect(socket->backend_socket, host, port);
     }
     avs_error_t err = ensure_have_backend_socket(socket);
     if (avs_is_err(err)) {
@@ -390,6 +398,9 @@ static avs_error_t get_opt_ssl(avs_net_socket_t *ssl_socket_,
     case AVS_NET_SOCKET_OPT_SESSION_RESUMED:
         out_option_value->flag = is_session_resumed(ssl_socket);
         return AVS_OK;
+    case AVS_NET_SOCKET_OPT_CONNECTION_ID_USED:
+        out_option_value->flag = is_connection_id_used(ssl_socket);
+        return AVS_OK;
     case AVS_NET_SOCKET_OPT_STATE:
         if (!ssl_socket->backend_socket) {
             out_option_value->state = AVS_NET_SOCKET_STATE_CLOSED;
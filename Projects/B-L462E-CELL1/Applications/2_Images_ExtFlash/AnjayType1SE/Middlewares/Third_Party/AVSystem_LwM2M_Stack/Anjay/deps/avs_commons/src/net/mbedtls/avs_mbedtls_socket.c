@@ -166,6 +166,21 @@ static mbedtls_ssl_context *get_context(ssl_socket_t *socket) {
     return &socket->context;
 }
 
+static bool is_connection_id_used(ssl_socket_t *socket) {
+#    if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+    int enabled = MBEDTLS_SSL_CID_DISABLED;
+    size_t peer_cid_len = 0;
+    // With an empty CID, the peer still identifies us by our address
+    return is_ssl_started(socket) && socket->use_connection_id
+           && !mbedtls_ssl_get_peer_cid(get_context(socket), &enabled, NULL,
+                                        &peer_cid_len)
+           && enabled == MBEDTLS_SSL_CID_ENABLED && peer_cid_len > 0;
+#    else  // MBEDTLS_SSL_DTLS_CONNECTION_ID
+    (void) socket;
+    return false;
+#    endif // MBEDTLS_SSL_DTLS_CONNECTION_ID
+}
+
 #    ifdef AVS_COMMONS_NET_WITH_MBEDTLS_LOGS
 static void debug_mbedtls(
         void *ctx, int level, const char *file, int line, const char *str) {
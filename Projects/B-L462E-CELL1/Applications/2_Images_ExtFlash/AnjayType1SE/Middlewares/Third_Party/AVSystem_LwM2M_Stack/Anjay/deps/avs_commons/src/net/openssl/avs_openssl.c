@@ -989,6 +989,11 @@ static bool is_session_resumed(ssl_socket_t *socket) {
     return false;
 }
 
+static bool is_connection_id_used(ssl_socket_t *socket) {
+    (void) socket;
+    return false;
+}
+
 #    ifdef AVS_COMMONS_WITH_AVS_CRYPTO_PKI
 typedef struct {
     SSL_CTX *ctx;
@@ -209,6 +209,11 @@ static bool is_session_resumed(ssl_socket_t *socket) {
     return false;
 }
 
+static bool is_connection_id_used(ssl_socket_t *socket) {
+    (void) socket;
+    return false;
+}
+
 static avs_error_t ssl_handshake(ssl_socket_t *socket) {
     const dtls_peer_t *peer = dtls_get_peer(socket->ctx, get_dtls_session());
     /* Arbitrary constant limiting the number of packet exchanges between our
@@ -55,6 +55,17 @@ struct avs_sched_job_struct {
     /** Instant in time at which the job is scheduled. */
     avs_time_monotonic_t instant;
 
+#    ifdef AVS_COMMONS_SCHED_WITH_HEAP
+    /**
+     * Sequence number assigned when inserting the job into the queue. Used to
+     * keep jobs scheduled for the same instant in FIFO order.
+     */
+    uint64_t seq;
+
+    /** Current position of the job in the @ref avs_sched_struct::jobs heap. */
+    size_t heap_index;
+#    endif // AVS_COMMONS_SCHED_WITH_HEAP
+
 #    ifdef AVS_COMMONS_WITH_INTERNAL_LOGS
     struct {
         /** File from which AVS_SCHED*() was called. */
@@ -96,8 +107,26 @@ struct avs_sched_struct {
     avs_condvar_t *task_condvar;
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
 
+#    ifdef AVS_COMMONS_SCHED_WITH_HEAP
+    /**
+     * Scheduled jobs, organized as a binary min-heap ordered by
+     * <c>(instant, seq)</c>. Each job knows its own position in the array, so
+     * that it can be removed in O(log n) without searching.
+     */
+    avs_sched_job_t **jobs;
+
+    /** Number of jobs currently in the heap. */
+    size_t jobs_count;
+
+    /** Number of elements allocated for the @ref jobs array. */
+    size_t jobs_capacity;
+
+    /** Sequence number to assign to the next inserted job. */
+    uint64_t next_seq;
+#    else  // AVS_COMMONS_SCHED_WITH_HEAP
     /** Scheduled jobs. */
     AVS_LIST(avs_sched_job_t) jobs;
+#    endif // AVS_COMMONS_SCHED_WITH_HEAP
 
     /**
      * A flag that prevents scheduling new jobs while the scheduler is shutting
@@ -188,6 +217,209 @@ static const char *job_log_id_impl(char buf[static JOB_LOG_ID_MAX_LENGTH],
 
 #    endif // AVS_COMMONS_WITH_INTERNAL_LOGS
 
+#    ifdef AVS_COMMONS_SCHED_WITH_HEAP
+
+#        define JOBS_INITIAL_CAPACITY 8
+
+static avs_sched_job_t *job_alloc(size_t clb_data_size) {
+    return (avs_sched_job_t *) avs_calloc(1, sizeof(avs_sched_job_t)
+                                                     + clb_data_size);
+}
+
+static void job_free(avs_sched_job_t *job) {
+    avs_free(job);
+}
+
+static avs_sched_job_t *jobs_first(avs_sched_t *sched) {
+    return sched->jobs_count ? sched->jobs[0] : NULL;
+}
+
+static bool job_before(const avs_sched_job_t *a, const avs_sched_job_t *b) {
+    if (avs_time_monotonic_before(a->instant, b->instant)) {
+        return true;
+    }
+    if (avs_time_monotonic_before(b->instant, a->instant)) {
+        return false;
+    }
+    return a->seq < b->seq;
+}
+
+static void heap_set(avs_sched_t *sched, size_t index, avs_sched_job_t *job) {
+    sched->jobs[index] = job;
+    job->heap_index = index;
+}
+
+static void heap_sift_up(avs_sched_t *sched, size_t index) {
+    avs_sched_job_t *job = sched->jobs[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!job_before(job, sched->jobs[parent])) {
+            break;
+        }
+        heap_set(sched, index, sched->jobs[parent]);
+        index = parent;
+    }
+    heap_set(sched, index, job);
+}
+
+static void heap_sift_down(avs_sched_t *sched, size_t index) {
+    avs_sched_job_t *job = sched->jobs[index];
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= sched->jobs_count) {
+            break;
+        }
+        if (child + 1 < sched->jobs_count
+                && job_before(sched->jobs[child + 1], sched->jobs[child])) {
+            ++child;
+        }
+        if (!job_before(sched->jobs[child], job)) {
+            break;
+        }
+        heap_set(sched, index, sched->jobs[child]);
+        index = child;
+    }
+    heap_set(sched, index, job);
+}
+
+/**
+ * Makes sure that there is space for at least one more job in the heap, so
+ * that @ref jobs_insert cannot fail.
+ */
+static int jobs_reserve(avs_sched_t *sched) {
+    if (sched->jobs_count < sched->jobs_capacity) {
+        return 0;
+    }
+    size_t new_capacity = sched->jobs_capacity ? 2 * sched->jobs_capacity
+                                               : JOBS_INITIAL_CAPACITY;
+    avs_sched_job_t **new_jobs = (avs_sched_job_t **) avs_realloc(
+            sched->jobs, new_capacity * sizeof(*sched->jobs));
+    if (!new_jobs) {
+        return -1;
+    }
+    sched->jobs = new_jobs;
+    sched->jobs_capacity = new_capacity;
+    return 0;
+}
+
+static void jobs_insert(avs_sched_t *sched, avs_sched_job_t *job) {
+    assert(sched->jobs_count < sched->jobs_capacity);
+    job->seq = sched->next_seq++;
+    sched->jobs[sched->jobs_count] = job;
+    heap_sift_up(sched, sched->jobs_count++);
+}
+
+static void jobs_detach(avs_sched_t *sched, avs_sched_job_t *job) {
+    size_t index = job->heap_index;
+    assert(index < sched->jobs_count);
+    assert(sched->jobs[index] == job);
+    avs_sched_job_t *last = sched->jobs[--sched->jobs_count];
+    if (last != job) {
+        heap_set(sched, index, last);
+        if (index > 0 && job_before(last, sched->jobs[(index - 1) / 2])) {
+            heap_sift_up(sched, index);
+        } else {
+            heap_sift_down(sched, index);
+        }
+    }
+    if (sched->jobs_capacity > JOBS_INITIAL_CAPACITY
+            && sched->jobs_count <= sched->jobs_capacity / 4) {
+        // shrinking is optional; keep the old buffer if realloc() fails
+        avs_sched_job_t **new_jobs = (avs_sched_job_t **) avs_realloc(
+                sched->jobs,
+                sched->jobs_capacity / 2 * sizeof(*sched->jobs));
+        if (new_jobs) {
+            sched->jobs = new_jobs;
+            sched->jobs_capacity /= 2;
+        }
+    }
+}
+
+/**
+ * Checks whether @p job, retrieved earlier from @p handle_ptr, is still
+ * scheduled in @p sched. @p job might be a dangling pointer if it has been
+ * executed or cancelled in the meantime, so it is only dereferenced after
+ * verifying that the handle still refers to it.
+ */
+static bool job_scheduled_locked(avs_sched_t *sched,
+                                 avs_sched_handle_t *handle_ptr,
+                                 avs_sched_job_t *job) {
+    nonfailing_mutex_lock(g_handle_access_mutex);
+    bool result = (*handle_ptr == job && job->sched == sched);
+    avs_mutex_unlock(g_handle_access_mutex);
+    assert(!result
+           || (job->heap_index < sched->jobs_count
+               && sched->jobs[job->heap_index] == job));
+    return result;
+}
+
+static void jobs_clear(avs_sched_t *sched) {
+    for (size_t i = 0; i < sched->jobs_count; ++i) {
+        if (sched->jobs[i]->handle_ptr) {
+            *sched->jobs[i]->handle_ptr = NULL;
+        }
+        job_free(sched->jobs[i]);
+    }
+    avs_free(sched->jobs);
+    sched->jobs = NULL;
+    sched->jobs_count = 0;
+    sched->jobs_capacity = 0;
+}
+
+#    else // AVS_COMMONS_SCHED_WITH_HEAP
+
+static avs_sched_job_t *job_alloc(size_t clb_data_size) {
+    return (avs_sched_job_t *) AVS_LIST_NEW_BUFFER(sizeof(avs_sched_job_t)
+                                                   + clb_data_size);
+}
+
+static void job_free(avs_sched_job_t *job) {
+    AVS_LIST_DELETE(&job);
+}
+
+static avs_sched_job_t *jobs_first(avs_sched_t *sched) {
+    return sched->jobs;
+}
+
+static int jobs_reserve(avs_sched_t *sched) {
+    (void) sched;
+    return 0;
+}
+
+static void jobs_insert(avs_sched_t *sched, avs_sched_job_t *job) {
+    AVS_LIST(avs_sched_job_t) *insert_ptr = &sched->jobs;
+    while (*insert_ptr
+           && !avs_time_monotonic_before(job->instant,
+                                         (*insert_ptr)->instant)) {
+        AVS_LIST_ADVANCE_PTR(&insert_ptr);
+    }
+    AVS_LIST_INSERT(insert_ptr, job);
+}
+
+static void jobs_detach(avs_sched_t *sched, avs_sched_job_t *job) {
+    AVS_LIST(avs_sched_job_t) *job_ptr =
+            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
+    assert(job_ptr);
+    AVS_LIST_DETACH(job_ptr);
+}
+
+static bool job_scheduled_locked(avs_sched_t *sched,
+                                 avs_sched_handle_t *handle_ptr,
+                                 avs_sched_job_t *job) {
+    (void) handle_ptr;
+    return AVS_LIST_FIND_PTR(&sched->jobs, job) != NULL;
+}
+
+static void jobs_clear(avs_sched_t *sched) {
+    AVS_LIST_CLEAR(&sched->jobs) {
+        if (sched->jobs->handle_ptr) {
+            *sched->jobs->handle_ptr = NULL;
+        }
+    }
+}
+
+#    endif // AVS_COMMONS_SCHED_WITH_HEAP
+
 avs_sched_t *avs_sched_new(const char *name, void *data) {
 #    ifdef AVS_COMMONS_SCHED_THREAD_SAFE
     if (avs_init_once(&g_init_handle, init_globals, NULL)) {
@@ -231,11 +463,7 @@ void avs_sched_cleanup(avs_sched_t **sched_ptr) {
     avs_sched_run(*sched_ptr);
 
     nonfailing_mutex_lock(g_handle_access_mutex);
-    AVS_LIST_CLEAR(&(*sched_ptr)->jobs) {
-        if ((*sched_ptr)->jobs->handle_ptr) {
-            *(*sched_ptr)->jobs->handle_ptr = NULL;
-        }
-    }
+    jobs_clear(*sched_ptr);
     avs_mutex_unlock(g_handle_access_mutex);
 
     avs_condvar_cleanup(&(*sched_ptr)->task_condvar);
@@ -253,8 +481,9 @@ void *avs_sched_data(avs_sched_t *sched) {
 
 static avs_time_monotonic_t sched_time_of_next_locked(avs_sched_t *sched) {
     assert(sched);
-    if (sched->jobs) {
-        return sched->jobs->instant;
+    avs_sched_job_t *first = jobs_first(sched);
+    if (first) {
+        return first->instant;
     }
     return AVS_TIME_MONOTONIC_INVALID;
 }
@@ -306,33 +535,36 @@ int avs_sched_wait_until_next(avs_sched_t *sched,
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
 }
 
-static AVS_LIST(avs_sched_job_t) fetch_job(avs_sched_t *sched,
-                                           avs_time_monotonic_t deadline) {
-    AVS_LIST(avs_sched_job_t) result = NULL;
+static avs_sched_job_t *fetch_job(avs_sched_t *sched,
+                                  avs_time_monotonic_t deadline) {
+    avs_sched_job_t *result = NULL;
     nonfailing_mutex_lock(sched->mutex);
-    if (sched->jobs
-            && avs_time_monotonic_before(sched->jobs->instant, deadline)) {
-        if (sched->jobs->handle_ptr) {
+    avs_sched_job_t *first = jobs_first(sched);
+    if (first && avs_time_monotonic_before(first->instant, deadline)) {
+        if (first->handle_ptr) {
             nonfailing_mutex_lock(g_handle_access_mutex);
-            assert(*sched->jobs->handle_ptr == sched->jobs);
-            *sched->jobs->handle_ptr = NULL;
+            assert(*first->handle_ptr == first);
+            *first->handle_ptr = NULL;
             avs_mutex_unlock(g_handle_access_mutex);
-            sched->jobs->handle_ptr = NULL;
+            first->handle_ptr = NULL;
         }
-        result = AVS_LIST_DETACH(&sched->jobs);
+        jobs_detach(sched, first);
+        result = first;
     }
     avs_mutex_unlock(sched->mutex);
     return result;
 }
 
-static void execute_job(avs_sched_t *sched, AVS_LIST(avs_sched_job_t) job) {
+static void execute_job(avs_sched_t *sched, avs_sched_job_t *job) {
+#    ifndef AVS_COMMONS_SCHED_WITH_HEAP
     // make sure that the task is detached
     assert(!AVS_LIST_NEXT(job));
+#    endif // AVS_COMMONS_SCHED_WITH_HEAP
 
     SCHED_LOG(sched, TRACE, _("executing job") "%s", JOB_LOG_ID(job));
 
     job->clb(sched, job->clb_data);
-    AVS_LIST_DELETE(&job);
+    job_free(job);
 }
 
 void avs_sched_run(avs_sched_t *sched) {
@@ -340,7 +572,7 @@ void avs_sched_run(avs_sched_t *sched) {
     avs_time_monotonic_t now = avs_time_monotonic_now();
 
     uint32_t tasks_executed = 0;
-    AVS_LIST(avs_sched_job_t) job = NULL;
+    avs_sched_job_t *job = NULL;
     while ((job = fetch_job(sched, now))) {
         assert(job->sched == sched);
         execute_job(sched, job);
@@ -363,16 +595,6 @@ void avs_sched_run(avs_sched_t *sched) {
 #    endif // AVS_COMMONS_WITH_INTERNAL_TRACE
 }
 
-static void schedule_job(avs_sched_t *sched, avs_sched_job_t *job) {
-    AVS_LIST(avs_sched_job_t) *insert_ptr = &sched->jobs;
-    while (*insert_ptr
-           && !avs_time_monotonic_before(job->instant,
-                                         (*insert_ptr)->instant)) {
-        AVS_LIST_ADVANCE_PTR(&insert_ptr);
-    }
-    AVS_LIST_INSERT(insert_ptr, job);
-}
-
 static int sched_at_locked(avs_sched_t *sched,
                            avs_sched_handle_t *out_handle,
                            avs_time_monotonic_t instant,
@@ -396,9 +618,8 @@ static int sched_at_locked(avs_sched_t *sched,
         return -1;
     }
 
-    AVS_LIST(avs_sched_job_t) job = (avs_sched_job_t *) AVS_LIST_NEW_BUFFER(
-            sizeof(avs_sched_job_t) + clb_data_size);
-    if (!job) {
+    avs_sched_job_t *job = NULL;
+    if (jobs_reserve(sched) || !(job = job_alloc(clb_data_size))) {
         SCHED_LOG(sched, ERROR, _("could not allocate scheduler task"));
         return -1;
     }
@@ -422,22 +643,20 @@ static int sched_at_locked(avs_sched_t *sched,
             AVS_ASSERT((*out_handle)->sched == sched,
                        "Replacing handles used by a different scheduler is "
                        "not supported");
-            AVS_LIST(avs_sched_job_t) *job_ptr =
-                    (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(
-                            &sched->jobs, *out_handle);
-            AVS_ASSERT(job_ptr, "dangling handle detected");
+            avs_sched_job_t *old_job = *out_handle;
             SCHED_LOG(sched, TRACE,
                       _("cancelling job") "%s" _(
                               " due to reschedule policy for job") "%s",
-                      JOB_LOG_ID(*job_ptr),
+                      JOB_LOG_ID(old_job),
                       JOB_LOG_ID_EXPLICIT(log_file, log_line, log_name));
-            AVS_LIST_DELETE(job_ptr);
+            jobs_detach(sched, old_job);
+            job_free(old_job);
         }
         *out_handle = job;
         avs_mutex_unlock(g_handle_access_mutex);
     }
 
-    schedule_job(sched, job);
+    jobs_insert(sched, job);
 #    ifdef AVS_COMMONS_WITH_INTERNAL_TRACE
     avs_time_duration_t remaining =
             avs_time_monotonic_diff(instant, avs_time_monotonic_now());
@@ -515,11 +734,10 @@ void avs_sched_del(avs_sched_handle_t *handle_ptr) {
 
     assert(sched);
     nonfailing_mutex_lock(sched->mutex);
-    AVS_LIST(avs_sched_job_t) *job_ptr =
-            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
-    if (!job_ptr) {
+    bool scheduled = job_scheduled_locked(sched, handle_ptr, job);
+    if (!scheduled) {
 #    ifndef AVS_COMMONS_SCHED_THREAD_SAFE
-        AVS_ASSERT(job_ptr, "dangling handle detected");
+        AVS_ASSERT(scheduled, "dangling handle detected");
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
            // Job might have been removed by another thread, don't do anything
     } else {
@@ -529,7 +747,8 @@ void avs_sched_del(avs_sched_handle_t *handle_ptr) {
         *job->handle_ptr = NULL;
         avs_mutex_unlock(g_handle_access_mutex);
 
-        AVS_LIST_DELETE(job_ptr);
+        jobs_detach(sched, job);
+        job_free(job);
     }
     avs_mutex_unlock(sched->mutex);
 }
@@ -554,11 +773,10 @@ void avs_sched_detach(avs_sched_handle_t *handle_ptr) {
 
     assert(sched);
     nonfailing_mutex_lock(sched->mutex);
-    AVS_LIST(avs_sched_job_t) *job_ptr =
-            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
-    if (!job_ptr) {
+    bool scheduled = job_scheduled_locked(sched, handle_ptr, job);
+    if (!scheduled) {
 #    ifndef AVS_COMMONS_SCHED_THREAD_SAFE
-        AVS_ASSERT(job_ptr, "dangling handle detected");
+        AVS_ASSERT(scheduled, "dangling handle detected");
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
            // Job might have been removed by another thread, don't do anything
     } else {
@@ -584,10 +802,19 @@ int avs_sched_leap_time(avs_sched_t *sched, avs_time_duration_t diff) {
     SCHED_LOG(sched, INFO, _("moving all jobs by ") "%s" _(" s"),
               AVS_TIME_DURATION_AS_STRING(diff));
 
+    // moving all jobs by the same amount of time does not change their
+    // relative order, so the queue does not need to be rebuilt
+#    ifdef AVS_COMMONS_SCHED_WITH_HEAP
+    for (size_t i = 0; i < sched->jobs_count; ++i) {
+        sched->jobs[i]->instant =
+                avs_time_monotonic_add(sched->jobs[i]->instant, diff);
+    }
+#    else  // AVS_COMMONS_SCHED_WITH_HEAP
     AVS_LIST(avs_sched_job_t) job;
     AVS_LIST_FOREACH(job, sched->jobs) {
         job->instant = avs_time_monotonic_add(job->instant, diff);
     }
+#    endif // AVS_COMMONS_SCHED_WITH_HEAP
     avs_condvar_notify_all(sched->task_condvar);
 
     avs_mutex_unlock(sched->mutex);
@@ -621,20 +848,18 @@ int avs_resched_at_impl__(avs_sched_handle_t *handle_ptr,
     int retval = 0;
     assert(sched);
     nonfailing_mutex_lock(sched->mutex);
-    AVS_LIST(avs_sched_job_t) *job_ptr =
-            (AVS_LIST(avs_sched_job_t) *) AVS_LIST_FIND_PTR(&sched->jobs, job);
-    if (job_ptr) {
-        SCHED_LOG(sched, TRACE, _("rescheduling job") "%s",
-                  JOB_LOG_ID(*job_ptr));
+    bool scheduled = job_scheduled_locked(sched, handle_ptr, job);
+    if (scheduled) {
+        SCHED_LOG(sched, TRACE, _("rescheduling job") "%s", JOB_LOG_ID(job));
 
-        avs_sched_job_t *detached_job = AVS_LIST_DETACH(job_ptr);
-        detached_job->instant = instant;
+        jobs_detach(sched, job);
+        job->instant = instant;
 
-        schedule_job(sched, detached_job);
+        jobs_insert(sched, job);
         avs_condvar_notify_all(sched->task_condvar);
     } else {
 #    ifndef AVS_COMMONS_SCHED_THREAD_SAFE
-        AVS_ASSERT(job_ptr, "dangling handle detected");
+        AVS_ASSERT(scheduled, "dangling handle detected");
 #    endif // AVS_COMMONS_SCHED_THREAD_SAFE
         retval = -1;
     }
@@ -643,4 +868,8 @@ int avs_resched_at_impl__(avs_sched_handle_t *handle_ptr,
     return retval;
 }
 
+#    if defined(AVS_UNIT_TESTING) && defined(AVS_COMMONS_SCHED_WITH_HEAP)
+#        include "tests/sched/test_sched_heap.c"
+#    endif // defined(AVS_UNIT_TESTING) && defined(AVS_COMMONS_SCHED_WITH_HEAP)
+
 #endif // AVS_COMMONS_WITH_AVS_SCHED
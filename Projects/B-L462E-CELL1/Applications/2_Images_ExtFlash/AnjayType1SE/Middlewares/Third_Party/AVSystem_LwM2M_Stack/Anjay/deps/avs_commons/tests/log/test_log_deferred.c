@@ -0,0 +1,213 @@
+/*
+ * Copyright 2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <avsystem/commons/avs_unit_test.h>
+
+#define DEFERRED_TEST_MAX_LINES 8
+
+// all lines are counted, but only the first few and the last one are kept
+static struct {
+    size_t count;
+    char lines[DEFERRED_TEST_MAX_LINES][AVS_COMMONS_LOG_MAX_LINE_LENGTH];
+    char last[AVS_COMMONS_LOG_MAX_LINE_LENGTH];
+} g_deferred_output;
+
+static unsigned g_deferred_notified;
+
+static void deferred_test_handler(avs_log_level_t level,
+                                  const char *module,
+                                  const char *file,
+                                  unsigned line,
+                                  const char *message) {
+    (void) level;
+    (void) module;
+    (void) file;
+    (void) line;
+    if (g_deferred_output.count < DEFERRED_TEST_MAX_LINES) {
+        snprintf(g_deferred_output.lines[g_deferred_output.count],
+                 sizeof(g_deferred_output.lines[0]), "%s", message);
+    }
+    snprintf(g_deferred_output.last, sizeof(g_deferred_output.last), "%s",
+             message);
+    ++g_deferred_output.count;
+}
+
+static void deferred_test_notify(void) {
+    ++g_deferred_notified;
+}
+
+static void deferred_test_setup(void) {
+    avs_log_deferred_flush();
+    avs_log_set_extended_handler(deferred_test_handler);
+    memset(&g_deferred_output, 0, sizeof(g_deferred_output));
+}
+
+static void deferred_test_teardown(void) {
+    avs_log_set_deferred_notify(NULL);
+    avs_log_deferred_flush();
+    avs_log_reset();
+}
+
+// Logs @p Format in deferred mode and checks that the flushed message is
+// exactly what snprintf() produces for the same arguments
+#define ASSERT_DEFERRED_FORMAT(Format, ...)                                    \
+    do {                                                                       \
+        char expected__[AVS_COMMONS_LOG_MAX_LINE_LENGTH];                      \
+        snprintf(expected__, sizeof(expected__), Format, __VA_ARGS__);         \
+        deferred_test_setup();                                                 \
+        avs_log(deferred_test, INFO, Format, __VA_ARGS__);                     \
+        AVS_UNIT_ASSERT_EQUAL(g_deferred_output.count, 0);                     \
+        AVS_UNIT_ASSERT_EQUAL(avs_log_deferred_flush(), 1);                    \
+        AVS_UNIT_ASSERT_EQUAL(g_deferred_output.count, 1);                     \
+        AVS_UNIT_ASSERT_EQUAL_STRING(g_deferred_output.lines[0], expected__);  \
+        deferred_test_teardown();                                              \
+    } while (0)
+
+AVS_UNIT_TEST(log_deferred, integers) {
+    ASSERT_DEFERRED_FORMAT("%d %i %u %x %X %o %c", -42, 7, 42u, 0xbeefu,
+                           0xbeefu, 8u, 'z');
+    ASSERT_DEFERRED_FORMAT("%hd %hhu %ld %lu %lld %llx", (short) -3,
+                           (unsigned char) 250, -123456789L, 123456789UL,
+                           -1234567890123LL, 0xdeadbeefcafeULL);
+    ASSERT_DEFERRED_FORMAT("%zu %jd %td", (size_t) 17, (intmax_t) -18,
+                           (ptrdiff_t) 19);
+    ASSERT_DEFERRED_FORMAT("[%-6d|%+d|% d|%06d|%#x]", 1, 2, 3, -4, 0x5u);
+    ASSERT_DEFERRED_FORMAT("%" PRIu32 " %" PRId64, (uint32_t) 4000000000u,
+                           (int64_t) INT64_MIN);
+}
+
+AVS_UNIT_TEST(log_deferred, floats_and_pointers) {
+    ASSERT_DEFERRED_FORMAT("%f %.3e %g %Lf", 3.5, 1e-10, 0.25,
+                           (long double) 2.75);
+    ASSERT_DEFERRED_FORMAT("%p", (void *) &g_deferred_output);
+}
+
+AVS_UNIT_TEST(log_deferred, width_and_precision) {
+    ASSERT_DEFERRED_FORMAT("[%*d|%-*d]", 5, 1, 4, 2);
+    ASSERT_DEFERRED_FORMAT("[%.*f|%*.*f]", 2, 3.14159, 8, 1, 2.71828);
+    ASSERT_DEFERRED_FORMAT("[%5.*s|%d]", 2, "abcde", 42);
+    ASSERT_DEFERRED_FORMAT("[%.*s]", -1, "full");
+    ASSERT_DEFERRED_FORMAT("[%*.*s]", 6, 4, "abcde");
+    ASSERT_DEFERRED_FORMAT("%s", "");
+    ASSERT_DEFERRED_FORMAT("100%% %s", "done");
+}
+
+AVS_UNIT_TEST(log_deferred, string_precision_does_not_read_past_it) {
+    // not terminated, so reading more than 5 bytes is caught by sanitizers
+    char *raw = (char *) avs_malloc(5);
+    AVS_UNIT_ASSERT_NOT_NULL(raw);
+    memcpy(raw, "abcde", 5);
+    ASSERT_DEFERRED_FORMAT("[%.*s]", 5, raw);
+    ASSERT_DEFERRED_FORMAT("[%.3s]", raw);
+    ASSERT_DEFERRED_FORMAT("[%.s]%s", raw, "");
+    avs_free(raw);
+}
+
+AVS_UNIT_TEST(log_deferred, strings_are_copied) {
+    char arg[] = "original";
+    deferred_test_setup();
+    avs_log(deferred_test, INFO, "%s", arg);
+    memcpy(arg, "changed!", sizeof(arg));
+    AVS_UNIT_ASSERT_EQUAL(avs_log_deferred_flush(), 1);
+    AVS_UNIT_ASSERT_EQUAL_STRING(g_deferred_output.lines[0], "original");
+    deferred_test_teardown();
+}
+
+AVS_UNIT_TEST(log_deferred, unsupported_formats_are_logged_right_away) {
+    deferred_test_setup();
+    // too long to be deferred
+    avs_log(deferred_test, INFO, "%-+9.000000000001d", 1);
+    AVS_UNIT_ASSERT_EQUAL(g_deferred_output.count, 1);
+    AVS_UNIT_ASSERT_EQUAL_STRING(g_deferred_output.lines[0], "+1       ");
+#if AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE \
+        <= 8 * AVS_COMMONS_LOG_MAX_LINE_LENGTH
+    // longer than half of the buffer, as each string is copied up to the
+    // length of a whole line
+    static char long_arg[AVS_COMMONS_LOG_MAX_LINE_LENGTH];
+    memset(long_arg, 'a', sizeof(long_arg) - 1);
+    avs_log(deferred_test, INFO, "%s%s%s%s%s%s%s%s", long_arg, long_arg,
+            long_arg, long_arg, long_arg, long_arg, long_arg, long_arg);
+    AVS_UNIT_ASSERT_EQUAL(g_deferred_output.count, 2);
+#endif
+    AVS_UNIT_ASSERT_EQUAL(avs_log_deferred_flush(), 0);
+    deferred_test_teardown();
+}
+
+AVS_UNIT_TEST(log_deferred, records_wrap_around_the_buffer) {
+    deferred_test_setup();
+    for (unsigned i = 0; i < 4 * AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+                                     / sizeof(deferred_record_t);
+         ++i) {
+        char expected[32];
+        snprintf(expected, sizeof(expected), "record %u %s", i, "x");
+        g_deferred_output.count = 0;
+        avs_log(deferred_test, INFO, "record %u %s", i, "x");
+        AVS_UNIT_ASSERT_EQUAL(avs_log_deferred_flush(), 1);
+        AVS_UNIT_ASSERT_EQUAL_STRING(g_deferred_output.lines[0], expected);
+    }
+    AVS_UNIT_ASSERT_EQUAL(avs_log_deferred_dropped(), 0);
+    deferred_test_teardown();
+}
+
+AVS_UNIT_TEST(log_deferred, drops_are_counted_and_reported) {
+    deferred_test_setup();
+    uint32_t dropped = avs_log_deferred_dropped();
+    g_deferred_notified = 0;
+    avs_log_set_deferred_notify(deferred_test_notify);
+    size_t recorded = 0;
+    while (avs_log_deferred_dropped() == dropped) {
+        avs_log(deferred_test, INFO, "filler %d", (int) recorded++);
+    }
+    --recorded;
+    avs_log(deferred_test, INFO, "filler %d", -1);
+    AVS_UNIT_ASSERT_EQUAL(avs_log_deferred_dropped() - dropped, 2);
+    AVS_UNIT_ASSERT_EQUAL(g_deferred_notified, recorded + 2);
+    AVS_UNIT_ASSERT_EQUAL(g_deferred_output.count, 0);
+
+    AVS_UNIT_ASSERT_EQUAL(avs_log_deferred_flush(), recorded);
+    AVS_UNIT_ASSERT_EQUAL(g_deferred_output.count, recorded + 1);
+    AVS_UNIT_ASSERT_EQUAL_STRING(g_deferred_output.lines[0], "filler 0");
+    AVS_UNIT_ASSERT_EQUAL_STRING(
+            g_deferred_output.last,
+            "2 messages dropped, deferred log buffer full");
+
+    // the drops are reported only once, and there is room again
+    g_deferred_output.count = 0;
+    avs_log(deferred_test, INFO, "after %s", "flush");
+    AVS_UNIT_ASSERT_EQUAL(avs_log_deferred_flush(), 1);
+    AVS_UNIT_ASSERT_EQUAL(g_deferred_output.count, 1);
+    AVS_UNIT_ASSERT_EQUAL_STRING(g_deferred_output.lines[0], "after flush");
+    deferred_test_teardown();
+}
+
+AVS_UNIT_TEST(log_deferred, notify_is_called_for_every_record) {
+    deferred_test_setup();
+    g_deferred_notified = 0;
+    avs_log_set_deferred_notify(deferred_test_notify);
+    avs_log(deferred_test, INFO, "first %d", 1);
+    avs_log(deferred_test, DEBUG, "filtered out %d", 2);
+    avs_log(deferred_test, WARNING, "second %s", "2");
+    AVS_UNIT_ASSERT_EQUAL(g_deferred_notified, 2);
+    avs_log_set_deferred_notify(NULL);
+    avs_log(deferred_test, INFO, "third %d", 3);
+    AVS_UNIT_ASSERT_EQUAL(g_deferred_notified, 2);
+    AVS_UNIT_ASSERT_EQUAL(avs_log_deferred_flush(), 3);
+    deferred_test_teardown();
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+
+#include <avsystem/commons/avs_unit_test.h>
+
+#define HEAP_TEST_MAX_JOBS 1024
+#define HEAP_TEST_OPERATIONS 4000
+
+typedef struct {
+    unsigned id;
+    int64_t instant_ms;
+    // order of the last scheduling or rescheduling, like the heap's seq
+    uint64_t order;
+    bool scheduled;
+    avs_sched_handle_t handle;
+} heap_test_job_t;
+
+static struct {
+    heap_test_job_t jobs[HEAP_TEST_MAX_JOBS];
+    size_t jobs_count;
+    uint64_t next_order;
+    unsigned executed[HEAP_TEST_MAX_JOBS];
+    size_t executed_count;
+    uint32_t random;
+} g_heap_test;
+
+static uint32_t heap_test_random(uint32_t range) {
+    g_heap_test.random = g_heap_test.random * 1103515245u + 12345u;
+    return (g_heap_test.random >> 8) % range;
+}
+
+static void heap_test_clb(avs_sched_t *sched, const void *id) {
+    (void) sched;
+    AVS_UNIT_ASSERT_TRUE(g_heap_test.executed_count < HEAP_TEST_MAX_JOBS);
+    g_heap_test.executed[g_heap_test.executed_count++] =
+            *(const unsigned *) id;
+}
+
+// jobs are scheduled in the past, so that avs_sched_run() executes all of them
+static avs_time_monotonic_t heap_test_instant(int64_t instant_ms) {
+    static avs_time_monotonic_t base;
+    if (!avs_time_monotonic_valid(base)) {
+        base = avs_time_monotonic_add(
+                avs_time_monotonic_now(),
+                avs_time_duration_from_scalar(-3600, AVS_TIME_S));
+    }
+    return avs_time_monotonic_add(
+            base, avs_time_duration_from_scalar(instant_ms, AVS_TIME_MS));
+}
+
+static void assert_heap_valid(avs_sched_t *sched) {
+    AVS_UNIT_ASSERT_TRUE(sched->jobs_count <= sched->jobs_capacity);
+    for (size_t i = 0; i < sched->jobs_count; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(sched->jobs[i]->heap_index, i);
+        if (i > 0) {
+            AVS_UNIT_ASSERT_FALSE(
+                    job_before(sched->jobs[i], sched->jobs[(i - 1) / 2]));
+        }
+    }
+}
+
+static int heap_test_job_compare(const void *a_ptr, const void *b_ptr) {
+    const heap_test_job_t *a = *(const heap_test_job_t *const *) a_ptr;
+    const heap_test_job_t *b = *(const heap_test_job_t *const *) b_ptr;
+    if (a->instant_ms != b->instant_ms) {
+        return a->instant_ms < b->instant_ms ? -1 : 1;
+    }
+    return a->order < b->order ? -1 : 1;
+}
+
+static void heap_test_schedule(avs_sched_t *sched) {
+    heap_test_job_t *job = &g_heap_test.jobs[g_heap_test.jobs_count];
+    job->id = (unsigned) g_heap_test.jobs_count++;
+    // a narrow range, so that many jobs are due at the same instant
+    job->instant_ms = heap_test_random(64);
+    job->order = g_heap_test.next_order++;
+    job->scheduled = true;
+    AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_AT(sched, &job->handle,
+                                         heap_test_instant(job->instant_ms),
+                                         heap_test_clb, &job->id,
+                                         sizeof(job->id)));
+}
+
+static heap_test_job_t *heap_test_random_scheduled(void) {
+    if (!g_heap_test.jobs_count) {
+        return NULL;
+    }
+    heap_test_job_t *job =
+            &g_heap_test.jobs[heap_test_random((uint32_t) g_heap_test
+                                                       .jobs_count)];
+    return job->scheduled ? job : NULL;
+}
+
+AVS_UNIT_TEST(sched_heap, random_operations_keep_time_then_fifo_order) {
+    memset(&g_heap_test, 0, sizeof(g_heap_test));
+    g_heap_test.random = 2021;
+    avs_sched_t *sched = avs_sched_new("heap", NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(sched);
+
+    for (unsigned i = 0; i < HEAP_TEST_OPERATIONS; ++i) {
+        uint32_t operation = heap_test_random(10);
+        heap_test_job_t *job;
+        if (operation < 5 && g_heap_test.jobs_count < HEAP_TEST_MAX_JOBS) {
+            heap_test_schedule(sched);
+        } else if (operation < 7 && (job = heap_test_random_scheduled())) {
+            avs_sched_del(&job->handle);
+            AVS_UNIT_ASSERT_NULL(job->handle);
+            job->scheduled = false;
+        } else if ((job = heap_test_random_scheduled())) {
+            job->instant_ms = heap_test_random(64);
+            job->order = g_heap_test.next_order++;
+            AVS_UNIT_ASSERT_SUCCESS(AVS_RESCHED_AT(
+                    &job->handle, heap_test_instant(job->instant_ms)));
+        }
+        assert_heap_valid(sched);
+    }
+
+    heap_test_job_t *expected[HEAP_TEST_MAX_JOBS];
+    size_t expected_count = 0;
+    for (size_t i = 0; i < g_heap_test.jobs_count; ++i) {
+        if (g_heap_test.jobs[i].scheduled) {
+            expected[expected_count++] = &g_heap_test.jobs[i];
+        }
+    }
+    AVS_UNIT_ASSERT_EQUAL(sched->jobs_count, expected_count);
+    qsort(expected, expected_count, sizeof(*expected), heap_test_job_compare);
+    AVS_UNIT_ASSERT_TRUE(avs_time_monotonic_equal(
+            avs_sched_time_of_next(sched),
+            heap_test_instant(expected[0]->instant_ms)));
+
+    avs_sched_run(sched);
+    AVS_UNIT_ASSERT_EQUAL(g_heap_test.executed_count, expected_count);
+    for (size_t i = 0; i < expected_count; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(g_heap_test.executed[i], expected[i]->id);
+        AVS_UNIT_ASSERT_NULL(expected[i]->handle);
+    }
+    AVS_UNIT_ASSERT_EQUAL(sched->jobs_count, 0);
+    avs_sched_cleanup(&sched);
+}
+
+AVS_UNIT_TEST(sched_heap, jobs_due_at_the_same_time_run_in_fifo_order) {
+    memset(&g_heap_test, 0, sizeof(g_heap_test));
+    avs_sched_t *sched = avs_sched_new("heap", NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(sched);
+    for (unsigned i = 0; i < 100; ++i) {
+        g_heap_test.jobs[i].id = i;
+        AVS_UNIT_ASSERT_SUCCESS(AVS_SCHED_AT(sched, &g_heap_test.jobs[i].handle,
+                                             heap_test_instant(0),
+                                             heap_test_clb,
+                                             &g_heap_test.jobs[i].id,
+                                             sizeof(unsigned)));
+    }
+    // a rescheduled job goes after the ones already due at the same time
+    AVS_UNIT_ASSERT_SUCCESS(
+            AVS_RESCHED_AT(&g_heap_test.jobs[0].handle, heap_test_instant(0)));
+    avs_sched_run(sched);
+    AVS_UNIT_ASSERT_EQUAL(g_heap_test.executed_count, 100);
+    for (unsigned i = 0; i < 99; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(g_heap_test.executed[i], i + 1);
+    }
+    AVS_UNIT_ASSERT_EQUAL(g_heap_test.executed[99], 0);
+    avs_sched_cleanup(&sched);
+}
+
+AVS_UNIT_TEST(sched_heap, storage_shrinks_when_jobs_are_cancelled) {
+    memset(&g_heap_test, 0, sizeof(g_heap_test));
+    g_heap_test.random = 7;
+    avs_sched_t *sched = avs_sched_new("heap", NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(sched);
+    for (unsigned i = 0; i < 256; ++i) {
+        heap_test_schedule(sched);
+    }
+    AVS_UNIT_ASSERT_EQUAL(sched->jobs_capacity, 256);
+    for (unsigned i = 1; i < 256; ++i) {
+        avs_sched_del(&g_heap_test.jobs[i].handle);
+        assert_heap_valid(sched);
+    }
+    AVS_UNIT_ASSERT_EQUAL(sched->jobs_count, 1);
+    AVS_UNIT_ASSERT_EQUAL(sched->jobs_capacity, JOBS_INITIAL_CAPACITY);
+
+    // cleanup cancels the remaining job and clears its handle
+    avs_sched_cleanup(&sched);
+    AVS_UNIT_ASSERT_NULL(g_heap_test.jobs[0].handle);
+}
@@ -27,6 +27,13 @@
 #define LWM2M_NOTIFY_THREAD_STACK_SIZE (512U)
 #define LWM2M_NOTIFY_THREAD_PRIO osPriorityNormal
 
+// Period of calls to the process_fcn passed to lwm2m_notify_start()
+#define LWM2M_NOTIFY_PERIOD_MS (1000U)
+
+// Period of Memory Free sampling and firmware download retries done by the
+// notify thread; without process_fcn, the thread only wakes up this often
+#define LWM2M_SAMPLE_PERIOD_MS (30000U)
+
 #define BOARD_BUTTONS_THREAD_STACK_SIZE (256U)
 #define BOARD_BUTTONS_THREAD_PRIO osPriorityBelowNormal
 
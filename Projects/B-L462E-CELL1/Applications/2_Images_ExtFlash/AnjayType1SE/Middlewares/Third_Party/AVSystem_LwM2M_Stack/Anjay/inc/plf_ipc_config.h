@@ -44,8 +44,17 @@ extern "C" {
 #define IPC_RXBUF_STREAM_MAXSIZE  ((uint16_t) IPC_RXBUF_MAXSIZE) /* maximum size of stream queue (if used) */
 #endif  /* (USE_SOCKETS_TYPE == USE_SOCKETS_MODEM) */
 
+/* RX mode: set to 1 to receive with circular DMA and idle line detection instead of one interrupt per character */
+#define IPC_USE_DMA_RX    (1U)
+#define IPC_RXDMA_BUFSIZE ((uint16_t) 256U) /* size of the circular RX DMA buffer */
+
 /* IPC_RXBUF_MAXSIZE and IPC_RXBUF_STREAM_MAXSIZE are defined above */
+#if (IPC_USE_DMA_RX == 1U)
+/* a whole DMA chunk may still arrive once the threshold has been reached */
+#define IPC_RXBUF_THRESHOLD  ((uint16_t) 20U + IPC_RXDMA_BUFSIZE)
+#else
 #define IPC_RXBUF_THRESHOLD  ((uint16_t) 20U)
+#endif /* IPC_USE_DMA_RX == 1U */
 
 /* IPC interface */
 #define IPC_USE_UART (1U) /* UART activated by default */
@@ -77,6 +77,24 @@ typedef struct anjay_struct anjay_t;
     }
 // clang-format on
 
+/**
+ * Callback deciding whether the DTLS connection_id extension shall be used for
+ * the connection configured by a given instance of the LwM2M Security Object.
+ *
+ * It is called each time a DTLS socket is created for a server. It MUST NOT
+ * call any Anjay API.
+ *
+ * @param ssid Short Server ID of the server configured by the Security Object
+ *             Instance, or @ref ANJAY_SSID_BOOTSTRAP for the Bootstrap Server.
+ *
+ * @param arg  Value of <c>use_connection_id_clb_arg</c> passed in
+ *             @ref anjay_configuration_t .
+ *
+ * @returns true if the connection_id extension shall be requested, false
+ *          otherwise.
+ */
+typedef bool anjay_use_connection_id_clb_t(anjay_ssid_t ssid, void *arg);
+
 typedef struct anjay_configuration {
     /**
      * Endpoint name as presented to the LwM2M server. Must be non-NULL, or
@@ -237,9 +255,26 @@ typedef struct anjay_configuration {
     /**
      * Enables support for DTLS connection_id extension for all DTLS
      * connections.
+     *
+     * If the server chooses a non-empty connection ID, the DTLS session is
+     * kept by @ref anjay_transport_schedule_reconnect and only the UDP socket
+     * is recreated, so that a change of the client address does not require
+     * a new handshake.
      */
     bool use_connection_id;
 
+    /**
+     * Callback enabling support for DTLS connection_id extension for specific
+     * Security Object Instances. If not NULL, it takes precedence over
+     * <c>use_connection_id</c>.
+     */
+    anjay_use_connection_id_clb_t *use_connection_id_clb;
+
+    /**
+     * Argument passed to <c>use_connection_id_clb</c>.
+     */
+    void *use_connection_id_clb_arg;
+
     /**
      * (D)TLS ciphersuites to use if the "DTLS/TLS Ciphersuite" Resource
      * (/0/x/16) is not available or empty.
@@ -770,6 +805,11 @@ int anjay_transport_set_online(anjay_t *anjay,
  * and will trigger sending any messages necessary to maintain valid
  * registration (DTLS session resumption and/or Register or Update RPCs).
  *
+ * DTLS connections for which the server chose a non-empty connection ID (see
+ * <c>use_connection_id</c> in @ref anjay_configuration_t ) are not closed:
+ * their UDP sockets are recreated immediately and the DTLS sessions go on
+ * without any handshake.
+ *
  * In case of ongoing downloads (started via @ref anjay_download or the
  * <c>fw_update</c> module), if the reconnection fails, the download will be
  * aborted with an error.
@@ -921,6 +961,54 @@ int anjay_security_config_from_dm(anjay_t *anjay,
  */
 bool anjay_ongoing_registration_exists(anjay_t *anjay);
 
+/**
+ * Dumps the registration state of all LwM2M Servers the client is currently
+ * registered to into the @p out_stream. This includes the Registration
+ * Interface location path and parameters sent in the last Register or Update
+ * message.
+ *
+ * The stored data, together with the state of the Server object, allows a
+ * client restarted e.g. after a reboot to continue using the existing
+ * registration with an Update, instead of performing a Register operation.
+ * Information about Observations is NOT persisted, so servers that have any
+ * Observations active are skipped and will be registered to anew after
+ * restoring.
+ *
+ * The DTLS session and the credentials are NOT part of the data, so it may be
+ * kept in storage that is not protected against reading. A new DTLS handshake
+ * is performed after restoring.
+ *
+ * @param anjay      Anjay object to operate on.
+ * @param out_stream Stream to write to.
+ *
+ * @returns AVS_OK in case of success, or an error code. If state persistence
+ *          support is not compiled in (see
+ *          <c>ANJAY_WITH_CORE_PERSISTENCE</c>), <c>AVS_ENOTSUP</c> is returned.
+ */
+avs_error_t anjay_registration_state_persist(anjay_t *anjay,
+                                             avs_stream_t *out_stream);
+
+/**
+ * Restores the registration state previously stored using
+ * @ref anjay_registration_state_persist .
+ *
+ * This function is required to be called before the first call to
+ * @ref anjay_sched_run on a newly created Anjay object. The restored state will
+ * be used for servers that are subsequently loaded from the data model with a
+ * matching Short Server ID. The first session established with each of such
+ * servers will be used to send an Update message; if the server rejects it, a
+ * regular Register operation will be performed.
+ *
+ * @param anjay     Anjay object to operate on.
+ * @param in_stream Stream to read from.
+ *
+ * @returns AVS_OK in case of success, or an error code. If state persistence
+ *          support is not compiled in (see
+ *          <c>ANJAY_WITH_CORE_PERSISTENCE</c>), <c>AVS_ENOTSUP</c> is returned.
+ */
+avs_error_t anjay_registration_state_restore(anjay_t *anjay,
+                                             avs_stream_t *in_stream);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
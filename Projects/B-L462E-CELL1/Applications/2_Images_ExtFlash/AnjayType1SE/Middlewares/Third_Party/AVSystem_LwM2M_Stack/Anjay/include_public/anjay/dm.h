@@ -977,6 +977,97 @@ typedef struct {
 anjay_resource_observation_status_t anjay_resource_observation_status(
         anjay_t *anjay, anjay_oid_t oid, anjay_iid_t iid, anjay_rid_t rid);
 
+/**
+ * Declares that every change of any Resource of a given Object is reported
+ * with @ref anjay_notify_changed (or happens through a data model operation,
+ * which Anjay reports by itself).
+ *
+ * Notifications for Object and Object Instance observations on such an Object
+ * are then prepared by re-reading only the Resources reported as changed, and
+ * reusing the previously read values of the remaining ones. For other Objects,
+ * all observed Resources are read whenever a notification is prepared, so that
+ * changes that have not been reported are picked up as well.
+ *
+ * NOTE: This function is only functional if Anjay is compiled with
+ * ANJAY_WITH_OBSERVE_INCREMENTAL_READ.
+ *
+ * @param anjay Anjay object to operate on.
+ * @param oid   Object ID of the Object.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int anjay_observe_incremental_read_enable(anjay_t *anjay, anjay_oid_t oid);
+
+/**
+ * Enables buffering of timestamped samples for a given Resource.
+ *
+ * Samples added with @ref anjay_sample_buffer_add_int or
+ * @ref anjay_sample_buffer_add_double are stored in a ring of @p capacity
+ * entries; when it is full, each new sample replaces the oldest one. Adding
+ * a sample does not trigger a notification by itself. Instead, each
+ * notification sent in a SenML-like Content-Format (LwM2M JSON or SenML CBOR)
+ * for an observation covering the Resource carries, in addition to the current
+ * value, one timestamped record for every sample taken since the previous
+ * notification. Together with the <c>pmax</c> attribute, this allows the
+ * application to sample a value frequently and report it in batches.
+ *
+ * Calling this function again for the same Resource discards all samples
+ * buffered so far. Passing @p capacity equal to 0 disables buffering.
+ *
+ * NOTE: This function is only functional if Anjay is compiled with
+ * ANJAY_WITH_OBSERVE_SAMPLE_BUFFER.
+ *
+ * @param anjay    Anjay object to operate on.
+ * @param oid      Object ID of the Resource.
+ * @param iid      Object Instance ID of the Resource.
+ * @param rid      Resource ID of the Resource.
+ * @param capacity Maximum number of samples kept for the Resource.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int anjay_sample_buffer_enable(anjay_t *anjay,
+                               anjay_oid_t oid,
+                               anjay_iid_t iid,
+                               anjay_rid_t rid,
+                               size_t capacity);
+
+/**
+ * Stores an integer sample of a given Resource, timestamped with the current
+ * real time. The sample buffer needs to be enabled for the Resource first using
+ * @ref anjay_sample_buffer_enable.
+ *
+ * @param anjay Anjay object to operate on.
+ * @param oid   Object ID of the Resource.
+ * @param iid   Object Instance ID of the Resource.
+ * @param rid   Resource ID of the Resource.
+ * @param value Sampled value.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int anjay_sample_buffer_add_int(anjay_t *anjay,
+                                anjay_oid_t oid,
+                                anjay_iid_t iid,
+                                anjay_rid_t rid,
+                                int64_t value);
+
+/**
+ * Stores a floating-point sample of a given Resource. See
+ * @ref anjay_sample_buffer_add_int for details.
+ *
+ * @param anjay Anjay object to operate on.
+ * @param oid   Object ID of the Resource.
+ * @param iid   Object Instance ID of the Resource.
+ * @param rid   Resource ID of the Resource.
+ * @param value Sampled value.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int anjay_sample_buffer_add_double(anjay_t *anjay,
+                                   anjay_oid_t oid,
+                                   anjay_iid_t iid,
+                                   anjay_rid_t rid,
+                                   double value);
+
 /**
  * Registers the Object in the data model, making it available for RPC calls.
  *
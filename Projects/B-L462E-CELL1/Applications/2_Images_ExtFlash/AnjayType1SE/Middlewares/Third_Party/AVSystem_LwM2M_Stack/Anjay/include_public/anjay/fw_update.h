@@ -453,6 +453,36 @@ typedef int anjay_fw_update_get_security_config_t(
 typedef avs_coap_udp_tx_params_t
 anjay_fw_update_get_coap_tx_params_t(void *user_ptr, const char *download_uri);
 
+/**
+ * Suspends the download stream after a PULL download has been interrupted by a
+ * connection loss, keeping the data written so far.
+ *
+ * If the handler succeeds, the stream is left open, positioned at
+ * @p out_resume_offset: data written past that offset (e.g. still buffered and
+ * not yet stored) shall be discarded. The object stays in the Downloading state,
+ * and the download is resumed from that offset, with the same ETag, when
+ * @ref anjay_fw_update_pull_reconnect is called.
+ *
+ * If the handler fails, the stream shall be closed. The object moves into the
+ * Idle state with the Update Result set to Connection Lost; the data may still
+ * be used to resume the download, e.g. by initializing the object with
+ * <c>ANJAY_FW_UPDATE_INITIAL_DOWNLOADING</c> after a reboot.
+ *
+ * If this handler is not implemented at all (with the corresponding field set
+ * to <c>NULL</c>), or the server sent no ETag, @ref anjay_fw_update_reset_t is
+ * called instead.
+ *
+ * @param user_ptr          Opaque pointer to user data, as passed to
+ *                          @ref anjay_fw_update_install
+ *
+ * @param out_resume_offset Offset in the package from which the download
+ *                          shall be resumed.
+ *
+ * @returns 0 if the download may be resumed, or a negative value otherwise.
+ */
+typedef int anjay_fw_update_suspend_t(void *user_ptr,
+                                      size_t *out_resume_offset);
+
 /**
  * Handler callbacks that shall implement the platform-specific part of firmware
  * update process.
@@ -484,6 +514,12 @@ anjay_fw_update_get_coap_tx_params_t(void *user_ptr, const char *download_uri);
  *     case
  *   - <c>reset</c> - shall remove all downloaded data; moves the object into
  *     the <em>Idle</em> state
+ *   - <c>suspend</c> - shall prepare the download stream to be resumed,
+ *     keeping the data downloaded so far; called instead of <c>reset</c> if a
+ *     PULL download is interrupted by a connection loss; if it succeeds, the
+ *     object stays in the <em>Downloading</em> state until the download is
+ *     resumed by @ref anjay_fw_update_pull_reconnect, otherwise it moves into
+ *     the <em>Idle</em> state
  * - <strong>Downloaded</strong>. The object might be initialized directly into
  *   this state by using <c>ANJAY_FW_UPDATE_INITIAL_DOWNLOADED</c>. In this
  *   state, the firmware package has been downloaded and checked and is ready to
@@ -530,6 +566,10 @@ typedef struct {
     /** Queries CoAP transmission parameters to be used during firmware
      * update. */
     anjay_fw_update_get_coap_tx_params_t *get_coap_tx_params;
+
+    /** Suspends the download stream after a connection loss, keeping the
+     * data downloaded so far; @ref anjay_fw_update_suspend_t */
+    anjay_fw_update_suspend_t *suspend;
 } anjay_fw_update_handlers_t;
 
 /**
@@ -597,6 +637,24 @@ int anjay_fw_update_install(
  */
 int anjay_fw_update_set_result(anjay_t *anjay, anjay_fw_update_result_t result);
 
+/**
+ * Resumes a PULL download suspended after a connection loss (see
+ * @ref anjay_fw_update_suspend_t), from the offset reported by the
+ * <c>suspend</c> handler and with the ETag of the interrupted download. Shall
+ * be called once the network connection is available again.
+ *
+ * If the server no longer has the same package, the download is restarted from
+ * the beginning, in the same way as after resuming with
+ * <c>ANJAY_FW_UPDATE_INITIAL_DOWNLOADING</c>.
+ *
+ * @param anjay Anjay object to operate on.
+ *
+ * @returns 0 if there was no suspended download, or it has been resumed;
+ *          a negative value if the download could not be resumed, in which
+ *          case the object moves into the Idle state.
+ */
+int anjay_fw_update_pull_reconnect(anjay_t *anjay);
+
 #ifdef __cplusplus
 }
 #endif
@@ -53,6 +53,23 @@ uint64_t anjay_get_num_incoming_retransmissions(anjay_t *anjay);
  */
 uint64_t anjay_get_num_outgoing_retransmissions(anjay_t *anjay);
 
+/**
+ * @returns the number of per-observation notification trigger updates that
+ *          were skipped because several data model changes reported in one
+ *          notify batch matched the same observation.
+ *
+ * NOTE: When ANJAY_WITH_OBSERVE is disabled this function always return 0.
+ */
+uint64_t anjay_get_num_coalesced_notify_triggers(anjay_t *anjay);
+
+/**
+ * @returns the number of times the list of Objects and Object Instances sent
+ *          in Register and Update requests was reused without querying the
+ *          data model, because no changes to the set of Object Instances were
+ *          reported since it was last generated.
+ */
+uint64_t anjay_get_num_registration_payload_cache_hits(anjay_t *anjay);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
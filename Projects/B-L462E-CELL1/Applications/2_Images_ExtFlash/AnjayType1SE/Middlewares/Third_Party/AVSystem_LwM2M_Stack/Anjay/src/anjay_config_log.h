@@ -189,6 +189,16 @@ static inline void _anjay_log_feature_list(void) {
 #else // ANJAY_WITH_OBSERVE
     _anjay_log(anjay, TRACE, "ANJAY_WITH_OBSERVE = OFF");
 #endif // ANJAY_WITH_OBSERVE
+#ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    _anjay_log(anjay, TRACE, "ANJAY_WITH_OBSERVE_INCREMENTAL_READ = ON");
+#else // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    _anjay_log(anjay, TRACE, "ANJAY_WITH_OBSERVE_INCREMENTAL_READ = OFF");
+#endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    _anjay_log(anjay, TRACE, "ANJAY_WITH_OBSERVE_SAMPLE_BUFFER = ON");
+#else // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    _anjay_log(anjay, TRACE, "ANJAY_WITH_OBSERVE_SAMPLE_BUFFER = OFF");
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
 #ifdef ANJAY_WITH_SEND
     _anjay_log(anjay, TRACE, "ANJAY_WITH_SEND = ON");
 #else // ANJAY_WITH_SEND
@@ -285,6 +295,11 @@ static inline void _anjay_log_feature_list(void) {
 #else // AVS_COMMONS_LOG_USE_GLOBAL_BUFFER
     _anjay_log(anjay, TRACE, "AVS_COMMONS_LOG_USE_GLOBAL_BUFFER = OFF");
 #endif // AVS_COMMONS_LOG_USE_GLOBAL_BUFFER
+#ifdef AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+    _anjay_log(anjay, TRACE, "AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE = ON");
+#else // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
+    _anjay_log(anjay, TRACE, "AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE = OFF");
+#endif // AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE
 #ifdef AVS_COMMONS_LOG_WITH_DEFAULT_HANDLER
     _anjay_log(anjay, TRACE, "AVS_COMMONS_LOG_WITH_DEFAULT_HANDLER = ON");
 #else // AVS_COMMONS_LOG_WITH_DEFAULT_HANDLER
@@ -375,6 +390,11 @@ static inline void _anjay_log_feature_list(void) {
 #else // AVS_COMMONS_SCHED_THREAD_SAFE
     _anjay_log(anjay, TRACE, "AVS_COMMONS_SCHED_THREAD_SAFE = OFF");
 #endif // AVS_COMMONS_SCHED_THREAD_SAFE
+#ifdef AVS_COMMONS_SCHED_WITH_HEAP
+    _anjay_log(anjay, TRACE, "AVS_COMMONS_SCHED_WITH_HEAP = ON");
+#else // AVS_COMMONS_SCHED_WITH_HEAP
+    _anjay_log(anjay, TRACE, "AVS_COMMONS_SCHED_WITH_HEAP = OFF");
+#endif // AVS_COMMONS_SCHED_WITH_HEAP
 #ifdef AVS_COMMONS_STREAM_WITH_FILE
     _anjay_log(anjay, TRACE, "AVS_COMMONS_STREAM_WITH_FILE = ON");
 #else // AVS_COMMONS_STREAM_WITH_FILE
@@ -53,6 +53,15 @@ int _anjay_acl_ref_validate_inst_ref(anjay_unlocked_t *anjay,
                                      anjay_oid_t target_oid,
                                      anjay_iid_t target_iid);
 
+/**
+ * Marks the compiled ACL index as outdated, so that it is rebuilt from the
+ * Access Control object on next access check. Changes to the Access Control
+ * object that are reported through the notify mechanism invalidate the index
+ * automatically - this function is only necessary if the object contents are
+ * replaced without notifying, e.g. when restoring persisted state.
+ */
+void _anjay_acl_index_invalidate(anjay_unlocked_t *anjay);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif /* ANJAY_INCLUDE_ANJAY_MODULES_ACCESS_UTILS_H */
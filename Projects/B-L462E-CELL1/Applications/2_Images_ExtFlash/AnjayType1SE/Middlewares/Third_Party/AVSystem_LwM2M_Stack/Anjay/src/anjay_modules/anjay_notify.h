@@ -67,6 +67,12 @@ int _anjay_notify_perform_without_servers(anjay_unlocked_t *anjay,
 int _anjay_notify_flush(anjay_unlocked_t *anjay,
                         anjay_notify_queue_t *queue_ptr);
 
+/**
+ * Checks whether any entry in @p queue signals a change to the set of
+ * instances of its Object.
+ */
+bool _anjay_notify_queue_instance_set_changed(anjay_notify_queue_t queue);
+
 int _anjay_notify_queue_instance_created(anjay_notify_queue_t *out_queue,
                                          anjay_oid_t oid,
                                          anjay_iid_t iid);
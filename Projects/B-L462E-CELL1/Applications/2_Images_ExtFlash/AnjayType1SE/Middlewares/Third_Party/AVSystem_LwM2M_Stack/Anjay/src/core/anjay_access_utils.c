@@ -17,6 +17,10 @@
 #include <anjay_init.h>
 
 #include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avsystem/commons/avs_memory.h>
 
 #include <anjay_modules/anjay_access_utils.h>
 #include <anjay_modules/anjay_raw_buffer.h>
@@ -268,20 +272,234 @@ static int get_mask(anjay_unlocked_t *anjay,
     return 0;
 }
 
+static const anjay_notify_queue_object_entry_t *
+get_ac_notif_entry(anjay_notify_queue_t queue);
+
+void _anjay_acl_index_invalidate(anjay_unlocked_t *anjay) {
+    anjay->acl_index.state = ANJAY_ACL_INDEX_INVALID;
+}
+
+void _anjay_acl_index_cleanup(anjay_unlocked_t *anjay) {
+    avs_free(anjay->acl_index.entries);
+    memset(&anjay->acl_index, 0, sizeof(anjay->acl_index));
+}
+
+static int acl_index_entry_cmp(const void *left_, const void *right_) {
+    const anjay_acl_index_entry_t *left =
+            (const anjay_acl_index_entry_t *) left_;
+    const anjay_acl_index_entry_t *right =
+            (const anjay_acl_index_entry_t *) right_;
+    if (left->oid != right->oid) {
+        return left->oid < right->oid ? -1 : 1;
+    }
+    if (left->iid != right->iid) {
+        return left->iid < right->iid ? -1 : 1;
+    }
+    if (left->ac_iid != right->ac_iid) {
+        return left->ac_iid < right->ac_iid ? -1 : 1;
+    }
+    if (left->ssid != right->ssid) {
+        return left->ssid < right->ssid ? -1 : 1;
+    }
+    return 0;
+}
+
+static int acl_index_lookup_cmp(const void *key_, const void *entry_) {
+    const anjay_acl_index_entry_t *key = (const anjay_acl_index_entry_t *) key_;
+    const anjay_acl_index_entry_t *entry =
+            (const anjay_acl_index_entry_t *) entry_;
+    if (key->oid != entry->oid) {
+        return key->oid < entry->oid ? -1 : 1;
+    }
+    if (key->iid != entry->iid) {
+        return key->iid < entry->iid ? -1 : 1;
+    }
+    if (key->ssid != entry->ssid) {
+        return key->ssid < entry->ssid ? -1 : 1;
+    }
+    return 0;
+}
+
+static int acl_index_append(anjay_acl_index_t *index,
+                            const anjay_acl_index_entry_t *entry) {
+    if (index->size == index->capacity) {
+        size_t new_capacity = index->capacity ? 2 * index->capacity : 16;
+        anjay_acl_index_entry_t *new_entries = (anjay_acl_index_entry_t *)
+                avs_realloc(index->entries,
+                            new_capacity * sizeof(*new_entries));
+        if (!new_entries) {
+            anjay_log(ERROR, _("out of memory"));
+            return -1;
+        }
+        index->entries = new_entries;
+        index->capacity = new_capacity;
+    }
+    index->entries[index->size++] = *entry;
+    return 0;
+}
+
+typedef struct {
+    anjay_acl_index_t *index;
+    anjay_acl_index_entry_t entry;
+} acl_index_build_args_t;
+
+static int acl_index_add_acl_entry_clb(anjay_unlocked_t *anjay,
+                                       const anjay_dm_installed_object_t *obj,
+                                       anjay_iid_t iid,
+                                       anjay_rid_t rid,
+                                       anjay_riid_t riid,
+                                       void *args_) {
+    acl_index_build_args_t *args = (acl_index_build_args_t *) args_;
+    int result = read_mask(anjay, obj, iid, rid, riid, &args->entry.mask);
+    if (!result) {
+        args->entry.ssid = riid;
+        result = acl_index_append(args->index, &args->entry);
+    }
+    return result;
+}
+
+static int acl_index_add_instance_clb(anjay_unlocked_t *anjay,
+                                      const anjay_dm_installed_object_t *ac_obj,
+                                      anjay_iid_t ac_iid,
+                                      void *index_) {
+    acl_index_build_args_t args = {
+        .index = (anjay_acl_index_t *) index_,
+        .entry = {
+            .ac_iid = ac_iid
+        }
+    };
+    int result = read_ids_from_ac_instance(anjay, ac_iid, &args.entry.oid,
+                                           &args.entry.iid, NULL);
+    if (result) {
+        return result;
+    }
+    size_t size_before = args.index->size;
+    if ((result = foreach_acl(anjay, ac_obj, ac_iid,
+                              acl_index_add_acl_entry_clb, &args))) {
+        return result;
+    }
+    if (args.index->size == size_before) {
+        // Empty ACL: the owner gets full access, except Create. Without
+        // a valid owner, nobody gets any access - an entry is still needed,
+        // so that other instances referring to the same target stay hidden.
+        anjay_ssid_t owner;
+        if (!read_ids_from_ac_instance(anjay, ac_iid, NULL, NULL, &owner)
+                && owner != ANJAY_SSID_ANY) {
+            args.entry.ssid = owner;
+            args.entry.mask = ANJAY_ACCESS_MASK_FULL & ~ANJAY_ACCESS_MASK_CREATE;
+        } else {
+            args.entry.ssid = ANJAY_SSID_ANY;
+            args.entry.mask = ANJAY_ACCESS_MASK_NONE;
+        }
+        result = acl_index_append(args.index, &args.entry);
+    }
+    return result;
+}
+
+static void acl_index_build(anjay_unlocked_t *anjay,
+                            const anjay_dm_installed_object_t *ac_obj) {
+    anjay_acl_index_t *index = &anjay->acl_index;
+    index->size = 0;
+    index->ac_obj = ac_obj;
+    if (_anjay_dm_foreach_instance(anjay, ac_obj, acl_index_add_instance_clb,
+                                   index)) {
+        anjay_log(WARNING, _("could not compile ACL index, falling back to "
+                             "reading the Access Control object directly"));
+        index->state = ANJAY_ACL_INDEX_UNAVAILABLE;
+        return;
+    }
+    qsort(index->entries, index->size, sizeof(*index->entries),
+          acl_index_entry_cmp);
+    // Only the first Access Control instance (in IID order) referring to a
+    // given target is ever taken into account; drop entries of the others
+    size_t out = 0;
+    for (size_t i = 0; i < index->size; ++i) {
+        if (out > 0 && index->entries[out - 1].oid == index->entries[i].oid
+                && index->entries[out - 1].iid == index->entries[i].iid
+                && index->entries[out - 1].ac_iid
+                               != index->entries[i].ac_iid) {
+            continue;
+        }
+        index->entries[out++] = index->entries[i];
+    }
+    index->size = out;
+    index->state = ANJAY_ACL_INDEX_READY;
+}
+
+static const anjay_acl_index_entry_t *
+acl_index_find(const anjay_acl_index_t *index,
+               anjay_oid_t oid,
+               anjay_iid_t iid,
+               anjay_ssid_t ssid) {
+    const anjay_acl_index_entry_t key = {
+        .oid = oid,
+        .iid = iid,
+        .ssid = ssid
+    };
+    return (const anjay_acl_index_entry_t *) bsearch(
+            &key, index->entries, index->size, sizeof(*index->entries),
+            acl_index_lookup_cmp);
+}
+
+/**
+ * Returns true and fills @p out_mask if the answer could be obtained from the
+ * compiled ACL index. The index is not used while changes to the Access
+ * Control object might still be waiting in one of the notification queues.
+ */
+static bool acl_index_mask(anjay_unlocked_t *anjay,
+                           const anjay_dm_installed_object_t *ac_obj,
+                           anjay_oid_t oid,
+                           anjay_iid_t iid,
+                           anjay_ssid_t ssid,
+                           anjay_access_mask_t *out_mask) {
+    if (get_ac_notif_entry(anjay->scheduled_notify.queue)
+#ifdef ANJAY_WITH_BOOTSTRAP
+            || get_ac_notif_entry(anjay->bootstrap.notification_queue)
+#endif // ANJAY_WITH_BOOTSTRAP
+    ) {
+        return false;
+    }
+    if (anjay->acl_index.state != ANJAY_ACL_INDEX_INVALID
+            && anjay->acl_index.ac_obj != ac_obj) {
+        _anjay_acl_index_invalidate(anjay);
+    }
+    if (anjay->acl_index.state == ANJAY_ACL_INDEX_INVALID) {
+        acl_index_build(anjay, ac_obj);
+    }
+    if (anjay->acl_index.state != ANJAY_ACL_INDEX_READY) {
+        return false;
+    }
+    const anjay_acl_index_entry_t *entry;
+    if ((entry = acl_index_find(&anjay->acl_index, oid, iid, ssid))
+            || (entry = acl_index_find(&anjay->acl_index, oid, iid,
+                                       ANJAY_SSID_ANY))) {
+        *out_mask = entry->mask;
+    } else {
+        *out_mask = ANJAY_ACCESS_MASK_NONE;
+    }
+    return true;
+}
+
 static anjay_access_mask_t access_control_mask(anjay_unlocked_t *anjay,
                                                anjay_oid_t oid,
                                                anjay_iid_t iid,
                                                anjay_ssid_t ssid) {
     const anjay_dm_installed_object_t *ac_obj =
             _anjay_dm_find_object_by_oid(anjay, ANJAY_DM_OID_ACCESS_CONTROL);
+    if (!ac_obj) {
+        return ANJAY_ACCESS_MASK_NONE;
+    }
+    anjay_access_mask_t mask;
+    if (acl_index_mask(anjay, ac_obj, oid, iid, ssid, &mask)) {
+        return mask;
+    }
+
     anjay_iid_t ac_iid;
-    if (!ac_obj
-            || find_ac_instance_by_target(anjay, ac_obj, &ac_iid, oid, iid)) {
+    if (find_ac_instance_by_target(anjay, ac_obj, &ac_iid, oid, iid)) {
         return ANJAY_ACCESS_MASK_NONE;
     }
 
     anjay_ssid_t found_ssid = ssid;
-    anjay_access_mask_t mask;
     if (get_mask(anjay, ac_obj, (anjay_iid_t) ac_iid, &found_ssid, &mask)) {
         anjay_log(WARNING, _("failed to read ACL!"));
         return ANJAY_ACCESS_MASK_NONE;
@@ -1046,6 +1264,9 @@ int _anjay_sync_access_control(anjay_unlocked_t *anjay,
     (void) notifications_queue;
     return 0;
 #else  // ANJAY_WITH_ACCESS_CONTROL
+    if (get_ac_notif_entry(*notifications_queue)) {
+        _anjay_acl_index_invalidate(anjay);
+    }
     const anjay_dm_installed_object_t *ac_obj = get_access_control(anjay);
     if (!ac_obj) {
         return 0;
@@ -1071,6 +1292,15 @@ int _anjay_sync_access_control(anjay_unlocked_t *anjay,
         result = generate_apparent_instance_set_change_notifications(
                 anjay, notifications_queue);
     }
-    return _anjay_dm_transaction_finish(anjay, result);
+    result = _anjay_dm_transaction_finish(anjay, result);
+    if (result || get_ac_notif_entry(*notifications_queue)) {
+        // Access Control instances might have been modified above
+        _anjay_acl_index_invalidate(anjay);
+    }
+    return result;
 #endif // ANJAY_WITH_ACCESS_CONTROL
 }
+
+#if defined(ANJAY_TEST) && defined(ANJAY_WITH_ACCESS_CONTROL)
+#    include "tests/core/acl_index.c"
+#endif // defined(ANJAY_TEST) && defined(ANJAY_WITH_ACCESS_CONTROL)
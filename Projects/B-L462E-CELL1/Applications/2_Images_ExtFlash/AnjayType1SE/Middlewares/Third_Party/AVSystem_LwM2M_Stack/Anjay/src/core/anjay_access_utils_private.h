@@ -67,6 +67,13 @@ bool _anjay_instance_action_allowed(anjay_unlocked_t *anjay,
 int _anjay_sync_access_control(anjay_unlocked_t *anjay,
                                anjay_notify_queue_t *notifications_queue);
 
+#ifdef ANJAY_WITH_ACCESS_CONTROL
+/**
+ * Frees the compiled ACL index built by access checks.
+ */
+void _anjay_acl_index_cleanup(anjay_unlocked_t *anjay);
+#endif // ANJAY_WITH_ACCESS_CONTROL
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif /* ANJAY_ACCESS_UTILS_PRIVATE_H */
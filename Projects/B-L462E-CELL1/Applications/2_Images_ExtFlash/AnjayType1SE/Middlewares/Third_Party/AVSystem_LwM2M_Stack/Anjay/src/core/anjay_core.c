@@ -38,6 +38,7 @@
 
 #include <anjay_config_log.h>
 
+#include "anjay_access_utils_private.h"
 #include "anjay_core.h"
 #include "coap/anjay_content_format.h"
 #include "coap/anjay_msg_details.h"
@@ -159,6 +160,8 @@ static int init_anjay(anjay_unlocked_t *anjay,
 
     anjay->prefer_hierarchical_formats = config->prefer_hierarchical_formats;
     anjay->use_connection_id = config->use_connection_id;
+    anjay->use_connection_id_clb = config->use_connection_id_clb;
+    anjay->use_connection_id_clb_arg = config->use_connection_id_clb_arg;
     anjay->additional_tls_config_clb = config->additional_tls_config_clb;
 
     if (config->prng_ctx) {
@@ -227,6 +230,7 @@ static void anjay_cleanup_impl(anjay_unlocked_t *anjay, bool deregister) {
     // scheduler. That prevents us from updating a registration even though
     // we're about to deregister anyway.
     _anjay_servers_cleanup(anjay);
+    _anjay_restored_registrations_cleanup(anjay);
 
     _anjay_bootstrap_cleanup(anjay);
 
@@ -236,6 +240,10 @@ static void anjay_cleanup_impl(anjay_unlocked_t *anjay, bool deregister) {
 
     _anjay_dm_cleanup(anjay);
     _anjay_notify_clear_queue(&anjay->scheduled_notify.queue);
+    _anjay_registration_payload_cache_invalidate(anjay);
+#ifdef ANJAY_WITH_ACCESS_CONTROL
+    _anjay_acl_index_cleanup(anjay);
+#endif // ANJAY_WITH_ACCESS_CONTROL
 
     avs_free(anjay->default_tls_ciphersuites.ids);
     avs_free(anjay->endpoint_name);
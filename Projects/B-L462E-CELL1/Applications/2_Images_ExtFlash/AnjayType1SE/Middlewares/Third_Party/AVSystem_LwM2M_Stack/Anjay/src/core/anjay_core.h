@@ -51,6 +51,35 @@ typedef struct {
     avs_crypto_prng_ctx_t *ctx;
 } anjay_prng_ctx_t;
 
+#ifdef ANJAY_WITH_ACCESS_CONTROL
+typedef struct {
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    anjay_iid_t ac_iid;
+    anjay_ssid_t ssid;
+    anjay_access_mask_t mask;
+} anjay_acl_index_entry_t;
+
+typedef enum {
+    ANJAY_ACL_INDEX_INVALID,
+    ANJAY_ACL_INDEX_READY,
+    ANJAY_ACL_INDEX_UNAVAILABLE
+} anjay_acl_index_state_t;
+
+/**
+ * Compiled contents of the Access Control object: one entry per ACL entry
+ * (or per owner, for instances with an empty ACL), sorted by (oid, iid, ssid).
+ * Rebuilt lazily after being invalidated by _anjay_sync_access_control().
+ */
+typedef struct {
+    anjay_acl_index_state_t state;
+    const anjay_dm_installed_object_t *ac_obj;
+    anjay_acl_index_entry_t *entries;
+    size_t size;
+    size_t capacity;
+} anjay_acl_index_t;
+#endif // ANJAY_WITH_ACCESS_CONTROL
+
 struct
 #ifdef ANJAY_WITH_THREAD_SAFETY
         anjay_unlocked_struct
@@ -83,6 +112,11 @@ struct
 
     anjay_connection_ref_t current_connection;
     anjay_scheduled_notify_t scheduled_notify;
+    anjay_registration_payload_cache_t registration_payload_cache;
+#if defined(ANJAY_WITH_CORE_PERSISTENCE) \
+        && defined(AVS_COMMONS_WITH_AVS_PERSISTENCE)
+    AVS_LIST(anjay_restored_registration_t) restored_registrations;
+#endif // ANJAY_WITH_CORE_PERSISTENCE && AVS_COMMONS_WITH_AVS_PERSISTENCE
 
     char *endpoint_name;
     anjay_transaction_state_t transaction_state;
@@ -98,9 +132,14 @@ struct
     closed_connections_stats_t closed_connections_stats;
 #endif // ANJAY_WITH_NET_STATS
     bool use_connection_id;
+    anjay_use_connection_id_clb_t *use_connection_id_clb;
+    void *use_connection_id_clb_arg;
     avs_ssl_additional_configuration_clb_t *additional_tls_config_clb;
 
     anjay_prng_ctx_t prng_ctx;
+#ifdef ANJAY_WITH_ACCESS_CONTROL
+    anjay_acl_index_t acl_index;
+#endif // ANJAY_WITH_ACCESS_CONTROL
 };
 
 #define ANJAY_DM_DEFAULT_PMIN_VALUE 1
@@ -112,6 +112,47 @@ static int validate_version(const anjay_dm_installed_object_t *obj) {
     return 0;
 }
 
+/**
+ * Returns the index of the first registered object with OID not less than
+ * @p oid, or <c>dm->objects_count</c> if there is no such object.
+ */
+static size_t find_object_index(const struct anjay_dm *dm, anjay_oid_t oid) {
+    size_t lo = 0;
+    size_t hi = dm->objects_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (_anjay_dm_installed_object_oid(dm->objects[mid]) < oid) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static bool object_at_index_has_oid(const struct anjay_dm *dm,
+                                    size_t index,
+                                    anjay_oid_t oid) {
+    return index < dm->objects_count
+           && _anjay_dm_installed_object_oid(dm->objects[index]) == oid;
+}
+
+static int reserve_objects(struct anjay_dm *dm, size_t count) {
+    if (count <= dm->objects_capacity) {
+        return 0;
+    }
+    size_t new_capacity = 2 * dm->objects_capacity + 1;
+    AVS_LIST(anjay_dm_installed_object_t) *new_objects =
+            (AVS_LIST(anjay_dm_installed_object_t) *) avs_realloc(
+                    dm->objects, new_capacity * sizeof(*new_objects));
+    if (!new_objects) {
+        return -1;
+    }
+    dm->objects = new_objects;
+    dm->objects_capacity = new_capacity;
+    return 0;
+}
+
 int _anjay_register_object_unlocked(
         anjay_unlocked_t *anjay,
         AVS_LIST(anjay_dm_installed_object_t) *elem_ptr_move) {
@@ -124,26 +165,22 @@ int _anjay_register_object_unlocked(
         return -1;
     }
 
-    AVS_LIST(anjay_dm_installed_object_t) *obj_iter;
-
-    AVS_LIST_FOREACH_PTR(obj_iter, &anjay->dm.objects) {
-        assert(*obj_iter);
-
-        if (_anjay_dm_installed_object_oid(*obj_iter)
-                >= _anjay_dm_installed_object_oid(*elem_ptr_move)) {
-            break;
-        }
-    }
-
-    if (*obj_iter
-            && _anjay_dm_installed_object_oid(*obj_iter)
-                           == _anjay_dm_installed_object_oid(*elem_ptr_move)) {
+    const anjay_oid_t oid = _anjay_dm_installed_object_oid(*elem_ptr_move);
+    size_t index = find_object_index(&anjay->dm, oid);
+    if (object_at_index_has_oid(&anjay->dm, index, oid)) {
         dm_log(ERROR, _("data model object ") "/%u" _(" already registered"),
-               _anjay_dm_installed_object_oid(*elem_ptr_move));
+               oid);
         return -1;
     }
 
-    AVS_LIST_INSERT(obj_iter, *elem_ptr_move);
+    if (reserve_objects(&anjay->dm, anjay->dm.objects_count + 1)) {
+        dm_log(ERROR, _("out of memory"));
+        return -1;
+    }
+    memmove(&anjay->dm.objects[index + 1], &anjay->dm.objects[index],
+            (anjay->dm.objects_count - index) * sizeof(*anjay->dm.objects));
+    anjay->dm.objects[index] = *elem_ptr_move;
+    ++anjay->dm.objects_count;
 
     dm_log(INFO, _("successfully registered object ") "/%u",
            _anjay_dm_installed_object_oid(*elem_ptr_move));
@@ -210,14 +247,14 @@ static void remove_oid_from_notify_queue(anjay_notify_queue_t *out_queue,
     }
 }
 
-static int
-unregister_object_unlocked(anjay_unlocked_t *anjay,
-                           AVS_LIST(anjay_dm_installed_object_t) *def_ptr) {
+static int unregister_object_unlocked(anjay_unlocked_t *anjay, size_t index) {
     assert(!anjay->current_connection.server);
-    assert(def_ptr && *def_ptr);
-    assert(AVS_LIST_FIND_PTR(&anjay->dm.objects, *def_ptr));
+    assert(index < anjay->dm.objects_count);
 
-    AVS_LIST(anjay_dm_installed_object_t) detached = AVS_LIST_DETACH(def_ptr);
+    AVS_LIST(anjay_dm_installed_object_t) detached = anjay->dm.objects[index];
+    --anjay->dm.objects_count;
+    memmove(&anjay->dm.objects[index], &anjay->dm.objects[index + 1],
+            (anjay->dm.objects_count - index) * sizeof(*anjay->dm.objects));
 
     AVS_LIST(const anjay_dm_installed_object_t *) *obj_in_transaction_iter;
     AVS_LIST_FOREACH_PTR(obj_in_transaction_iter,
@@ -269,26 +306,22 @@ int anjay_unregister_object(anjay_t *anjay_locked,
     if (!def_ptr || !*def_ptr) {
         dm_log(ERROR, _("invalid object pointer"));
     } else {
-        AVS_LIST(anjay_dm_installed_object_t) *obj_iter;
-        AVS_LIST_FOREACH_PTR(obj_iter, &anjay->dm.objects) {
-            assert(*obj_iter);
-            if (_anjay_dm_installed_object_oid(*obj_iter) >= (*def_ptr)->oid) {
-                break;
-            }
-        }
+        size_t index = find_object_index(&anjay->dm, (*def_ptr)->oid);
+        const anjay_dm_installed_object_t *obj =
+                object_at_index_has_oid(&anjay->dm, index, (*def_ptr)->oid)
+                        ? anjay->dm.objects[index]
+                        : NULL;
 
-        if (!*obj_iter
-                || _anjay_dm_installed_object_oid(*obj_iter)
-                               != (*def_ptr)->oid) {
+        if (!obj) {
             dm_log(ERROR,
                    _("object ") "%" PRIu16 _(" is not currently registered"),
                    (*def_ptr)->oid);
         } else if (
 #ifdef ANJAY_WITH_THREAD_SAFETY
-                (*obj_iter)->type != ANJAY_DM_OBJECT_USER_PROVIDED
-                || (*obj_iter)->impl.user_provided != def_ptr
+                obj->type != ANJAY_DM_OBJECT_USER_PROVIDED
+                || obj->impl.user_provided != def_ptr
 #else  // ANJAY_WITH_THREAD_SAFETY
-                **obj_iter != def_ptr
+                *obj != def_ptr
 #endif // ANJAY_WITH_THREAD_SAFETY
         ) {
             dm_log(ERROR,
@@ -297,7 +330,7 @@ int anjay_unregister_object(anjay_t *anjay_locked,
                            "passed for unregister"),
                    (*def_ptr)->oid);
         } else {
-            result = unregister_object_unlocked(anjay, obj_iter);
+            result = unregister_object_unlocked(anjay, index);
         }
     }
     ANJAY_MUTEX_UNLOCK(anjay_locked);
@@ -311,19 +344,21 @@ void _anjay_dm_cleanup(anjay_unlocked_t *anjay) {
         }
     }
 
-    AVS_LIST_CLEAR(&anjay->dm.objects);
+    for (size_t i = 0; i < anjay->dm.objects_count; ++i) {
+        AVS_LIST_DELETE(&anjay->dm.objects[i]);
+    }
+    avs_free(anjay->dm.objects);
+    anjay->dm.objects = NULL;
+    anjay->dm.objects_count = 0;
+    anjay->dm.objects_capacity = 0;
 }
 
 const anjay_dm_installed_object_t *
 _anjay_dm_find_object_by_oid(anjay_unlocked_t *anjay, anjay_oid_t oid) {
-    AVS_LIST(anjay_dm_installed_object_t) obj;
-    AVS_LIST_FOREACH(obj, anjay->dm.objects) {
-        if (_anjay_dm_installed_object_oid(obj) == oid) {
-            return obj;
-        }
-    }
-
-    return NULL;
+    size_t index = find_object_index(&anjay->dm, oid);
+    return object_at_index_has_oid(&anjay->dm, index, oid)
+                   ? anjay->dm.objects[index]
+                   : NULL;
 }
 
 uint8_t _anjay_dm_make_success_response_code(anjay_request_action_t action) {
@@ -684,8 +719,8 @@ int _anjay_dm_perform_action(anjay_unlocked_t *anjay,
 int _anjay_dm_foreach_object(anjay_unlocked_t *anjay,
                              anjay_dm_foreach_object_handler_t *handler,
                              void *data) {
-    AVS_LIST(anjay_dm_installed_object_t) obj;
-    AVS_LIST_FOREACH(obj, anjay->dm.objects) {
+    for (size_t i = 0; i < anjay->dm.objects_count; ++i) {
+        const anjay_dm_installed_object_t *obj = anjay->dm.objects[i];
         int result = handler(anjay, obj, data);
         if (result == ANJAY_FOREACH_BREAK) {
             dm_log(TRACE, _("foreach_object: break on ") "/%u",
@@ -1167,4 +1202,5 @@ anjay_ssid_t _anjay_dm_current_ssid(anjay_unlocked_t *anjay) {
 
 #ifdef ANJAY_TEST
 #    include "tests/core/dm.c"
+#    include "tests/core/dm_registry.c"
 #endif // ANJAY_TEST
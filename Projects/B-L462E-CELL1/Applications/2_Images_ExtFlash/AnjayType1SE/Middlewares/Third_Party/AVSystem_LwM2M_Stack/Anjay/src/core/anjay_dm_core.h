@@ -37,7 +37,15 @@ typedef struct {
 } anjay_dm_installed_module_t;
 
 struct anjay_dm {
-    AVS_LIST(anjay_dm_installed_object_t) objects;
+    /**
+     * Registered objects, sorted by OID, for binary search lookup. Each entry
+     * is a single-element AVS_LIST owned by the registry; the elements are
+     * never moved, so pointers to them stay valid until unregistration, and
+     * modules may embed them in larger structures.
+     */
+    AVS_LIST(anjay_dm_installed_object_t) *objects;
+    size_t objects_count;
+    size_t objects_capacity;
     AVS_LIST(anjay_dm_installed_module_t) modules;
 };
 
@@ -30,27 +30,8 @@ VISIBILITY_SOURCE_BEGIN
 
 #ifdef ANJAY_WITH_OBSERVE
 static int observe_notify(anjay_unlocked_t *anjay, anjay_notify_queue_t queue) {
-    int ret = 0;
-    AVS_LIST(anjay_notify_queue_object_entry_t) it;
-    AVS_LIST_FOREACH(it, queue) {
-        if (it->instance_set_changes.instance_set_changed) {
-            _anjay_update_ret(
-                    &ret,
-                    _anjay_observe_notify(anjay, &MAKE_OBJECT_PATH(it->oid),
-                                          _anjay_dm_current_ssid(anjay), true));
-        } else {
-            AVS_LIST(anjay_notify_queue_resource_entry_t) it2;
-            AVS_LIST_FOREACH(it2, it->resources_changed) {
-                _anjay_update_ret(&ret,
-                                  _anjay_observe_notify(
-                                          anjay,
-                                          &MAKE_RESOURCE_PATH(it->oid, it2->iid,
-                                                              it2->rid),
-                                          _anjay_dm_current_ssid(anjay), true));
-            }
-        }
-    }
-    return ret;
+    return _anjay_observe_notify_queue(anjay, queue,
+                                       _anjay_dm_current_ssid(anjay), true);
 }
 #else // ANJAY_WITH_OBSERVE
 #    define observe_notify(anjay, queue) (0)
@@ -112,6 +93,9 @@ static int anjay_notify_perform_impl(anjay_unlocked_t *anjay,
     }
     int ret = 0;
     _anjay_update_ret(&ret, _anjay_sync_access_control(anjay, queue_ptr));
+    if (_anjay_notify_queue_instance_set_changed(*queue_ptr)) {
+        _anjay_registration_payload_cache_invalidate(anjay);
+    }
     AVS_LIST(anjay_notify_queue_object_entry_t) it;
     AVS_LIST_FOREACH(it, *queue_ptr) {
         if (it->oid > ANJAY_DM_OID_SERVER) {
@@ -151,6 +135,16 @@ int _anjay_notify_flush(anjay_unlocked_t *anjay,
     return result;
 }
 
+bool _anjay_notify_queue_instance_set_changed(anjay_notify_queue_t queue) {
+    AVS_LIST(anjay_notify_queue_object_entry_t) it;
+    AVS_LIST_FOREACH(it, queue) {
+        if (it->instance_set_changes.instance_set_changed) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static AVS_LIST(anjay_notify_queue_object_entry_t) *
 find_or_create_object_entry(anjay_notify_queue_t *out_queue, anjay_oid_t oid) {
     AVS_LIST(anjay_notify_queue_object_entry_t) *it;
@@ -413,3 +407,21 @@ anjay_resource_observation_status(anjay_t *anjay_locked,
     return retval;
 }
 #endif // ANJAY_WITH_OBSERVATION_STATUS
+
+int anjay_observe_incremental_read_enable(anjay_t *anjay_locked,
+                                          anjay_oid_t oid) {
+    int result = -1;
+#if defined(ANJAY_WITH_OBSERVE) && defined(ANJAY_WITH_OBSERVE_INCREMENTAL_READ)
+    ANJAY_MUTEX_LOCK(anjay, anjay_locked);
+    result = _anjay_observe_incremental_read_enable(anjay, oid);
+    ANJAY_MUTEX_UNLOCK(anjay_locked);
+#else  // defined(ANJAY_WITH_OBSERVE) &&
+       // defined(ANJAY_WITH_OBSERVE_INCREMENTAL_READ)
+    (void) anjay_locked;
+    (void) oid;
+    anjay_log(ERROR, _("incremental observation reads support is disabled"));
+#endif // defined(ANJAY_WITH_OBSERVE) &&
+       // defined(ANJAY_WITH_OBSERVE_INCREMENTAL_READ)
+    return result;
+}
+
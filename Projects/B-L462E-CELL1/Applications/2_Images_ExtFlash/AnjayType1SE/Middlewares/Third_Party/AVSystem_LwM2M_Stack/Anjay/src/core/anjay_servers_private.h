@@ -104,9 +104,38 @@ typedef struct {
     AVS_LIST(anjay_iid_t) instances;
 } anjay_dm_cache_object_t;
 
+/**
+ * Immutable, reference-counted Registration payload (the list of Objects and
+ * Object Instances sent in Register and Update requests). Sharing it between
+ * the payload cache and all the servers' registration state allows comparing
+ * the payloads by pointer in the common case where nothing has changed.
+ */
+typedef struct {
+    size_t refcount;
+    size_t size;
+    char data[];
+} anjay_registration_payload_t;
+
+typedef struct {
+    /**
+     * Payload corresponding to the current state of the data model, or NULL if
+     * it needs to be rebuilt.
+     */
+    anjay_registration_payload_t *payload;
+    /**
+     * LwM2M version the payload has been built for; the Object Versions it
+     * carries depend on it.
+     */
+    anjay_lwm2m_version_t version;
+    /**
+     * Number of times the payload was reused without querying the data model.
+     */
+    uint64_t hits;
+} anjay_registration_payload_cache_t;
+
 typedef struct {
     int64_t lifetime_s;
-    char *dm;
+    anjay_registration_payload_t *dm;
     anjay_binding_mode_t binding_mode;
 } anjay_update_parameters_t;
 
@@ -127,6 +156,13 @@ typedef struct {
     anjay_update_parameters_t last_update_params;
 } anjay_registration_info_t;
 
+/**
+ * Registration state of a single server, loaded using
+ * anjay_registration_state_restore() and waiting for the server entry to be
+ * created. Defined in servers/anjay_servers_persistence.c.
+ */
+typedef struct anjay_restored_registration_struct anjay_restored_registration_t;
+
 ////////////////////////////////////////////////////////////////////////////////
 // METHODS ON THE WHOLE SERVERS SUBSYSTEM //////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -165,6 +201,17 @@ void _anjay_servers_deregister(anjay_unlocked_t *anjay);
  */
 void _anjay_servers_cleanup(anjay_unlocked_t *anjay);
 
+#if defined(ANJAY_WITH_CORE_PERSISTENCE) \
+        && defined(AVS_COMMONS_WITH_AVS_PERSISTENCE)
+/**
+ * Frees registration state restored using anjay_registration_state_restore()
+ * that has not been claimed by any server.
+ */
+void _anjay_restored_registrations_cleanup(anjay_unlocked_t *anjay);
+#else  // ANJAY_WITH_CORE_PERSISTENCE && AVS_COMMONS_WITH_AVS_PERSISTENCE
+#    define _anjay_restored_registrations_cleanup(Anjay) ((void) (Anjay))
+#endif // ANJAY_WITH_CORE_PERSISTENCE && AVS_COMMONS_WITH_AVS_PERSISTENCE
+
 /**
  * Removes all references to inactive servers (see docs for anjay_server_info_t
  * above for an information what is considered "active") from internal
@@ -509,6 +556,16 @@ void _anjay_connection_bring_online(anjay_connection_ref_t ref);
  */
 void _anjay_connection_suspend(anjay_connection_ref_t conn_ref);
 
+/**
+ * Recreates the socket underlying the specified online connection, keeping the
+ * DTLS session as is, if the server identifies that session by a connection ID.
+ * Otherwise, an error is returned and the connection is left untouched. If
+ * recreating the socket fails, the connection needs to be suspended.
+ *
+ * It is called from anjay_transport_schedule_reconnect().
+ */
+avs_error_t _anjay_connection_rebind(anjay_connection_ref_t conn_ref);
+
 anjay_socket_transport_t
 _anjay_connection_transport(anjay_connection_ref_t conn_ref);
 
@@ -520,6 +577,13 @@ _anjay_connection_transport(anjay_connection_ref_t conn_ref);
 AVS_LIST(const anjay_socket_entry_t)
 _anjay_get_socket_entries_unlocked(anjay_unlocked_t *anjay);
 
+/**
+ * Drops the cached Registration payload, so that it will be rebuilt from the
+ * data model the next time Register or Update is considered. Called whenever
+ * the set of Object Instances changes; also used during cleanup.
+ */
+void _anjay_registration_payload_cache_invalidate(anjay_unlocked_t *anjay);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_SERVERS_PRIVATE_H
@@ -232,6 +232,26 @@ void _anjay_coap_ctx_cleanup(anjay_unlocked_t *anjay, avs_coap_ctx_t **ctx) {
 
 #endif // ANJAY_WITH_NET_STATS
 
+uint64_t anjay_get_num_coalesced_notify_triggers(anjay_t *anjay_locked) {
+    uint64_t result = 0;
+#ifdef ANJAY_WITH_OBSERVE
+    ANJAY_MUTEX_LOCK(anjay, anjay_locked);
+    result = anjay->observe.coalesced_notify_triggers;
+    ANJAY_MUTEX_UNLOCK(anjay_locked);
+#else  // ANJAY_WITH_OBSERVE
+    (void) anjay_locked;
+#endif // ANJAY_WITH_OBSERVE
+    return result;
+}
+
+uint64_t anjay_get_num_registration_payload_cache_hits(anjay_t *anjay_locked) {
+    uint64_t result = 0;
+    ANJAY_MUTEX_LOCK(anjay, anjay_locked);
+    result = anjay->registration_payload_cache.hits;
+    ANJAY_MUTEX_UNLOCK(anjay_locked);
+    return result;
+}
+
 avs_error_t _anjay_socket_cleanup(anjay_unlocked_t *anjay,
                                   avs_net_socket_t **socket) {
     assert(socket);
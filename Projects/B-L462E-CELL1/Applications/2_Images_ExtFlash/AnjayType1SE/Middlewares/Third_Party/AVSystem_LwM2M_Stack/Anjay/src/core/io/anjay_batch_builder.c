@@ -23,7 +23,6 @@
 #    include "anjay_batch_builder.h"
 #    include "anjay_vtable.h"
 
-#    include <avsystem/commons/avs_list.h>
 #    include <avsystem/commons/avs_utils.h>
 
 #    ifdef ANJAY_WITH_THREAD_SAFETY
@@ -51,11 +50,14 @@ typedef enum {
 typedef struct {
     anjay_batch_data_type_t type;
     union {
+        // Used for both ANJAY_BATCH_DATA_BYTES and ANJAY_BATCH_DATA_STRING.
+        // The data is kept in the storage area of the containing batch (or
+        // builder), at the given offset. Strings are stored along with the
+        // terminating nullbyte, which is not included in length.
         struct {
-            const void *data;
+            size_t offset;
             size_t length;
         } bytes;
-        const char *string;
         int64_t int_value;
         double double_value;
         bool bool_value;
@@ -72,19 +74,25 @@ struct anjay_batch_entry {
     avs_time_real_t timestamp;
 };
 
+/**
+ * Compiled batches are allocated as single blocks of memory: the header below
+ * is followed either by entries_count entries and the storage area for their
+ * string and bytes values, or, for batches created using
+ * _anjay_batch_builder_compile_split() or _anjay_batch_compose(), by
+ * parts_count pointers to parts, each of them being a regular batch.
+ */
 struct anjay_batch_struct {
-    AVS_LIST(anjay_batch_entry_t) list;
     size_t ref_count;
     avs_time_real_t compilation_time;
-};
-
-struct anjay_batch_data_output_state_struct {
-    anjay_batch_entry_t entry;
+    size_t parts_count;
+    size_t entries_count;
+    avs_max_align_t data[];
 };
 
 typedef struct {
     const anjay_ret_bytes_ctx_vtable_t *vtable;
-    void *data;
+    anjay_batch_builder_t *builder;
+    size_t offset;
     size_t remaining_bytes;
 } builder_bytes_t;
 
@@ -99,40 +107,60 @@ typedef struct builder_out_struct {
     avs_time_real_t timestamp;
 } builder_out_ctx_t;
 
+#    define BUILDER_INITIAL_ENTRIES 4
+#    define BUILDER_INITIAL_STORAGE 32
+
 anjay_batch_builder_t *_anjay_batch_builder_new(void) {
-    anjay_batch_builder_t *builder =
-            (anjay_batch_builder_t *) avs_calloc(1,
-                                                 sizeof(anjay_batch_builder_t));
-    if (!builder) {
-        return NULL;
-    }
-    builder->append_ptr = &builder->list;
-    return builder;
+    return (anjay_batch_builder_t *) avs_calloc(1,
+                                                sizeof(anjay_batch_builder_t));
 }
 
-static int make_data_with_duplicated_string(anjay_batch_data_t *batch_data,
-                                            const char *str) {
-    assert(batch_data);
-    assert(str);
-    char *new_str = avs_strdup(str);
-    if (!new_str) {
-        return -1;
+/**
+ * Makes sure that @p buffer can hold at least @p required elements, growing it
+ * geometrically if necessary. Returns the (possibly moved) buffer, or NULL
+ * on failure, in which case @p buffer and @p *capacity_ptr are left intact.
+ */
+static void *reserve_buffer(void *buffer,
+                            size_t *capacity_ptr,
+                            size_t element_size,
+                            size_t required,
+                            size_t initial_capacity) {
+    assert(required > 0);
+    if (required <= *capacity_ptr) {
+        return buffer;
     }
-    *batch_data = (anjay_batch_data_t) {
-        .type = ANJAY_BATCH_DATA_STRING,
-        .value = {
-            .string = new_str
+    size_t new_capacity = *capacity_ptr ? *capacity_ptr : initial_capacity;
+    while (new_capacity < required) {
+        if (new_capacity > SIZE_MAX / 2 / element_size) {
+            return NULL;
         }
-    };
-    return 0;
+        new_capacity *= 2;
+    }
+    void *new_buffer = avs_realloc(buffer, new_capacity * element_size);
+    if (new_buffer) {
+        *capacity_ptr = new_capacity;
+    }
+    return new_buffer;
 }
 
-static void batch_data_cleanup(anjay_batch_data_t *data) {
-    if (data->type == ANJAY_BATCH_DATA_STRING) {
-        avs_free((void *) (intptr_t) data->value.string);
-    } else if (data->type == ANJAY_BATCH_DATA_BYTES) {
-        avs_free((void *) (intptr_t) data->value.bytes.data);
+static int storage_alloc(anjay_batch_builder_t *builder,
+                         size_t size,
+                         size_t *out_offset) {
+    if (size) {
+        if (size > SIZE_MAX - builder->storage_size) {
+            return -1;
+        }
+        char *storage = (char *) reserve_buffer(
+                builder->storage, &builder->storage_capacity, 1,
+                builder->storage_size + size, BUILDER_INITIAL_STORAGE);
+        if (!storage) {
+            return -1;
+        }
+        builder->storage = storage;
     }
+    *out_offset = builder->storage_size;
+    builder->storage_size += size;
+    return 0;
 }
 
 static int batch_data_add(anjay_batch_builder_t *builder,
@@ -142,20 +170,52 @@ static int batch_data_add(anjay_batch_builder_t *builder,
     assert(builder);
     if (data.type != ANJAY_BATCH_DATA_START_AGGREGATE
             && !_anjay_uri_path_has(uri, ANJAY_ID_RID)) {
-        batch_data_cleanup(&data);
         return -1;
     }
-    *builder->append_ptr = AVS_LIST_NEW_ELEMENT(anjay_batch_entry_t);
-    if (!*builder->append_ptr) {
-        batch_data_cleanup(&data);
+    anjay_batch_entry_t *entries = (anjay_batch_entry_t *) reserve_buffer(
+            builder->entries, &builder->entries_capacity,
+            sizeof(anjay_batch_entry_t), builder->entries_count + 1,
+            BUILDER_INITIAL_ENTRIES);
+    if (!entries) {
         return -1;
     }
-    **builder->append_ptr = (anjay_batch_entry_t) {
+    builder->entries = entries;
+    builder->entries[builder->entries_count++] = (anjay_batch_entry_t) {
         .path = *uri,
         .timestamp = timestamp,
         .data = data
     };
-    AVS_LIST_ADVANCE_PTR(&builder->append_ptr);
+    return 0;
+}
+
+/**
+ * Adds an entry with space for @p length bytes reserved in the storage area.
+ * On failure, the builder is left unchanged.
+ */
+static int batch_data_add_with_storage(anjay_batch_builder_t *builder,
+                                       const anjay_uri_path_t *uri,
+                                       avs_time_real_t timestamp,
+                                       anjay_batch_data_type_t type,
+                                       size_t length,
+                                       size_t *out_offset) {
+    const size_t storage_size =
+            length + (type == ANJAY_BATCH_DATA_STRING ? 1 : 0);
+    anjay_batch_data_t data = {
+        .type = type,
+        .value = {
+            .bytes = {
+                .length = length
+            }
+        }
+    };
+    if (storage_alloc(builder, storage_size, &data.value.bytes.offset)) {
+        return -1;
+    }
+    if (batch_data_add(builder, uri, timestamp, data)) {
+        builder->storage_size -= storage_size;
+        return -1;
+    }
+    *out_offset = data.value.bytes.offset;
     return 0;
 }
 
@@ -202,11 +262,15 @@ int _anjay_batch_add_string(anjay_batch_builder_t *builder,
                             const anjay_uri_path_t *uri,
                             avs_time_real_t timestamp,
                             const char *str) {
-    anjay_batch_data_t str_data;
-    if (make_data_with_duplicated_string(&str_data, str)) {
+    assert(str);
+    const size_t length = strlen(str);
+    size_t offset;
+    if (batch_data_add_with_storage(builder, uri, timestamp,
+                                    ANJAY_BATCH_DATA_STRING, length, &offset)) {
         return -1;
     }
-    return batch_data_add(builder, uri, timestamp, str_data);
+    memcpy(builder->storage + offset, str, length + 1);
+    return 0;
 }
 
 int _anjay_batch_add_objlnk(anjay_batch_builder_t *builder,
@@ -226,20 +290,10 @@ int _anjay_batch_add_objlnk(anjay_batch_builder_t *builder,
     return batch_data_add(builder, uri, timestamp, data);
 }
 
-static void batch_entry_cleanup(void *entry_) {
-    anjay_batch_entry_t *entry = (anjay_batch_entry_t *) entry_;
-    batch_data_cleanup(&entry->data);
-}
-
-void _anjay_batch_entry_list_cleanup(AVS_LIST(anjay_batch_entry_t) *list) {
-    AVS_LIST_CLEAR(list) {
-        batch_entry_cleanup(*list);
-    }
-}
-
 void _anjay_batch_builder_cleanup(anjay_batch_builder_t **builder) {
     if (builder && *builder) {
-        _anjay_batch_entry_list_cleanup(&(*builder)->list);
+        avs_free((*builder)->entries);
+        avs_free((*builder)->storage);
         avs_free(*builder);
         *builder = NULL;
     }
@@ -265,8 +319,21 @@ static int ensure_ref_count_mutex_initialized(void) {
 }
 #    endif // ANJAY_WITH_THREAD_SAFETY
 
-anjay_batch_t *_anjay_batch_builder_compile(anjay_batch_builder_t **builder) {
-    assert(builder && *builder);
+static inline anjay_batch_entry_t *batch_entries(const anjay_batch_t *batch) {
+    assert(!batch->parts_count);
+    return (anjay_batch_entry_t *) (intptr_t) (const void *) batch->data;
+}
+
+static inline const char *batch_storage(const anjay_batch_t *batch) {
+    return (const char *) (batch_entries(batch) + batch->entries_count);
+}
+
+static inline anjay_batch_t **batch_parts(const anjay_batch_t *batch) {
+    assert(batch->parts_count);
+    return (anjay_batch_t **) (intptr_t) (const void *) batch->data;
+}
+
+static anjay_batch_t *batch_new(size_t data_size) {
 #    ifdef ANJAY_WITH_THREAD_SAFETY
     if (ensure_ref_count_mutex_initialized()) {
         return NULL;
@@ -274,18 +341,235 @@ anjay_batch_t *_anjay_batch_builder_compile(anjay_batch_builder_t **builder) {
     assert(REF_COUNT_MUTEX);
 #    endif // ANJAY_WITH_THREAD_SAFETY
     anjay_batch_t *batch =
-            (anjay_batch_t *) avs_calloc(1, sizeof(anjay_batch_t));
+            (anjay_batch_t *) avs_calloc(1, sizeof(anjay_batch_t) + data_size);
     if (!batch) {
         return NULL;
     }
-    batch->list = (*builder)->list;
     batch->ref_count = 1;
     batch->compilation_time = avs_time_real_now();
-    avs_free(*builder);
-    *builder = NULL;
     return batch;
 }
 
+static size_t entry_storage_size(const anjay_batch_entry_t *entry) {
+    switch (entry->data.type) {
+    case ANJAY_BATCH_DATA_BYTES:
+        return entry->data.value.bytes.length;
+    case ANJAY_BATCH_DATA_STRING:
+        return entry->data.value.bytes.length + 1;
+    default:
+        return 0;
+    }
+}
+
+static anjay_batch_t *compile_entries(const anjay_batch_builder_t *builder,
+                                      size_t first,
+                                      size_t count) {
+    assert(first + count <= builder->entries_count);
+    size_t storage_size = 0;
+    for (size_t i = first; i < first + count; ++i) {
+        storage_size += entry_storage_size(&builder->entries[i]);
+    }
+    anjay_batch_t *batch =
+            batch_new(count * sizeof(anjay_batch_entry_t) + storage_size);
+    if (!batch) {
+        return NULL;
+    }
+    batch->entries_count = count;
+    anjay_batch_entry_t *entries = batch_entries(batch);
+    char *storage = (char *) (intptr_t) batch_storage(batch);
+    size_t offset = 0;
+    for (size_t i = 0; i < count; ++i) {
+        entries[i] = builder->entries[first + i];
+        const size_t size = entry_storage_size(&entries[i]);
+        if (size) {
+            memcpy(storage + offset,
+                   builder->storage + entries[i].data.value.bytes.offset, size);
+            entries[i].data.value.bytes.offset = offset;
+            offset += size;
+        }
+    }
+    assert(offset == storage_size);
+    return batch;
+}
+
+anjay_batch_t *_anjay_batch_builder_compile(anjay_batch_builder_t **builder) {
+    assert(builder && *builder);
+    anjay_batch_t *batch =
+            compile_entries(*builder, 0, (*builder)->entries_count);
+    if (batch) {
+        _anjay_batch_builder_cleanup(builder);
+    }
+    return batch;
+}
+
+static anjay_uri_path_t entry_part_path(const anjay_batch_entry_t *entry) {
+    anjay_uri_path_t path = entry->path;
+    if (_anjay_uri_path_has(&path, ANJAY_ID_RID)) {
+        path.ids[ANJAY_ID_RIID] = ANJAY_ID_INVALID;
+    }
+    return path;
+}
+
+/**
+ * Returns the number of entries, starting at @p first, that pertain to the
+ * same part as the one at @p first.
+ */
+static size_t part_length(const anjay_batch_builder_t *builder, size_t first) {
+    const anjay_uri_path_t part_path =
+            entry_part_path(&builder->entries[first]);
+    size_t end = first + 1;
+    while (end < builder->entries_count) {
+        const anjay_uri_path_t path = entry_part_path(&builder->entries[end]);
+        if (!_anjay_uri_path_equal(&path, &part_path)) {
+            break;
+        }
+        ++end;
+    }
+    return end - first;
+}
+
+anjay_batch_t *
+_anjay_batch_builder_compile_split(anjay_batch_builder_t **builder) {
+    assert(builder && *builder);
+    size_t parts_count = 0;
+    for (size_t i = 0; i < (*builder)->entries_count;
+         i += part_length(*builder, i)) {
+        ++parts_count;
+    }
+    if (parts_count <= 1) {
+        // nothing to gain from splitting
+        return _anjay_batch_builder_compile(builder);
+    }
+
+    anjay_batch_t *batch = batch_new(parts_count * sizeof(anjay_batch_t *));
+    if (!batch) {
+        return NULL;
+    }
+    batch->parts_count = parts_count;
+    anjay_batch_t **parts = batch_parts(batch);
+    size_t first = 0;
+    for (size_t i = 0; i < parts_count; ++i) {
+        const size_t length = part_length(*builder, first);
+        if (!(parts[i] = compile_entries(*builder, first, length))) {
+            while (i--) {
+                _anjay_batch_release(&parts[i]);
+            }
+            avs_free(batch);
+            return NULL;
+        }
+        parts[i]->compilation_time = batch->compilation_time;
+        first += length;
+    }
+    assert(first == (*builder)->entries_count);
+    _anjay_batch_builder_cleanup(builder);
+    return batch;
+}
+
+anjay_batch_t *_anjay_batch_compose(anjay_batch_t *const *parts,
+                                    size_t parts_count) {
+    assert(parts || !parts_count);
+    anjay_batch_t *batch = batch_new(parts_count * sizeof(anjay_batch_t *));
+    if (!batch) {
+        return NULL;
+    }
+    batch->parts_count = parts_count;
+    for (size_t i = 0; i < parts_count; ++i) {
+        assert(parts[i]);
+        assert(!parts[i]->parts_count);
+        batch_parts(batch)[i] = parts[i];
+    }
+    return batch;
+}
+
+size_t _anjay_batch_parts_count(const anjay_batch_t *batch) {
+    return batch->parts_count;
+}
+
+const anjay_batch_t *_anjay_batch_part(const anjay_batch_t *batch,
+                                       size_t index) {
+    assert(index < batch->parts_count);
+    return batch_parts(batch)[index];
+}
+
+anjay_uri_path_t _anjay_batch_part_path(const anjay_batch_t *part) {
+    return part->entries_count ? entry_part_path(batch_entries(part))
+                               : MAKE_ROOT_PATH();
+}
+
+/**
+ * Position of an entry within a batch. For split or composed batches, owner
+ * is the part that contains the entry; otherwise it is the batch itself.
+ * owner is NULL if the cursor is past the last entry.
+ */
+typedef struct {
+    const anjay_batch_t *owner;
+    size_t part_index;
+    size_t entry_index;
+} batch_cursor_t;
+
+static inline const anjay_batch_entry_t *
+cursor_entry(const batch_cursor_t *cursor) {
+    assert(cursor->owner);
+    return &batch_entries(cursor->owner)[cursor->entry_index];
+}
+
+static void cursor_seek_part(const anjay_batch_t *batch,
+                             batch_cursor_t *cursor,
+                             size_t part_index) {
+    for (; part_index < batch->parts_count; ++part_index) {
+        const anjay_batch_t *part = batch_parts(batch)[part_index];
+        if (part->entries_count) {
+            cursor->owner = part;
+            cursor->part_index = part_index;
+            cursor->entry_index = 0;
+            return;
+        }
+    }
+    cursor->owner = NULL;
+}
+
+static batch_cursor_t cursor_first(const anjay_batch_t *batch) {
+    batch_cursor_t cursor = {
+        .owner = NULL
+    };
+    if (batch->parts_count) {
+        cursor_seek_part(batch, &cursor, 0);
+    } else if (batch->entries_count) {
+        cursor.owner = batch;
+    }
+    return cursor;
+}
+
+static void cursor_next(const anjay_batch_t *batch, batch_cursor_t *cursor) {
+    assert(cursor->owner);
+    if (++cursor->entry_index < cursor->owner->entries_count) {
+        return;
+    }
+    if (batch->parts_count) {
+        cursor_seek_part(batch, cursor, cursor->part_index + 1);
+    } else {
+        cursor->owner = NULL;
+    }
+}
+
+static batch_cursor_t
+cursor_from_state(const anjay_batch_t *batch,
+                  const anjay_batch_data_output_state_t *state) {
+    batch_cursor_t cursor = {
+        .owner = batch->parts_count ? batch_parts(batch)[state->part_index]
+                                    : batch,
+        .part_index = state->part_index,
+        .entry_index = state->entry_index
+    };
+    assert(cursor.entry_index < cursor.owner->entries_count);
+    return cursor;
+}
+
+static inline const void *entry_bytes(const batch_cursor_t *cursor) {
+    return batch_storage(cursor->owner)
+           + cursor_entry(cursor)->data.value.bytes.offset;
+}
+
 anjay_batch_t *_anjay_batch_acquire(const anjay_batch_t *batch_) {
     assert(batch_);
     anjay_batch_t *batch = (anjay_batch_t *) (intptr_t) batch_;
@@ -319,7 +603,9 @@ void _anjay_batch_release(anjay_batch_t **batch) {
 #    endif // ANJAY_WITH_THREAD_SAFETY
 
     if (old_count <= 1) {
-        _anjay_batch_entry_list_cleanup(&(*batch)->list);
+        for (size_t i = 0; i < (*batch)->parts_count; ++i) {
+            _anjay_batch_release(&batch_parts(*batch)[i]);
+        }
         avs_free(*batch);
     }
     *batch = NULL;
@@ -341,8 +627,8 @@ static int bytes_append(anjay_unlocked_ret_bytes_ctx_t *ctx,
         return -1;
     }
 
-    memcpy(bytes->data, data, length);
-    bytes->data = ((uint8_t *) bytes->data) + length;
+    memcpy(bytes->builder->storage + bytes->offset, data, length);
+    bytes->offset += length;
     bytes->remaining_bytes -= length;
     return 0;
 }
@@ -364,31 +650,18 @@ static int bytes_begin(anjay_unlocked_output_ctx_t *ctx_,
         return -1;
     }
 
-    void *buf = NULL;
-    if (length) {
-        buf = avs_malloc(length);
-        if (!buf) {
-            return -1;
-        }
-    }
-
-    anjay_batch_data_t data = {
-        .type = ANJAY_BATCH_DATA_BYTES,
-        .value.bytes = {
-            .data = buf,
-            .length = length
-        }
-    };
-
-    if (batch_data_add(ctx->builder, &ctx->path, ctx->timestamp, data)) {
-        avs_free(buf);
+    size_t offset;
+    if (batch_data_add_with_storage(ctx->builder, &ctx->path, ctx->timestamp,
+                                    ANJAY_BATCH_DATA_BYTES, length, &offset)) {
         return -1;
     }
 
     value_returned(ctx);
 
-    // Doesn't change owner of buf
-    ctx->bytes.data = buf;
+    // No other values may be added until all bytes are passed, so the offset
+    // stays valid even if the storage area is reallocated in the meantime
+    ctx->bytes.builder = ctx->builder;
+    ctx->bytes.offset = offset;
     ctx->bytes.remaining_bytes = length;
     *out_bytes_ctx = (anjay_unlocked_ret_bytes_ctx_t *) &ctx->bytes;
     return 0;
@@ -567,14 +840,15 @@ int _anjay_dm_read_into_batch(anjay_batch_builder_t *builder,
            || path_info->uri.ids[ANJAY_ID_OID]
                       == _anjay_dm_installed_object_oid(obj));
 
-    AVS_LIST(anjay_batch_entry_t) *initial_append_ptr = builder->append_ptr;
+    const size_t initial_entries_count = builder->entries_count;
+    const size_t initial_storage_size = builder->storage_size;
     int result = read_into_batch(builder, anjay, obj, path_info,
                                  requesting_ssid, forced_timestamp);
 
     // Despite of failure, the new element may be added. Remove it.
     if (result) {
-        builder->append_ptr = initial_append_ptr;
-        _anjay_batch_entry_list_cleanup(builder->append_ptr);
+        builder->entries_count = initial_entries_count;
+        builder->storage_size = initial_storage_size;
     }
     return result;
 }
@@ -615,9 +889,10 @@ static double convert_to_senml_time(avs_time_real_t timestamp,
     }
 }
 
-static int serialize_batch_entry(const anjay_batch_entry_t *entry,
+static int serialize_batch_entry(const batch_cursor_t *cursor,
                                  avs_time_real_t serialization_time,
                                  anjay_unlocked_output_ctx_t *output) {
+    const anjay_batch_entry_t *entry = cursor_entry(cursor);
     int result = _anjay_output_set_path(output, &entry->path);
     if (result) {
         return result;
@@ -631,11 +906,11 @@ static int serialize_batch_entry(const anjay_batch_entry_t *entry,
     }
     switch (entry->data.type) {
     case ANJAY_BATCH_DATA_BYTES:
-        return _anjay_ret_bytes_unlocked(output,
-                                         entry->data.value.bytes.data,
+        return _anjay_ret_bytes_unlocked(output, entry_bytes(cursor),
                                          entry->data.value.bytes.length);
     case ANJAY_BATCH_DATA_STRING:
-        return _anjay_ret_string_unlocked(output, entry->data.value.string);
+        return _anjay_ret_string_unlocked(output,
+                                          (const char *) entry_bytes(cursor));
     case ANJAY_BATCH_DATA_INT:
         return _anjay_ret_i64_unlocked(output, entry->data.value.int_value);
     case ANJAY_BATCH_DATA_DOUBLE:
@@ -673,12 +948,14 @@ int _anjay_batch_data_output(anjay_unlocked_t *anjay,
                              anjay_ssid_t target_ssid,
                              anjay_unlocked_output_ctx_t *out_ctx) {
     const avs_time_real_t serialization_time = avs_time_real_now();
-    const anjay_batch_data_output_state_t *state = NULL;
+    anjay_batch_data_output_state_t state = {
+        .in_progress = false
+    };
     int result = 0;
     do {
         result = _anjay_batch_data_output_entry(
                 anjay, batch, target_ssid, serialization_time, &state, out_ctx);
-    } while (!result && state);
+    } while (!result && state.in_progress);
     return result;
 }
 
@@ -687,53 +964,59 @@ int _anjay_batch_data_output_entry(
         const anjay_batch_t *batch,
         anjay_ssid_t target_ssid,
         avs_time_real_t serialization_time,
-        const anjay_batch_data_output_state_t **state,
+        anjay_batch_data_output_state_t *state,
         anjay_unlocked_output_ctx_t *out_ctx) {
     assert(state);
-    const AVS_LIST(anjay_batch_entry_t) it;
-    if (!*state) {
-        it = batch->list;
-    } else {
-        it = &(*state)->entry;
-        assert(AVS_LIST_FIND_PTR(&batch->list, it) != NULL);
-    }
-    while (it
-           && !is_server_allowed_to_read(anjay, it->path.ids[ANJAY_ID_OID],
-                                         it->path.ids[ANJAY_ID_IID],
-                                         target_ssid)) {
-        AVS_LIST_ADVANCE(&it);
+    batch_cursor_t cursor = state->in_progress
+                                    ? cursor_from_state(batch, state)
+                                    : cursor_first(batch);
+    while (cursor.owner) {
+        const anjay_batch_entry_t *entry = cursor_entry(&cursor);
+        if (is_server_allowed_to_read(anjay, entry->path.ids[ANJAY_ID_OID],
+                                      entry->path.ids[ANJAY_ID_IID],
+                                      target_ssid)) {
+            break;
+        }
+        cursor_next(batch, &cursor);
     }
     int result = 0;
-    if (it) {
-        result = serialize_batch_entry(it, serialization_time, out_ctx);
-        AVS_LIST_ADVANCE(&it);
+    if (cursor.owner) {
+        result = serialize_batch_entry(&cursor, serialization_time, out_ctx);
+        cursor_next(batch, &cursor);
     }
-    *state = AVS_CONTAINER_OF(it, anjay_batch_data_output_state_t, entry);
+    state->in_progress = !!cursor.owner;
+    state->part_index = cursor.part_index;
+    state->entry_index = cursor.entry_index;
     return result;
 }
 
-static bool batch_data_equal(const anjay_batch_data_t *a,
-                             const anjay_batch_data_t *b) {
-    if (a->type != b->type) {
+static bool entries_equal(const batch_cursor_t *a, const batch_cursor_t *b) {
+    const anjay_batch_entry_t *a_entry = cursor_entry(a);
+    const anjay_batch_entry_t *b_entry = cursor_entry(b);
+    if (!_anjay_uri_path_equal(&a_entry->path, &b_entry->path)
+            || a_entry->data.type != b_entry->data.type) {
         return false;
     }
-    switch (a->type) {
+    switch (a_entry->data.type) {
     case ANJAY_BATCH_DATA_BYTES:
-        return a->value.bytes.length == b->value.bytes.length
-               && !memcmp(a->value.bytes.data,
-                          b->value.bytes.data,
-                          a->value.bytes.length);
     case ANJAY_BATCH_DATA_STRING:
-        return !strcmp(a->value.string, b->value.string);
+        return a_entry->data.value.bytes.length
+                       == b_entry->data.value.bytes.length
+               && !memcmp(entry_bytes(a), entry_bytes(b),
+                          a_entry->data.value.bytes.length);
     case ANJAY_BATCH_DATA_INT:
-        return a->value.int_value == b->value.int_value;
+        return a_entry->data.value.int_value == b_entry->data.value.int_value;
     case ANJAY_BATCH_DATA_DOUBLE:
-        return a->value.double_value == b->value.double_value;
+        return a_entry->data.value.double_value
+               == b_entry->data.value.double_value;
     case ANJAY_BATCH_DATA_BOOL:
-        return a->value.bool_value == b->value.bool_value;
+        return a_entry->data.value.bool_value
+               == b_entry->data.value.bool_value;
     case ANJAY_BATCH_DATA_OBJLNK:
-        return a->value.objlnk.oid == b->value.objlnk.oid
-               && a->value.objlnk.iid == b->value.objlnk.iid;
+        return a_entry->data.value.objlnk.oid
+                       == b_entry->data.value.objlnk.oid
+               && a_entry->data.value.objlnk.iid
+                          == b_entry->data.value.objlnk.iid;
     case ANJAY_BATCH_DATA_START_AGGREGATE:;
     }
     return true;
@@ -743,26 +1026,55 @@ bool _anjay_batch_values_equal(const anjay_batch_t *a, const anjay_batch_t *b) {
     if (!a || !b) {
         return !a && !b;
     }
-    AVS_LIST(anjay_batch_entry_t) ait = a->list;
-    AVS_LIST(anjay_batch_entry_t) bit = b->list;
-    while (ait && bit) {
-        if (!_anjay_uri_path_equal(&ait->path, &bit->path)
-                || !batch_data_equal(&ait->data, &bit->data)) {
+    if (a == b) {
+        return true;
+    }
+    if (a->parts_count && a->parts_count == b->parts_count) {
+        // shortcut for batches sharing unchanged parts
+        for (size_t i = 0; i < a->parts_count; ++i) {
+            if (!_anjay_batch_values_equal(batch_parts(a)[i],
+                                           batch_parts(b)[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    batch_cursor_t ait = cursor_first(a);
+    batch_cursor_t bit = cursor_first(b);
+    while (ait.owner && bit.owner) {
+        if (!entries_equal(&ait, &bit)) {
             return false;
         }
-        AVS_LIST_ADVANCE(&ait);
-        AVS_LIST_ADVANCE(&bit);
+        cursor_next(a, &ait);
+        cursor_next(b, &bit);
+    }
+    return !ait.owner && !bit.owner;
+}
+
+/**
+ * Returns the only entry of @p batch, or NULL if it does not consist of
+ * exactly one entry.
+ */
+static const anjay_batch_entry_t *single_entry(const anjay_batch_t *batch) {
+    if (!batch) {
+        return NULL;
+    }
+    batch_cursor_t cursor = cursor_first(batch);
+    if (!cursor.owner) {
+        return NULL;
     }
-    return !ait && !bit;
+    const anjay_batch_entry_t *entry = cursor_entry(&cursor);
+    cursor_next(batch, &cursor);
+    return cursor.owner ? NULL : entry;
 }
 
 bool _anjay_batch_data_requires_hierarchical_format(
         const anjay_batch_t *batch) {
-    if (!batch || !batch->list || AVS_LIST_NEXT(batch->list)) {
-        // entry list is not exactly 1 element long
+    const anjay_batch_entry_t *const entry = single_entry(batch);
+    if (!entry) {
+        // batch does not consist of exactly 1 entry
         return true;
     }
-    const anjay_batch_entry_t *const entry = batch->list;
     if (entry->data.type == ANJAY_BATCH_DATA_START_AGGREGATE) {
         // batch consists of an empty aggregate, so isn't a single simple value
         return true;
@@ -776,7 +1088,7 @@ double _anjay_batch_data_numeric_value(const anjay_batch_t *batch) {
         // not a simple value
         return NAN;
     }
-    const anjay_batch_entry_t *const entry = batch->list;
+    const anjay_batch_entry_t *const entry = single_entry(batch);
     switch (entry->data.type) {
     case ANJAY_BATCH_DATA_INT:
         return (double) entry->data.value.int_value;
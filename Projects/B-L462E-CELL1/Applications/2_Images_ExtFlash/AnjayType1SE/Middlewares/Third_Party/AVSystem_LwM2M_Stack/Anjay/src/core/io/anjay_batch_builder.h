@@ -35,14 +35,29 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 typedef struct anjay_batch_entry anjay_batch_entry_t;
 
 typedef struct anjay_batch_builder_struct {
-    AVS_LIST(anjay_batch_entry_t) list;
-    AVS_LIST(anjay_batch_entry_t) *append_ptr;
+    // growable array of entries added so far
+    anjay_batch_entry_t *entries;
+    size_t entries_count;
+    size_t entries_capacity;
+    // growable buffer for contents of string and bytes values
+    char *storage;
+    size_t storage_size;
+    size_t storage_capacity;
 } anjay_batch_builder_t;
 
 typedef struct anjay_batch_struct anjay_batch_t;
 
-typedef struct anjay_batch_data_output_state_struct
-        anjay_batch_data_output_state_t;
+/**
+ * Iteration state of @ref _anjay_batch_data_output_entry. Only
+ * <c>in_progress</c> may be inspected by the caller; the position fields are
+ * private to the iteration.
+ */
+typedef struct {
+    // false before the first entry and after the last one
+    bool in_progress;
+    size_t part_index;
+    size_t entry_index;
+} anjay_batch_data_output_state_t;
 
 anjay_batch_builder_t *_anjay_batch_builder_new(void);
 
@@ -89,7 +104,8 @@ void _anjay_batch_builder_cleanup(anjay_batch_builder_t **builder);
 
 /**
  * Compiles data from the batch builder into a reference-counted (with count
- * initialized to 1) immutable data batch.
+ * initialized to 1) immutable data batch. The batch, including all string and
+ * bytes values, is stored in a single contiguous memory block.
  *
  * @param builder Pointer to pointer to batch builder. Set to NULL after
  *                successful return.
@@ -101,6 +117,54 @@ void _anjay_batch_builder_cleanup(anjay_batch_builder_t **builder);
  */
 anjay_batch_t *_anjay_batch_builder_compile(anjay_batch_builder_t **builder);
 
+/**
+ * Works like @ref _anjay_batch_builder_compile, but additionally splits the
+ * data into separately reference-counted parts, one for each Resource present
+ * in the batch (entries that do not pertain to any Resource, e.g. empty
+ * aggregates, form parts of their own).
+ *
+ * Parts of such batch may be accessed using @ref _anjay_batch_part and reused
+ * in other batches created with @ref _anjay_batch_compose. If the data does
+ * not span more than one part, a regular, unsplit batch is returned.
+ */
+anjay_batch_t *
+_anjay_batch_builder_compile_split(anjay_batch_builder_t **builder);
+
+/**
+ * Creates a batch that consists of the entries of all @p parts, in order.
+ *
+ * @param parts       Array of regular (i.e. not split or composed) batches.
+ *                    On success, the references are moved into the created
+ *                    batch; on failure, they are left untouched.
+ *
+ * @param parts_count Number of elements in @p parts.
+ *
+ * @returns Pointer to the created batch, with reference count initialized to
+ *          1, or NULL in case of an out-of-memory condition.
+ */
+anjay_batch_t *_anjay_batch_compose(anjay_batch_t *const *parts,
+                                    size_t parts_count);
+
+/**
+ * Returns the number of parts of a batch created using
+ * @ref _anjay_batch_builder_compile_split or @ref _anjay_batch_compose, or 0
+ * for regular batches.
+ */
+size_t _anjay_batch_parts_count(const anjay_batch_t *batch);
+
+/**
+ * Returns a borrowed pointer to a part of @p batch. @p index MUST be less than
+ * @ref _anjay_batch_parts_count .
+ */
+const anjay_batch_t *_anjay_batch_part(const anjay_batch_t *batch,
+                                       size_t index);
+
+/**
+ * Returns path of the Resource that the entries of @p part pertain to, or the
+ * path of its only entry if it does not pertain to any Resource.
+ */
+anjay_uri_path_t _anjay_batch_part_path(const anjay_batch_t *part);
+
 /**
  * Increments the refcount for a *batch.
  *
@@ -122,8 +186,6 @@ anjay_batch_t *_anjay_batch_acquire(const anjay_batch_t *batch);
  */
 void _anjay_batch_release(anjay_batch_t **batch);
 
-void _anjay_batch_entry_list_cleanup(AVS_LIST(anjay_batch_entry_t) *list);
-
 int _anjay_dm_read_into_batch(anjay_batch_builder_t *builder,
                               anjay_unlocked_t *anjay,
                               const anjay_dm_installed_object_t *obj,
@@ -160,12 +222,14 @@ int _anjay_batch_data_output(anjay_unlocked_t *anjay,
  *
  * @code
  * const avs_time_real_t serialization_time = avs_time_real_now();
- * const anjay_batch_data_output_state_t *state = NULL;
+ * anjay_batch_data_output_state_t state = {
+ *     .in_progress = false
+ * };
  * int result = 0;
  * do {
  *     result = _anjay_batch_data_output_entry(
  *             anjay, batch, target_ssid, serialization_time, &state, out_ctx);
- * } while (!result && state);
+ * } while (!result && state.in_progress);
  * @endcode
  * </example>
  *
@@ -183,41 +247,40 @@ int _anjay_batch_data_output(anjay_unlocked_t *anjay,
  *                                   all calls in a given iteration.
  *
  * @param [inout] state              Pointer to a state variable. Before the
- *                                   initial call, <c>*state</c> shall be
- *                                   <c>NULL</c> - this function will then
- *                                   serialize the first batch element, and set
- *                                   <c>*state</c> so that the next call will
- *                                   serialize the subsequent entry. If
- *                                   <c>state</c> is <c>NULL</c> on return, it
- *                                   means that there are no more entries to
- *                                   serialize.
- *
- *                                   The value of <c>*state</c> shall be treated
- *                                   as opaque - the caller MUST NOT ever
- *                                   attempt to dereference, deallocate or
- *                                   otherwise access it in any way other than
- *                                   passing it to
- *                                   @ref _anjay_batch_data_output_entry again.
- *                                   Iteration does not allocate any additional
- *                                   resources, so it is memory-safe, and does
- *                                   not require any additional deallocation, to
- *                                   stop serializing without reaching the end.
+ *                                   initial call, <c>state->in_progress</c>
+ *                                   shall be <c>false</c> - this function will
+ *                                   then serialize the first batch element, and
+ *                                   update <c>*state</c> so that the next call
+ *                                   will serialize the subsequent entry. If
+ *                                   <c>state->in_progress</c> is <c>false</c>
+ *                                   on return, it means that there are no more
+ *                                   entries to serialize, and the state may be
+ *                                   reused to serialize another batch.
+ *
+ *                                   The state records the position of the next
+ *                                   entry, including the part of a split or
+ *                                   composed batch it belongs to, so each call
+ *                                   takes constant time to resume. Iteration
+ *                                   does not allocate any additional resources,
+ *                                   so it is memory-safe, and does not require
+ *                                   any additional deallocation, to stop
+ *                                   serializing without reaching the end.
  *
  * @param [in]    out_ctx            Output context to serialize into.
  *
  * @returns 0 for success, or a negative value in case of error. On error, the
  *          value of <c>*state</c> shall be treated as invalid.
  *
- * If <c>*state</c> is neither <c>NULL</c> nor a value set by a previous call to
- * this function with otherwise the same set of arguments, the behaviour is
- * undefined.
+ * If <c>state->in_progress</c> is <c>true</c>, but <c>*state</c> has not been
+ * set by a previous call to this function with otherwise the same set of
+ * arguments, the behaviour is undefined.
  */
 int _anjay_batch_data_output_entry(
         anjay_unlocked_t *anjay,
         const anjay_batch_t *batch,
         anjay_ssid_t target_ssid,
         avs_time_real_t serialization_time,
-        const anjay_batch_data_output_state_t **state,
+        anjay_batch_data_output_state_t *state,
         anjay_unlocked_output_ctx_t *out_ctx);
 
 /**
@@ -0,0 +1,376 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_init.h>
+
+#ifdef ANJAY_WITH_CBOR
+
+#    include <assert.h>
+#    include <math.h>
+#    include <string.h>
+
+#    include <avsystem/commons/avs_log.h>
+#    include <avsystem/commons/avs_memory.h>
+#    include <avsystem/commons/avs_utils.h>
+
+#    include "../anjay_io_core.h"
+#    include "anjay_common.h"
+#    include "anjay_senml_like_encoder_vtable.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#    define cbor_log(level, ...) _anjay_log(cbor, level, __VA_ARGS__)
+
+#    define CBOR_MAJOR_TYPE_UINT 0
+#    define CBOR_MAJOR_TYPE_NEGATIVE_INT 1
+#    define CBOR_MAJOR_TYPE_BYTE_STRING 2
+#    define CBOR_MAJOR_TYPE_TEXT_STRING 3
+#    define CBOR_MAJOR_TYPE_ARRAY 4
+#    define CBOR_MAJOR_TYPE_MAP 5
+
+#    define CBOR_EXT_LENGTH_1BYTE 24
+#    define CBOR_EXT_LENGTH_2BYTE 25
+#    define CBOR_EXT_LENGTH_4BYTE 26
+#    define CBOR_EXT_LENGTH_8BYTE 27
+#    define CBOR_EXT_LENGTH_INDEFINITE 31
+
+#    define CBOR_VALUE_FALSE 0xF4
+#    define CBOR_VALUE_TRUE 0xF5
+#    define CBOR_VALUE_FLOAT_32 0xFA
+#    define CBOR_VALUE_FLOAT_64 0xFB
+#    define CBOR_VALUE_BREAK 0xFF
+
+#    define CBOR_CONTEXT_LEVEL_ARRAY 0
+#    define CBOR_CONTEXT_LEVEL_MAP 1
+#    define CBOR_CONTEXT_LEVEL_BYTES 2
+
+typedef struct {
+    const anjay_senml_like_encoder_vtable_t *vtable;
+    avs_stream_t *stream;
+    /**
+     * Base Time written in the first timestamped record, or NAN if none has
+     * been written yet. Times of all subsequent records are encoded relative
+     * to it, which usually makes them fit in a single byte.
+     */
+    double base_time;
+    size_t bytes_remaining;
+    uint8_t level;
+} senml_cbor_encoder_t;
+
+static int write_head(avs_stream_t *stream, uint8_t major_type, uint64_t arg) {
+    uint8_t buf[9];
+    size_t size;
+    if (arg < CBOR_EXT_LENGTH_1BYTE) {
+        buf[0] = (uint8_t) ((major_type << 5) | arg);
+        size = 1;
+    } else if (arg <= UINT8_MAX) {
+        buf[0] = (uint8_t) ((major_type << 5) | CBOR_EXT_LENGTH_1BYTE);
+        buf[1] = (uint8_t) arg;
+        size = 2;
+    } else if (arg <= UINT16_MAX) {
+        buf[0] = (uint8_t) ((major_type << 5) | CBOR_EXT_LENGTH_2BYTE);
+        const uint16_t value = avs_convert_be16((uint16_t) arg);
+        memcpy(&buf[1], &value, sizeof(value));
+        size = 3;
+    } else if (arg <= UINT32_MAX) {
+        buf[0] = (uint8_t) ((major_type << 5) | CBOR_EXT_LENGTH_4BYTE);
+        const uint32_t value = avs_convert_be32((uint32_t) arg);
+        memcpy(&buf[1], &value, sizeof(value));
+        size = 5;
+    } else {
+        buf[0] = (uint8_t) ((major_type << 5) | CBOR_EXT_LENGTH_8BYTE);
+        const uint64_t value = avs_convert_be64(arg);
+        memcpy(&buf[1], &value, sizeof(value));
+        size = 9;
+    }
+    return avs_is_ok(avs_stream_write(stream, buf, size)) ? 0 : -1;
+}
+
+static int write_byte(avs_stream_t *stream, uint8_t value) {
+    return avs_is_ok(avs_stream_write(stream, &value, 1)) ? 0 : -1;
+}
+
+static int write_int(avs_stream_t *stream, int64_t value) {
+    if (value >= 0) {
+        return write_head(stream, CBOR_MAJOR_TYPE_UINT, (uint64_t) value);
+    }
+    return write_head(stream, CBOR_MAJOR_TYPE_NEGATIVE_INT,
+                      (uint64_t) (-(value + 1)));
+}
+
+/**
+ * Writes @p value as a single precision float if that does not lose
+ * precision, and as a double precision float otherwise.
+ */
+static int write_float(avs_stream_t *stream, double value) {
+    const float value_float = (float) value;
+    if ((double) value_float == value || isnan(value)) {
+        const uint32_t bits = avs_htonf(value_float);
+        return (write_byte(stream, CBOR_VALUE_FLOAT_32)
+                || avs_is_err(avs_stream_write(stream, &bits, sizeof(bits))))
+                       ? -1
+                       : 0;
+    }
+    const uint64_t bits = avs_htond(value);
+    return (write_byte(stream, CBOR_VALUE_FLOAT_64)
+            || avs_is_err(avs_stream_write(stream, &bits, sizeof(bits))))
+                   ? -1
+                   : 0;
+}
+
+/**
+ * Times are encoded as integers whenever possible, as Unix timestamps and
+ * their differences usually are whole seconds.
+ */
+static int write_time(avs_stream_t *stream, double value) {
+    if (value >= (double) INT64_MIN && value < (double) INT64_MAX
+            && (double) (int64_t) value == value) {
+        return write_int(stream, (int64_t) value);
+    }
+    return write_float(stream, value);
+}
+
+static int write_text(avs_stream_t *stream, const char *value) {
+    const size_t length = strlen(value);
+    if (write_head(stream, CBOR_MAJOR_TYPE_TEXT_STRING, length)
+            || avs_is_err(avs_stream_write(stream, value, length))) {
+        return -1;
+    }
+    return 0;
+}
+
+static int write_label(avs_stream_t *stream, senml_label_t label) {
+    if (label == SENML_EXT_LABEL_OBJLNK) {
+        return write_text(stream, SENML_EXT_OBJLNK_REPR);
+    }
+    return write_int(stream, (int64_t) label);
+}
+
+static inline void nested_context_push(senml_cbor_encoder_t *ctx,
+                                       uint8_t level) {
+    assert(ctx->level == level - 1);
+    (void) level;
+    ctx->level++;
+}
+
+static inline void nested_context_pop(senml_cbor_encoder_t *ctx) {
+    assert(ctx->level);
+    ctx->level--;
+}
+
+static int begin_value(senml_cbor_encoder_t *ctx, senml_label_t label) {
+    if (ctx->level != CBOR_CONTEXT_LEVEL_MAP) {
+        return -1;
+    }
+    return write_label(ctx->stream, label);
+}
+
+static int encode_uint(anjay_senml_like_encoder_t *ctx_, uint64_t value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_VALUE)
+            || write_head(ctx->stream, CBOR_MAJOR_TYPE_UINT, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_int(anjay_senml_like_encoder_t *ctx_, int64_t value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_VALUE) || write_int(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_double(anjay_senml_like_encoder_t *ctx_, double value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_VALUE)
+            || write_float(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_bool(anjay_senml_like_encoder_t *ctx_, bool value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_VALUE_BOOL)
+            || write_byte(ctx->stream,
+                          value ? CBOR_VALUE_TRUE : CBOR_VALUE_FALSE)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_string(anjay_senml_like_encoder_t *ctx_, const char *value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_VALUE_STRING)
+            || write_text(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_objlnk(anjay_senml_like_encoder_t *ctx_, const char *value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_EXT_LABEL_OBJLNK)
+            || write_text(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int element_begin(anjay_senml_like_encoder_t *ctx_,
+                         const char *basename,
+                         const char *name,
+                         double time_s) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    bool write_base_time = false;
+    double relative_time = 0.0;
+
+    if (!isnan(time_s)) {
+        if (isnan(ctx->base_time)) {
+            write_base_time = true;
+            ctx->base_time = time_s;
+        } else {
+            relative_time = time_s - ctx->base_time;
+        }
+    } else if (!isnan(ctx->base_time)) {
+        // Base Time applies to all subsequent records; make this one resolve
+        // to zero, i.e. "now", as it would without Base Time
+        relative_time = -ctx->base_time;
+    }
+
+    // exactly one value is always encoded in each record
+    const uint64_t entries = 1 + !!basename + write_base_time + !!name
+                             + (relative_time != 0.0);
+
+    nested_context_push(ctx, CBOR_CONTEXT_LEVEL_MAP);
+    if (write_head(ctx->stream, CBOR_MAJOR_TYPE_MAP, entries)
+            || (basename
+                && (write_label(ctx->stream, SENML_LABEL_BASE_NAME)
+                    || write_text(ctx->stream, basename)))
+            || (write_base_time
+                && (write_label(ctx->stream, SENML_LABEL_BASE_TIME)
+                    || write_time(ctx->stream, ctx->base_time)))
+            || (name
+                && (write_label(ctx->stream, SENML_LABEL_NAME)
+                    || write_text(ctx->stream, name)))
+            || (relative_time != 0.0
+                && (write_label(ctx->stream, SENML_LABEL_TIME)
+                    || write_time(ctx->stream, relative_time)))) {
+        return -1;
+    }
+    return 0;
+}
+
+static int element_end(anjay_senml_like_encoder_t *ctx_) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    nested_context_pop(ctx);
+    return 0;
+}
+
+static int bytes_begin(anjay_senml_like_encoder_t *ctx_, size_t size) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_VALUE_OPAQUE)
+            || write_head(ctx->stream, CBOR_MAJOR_TYPE_BYTE_STRING, size)) {
+        return -1;
+    }
+    nested_context_push(ctx, CBOR_CONTEXT_LEVEL_BYTES);
+    ctx->bytes_remaining = size;
+    return 0;
+}
+
+static int
+bytes_append(anjay_senml_like_encoder_t *ctx_, const void *data, size_t size) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (size > ctx->bytes_remaining) {
+        cbor_log(DEBUG, _("too many bytes for the declared length"));
+        return -1;
+    }
+    ctx->bytes_remaining -= size;
+    return avs_is_ok(avs_stream_write(ctx->stream, data, size)) ? 0 : -1;
+}
+
+static int bytes_end(anjay_senml_like_encoder_t *ctx_) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    nested_context_pop(ctx);
+    if (ctx->bytes_remaining) {
+        cbor_log(DEBUG, _("fewer bytes than the declared length"));
+        return -1;
+    }
+    return 0;
+}
+
+static int encoder_cleanup(anjay_senml_like_encoder_t **ctx_) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) *ctx_;
+    int retval = -1;
+
+    if (ctx->level == CBOR_CONTEXT_LEVEL_ARRAY
+            && !write_byte(ctx->stream, CBOR_VALUE_BREAK)) {
+        retval = 0;
+    }
+
+    avs_free(*ctx_);
+    *ctx_ = NULL;
+    return retval;
+}
+
+static const anjay_senml_like_encoder_vtable_t SENML_CBOR_ENCODER_VTABLE = {
+    .senml_like_encode_uint = encode_uint,
+    .senml_like_encode_int = encode_int,
+    .senml_like_encode_double = encode_double,
+    .senml_like_encode_bool = encode_bool,
+    .senml_like_encode_string = encode_string,
+    .senml_like_encode_objlnk = encode_objlnk,
+    .senml_like_element_begin = element_begin,
+    .senml_like_element_end = element_end,
+    .senml_like_bytes_begin = bytes_begin,
+    .senml_like_bytes_append = bytes_append,
+    .senml_like_bytes_end = bytes_end,
+    .senml_like_encoder_cleanup = encoder_cleanup
+};
+
+anjay_senml_like_encoder_t *
+_anjay_senml_cbor_encoder_new(avs_stream_t *stream) {
+    if (!stream) {
+        cbor_log(DEBUG, _("no stream provided"));
+        return NULL;
+    }
+
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) avs_calloc(
+            1, sizeof(senml_cbor_encoder_t));
+    if (!ctx) {
+        cbor_log(DEBUG, _("failed to allocate encoder context"));
+        return NULL;
+    }
+    ctx->vtable = &SENML_CBOR_ENCODER_VTABLE;
+    ctx->stream = stream;
+    ctx->base_time = NAN;
+
+    // the records are streamed, so their count is not known upfront
+    if (write_byte(stream, (CBOR_MAJOR_TYPE_ARRAY << 5)
+                                   | CBOR_EXT_LENGTH_INDEFINITE)) {
+        avs_free(ctx);
+        return NULL;
+    }
+    return (anjay_senml_like_encoder_t *) ctx;
+}
+
+#    ifdef ANJAY_TEST
+#        include "tests/core/io/senml_cbor_encoder.c"
+#    endif // ANJAY_TEST
+
+#endif // ANJAY_WITH_CBOR
@@ -114,6 +114,9 @@ int _anjay_senml_like_encoder_cleanup(anjay_senml_like_encoder_t **ctx);
 anjay_senml_like_encoder_t *_anjay_lwm2m_json_encoder_new(avs_stream_t *stream,
                                                           const char *basename);
 
+anjay_senml_like_encoder_t *
+_anjay_senml_cbor_encoder_new(avs_stream_t *stream);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_IO_SENML_LIKE_ENCODER_H
@@ -302,6 +302,12 @@ anjay_unlocked_output_ctx_t *_anjay_output_senml_like_create(
         break;
     }
 #    endif // ANJAY_WITH_LWM2M_JSON
+#    ifdef ANJAY_WITH_CBOR
+    case AVS_COAP_FORMAT_SENML_CBOR:
+        // Base Name is written along with the first record
+        ctx->encoder = _anjay_senml_cbor_encoder_new(stream);
+        break;
+#    endif // ANJAY_WITH_CBOR
     default:
         senml_log(WARNING, _("unsupported content format"));
         goto error;
@@ -21,7 +21,6 @@
 #    include <assert.h>
 #    include <string.h>
 
-#    include <avsystem/commons/avs_list.h>
 #    include <avsystem/commons/avs_memory.h>
 #    include <avsystem/commons/avs_stream.h>
 #    include <avsystem/commons/avs_utils.h>
@@ -33,31 +32,28 @@
 
 VISIBILITY_SOURCE_BEGIN
 
-typedef struct {
-    tlv_id_type_t type;
-    uint16_t id;
-} tlv_id_t;
-
 #    define TLV_MAX_LENGTH ((1 << 24) - 1)
 
-typedef struct {
-    size_t data_length;
-    tlv_id_t id;
-    char data[];
-} tlv_entry_t;
+// type field + up to 2 bytes of ID + up to 3 bytes of length
+#    define TLV_MAX_HEADER_SIZE 6
 
 typedef struct {
     const anjay_ret_bytes_ctx_vtable_t *vtable;
     union {
-        char *buffer_ptr;
+        struct {
+            // pointer to tlv_out_t::buffer, which may be reallocated
+            char **buffer;
+            size_t offset;
+        } buffered;
         avs_stream_t *stream;
     } output;
     size_t bytes_left;
 } tlv_bytes_t;
 
 typedef struct {
-    AVS_LIST(tlv_entry_t) entries;
-    AVS_LIST(tlv_entry_t) *next_entry_ptr;
+    // Offset in tlv_out_t::buffer of the space reserved for the header of the
+    // entry that this level is serialized into. Unused for the root level.
+    size_t header_offset;
 
     // ID that will be used when serializing the next element.
     // ANJAY_ID_INVALID if it's not set.
@@ -79,6 +75,18 @@ typedef struct tlv_out_struct {
     anjay_uri_path_t root_path;
     tlv_out_level_t levels[_TLV_OUT_LEVEL_LIMIT];
     tlv_out_level_id_t level;
+
+    /**
+     * Serialized contents of the nested (non-root) levels. Each nested level
+     * starts with TLV_MAX_HEADER_SIZE bytes reserved for its own header,
+     * followed by its entries, already in their final form. When the level is
+     * finished, the actual header is written in place and the data is moved
+     * back to close the gap. Only complete top-level entries are copied to the
+     * output stream, after which the buffer is reused.
+     */
+    char *buffer;
+    size_t buffer_size;
+    size_t buffer_capacity;
 } tlv_out_t;
 
 static inline uint8_t u32_length(uint32_t value) {
@@ -179,31 +187,62 @@ static int get_current_level_value_type(tlv_out_t *ctx, tlv_id_type_t *out) {
     }
 }
 
-static int write_entry(avs_stream_t *stream,
-                       const tlv_id_t *id,
-                       const void *buf,
-                       size_t length) {
-    if (write_header(stream, id->type, id->id, length)
-            || avs_is_err(avs_stream_write(stream, buf, length))) {
+static int buffered_bytes_append(anjay_unlocked_ret_bytes_ctx_t *ctx_,
+                                 const void *data,
+                                 size_t length);
+
+static const anjay_ret_bytes_ctx_vtable_t BUFFERED_BYTES_VTABLE = {
+    .append = buffered_bytes_append
+};
+
+static int write_buffered_header(char *out,
+                                 tlv_id_type_t type,
+                                 uint16_t id,
+                                 size_t length,
+                                 size_t *out_header_size) {
+    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;
+    avs_stream_outbuf_set_buffer(&outbuf, out, TLV_MAX_HEADER_SIZE);
+    if (write_header((avs_stream_t *) &outbuf, type, id, length)) {
         return -1;
     }
+    *out_header_size = avs_stream_outbuf_offset(&outbuf);
     return 0;
 }
 
-static char *
+static int reserve_buffer(tlv_out_t *ctx, size_t size, size_t *out_offset) {
+    if (size > ctx->buffer_capacity - ctx->buffer_size) {
+        size_t new_capacity = 2 * ctx->buffer_capacity + size;
+        char *new_buffer = (char *) avs_realloc(ctx->buffer, new_capacity);
+        if (!new_buffer) {
+            return -1;
+        }
+        ctx->buffer = new_buffer;
+        ctx->buffer_capacity = new_capacity;
+    }
+    *out_offset = ctx->buffer_size;
+    ctx->buffer_size += size;
+    return 0;
+}
+
+static anjay_unlocked_ret_bytes_ctx_t *
 add_buffered_entry(tlv_out_t *ctx, tlv_id_type_t type, size_t length) {
-    tlv_entry_t *new_entry =
-            (tlv_entry_t *) AVS_LIST_NEW_BUFFER(sizeof(tlv_entry_t) + length);
-    if (!new_entry) {
+    tlv_out_level_t *out_level = current_level(ctx);
+    size_t entry_header_size = header_size(out_level->next_id, length);
+    size_t offset;
+    if (reserve_buffer(ctx, entry_header_size + length, &offset)) {
         return NULL;
     }
-    new_entry->data_length = length;
-    new_entry->id.type = type;
-    new_entry->id.id = current_level(ctx)->next_id;
-    current_level(ctx)->next_id = ANJAY_ID_INVALID;
-    *current_level(ctx)->next_entry_ptr = new_entry;
-    AVS_LIST_ADVANCE_PTR(&current_level(ctx)->next_entry_ptr);
-    return new_entry->data;
+    if (write_buffered_header(&ctx->buffer[offset], type, out_level->next_id,
+                              length, &entry_header_size)) {
+        ctx->buffer_size = offset;
+        return NULL;
+    }
+    out_level->next_id = ANJAY_ID_INVALID;
+    out_level->bytes_ctx.vtable = &BUFFERED_BYTES_VTABLE;
+    out_level->bytes_ctx.output.buffered.buffer = &ctx->buffer;
+    out_level->bytes_ctx.output.buffered.offset = offset + entry_header_size;
+    out_level->bytes_ctx.bytes_left = length;
+    return (anjay_unlocked_ret_bytes_ctx_t *) &out_level->bytes_ctx;
 }
 
 static int streamed_bytes_append(anjay_unlocked_ret_bytes_ctx_t *ctx_,
@@ -230,14 +269,6 @@ static int streamed_bytes_append(anjay_unlocked_ret_bytes_ctx_t *ctx_,
     return 0;
 }
 
-static int buffered_bytes_append(anjay_unlocked_ret_bytes_ctx_t *ctx_,
-                                 const void *data,
-                                 size_t length);
-
-static const anjay_ret_bytes_ctx_vtable_t BUFFERED_BYTES_VTABLE = {
-    .append = buffered_bytes_append
-};
-
 static int buffered_bytes_append(anjay_unlocked_ret_bytes_ctx_t *ctx_,
                                  const void *data,
                                  size_t length) {
@@ -248,8 +279,9 @@ static int buffered_bytes_append(anjay_unlocked_ret_bytes_ctx_t *ctx_,
         if (length > ctx->bytes_left) {
             retval = -1;
         } else {
-            memcpy(ctx->output.buffer_ptr, data, length);
-            ctx->output.buffer_ptr += length;
+            memcpy(*ctx->output.buffered.buffer + ctx->output.buffered.offset,
+                   data, length);
+            ctx->output.buffered.offset += length;
         }
     }
     if (!retval) {
@@ -267,12 +299,7 @@ add_entry(tlv_out_t *ctx, tlv_id_type_t type, size_t length) {
         return NULL;
     }
     if (ctx->level > root_level) {
-        if ((out_level->bytes_ctx.output.buffer_ptr =
-                     add_buffered_entry(ctx, type, length))) {
-            out_level->bytes_ctx.vtable = &BUFFERED_BYTES_VTABLE;
-            out_level->bytes_ctx.bytes_left = length;
-            return (anjay_unlocked_ret_bytes_ctx_t *) &out_level->bytes_ctx;
-        }
+        return add_buffered_entry(ctx, type, length);
     } else {
         int retval =
                 write_header(ctx->stream, type, out_level->next_id, length);
@@ -352,7 +379,7 @@ static int tlv_ret_objlnk(anjay_unlocked_output_ctx_t *ctx,
     return _anjay_ret_bytes_unlocked(ctx, &portable, sizeof(portable));
 }
 
-static void tlv_slave_start(tlv_out_t *ctx);
+static int tlv_slave_start(tlv_out_t *ctx);
 
 static int tlv_slave_finish(tlv_out_t *ctx) {
     tlv_out_level_id_t root_level;
@@ -361,44 +388,60 @@ static int tlv_slave_finish(tlv_out_t *ctx) {
         AVS_UNREACHABLE("Already at root level of TLV structure");
         return -1;
     }
-    size_t data_size = 0;
-    {
-        tlv_entry_t *entry = NULL;
-        AVS_LIST_FOREACH(entry, current_level(ctx)->entries) {
-            data_size += header_size(entry->id.id, entry->data_length)
-                         + entry->data_length;
-        }
+    const size_t header_offset = current_level(ctx)->header_offset;
+    const size_t data_offset = header_offset + TLV_MAX_HEADER_SIZE;
+    assert(data_offset <= ctx->buffer_size);
+    const size_t length = ctx->buffer_size - data_offset;
+    tlv_out_level_t *finished_level = current_level(ctx);
+    ctx->level = (tlv_out_level_id_t) (ctx->level - 1);
+    if (finished_level->bytes_ctx.bytes_left) {
+        // The last entry has not been written completely, the rest of its
+        // space in the buffer is uninitialized
+        finished_level->bytes_ctx.bytes_left = 0;
+        ctx->buffer_size = header_offset;
+        return -1;
     }
-    char *buffer = (char *) (data_size ? avs_malloc(data_size) : NULL);
-    int retval = ((!data_size || buffer) ? 0 : -1);
-    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;
-    avs_stream_outbuf_set_buffer(&outbuf, buffer, data_size);
-    AVS_LIST_CLEAR(&current_level(ctx)->entries) {
-        if (!retval) {
-            retval = write_entry((avs_stream_t *) &outbuf,
-                                 &current_level(ctx)->entries->id,
-                                 current_level(ctx)->entries->data,
-                                 current_level(ctx)->entries->data_length);
-        }
+
+    tlv_id_type_t type;
+    switch (ctx->level) {
+    case TLV_OUT_LEVEL_RID:
+        type = TLV_ID_RID_ARRAY;
+        break;
+    case TLV_OUT_LEVEL_IID:
+        type = TLV_ID_IID;
+        break;
+    default:
+        ctx->buffer_size = header_offset;
+        return -1;
     }
-    ctx->level = (tlv_out_level_id_t) (ctx->level - 1);
-    if (!retval) {
-        size_t length = avs_stream_outbuf_offset(&outbuf);
-        anjay_unlocked_ret_bytes_ctx_t *bytes = NULL;
-        switch (ctx->level) {
-        case TLV_OUT_LEVEL_RID:
-            bytes = add_entry(ctx, TLV_ID_RID_ARRAY, length);
-            break;
-        case TLV_OUT_LEVEL_IID:
-            bytes = add_entry(ctx, TLV_ID_IID, length);
-            break;
-        default:;
+
+    int retval = 0;
+    if (ctx->level > root_level) {
+        // Still nested - write the real header into the reserved space and
+        // move the data back so that it directly follows it
+        tlv_out_level_t *out_level = current_level(ctx);
+        size_t entry_header_size;
+        if (length > TLV_MAX_LENGTH || out_level->bytes_ctx.bytes_left
+                || write_buffered_header(&ctx->buffer[header_offset], type,
+                                         out_level->next_id, length,
+                                         &entry_header_size)) {
+            ctx->buffer_size = header_offset;
+            retval = -1;
+        } else {
+            if (entry_header_size < TLV_MAX_HEADER_SIZE) {
+                memmove(&ctx->buffer[header_offset + entry_header_size],
+                        &ctx->buffer[data_offset], length);
+            }
+            ctx->buffer_size = header_offset + entry_header_size + length;
         }
+        out_level->next_id = ANJAY_ID_INVALID;
+    } else {
+        anjay_unlocked_ret_bytes_ctx_t *bytes = add_entry(ctx, type, length);
         retval = !bytes ? -1
-                        : _anjay_ret_bytes_append_unlocked(bytes, buffer,
-                                                           length);
+                        : _anjay_ret_bytes_append_unlocked(
+                                  bytes, &ctx->buffer[data_offset], length);
+        ctx->buffer_size = header_offset;
     }
-    avs_free(buffer);
     return retval;
 }
 
@@ -413,7 +456,7 @@ static int tlv_start_aggregate(anjay_unlocked_output_ctx_t *ctx_) {
             // Resource Instances - so we're starting the slave context that
             // will expect Resource Instance entries, or serialize to an empty
             // array if no Resource Instances will follow.
-            tlv_slave_start(ctx);
+            return tlv_slave_start(ctx);
         } else {
             AVS_ASSERT(_anjay_uri_path_leaf_is(&ctx->root_path, ANJAY_ID_IID),
                        "Called tlv_start_aggregate in inappropriate state");
@@ -437,7 +480,7 @@ static int tlv_start_aggregate(anjay_unlocked_output_ctx_t *ctx_) {
         // starting aggregate on the Instance level, i.e. an array of Resources
         // - so we're starting the slave context that will expect Resource
         // entries, or serialize to an empty array if no Resources will follow.
-        tlv_slave_start(ctx);
+        return tlv_slave_start(ctx);
     } else {
         AVS_UNREACHABLE("tlv_start_aggregate called in invalid state");
         return -1;
@@ -534,7 +577,9 @@ static int tlv_set_path(anjay_unlocked_output_ctx_t *ctx_,
                                        &ctx->levels[i].next_id))) {
             return result;
         }
-        tlv_slave_start(ctx);
+        if ((result = tlv_slave_start(ctx))) {
+            return result;
+        }
     }
     assert(ctx->level == AVS_MAX(new_level, lowest_level));
     if (new_level >= lowest_level) {
@@ -569,9 +614,10 @@ static int tlv_output_close(anjay_unlocked_output_ctx_t *ctx_) {
             _anjay_update_ret(&result, tlv_slave_finish(ctx));
         }
     }
-    for (uint8_t i = 0; i < AVS_ARRAY_SIZE(ctx->levels); ++i) {
-        AVS_LIST_CLEAR(&ctx->levels[i].entries);
-    }
+    avs_free(ctx->buffer);
+    ctx->buffer = NULL;
+    ctx->buffer_size = 0;
+    ctx->buffer_capacity = 0;
     return result;
 }
 
@@ -588,12 +634,17 @@ static const anjay_output_ctx_vtable_t TLV_OUT_VTABLE = {
     .close = tlv_output_close
 };
 
-static void tlv_slave_start(tlv_out_t *ctx) {
+static int tlv_slave_start(tlv_out_t *ctx) {
     assert((size_t) (ctx->level + 1) <= AVS_ARRAY_SIZE(ctx->levels));
+    size_t header_offset;
+    if (current_level(ctx)->bytes_ctx.bytes_left
+            || reserve_buffer(ctx, TLV_MAX_HEADER_SIZE, &header_offset)) {
+        return -1;
+    }
     ctx->level = (tlv_out_level_id_t) (ctx->level + 1);
-    assert(!current_level(ctx)->entries);
-    current_level(ctx)->next_entry_ptr = &current_level(ctx)->entries;
+    current_level(ctx)->header_offset = header_offset;
     current_level(ctx)->next_id = ANJAY_ID_INVALID;
+    return 0;
 }
 
 anjay_unlocked_output_ctx_t *
@@ -611,13 +662,13 @@ _anjay_output_tlv_create(avs_stream_t *stream, const anjay_uri_path_t *uri) {
     ctx->base.vtable = &TLV_OUT_VTABLE;
     ctx->stream = stream;
     ctx->root_path = *uri;
-    current_level(ctx)->next_entry_ptr = &current_level(ctx)->entries;
     current_level(ctx)->next_id = ANJAY_ID_INVALID;
     return (anjay_unlocked_output_ctx_t *) ctx;
 }
 
 #    ifdef ANJAY_TEST
 #        include "tests/core/io/tlv_out.c"
+#        include "tests/core/io/tlv_out_buffer.c"
 #    endif
 
 #endif // ANJAY_WITHOUT_TLV
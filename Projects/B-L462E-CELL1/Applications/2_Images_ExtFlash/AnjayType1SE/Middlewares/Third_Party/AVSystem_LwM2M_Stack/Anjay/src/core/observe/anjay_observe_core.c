@@ -100,6 +100,11 @@ static void delete_value(AVS_LIST(anjay_observation_value_t) *value_ptr) {
             }
         }
     }
+#    ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    if ((*value_ptr)->samples) {
+        _anjay_batch_release(&(*value_ptr)->samples);
+    }
+#    endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
     AVS_LIST_DELETE(value_ptr);
 }
 
@@ -254,6 +259,12 @@ void _anjay_observe_cleanup(anjay_observe_state_t *observe) {
     AVS_LIST_CLEAR(&observe->connection_entries) {
         _anjay_observe_cleanup_connection(observe->connection_entries);
     }
+#    ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    _anjay_sample_buffers_cleanup(&observe->sample_buffers);
+#    endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+#    ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    AVS_LIST_CLEAR(&observe->incremental_read_oids);
+#    endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
 }
 
 static void
@@ -351,7 +362,8 @@ create_observation_value(const anjay_msg_details_t *details,
                          avs_coap_notify_reliability_hint_t reliability_hint,
                          anjay_observation_t *ref,
                          const avs_time_real_t *timestamp,
-                         const anjay_batch_t *const *values) {
+                         const anjay_batch_t *const *values,
+                         const anjay_batch_t *samples) {
     const size_t values_count =
             _anjay_observe_is_error_details(details) ? 0 : ref->paths_count;
     const size_t element_size = offsetof(anjay_observation_value_t, values)
@@ -374,6 +386,14 @@ create_observation_value(const anjay_msg_details_t *details,
             break;
         }
     }
+#    ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    if (result && samples
+            && !(result->samples = _anjay_batch_acquire(samples))) {
+        delete_value(&result);
+    }
+#    else  // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    (void) samples;
+#    endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
     return result;
 }
 
@@ -450,7 +470,8 @@ static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
                             avs_coap_notify_reliability_hint_t reliability_hint,
                             const anjay_msg_details_t *details,
                             const avs_time_real_t *timestamp,
-                            const anjay_batch_t *const *values) {
+                            const anjay_batch_t *const *values,
+                            const anjay_batch_t *samples) {
     anjay_observe_state_t *observe =
             &_anjay_from_server(conn_state->conn_ref.server)->observe;
     if (is_observe_queue_full(observe)) {
@@ -468,7 +489,7 @@ static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
 
     AVS_LIST(anjay_observation_value_t) res_value =
             create_observation_value(details, reliability_hint, observation,
-                                     timestamp, values);
+                                     timestamp, values, samples);
     if (!res_value) {
         return -1;
     }
@@ -496,7 +517,7 @@ static int insert_error(anjay_observe_connection_entry_t *conn_state,
     const avs_time_real_t timestamp = avs_time_real_now();
     return insert_new_value(conn_state, observation,
                             AVS_COAP_NOTIFY_PREFER_CONFIRMABLE, &details,
-                            &timestamp, NULL);
+                            &timestamp, NULL, NULL);
 }
 
 static int get_effective_attrs(anjay_unlocked_t *anjay,
@@ -608,7 +629,7 @@ static int insert_initial_value(anjay_observe_connection_entry_t *conn_state,
     // even though we haven't actually sent it ourselves
     if ((observation->last_sent = create_observation_value(
                  details, AVS_COAP_NOTIFY_PREFER_NON_CONFIRMABLE, observation,
-                 timestamp, values))
+                 timestamp, values, NULL))
             && !(result = _anjay_observe_schedule_pmax_trigger(conn_state,
                                                                observation))) {
         observation->last_confirmable = now;
@@ -787,6 +808,19 @@ put_entry_into_connection_state(const anjay_request_t *request,
     return observation;
 }
 
+static anjay_batch_t *compile_batch(anjay_batch_builder_t **builder,
+                                    const anjay_uri_path_t *path) {
+#    ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    // Object and Object Instance reads are split per Resource, so that parts
+    // that did not change can be shared between subsequent values
+    if (!_anjay_uri_path_has(path, ANJAY_ID_RID)) {
+        return _anjay_batch_builder_compile_split(builder);
+    }
+#    endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    (void) path;
+    return _anjay_batch_builder_compile(builder);
+}
+
 static int read_as_batch(anjay_unlocked_t *anjay,
                          const anjay_dm_installed_object_t *obj_ptr,
                          const anjay_dm_path_info_t *path_info,
@@ -804,7 +838,7 @@ static int read_as_batch(anjay_unlocked_t *anjay,
     int result = _anjay_dm_read_into_batch(builder, anjay, obj_ptr, path_info,
                                            connection_ssid, timestamp);
     (void) action;
-    if (!result && !(*out_batch = _anjay_batch_builder_compile(&builder))) {
+    if (!result && !(*out_batch = compile_batch(&builder, &path_info->uri))) {
         anjay_log(ERROR, _("out of memory"));
         result = -1;
     }
@@ -822,6 +856,33 @@ static anjay_uri_path_t get_response_path(anjay_observation_value_t *value) {
     return observation->paths[0];
 }
 
+static const anjay_batch_t *
+current_serialized_batch(const anjay_observe_connection_entry_t *conn) {
+    const anjay_observation_value_t *value = conn->unsent;
+#    ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    if (value->samples && !conn->serialization_state.samples_written) {
+        return value->samples;
+    }
+#    endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    return value->values[conn->serialization_state.curr_value_idx];
+}
+
+/**
+ * Moves on to the next batch to serialize. Returns true if there are no more
+ * batches left.
+ */
+static bool advance_serialized_batch(anjay_observe_connection_entry_t *conn) {
+    const anjay_observation_value_t *value = conn->unsent;
+#    ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    if (value->samples && !conn->serialization_state.samples_written) {
+        conn->serialization_state.samples_written = true;
+        return !value->ref->paths_count;
+    }
+#    endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    return ++conn->serialization_state.curr_value_idx
+           >= value->ref->paths_count;
+}
+
 static int write_notify_payload(size_t payload_offset,
                                 void *payload_buf,
                                 size_t payload_buf_size,
@@ -839,9 +900,6 @@ static int write_notify_payload(size_t payload_offset,
     }
 
     anjay_unlocked_t *anjay = _anjay_from_server(conn->conn_ref.server);
-    anjay_observation_value_t *value = conn->unsent;
-    anjay_observation_t *observation = value->ref;
-
     char *write_ptr = (char *) payload_buf;
     const char *end_ptr = write_ptr + payload_buf_size;
     while (true) {
@@ -859,18 +917,14 @@ static int write_notify_payload(size_t payload_offset,
         // read_as_batch() stage, so we're "spoofing" ANJAY_SSID_BOOTSTRAP
         // as the permissions are checked now
         int result = _anjay_batch_data_output_entry(
-                anjay, value->values[conn->serialization_state.curr_value_idx],
-                ANJAY_SSID_BOOTSTRAP,
+                anjay, current_serialized_batch(conn), ANJAY_SSID_BOOTSTRAP,
                 conn->serialization_state.serialization_time,
                 &conn->serialization_state.output_state,
                 conn->serialization_state.out_ctx);
-        if (!result && !conn->serialization_state.output_state) {
-            ++conn->serialization_state.curr_value_idx;
-            if (conn->serialization_state.curr_value_idx
-                    >= observation->paths_count) {
-                result = _anjay_output_ctx_destroy_and_process_result(
-                        &conn->serialization_state.out_ctx, result);
-            }
+        if (!result && !conn->serialization_state.output_state.in_progress
+                && advance_serialized_batch(conn)) {
+            result = _anjay_output_ctx_destroy_and_process_result(
+                    &conn->serialization_state.out_ctx, result);
         }
         if (result) {
             return result;
@@ -1462,6 +1516,12 @@ bool _anjay_observe_needs_flushing(anjay_connection_ref_t ref) {
            && !avs_coap_exchange_id_valid((*conn_ptr)->notify_exchange_id);
 }
 
+bool _anjay_observe_has_observations(anjay_connection_ref_t ref) {
+    AVS_LIST(anjay_observe_connection_entry_t) *conn_ptr =
+            _anjay_observe_find_connection_state(ref);
+    return conn_ptr && AVS_RBTREE_FIRST((*conn_ptr)->observations);
+}
+
 int _anjay_observe_sched_flush(anjay_connection_ref_t ref) {
     anjay_log(TRACE,
               _("scheduling notifications flush for server SSID ") "%u" _(
@@ -1481,6 +1541,314 @@ int _anjay_observe_sched_flush(anjay_connection_ref_t ref) {
     }
 }
 
+#    ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+static AVS_LIST(anjay_oid_t) *find_incremental_read_oid_ptr(
+        anjay_unlocked_t *anjay, anjay_oid_t oid) {
+    AVS_LIST(anjay_oid_t) *oid_ptr;
+    AVS_LIST_FOREACH_PTR(oid_ptr, &anjay->observe.incremental_read_oids) {
+        if (**oid_ptr >= oid) {
+            break;
+        }
+    }
+    return oid_ptr;
+}
+
+int _anjay_observe_incremental_read_enable(anjay_unlocked_t *anjay,
+                                           anjay_oid_t oid) {
+    AVS_LIST(anjay_oid_t) *oid_ptr = find_incremental_read_oid_ptr(anjay, oid);
+    if (*oid_ptr && **oid_ptr == oid) {
+        return 0;
+    }
+    AVS_LIST(anjay_oid_t) entry = AVS_LIST_NEW_ELEMENT(anjay_oid_t);
+    if (!entry) {
+        anjay_log(ERROR, _("out of memory"));
+        return -1;
+    }
+    *entry = oid;
+    AVS_LIST_INSERT(oid_ptr, entry);
+    return 0;
+}
+
+/**
+ * Resources of other Objects may change without anjay_notify_changed() being
+ * called; their previously read values cannot be reused, as such a change
+ * would then only be picked up when pmax expires.
+ */
+static bool incremental_read_enabled(anjay_unlocked_t *anjay,
+                                     const anjay_uri_path_t *path) {
+    AVS_LIST(anjay_oid_t) *oid_ptr =
+            find_incremental_read_oid_ptr(anjay, path->ids[ANJAY_ID_OID]);
+    return *oid_ptr && **oid_ptr == path->ids[ANJAY_ID_OID];
+}
+
+static bool paths_overlap(const anjay_uri_path_t *a,
+                          const anjay_uri_path_t *b) {
+    return !_anjay_uri_path_outside_base(a, b)
+           || !_anjay_uri_path_outside_base(b, a);
+}
+
+static void require_full_read(anjay_observation_t *observation) {
+    observation->full_read_required = true;
+    observation->changed_paths_count = 0;
+}
+
+static void mark_path_changed(anjay_observation_t *observation,
+                              const anjay_uri_path_t *path) {
+    if (observation->full_read_required) {
+        return;
+    }
+    if (!_anjay_uri_path_has(path, ANJAY_ID_RID)) {
+        // e.g. Instance set changes; there is no previous part to replace
+        require_full_read(observation);
+        return;
+    }
+    for (size_t i = 0; i < observation->changed_paths_count; ++i) {
+        if (_anjay_uri_path_equal(&observation->changed_paths[i], path)) {
+            return;
+        }
+    }
+    if (observation->changed_paths_count
+            >= AVS_ARRAY_SIZE(observation->changed_paths)) {
+        require_full_read(observation);
+        return;
+    }
+    observation->changed_paths[observation->changed_paths_count++] = *path;
+}
+
+static bool path_changed(const anjay_observation_t *observation,
+                         const anjay_uri_path_t *path) {
+    for (size_t i = 0; i < observation->changed_paths_count; ++i) {
+        if (paths_overlap(&observation->changed_paths[i], path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool changes_match_parts(const anjay_observation_t *observation,
+                                const anjay_uri_path_t *path,
+                                const anjay_batch_t *previous) {
+    const size_t parts_count = _anjay_batch_parts_count(previous);
+    for (size_t i = 0; i < observation->changed_paths_count; ++i) {
+        anjay_uri_path_t change = observation->changed_paths[i];
+        if (!paths_overlap(&change, path)) {
+            continue;
+        }
+        if (!_anjay_uri_path_has(&change, ANJAY_ID_RID)
+                || _anjay_uri_path_outside_base(&change, path)) {
+            // change affects more than a single Resource
+            return false;
+        }
+        change.ids[ANJAY_ID_RIID] = ANJAY_ID_INVALID;
+        size_t j = 0;
+        while (j < parts_count) {
+            anjay_uri_path_t part_path =
+                    _anjay_batch_part_path(_anjay_batch_part(previous, j));
+            if (_anjay_uri_path_equal(&part_path, &change)) {
+                break;
+            }
+            ++j;
+        }
+        if (j >= parts_count) {
+            // Resource not present in the previous value
+            return false;
+        }
+    }
+    return true;
+}
+
+static void release_parts(anjay_batch_t ***parts_ptr, size_t parts_count) {
+    for (size_t i = 0; i < parts_count; ++i) {
+        if ((*parts_ptr)[i]) {
+            _anjay_batch_release(&(*parts_ptr)[i]);
+        }
+    }
+    avs_free(*parts_ptr);
+    *parts_ptr = NULL;
+}
+
+/**
+ * Creates a new value of an Object or Object Instance level observation path
+ * by re-reading only the Resources that have been reported as changed and
+ * sharing the remaining parts of the previous value.
+ *
+ * Leaves *out_batch NULL, without reporting an error, if the changes cannot be
+ * applied that way and the path shall be read in full instead.
+ */
+static int reread_changed_parts(anjay_unlocked_t *anjay,
+                                const anjay_observation_t *observation,
+                                const anjay_uri_path_t *path,
+                                const anjay_batch_t *previous,
+                                anjay_ssid_t ssid,
+                                const avs_time_real_t *timestamp,
+                                anjay_batch_t **out_batch) {
+    assert(out_batch && !*out_batch);
+    const size_t parts_count = _anjay_batch_parts_count(previous);
+    if (!parts_count || !changes_match_parts(observation, path, previous)) {
+        return 0;
+    }
+
+    anjay_batch_t **parts =
+            (anjay_batch_t **) avs_calloc(parts_count, sizeof(*parts));
+    if (!parts) {
+        anjay_log(ERROR, _("out of memory"));
+        return -1;
+    }
+    size_t reread_count = 0;
+    for (size_t i = 0; i < parts_count; ++i) {
+        const anjay_batch_t *part = _anjay_batch_part(previous, i);
+        const anjay_uri_path_t part_path = _anjay_batch_part_path(part);
+        // parts that do not pertain to any Resource, e.g. Instance entries,
+        // only change along with the Instance set, which requires a full read
+        if (!_anjay_uri_path_has(&part_path, ANJAY_ID_RID)
+                || !path_changed(observation, &part_path)) {
+            if (!(parts[i] = _anjay_batch_acquire(part))) {
+                release_parts(&parts, parts_count);
+                return -1;
+            }
+        } else if (read_observation_path(anjay, &part_path,
+                                         observation->action, ssid, timestamp,
+                                         &parts[i])) {
+            // e.g. the Resource is no longer present
+            release_parts(&parts, parts_count);
+            return 0;
+        } else {
+            ++reread_count;
+        }
+    }
+    if (!(*out_batch = _anjay_batch_compose(parts, parts_count))) {
+        anjay_log(ERROR, _("out of memory"));
+        release_parts(&parts, parts_count);
+        return -1;
+    }
+    avs_free(parts);
+    anjay_log(LAZY_TRACE,
+              _("re-read ") "%u" _(" of ") "%u" _(" Resources of ") "%s",
+              (unsigned) reread_count, (unsigned) parts_count,
+              ANJAY_DEBUG_MAKE_PATH(path));
+    return 0;
+}
+
+/**
+ * Called after a new value of the observation has been stored. Forgets the
+ * tracked changes that have been taken into account in it, i.e. all except
+ * those pertaining to paths that were held from reading due to epmin.
+ */
+static void forget_read_changes(anjay_observation_t *observation,
+                                anjay_batch_t *const *batches,
+                                avs_time_real_t read_time) {
+    bool all_read = true;
+    size_t kept_count = 0;
+    for (size_t i = 0; i < observation->changed_paths_count; ++i) {
+        bool keep = false;
+        for (size_t j = 0; j < observation->paths_count; ++j) {
+            if (avs_time_real_before(
+                        _anjay_batch_get_compilation_time(batches[j]),
+                        read_time)
+                    && paths_overlap(&observation->changed_paths[i],
+                                     &observation->paths[j])) {
+                keep = true;
+                break;
+            }
+        }
+        if (keep) {
+            observation->changed_paths[kept_count++] =
+                    observation->changed_paths[i];
+        }
+    }
+    observation->changed_paths_count = (uint8_t) kept_count;
+    for (size_t j = 0; all_read && j < observation->paths_count; ++j) {
+        all_read = !avs_time_real_before(
+                _anjay_batch_get_compilation_time(batches[j]), read_time);
+    }
+    if (all_read) {
+        observation->full_read_required = false;
+    }
+}
+#    endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+
+static int read_notification_path(anjay_unlocked_t *anjay,
+                                  anjay_observation_t *observation,
+                                  size_t index,
+                                  bool full_read,
+                                  anjay_ssid_t ssid,
+                                  const avs_time_real_t *timestamp,
+                                  anjay_batch_t **out_batch) {
+    const anjay_uri_path_t *path = &observation->paths[index];
+#    ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    // Only a trigger caused by reported Resource changes may be handled
+    // incrementally; in any other case, e.g. pmax or an attribute change,
+    // Resources might have changed without being reported
+    if (!full_read && !observation->full_read_required
+            && observation->changed_paths_count
+            && incremental_read_enabled(anjay, path)) {
+        const anjay_batch_t *previous =
+                newest_value(observation)->values[index];
+        if (!path_changed(observation, path)) {
+            // nothing has been reported as changed under this path
+            return (*out_batch = _anjay_batch_acquire(previous)) ? 0 : -1;
+        }
+        int result = reread_changed_parts(anjay, observation, path, previous,
+                                          ssid, timestamp, out_batch);
+        if (result || *out_batch) {
+            return result;
+        }
+    }
+#    else  // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    (void) full_read;
+#    endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    return read_observation_path(anjay, path, observation->action, ssid,
+                                 timestamp, out_batch);
+}
+
+#    ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+static int collect_samples(anjay_unlocked_t *anjay,
+                           anjay_observation_t *observation,
+                           anjay_ssid_t ssid,
+                           avs_time_real_t until,
+                           anjay_batch_t **out_samples) {
+    const anjay_observation_value_t *previous = newest_value(observation);
+    assert(!*out_samples);
+    if (!anjay->observe.sample_buffers) {
+        return 0;
+    }
+    if (!_anjay_sample_buffer_format_supported(previous->details.format)) {
+        for (size_t i = 0; !observation->samples_format_warned
+                           && i < observation->paths_count;
+             ++i) {
+            if (_anjay_sample_buffers_pending(anjay, &observation->paths[i])) {
+                anjay_log(WARNING,
+                          _("samples of ") "%s" _(" dropped: Content-Format ")
+                                  "%" PRIu16 _(" cannot carry them, observe "
+                                               "with LwM2M JSON or SenML CBOR"),
+                          ANJAY_DEBUG_MAKE_PATH(&observation->paths[i]),
+                          previous->details.format);
+                observation->samples_format_warned = true;
+            }
+        }
+        return 0;
+    }
+    anjay_batch_builder_t *builder = _anjay_batch_builder_new();
+    if (!builder) {
+        anjay_log(ERROR, _("out of memory"));
+        return -1;
+    }
+    int result = 0;
+    for (size_t i = 0; !result && i < observation->paths_count; ++i) {
+        result = _anjay_sample_buffers_collect(anjay, &observation->paths[i],
+                                               ssid, previous->timestamp,
+                                               until, builder);
+    }
+    if (!result && builder->entries_count
+            && !(*out_samples = _anjay_batch_builder_compile(&builder))) {
+        anjay_log(ERROR, _("out of memory"));
+        result = -1;
+    }
+    _anjay_batch_builder_cleanup(&builder);
+    return result;
+}
+#    endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+
 static int
 update_notification_value(anjay_observe_connection_entry_t *conn_state,
                           anjay_observation_t *observation) {
@@ -1491,6 +1859,7 @@ update_notification_value(anjay_observe_connection_entry_t *conn_state,
     anjay_unlocked_t *anjay = _anjay_from_server(conn_state->conn_ref.server);
     anjay_ssid_t ssid = _anjay_server_ssid(conn_state->conn_ref.server);
     anjay_batch_t **batches = NULL;
+    anjay_batch_t *samples = NULL;
     bool should_update_batch = false;
     int32_t pmax = -1;
     anjay_dm_con_attr_t con = ANJAY_DM_CON_ATTR_DEFAULT;
@@ -1516,9 +1885,11 @@ update_notification_value(anjay_observe_connection_entry_t *conn_state,
 
         if (has_epmin_expired(newest_value(observation)->values[i],
                               &attrs.standard.common)) {
-            if ((result = read_observation_path(anjay, &observation->paths[i],
-                                                observation->action, ssid,
-                                                &timestamp, &batches[i]))) {
+            if ((result = read_notification_path(
+                         anjay, observation, i,
+                         has_pmax_expired(newest_value(observation),
+                                          &attrs.standard.common),
+                         ssid, &timestamp, &batches[i]))) {
                 anjay_log(ERROR,
                           _("Could not read path ") "%s" _(" for notifying"),
                           ANJAY_DEBUG_MAKE_PATH(&observation->paths[i]));
@@ -1553,6 +1924,14 @@ update_notification_value(anjay_observe_connection_entry_t *conn_state,
 #    endif // ANJAY_WITH_CON_ATTR
     }
 
+#    ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    if (should_update_batch
+            && (result = collect_samples(anjay, observation, ssid, timestamp,
+                                         &samples))) {
+        goto finish;
+    }
+#    endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+
     if (should_update_batch) {
         if (con < 0 && anjay->observe.confirmable_notifications) {
             con = ANJAY_DM_CON_ATTR_CON;
@@ -1564,7 +1943,12 @@ update_notification_value(anjay_observe_connection_entry_t *conn_state,
         result = insert_new_value(conn_state, observation, reliability_hint,
                                   &newest_value(observation)->details,
                                   &timestamp,
-                                  cast_to_const_batch_array(batches));
+                                  cast_to_const_batch_array(batches), samples);
+#    ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+        if (!result) {
+            forget_read_changes(observation, batches, timestamp);
+        }
+#    endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
     }
 
     if (!result && pmax >= 0) {
@@ -1572,6 +1956,9 @@ update_notification_value(anjay_observe_connection_entry_t *conn_state,
     }
 
 finish:
+    if (samples) {
+        _anjay_batch_release(&samples);
+    }
     delete_batch_array(&batches, observation->paths_count);
     return result;
 }
@@ -1636,6 +2023,9 @@ static int notify_path_changed(anjay_observe_connection_entry_t *connection,
     AVS_LIST_FOREACH(ref, path_entry->refs) {
         assert(ref);
         assert(*ref);
+#    ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+        require_full_read(*ref);
+#    endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
         _anjay_update_ret((int *) result_ptr,
                           schedule_trigger(connection, *ref, period));
     }
@@ -1786,6 +2176,228 @@ int _anjay_observe_notify(anjay_unlocked_t *anjay,
                                notify_path_changed);
 }
 
+typedef struct {
+    uint32_t generation;
+    // intrusive list of observations to schedule, linked via
+    // anjay_observation_t::notify_batch_next
+    anjay_observation_t *pending;
+    // number of schedule_trigger() calls that _anjay_observe_notify() would
+    // have made for the same set of changes
+    uint64_t matches;
+    // path currently being processed
+    const anjay_uri_path_t *changed_path;
+    // if set, changes are only recorded in the matching observations, without
+    // scheduling notifications
+    bool record_only;
+} notify_batch_t;
+
+static int
+notify_path_changed_batched(anjay_observe_connection_entry_t *connection,
+                            anjay_observe_path_entry_t *path_entry,
+                            void *batch_) {
+    notify_batch_t *batch = (notify_batch_t *) batch_;
+#    ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    if (batch->record_only) {
+        AVS_LIST(AVS_RBTREE_ELEM(anjay_observation_t)) ref;
+        AVS_LIST_FOREACH(ref, path_entry->refs) {
+            assert(ref);
+            assert(*ref);
+            mark_path_changed(*ref, batch->changed_path);
+        }
+        return 0;
+    }
+#    endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    // entries already matched by another changed path in this batch only need
+    // to have the change recorded
+    const bool already_matched =
+            (path_entry->notify_batch_generation == batch->generation);
+    int32_t period = 0;
+    if (!already_matched) {
+        path_entry->notify_batch_generation = batch->generation;
+        period = get_oi_attributes(connection, path_entry).min_period;
+        period = AVS_MAX(period, 0);
+    }
+
+    AVS_LIST(AVS_RBTREE_ELEM(anjay_observation_t)) ref;
+    AVS_LIST_FOREACH(ref, path_entry->refs) {
+        assert(ref);
+        assert(*ref);
+        anjay_observation_t *observation = *ref;
+        ++batch->matches;
+#    ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+        mark_path_changed(observation, batch->changed_path);
+#    endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+        if (already_matched) {
+            continue;
+        }
+        if (observation->notify_batch_generation != batch->generation) {
+            observation->notify_batch_generation = batch->generation;
+            observation->notify_batch_period = period;
+            observation->notify_batch_next = batch->pending;
+            batch->pending = observation;
+        } else if (period < observation->notify_batch_period) {
+            observation->notify_batch_period = period;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Matches the Resource changes of a single Object entry from the notify queue
+ * against an observed path of that Object. @p cursor_ptr points to the first
+ * change not below the Instances already visited; entries are visited in
+ * tree order, i.e. by ascending IID, with the Object path itself last.
+ */
+static void notify_object_changes_for_entry(
+        anjay_observe_connection_entry_t *connection,
+        anjay_observe_path_entry_t *path_entry,
+        const anjay_notify_queue_object_entry_t *object_entry,
+        AVS_LIST(anjay_notify_queue_resource_entry_t) *cursor_ptr,
+        notify_batch_t *batch) {
+    const anjay_iid_t iid = path_entry->path.ids[ANJAY_ID_IID];
+    const anjay_rid_t rid = path_entry->path.ids[ANJAY_ID_RID];
+    AVS_LIST(anjay_notify_queue_resource_entry_t) change =
+            object_entry->resources_changed;
+    if (iid != ANJAY_ID_INVALID) {
+        while (*cursor_ptr && (*cursor_ptr)->iid < iid) {
+            *cursor_ptr = AVS_LIST_NEXT(*cursor_ptr);
+        }
+        change = *cursor_ptr;
+    }
+    for (; change && (iid == ANJAY_ID_INVALID || change->iid == iid);
+         change = AVS_LIST_NEXT(change)) {
+        if (rid != ANJAY_ID_INVALID && change->rid != rid) {
+            if (change->rid > rid) {
+                break;
+            }
+            continue;
+        }
+        const anjay_uri_path_t path =
+                MAKE_RESOURCE_PATH(object_entry->oid, change->iid, change->rid);
+        batch->changed_path = &path;
+        notify_path_changed_batched(connection, path_entry, batch);
+    }
+}
+
+static void notify_queue_changes_for_entry(
+        anjay_observe_connection_entry_t *connection,
+        anjay_observe_path_entry_t *path_entry,
+        const anjay_notify_queue_object_entry_t *object_entry,
+        notify_batch_t *batch) {
+    if (object_entry->instance_set_changes.instance_set_changed) {
+        const anjay_uri_path_t path = MAKE_OBJECT_PATH(object_entry->oid);
+        batch->changed_path = &path;
+        notify_path_changed_batched(connection, path_entry, batch);
+    } else {
+        AVS_LIST(anjay_notify_queue_resource_entry_t) change;
+        AVS_LIST_FOREACH(change, object_entry->resources_changed) {
+            const anjay_uri_path_t path =
+                    MAKE_RESOURCE_PATH(object_entry->oid, change->iid,
+                                       change->rid);
+            batch->changed_path = &path;
+            notify_path_changed_batched(connection, path_entry, batch);
+        }
+    }
+}
+
+/**
+ * Matches all changes from @p queue against the observed paths of
+ * @p connection in a single ordered pass over its observed_paths tree.
+ *
+ * The notify queue is kept sorted by OID, and each Object's changes by IID and
+ * RID, without duplicates, so it may be merged with the tree directly: only
+ * the subtrees of the changed Objects are visited, each entry once. The root
+ * path entry, if any, sorts last and matches every change.
+ */
+static void
+notify_queue_for_connection(anjay_observe_connection_entry_t *connection,
+                            anjay_notify_queue_t queue,
+                            notify_batch_t *batch) {
+    AVS_LIST(anjay_notify_queue_object_entry_t) it;
+    AVS_LIST_FOREACH(it, queue) {
+        anjay_uri_path_t lower_bound = MAKE_OBJECT_PATH(it->oid);
+        for (size_t i = ANJAY_ID_IID; i < _ANJAY_URI_PATH_MAX_LENGTH; ++i) {
+            lower_bound.ids[i] = 0;
+        }
+        const anjay_uri_path_t upper_bound = MAKE_OBJECT_PATH(it->oid);
+        AVS_RBTREE_ELEM(anjay_observe_path_entry_t) entry =
+                AVS_RBTREE_LOWER_BOUND(connection->observed_paths,
+                                       path_entry_query(&lower_bound));
+        AVS_RBTREE_ELEM(anjay_observe_path_entry_t) end =
+                AVS_RBTREE_UPPER_BOUND(connection->observed_paths,
+                                       path_entry_query(&upper_bound));
+        AVS_LIST(anjay_notify_queue_resource_entry_t) cursor =
+                it->resources_changed;
+        for (; entry != end; entry = AVS_RBTREE_ELEM_NEXT(entry)) {
+            assert(entry);
+            if (it->instance_set_changes.instance_set_changed) {
+                notify_queue_changes_for_entry(connection, entry, it, batch);
+            } else {
+                notify_object_changes_for_entry(connection, entry, it, &cursor,
+                                                batch);
+            }
+        }
+    }
+
+    AVS_RBTREE_ELEM(anjay_observe_path_entry_t) root =
+            AVS_RBTREE_LAST(connection->observed_paths);
+    if (root && !_anjay_uri_path_length(&root->path)) {
+        AVS_LIST_FOREACH(it, queue) {
+            notify_queue_changes_for_entry(connection, root, it, batch);
+        }
+    }
+    batch->changed_path = NULL;
+}
+
+int _anjay_observe_notify_queue(anjay_unlocked_t *anjay,
+                                anjay_notify_queue_t queue,
+                                anjay_ssid_t ssid,
+                                bool invert_ssid_match) {
+    int result = 0;
+    notify_batch_t batch = {
+        .generation = ++anjay->observe.notify_batch_generation
+    };
+    if (!batch.generation) {
+        // generation 0 is what freshly allocated entries have
+        batch.generation = ++anjay->observe.notify_batch_generation;
+    }
+
+    AVS_LIST(anjay_observe_connection_entry_t) connection;
+    AVS_LIST_FOREACH(connection, anjay->observe.connection_entries) {
+        /* Some compilers complain about promotion of comparison result, so
+         * we're casting it to bool explicitly */
+        if ((bool) (_anjay_server_ssid(connection->conn_ref.server) == ssid)
+                == invert_ssid_match) {
+#    ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+            // e.g. the server that made the change is not notified about it,
+            // but its observations still need the changed values re-read
+            // when notifying about anything else
+            batch.record_only = true;
+            notify_queue_for_connection(connection, queue, &batch);
+            batch.record_only = false;
+#    endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+            continue;
+        }
+        notify_queue_for_connection(connection, queue, &batch);
+
+        uint64_t scheduled = 0;
+        while (batch.pending) {
+            anjay_observation_t *observation = batch.pending;
+            batch.pending = observation->notify_batch_next;
+            observation->notify_batch_next = NULL;
+            _anjay_update_ret(&result,
+                              schedule_trigger(connection, observation,
+                                               observation
+                                                       ->notify_batch_period));
+            ++scheduled;
+        }
+        assert(batch.matches >= scheduled);
+        anjay->observe.coalesced_notify_triggers += batch.matches - scheduled;
+        batch.matches = 0;
+    }
+    return result;
+}
+
 #    ifdef ANJAY_WITH_OBSERVATION_STATUS
 static int get_observe_status(anjay_observe_connection_entry_t *connection,
                               anjay_observe_path_entry_t *entry,
@@ -1837,6 +2449,10 @@ _anjay_observe_status(anjay_unlocked_t *anjay,
 #    endif // ANJAY_WITH_OBSERVATION_STATUS
 
 #    ifdef ANJAY_TEST
+#        include "tests/core/observe/notify_queue.c"
+#        ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+#            include "tests/core/observe/incremental_read.c"
+#        endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
 #        include "tests/core/observe/observe.c"
 #    endif // ANJAY_TEST
 
@@ -20,10 +20,14 @@
 #include <avsystem/commons/avs_persistence.h>
 #include <avsystem/commons/avs_rbtree.h>
 
+#include <anjay_modules/anjay_notify.h>
+
 #include "../anjay_servers_private.h"
 #include "../coap/anjay_msg_details.h"
 #include "../io/anjay_batch_builder.h"
 
+#include "anjay_sample_buffer.h"
+
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
 typedef struct anjay_observation_struct anjay_observation_t;
@@ -41,6 +45,22 @@ typedef struct {
 
     notify_queue_limit_mode_t notify_queue_limit_mode;
     size_t notify_queue_limit;
+
+    // generation counter for _anjay_observe_notify_queue() batches
+    uint32_t notify_batch_generation;
+    // number of notification trigger reschedules avoided by coalescing all
+    // changes from a notify queue; see anjay_get_num_coalesced_notify_triggers
+    uint64_t coalesced_notify_triggers;
+
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    // sorted by path; see anjay_sample_buffer_enable()
+    AVS_LIST(anjay_sample_buffer_t) sample_buffers;
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+
+#ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    // sorted; see anjay_observe_incremental_read_enable()
+    AVS_LIST(anjay_oid_t) incremental_read_oids;
+#endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
 } anjay_observe_state_t;
 
 typedef struct {
@@ -49,6 +69,12 @@ typedef struct {
     avs_coap_notify_reliability_hint_t reliability_hint;
     avs_time_real_t timestamp;
 
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    // Buffered samples taken since the previous value, serialized before
+    // values; NULL if there are none
+    anjay_batch_t *samples;
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+
     // Array size is ref->paths_count for "normal" entry, or 0 for error entry
     // (determined based on is_error_value()). values[i] is a value
     // corresponding to ref->paths[i]. Note that each values[i] element might
@@ -74,6 +100,8 @@ void _anjay_observe_interrupt(anjay_connection_ref_t ref);
 
 bool _anjay_observe_needs_flushing(anjay_connection_ref_t ref);
 
+bool _anjay_observe_has_observations(anjay_connection_ref_t ref);
+
 int _anjay_observe_sched_flush(anjay_connection_ref_t ref);
 
 int _anjay_observe_notify(anjay_unlocked_t *anjay,
@@ -81,6 +109,21 @@ int _anjay_observe_notify(anjay_unlocked_t *anjay,
                           anjay_ssid_t ssid,
                           bool invert_ssid_match);
 
+/**
+ * Equivalent to calling @ref _anjay_observe_notify for every change recorded
+ * in @p queue, but walks observed paths of each connection only once for all
+ * the changes and schedules each affected observation at most once.
+ */
+int _anjay_observe_notify_queue(anjay_unlocked_t *anjay,
+                                anjay_notify_queue_t queue,
+                                anjay_ssid_t ssid,
+                                bool invert_ssid_match);
+
+#    ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+int _anjay_observe_incremental_read_enable(anjay_unlocked_t *anjay,
+                                           anjay_oid_t oid);
+#    endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+
 #    ifdef ANJAY_WITH_OBSERVATION_STATUS
 anjay_resource_observation_status_t
 _anjay_observe_status(anjay_unlocked_t *anjay,
@@ -96,6 +139,7 @@ _anjay_observe_status(anjay_unlocked_t *anjay,
 #    define _anjay_observe_gc(...) ((void) 0)
 #    define _anjay_observe_interrupt(...) ((void) 0)
 #    define _anjay_observe_needs_flushing(...) false
+#    define _anjay_observe_has_observations(...) false
 #    define _anjay_observe_sched_flush(...) 0
 
 #    ifdef ANJAY_WITH_OBSERVATION_STATUS
@@ -25,6 +25,12 @@
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
+#ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+// Maximum number of distinct changed paths tracked per observation between
+// notifications; if more are reported, the observation is read in full
+#    define ANJAY_OBSERVE_MAX_TRACKED_CHANGES 4
+#endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+
 struct anjay_observation_struct {
     const avs_coap_token_t token;
 
@@ -45,6 +51,30 @@ struct anjay_observation_struct {
     // to this resource+format or not)
     AVS_LIST(anjay_observation_value_t) last_unsent;
 
+    // state used by _anjay_observe_notify_queue() to schedule each observation
+    // at most once for a whole batch of changes; only meaningful if
+    // notify_batch_generation is equal to the current batch generation
+    uint32_t notify_batch_generation;
+    int32_t notify_batch_period;
+    anjay_observation_t *notify_batch_next;
+
+#ifdef ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+    // Resource paths reported through the notify queue as changed since the
+    // newest value has been read; only these are re-read on the next trigger.
+    // Everything is read if there are none, i.e. the trigger has not been a
+    // reported change, or if full_read_required is set, e.g. because there
+    // were more changes than fit in the array.
+    anjay_uri_path_t changed_paths[ANJAY_OBSERVE_MAX_TRACKED_CHANGES];
+    uint8_t changed_paths_count;
+    bool full_read_required;
+#endif // ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    // set once it has been logged that buffered samples are not reported,
+    // because the Content-Format of the observation cannot carry them
+    bool samples_format_warned;
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+
     const size_t paths_count;
     const anjay_uri_path_t paths[];
 };
@@ -55,6 +85,10 @@ typedef struct {
     // List of observations (pointers to elements inside
     // anjay_observe_connection_entry_t::observations) that include "path"
     AVS_LIST(AVS_RBTREE_ELEM(anjay_observation_t)) refs;
+
+    // generation of the last _anjay_observe_notify_queue() batch that matched
+    // this entry; used to evaluate each entry only once per batch
+    uint32_t notify_batch_generation;
 } anjay_observe_path_entry_t;
 
 typedef struct {
@@ -63,7 +97,10 @@ typedef struct {
     size_t expected_offset;
     avs_time_real_t serialization_time;
     size_t curr_value_idx;
-    const anjay_batch_data_output_state_t *output_state;
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    bool samples_written;
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    anjay_batch_data_output_state_t output_state;
 } anjay_observation_serialization_state_t;
 
 struct anjay_observe_connection_entry_struct {
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_init.h>
+
+#include <anjay/dm.h>
+
+#include "../anjay_core.h"
+
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+#    include <avsystem/coap/option.h>
+
+#    include "../anjay_access_utils_private.h"
+#    include "../anjay_io_core.h"
+
+#    include "anjay_sample_buffer.h"
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+
+VISIBILITY_SOURCE_BEGIN
+
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+
+void _anjay_sample_buffers_cleanup(AVS_LIST(anjay_sample_buffer_t) *buffers) {
+    AVS_LIST_CLEAR(buffers);
+}
+
+bool _anjay_sample_buffer_format_supported(uint16_t format) {
+    switch (_anjay_translate_legacy_content_format(format)) {
+    case AVS_COAP_FORMAT_OMA_LWM2M_JSON:
+    case AVS_COAP_FORMAT_SENML_CBOR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool _anjay_sample_buffers_pending(anjay_unlocked_t *anjay,
+                                   const anjay_uri_path_t *path) {
+    AVS_LIST(anjay_sample_buffer_t) buffer;
+    AVS_LIST_FOREACH(buffer, anjay->observe.sample_buffers) {
+        if (buffer->count
+                && !_anjay_uri_path_outside_base(&buffer->path, path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static AVS_LIST(anjay_sample_buffer_t) *
+find_buffer_ptr(anjay_unlocked_t *anjay, const anjay_uri_path_t *path) {
+    AVS_LIST(anjay_sample_buffer_t) *buffer_ptr;
+    AVS_LIST_FOREACH_PTR(buffer_ptr, &anjay->observe.sample_buffers) {
+        if (_anjay_uri_path_compare(&(*buffer_ptr)->path, path) >= 0) {
+            break;
+        }
+    }
+    return buffer_ptr;
+}
+
+static int enable_unlocked(anjay_unlocked_t *anjay,
+                           const anjay_uri_path_t *path,
+                           size_t capacity) {
+    AVS_LIST(anjay_sample_buffer_t) *buffer_ptr = find_buffer_ptr(anjay, path);
+    if (*buffer_ptr && _anjay_uri_path_equal(&(*buffer_ptr)->path, path)) {
+        AVS_LIST_DELETE(buffer_ptr);
+    }
+    if (!capacity) {
+        return 0;
+    }
+    AVS_LIST(anjay_sample_buffer_t) buffer =
+            (AVS_LIST(anjay_sample_buffer_t)) AVS_LIST_NEW_BUFFER(
+                    offsetof(anjay_sample_buffer_t, samples)
+                    + capacity * sizeof(anjay_sample_t));
+    if (!buffer) {
+        anjay_log(ERROR, _("out of memory"));
+        return -1;
+    }
+    buffer->path = *path;
+    buffer->capacity = capacity;
+    AVS_LIST_INSERT(buffer_ptr, buffer);
+    return 0;
+}
+
+static int add_unlocked(anjay_unlocked_t *anjay,
+                        const anjay_uri_path_t *path,
+                        const anjay_sample_t *sample) {
+    AVS_LIST(anjay_sample_buffer_t) *buffer_ptr = find_buffer_ptr(anjay, path);
+    if (!*buffer_ptr || !_anjay_uri_path_equal(&(*buffer_ptr)->path, path)) {
+        anjay_log(ERROR, _("sample buffer not enabled for ") "%s",
+                  ANJAY_DEBUG_MAKE_PATH(path));
+        return -1;
+    }
+    anjay_sample_buffer_t *buffer = *buffer_ptr;
+    size_t index = (buffer->first + buffer->count) % buffer->capacity;
+    if (buffer->count < buffer->capacity) {
+        ++buffer->count;
+    } else {
+        buffer->first = (buffer->first + 1) % buffer->capacity;
+    }
+    buffer->samples[index] = *sample;
+    return 0;
+}
+
+static int add_sample_to_batch(anjay_batch_builder_t *builder,
+                               const anjay_uri_path_t *path,
+                               const anjay_sample_t *sample) {
+    switch (sample->type) {
+    case ANJAY_SAMPLE_INT:
+        return _anjay_batch_add_int(builder, path, sample->timestamp,
+                                    sample->value.int_value);
+    case ANJAY_SAMPLE_DOUBLE:
+        return _anjay_batch_add_double(builder, path, sample->timestamp,
+                                       sample->value.double_value);
+    }
+    AVS_UNREACHABLE("invalid sample type");
+    return -1;
+}
+
+int _anjay_sample_buffers_collect(anjay_unlocked_t *anjay,
+                                  const anjay_uri_path_t *path,
+                                  anjay_ssid_t ssid,
+                                  avs_time_real_t since,
+                                  avs_time_real_t until,
+                                  anjay_batch_builder_t *builder) {
+    AVS_LIST(anjay_sample_buffer_t) buffer;
+    AVS_LIST_FOREACH(buffer, anjay->observe.sample_buffers) {
+        if (_anjay_uri_path_outside_base(&buffer->path, path)) {
+            continue;
+        }
+        const anjay_action_info_t info = {
+            .oid = buffer->path.ids[ANJAY_ID_OID],
+            .iid = buffer->path.ids[ANJAY_ID_IID],
+            .ssid = ssid,
+            .action = ANJAY_ACTION_READ
+        };
+        if (!_anjay_instance_action_allowed(anjay, &info)) {
+            continue;
+        }
+        for (size_t i = 0; i < buffer->count; ++i) {
+            const anjay_sample_t *sample =
+                    &buffer->samples[(buffer->first + i) % buffer->capacity];
+            if (!avs_time_real_before(since, sample->timestamp)
+                    || avs_time_real_before(until, sample->timestamp)) {
+                continue;
+            }
+            int result = add_sample_to_batch(builder, &buffer->path, sample);
+            if (result) {
+                return result;
+            }
+        }
+    }
+    return 0;
+}
+
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+
+int anjay_sample_buffer_enable(anjay_t *anjay_locked,
+                               anjay_oid_t oid,
+                               anjay_iid_t iid,
+                               anjay_rid_t rid,
+                               size_t capacity) {
+    int result = -1;
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    const anjay_uri_path_t path = MAKE_RESOURCE_PATH(oid, iid, rid);
+    ANJAY_MUTEX_LOCK(anjay, anjay_locked);
+    result = enable_unlocked(anjay, &path, capacity);
+    ANJAY_MUTEX_UNLOCK(anjay_locked);
+#else  // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    (void) anjay_locked;
+    (void) oid;
+    (void) iid;
+    (void) rid;
+    (void) capacity;
+    anjay_log(ERROR, _("sample buffer support is disabled"));
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    return result;
+}
+
+int anjay_sample_buffer_add_int(anjay_t *anjay_locked,
+                                anjay_oid_t oid,
+                                anjay_iid_t iid,
+                                anjay_rid_t rid,
+                                int64_t value) {
+    int result = -1;
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    const anjay_uri_path_t path = MAKE_RESOURCE_PATH(oid, iid, rid);
+    const anjay_sample_t sample = {
+        .timestamp = avs_time_real_now(),
+        .type = ANJAY_SAMPLE_INT,
+        .value.int_value = value
+    };
+    ANJAY_MUTEX_LOCK(anjay, anjay_locked);
+    result = add_unlocked(anjay, &path, &sample);
+    ANJAY_MUTEX_UNLOCK(anjay_locked);
+#else  // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    (void) anjay_locked;
+    (void) oid;
+    (void) iid;
+    (void) rid;
+    (void) value;
+    anjay_log(ERROR, _("sample buffer support is disabled"));
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    return result;
+}
+
+int anjay_sample_buffer_add_double(anjay_t *anjay_locked,
+                                   anjay_oid_t oid,
+                                   anjay_iid_t iid,
+                                   anjay_rid_t rid,
+                                   double value) {
+    int result = -1;
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    const anjay_uri_path_t path = MAKE_RESOURCE_PATH(oid, iid, rid);
+    const anjay_sample_t sample = {
+        .timestamp = avs_time_real_now(),
+        .type = ANJAY_SAMPLE_DOUBLE,
+        .value.double_value = value
+    };
+    ANJAY_MUTEX_LOCK(anjay, anjay_locked);
+    result = add_unlocked(anjay, &path, &sample);
+    ANJAY_MUTEX_UNLOCK(anjay_locked);
+#else  // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    (void) anjay_locked;
+    (void) oid;
+    (void) iid;
+    (void) rid;
+    (void) value;
+    anjay_log(ERROR, _("sample buffer support is disabled"));
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+    return result;
+}
+
+#if defined(ANJAY_TEST) && defined(ANJAY_WITH_OBSERVE_SAMPLE_BUFFER)
+#    include "tests/core/observe/sample_buffer.c"
+#endif // defined(ANJAY_TEST) && defined(ANJAY_WITH_OBSERVE_SAMPLE_BUFFER)
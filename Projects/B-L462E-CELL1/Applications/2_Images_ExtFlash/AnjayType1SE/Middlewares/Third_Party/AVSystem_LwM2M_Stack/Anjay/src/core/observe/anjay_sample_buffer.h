@@ -0,0 +1,93 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_OBSERVE_SAMPLE_BUFFER_H
+#define ANJAY_OBSERVE_SAMPLE_BUFFER_H
+
+#include <avsystem/commons/avs_list.h>
+#include <avsystem/commons/avs_time.h>
+
+#include "../io/anjay_batch_builder.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+#ifdef ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+
+typedef enum {
+    ANJAY_SAMPLE_INT,
+    ANJAY_SAMPLE_DOUBLE
+} anjay_sample_type_t;
+
+typedef struct {
+    avs_time_real_t timestamp;
+    anjay_sample_type_t type;
+    union {
+        int64_t int_value;
+        double double_value;
+    } value;
+} anjay_sample_t;
+
+/**
+ * Fixed-size ring of timestamped values of a single Resource. When the ring is
+ * full, each new sample overwrites the oldest one.
+ *
+ * Samples are not removed when they are reported. Each observation keeps the
+ * timestamp of its newest value and only picks up the samples taken after it,
+ * so the same ring may be drained independently by any number of
+ * observations.
+ */
+typedef struct {
+    anjay_uri_path_t path;
+    // index of the oldest sample
+    size_t first;
+    size_t count;
+    size_t capacity;
+    anjay_sample_t samples[];
+} anjay_sample_buffer_t;
+
+void _anjay_sample_buffers_cleanup(AVS_LIST(anjay_sample_buffer_t) *buffers);
+
+/**
+ * Checks whether buffered samples can be reported in a given Content-Format,
+ * i.e. whether it is able to carry multiple timestamped records per Resource.
+ */
+bool _anjay_sample_buffer_format_supported(uint16_t format);
+
+/**
+ * Checks whether there are buffered samples of any Resource at or below
+ * @p path.
+ */
+bool _anjay_sample_buffers_pending(anjay_unlocked_t *anjay,
+                                   const anjay_uri_path_t *path);
+
+/**
+ * Adds to @p builder all samples of Resources at or below @p path that have
+ * been taken after @p since, but not after @p until, as long as @p ssid is
+ * allowed to read them. Samples are added in chronological order for each
+ * Resource.
+ */
+int _anjay_sample_buffers_collect(anjay_unlocked_t *anjay,
+                                  const anjay_uri_path_t *path,
+                                  anjay_ssid_t ssid,
+                                  avs_time_real_t since,
+                                  avs_time_real_t until,
+                                  anjay_batch_builder_t *builder);
+
+#endif // ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_OBSERVE_SAMPLE_BUFFER_H */
@@ -39,6 +39,7 @@ void _anjay_server_on_failure(anjay_server_info_t *server,
                               const char *debug_msg) {
     _anjay_server_clean_active_data(server);
     server->refresh_failed = true;
+    server->connection_rebound = false;
 
     if (server->ssid == ANJAY_SSID_BOOTSTRAP) {
         anjay_log(DEBUG,
@@ -65,8 +66,21 @@ void _anjay_server_on_failure(anjay_server_info_t *server,
 static void server_communication_error_job(avs_sched_t *sched,
                                            const void *server_ptr) {
     (void) sched;
-    _anjay_server_on_failure(*(anjay_server_info_t *const *) server_ptr,
-                             "not reachable");
+    anjay_server_info_t *server = *(anjay_server_info_t *const *) server_ptr;
+    // A session identified by a DTLS connection ID may have only lost its
+    // address mapping. Rebind it and retry the Update over the same session
+    // once, before closing it and starting over with a new handshake.
+    if (!server->connection_rebound
+            && avs_is_ok(_anjay_connection_rebind((anjay_connection_ref_t) {
+                   .server = server,
+                   .conn_type = ANJAY_CONNECTION_PRIMARY
+               }))) {
+        server->connection_rebound = true;
+        server->registration_info.update_forced = true;
+        _anjay_active_server_refresh(server);
+        return;
+    }
+    _anjay_server_on_failure(server, "not reachable");
 }
 
 void _anjay_server_on_server_communication_error(anjay_server_info_t *server,
@@ -189,6 +203,7 @@ void _anjay_server_on_updated_registration(anjay_server_info_t *server,
     case ANJAY_REGISTRATION_SUCCESS:
         server->reactivate_time = AVS_TIME_REAL_INVALID;
         server->refresh_failed = false;
+        server->connection_rebound = false;
         // Failure to handle Bootstrap state is not a failure of the
         // Register operation - hence, not checking return value.
         _anjay_bootstrap_notify_regular_connection_available(server->anjay);
@@ -367,6 +382,7 @@ _anjay_servers_create_inactive(anjay_unlocked_t *anjay, anjay_ssid_t ssid) {
             ->transport = ANJAY_SOCKET_TRANSPORT_INVALID;
     new_server->reactivate_time = AVS_TIME_REAL_INVALID;
     new_server->registration_info.lwm2m_version = ANJAY_LWM2M_VERSION_1_0;
+    _anjay_server_apply_restored_registration(new_server);
     return new_server;
 }
 
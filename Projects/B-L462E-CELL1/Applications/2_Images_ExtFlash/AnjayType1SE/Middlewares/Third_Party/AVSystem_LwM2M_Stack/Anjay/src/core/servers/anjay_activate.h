@@ -107,6 +107,19 @@ int _anjay_server_deactivate(anjay_unlocked_t *anjay,
 AVS_LIST(anjay_server_info_t)
 _anjay_servers_create_inactive(anjay_unlocked_t *anjay, anjay_ssid_t ssid);
 
+#if defined(ANJAY_WITH_CORE_PERSISTENCE) \
+        && defined(AVS_COMMONS_WITH_AVS_PERSISTENCE)
+/**
+ * If registration state for the SSID of a freshly created @p server has been
+ * loaded using anjay_registration_state_restore(), moves it into @p server .
+ *
+ * Implemented in anjay_servers_persistence.c.
+ */
+void _anjay_server_apply_restored_registration(anjay_server_info_t *server);
+#else  // ANJAY_WITH_CORE_PERSISTENCE && AVS_COMMONS_WITH_AVS_PERSISTENCE
+#    define _anjay_server_apply_restored_registration(Server) ((void) (Server))
+#endif // ANJAY_WITH_CORE_PERSISTENCE && AVS_COMMONS_WITH_AVS_PERSISTENCE
+
 /**
  * Checks whether now is a right moment to initiate Client Initiated Bootstrap
  * as per requirements in the specification.
@@ -157,12 +157,57 @@ avs_error_t _anjay_server_connection_internal_bring_online(
     if (!session_resumed) {
         _anjay_conn_session_token_reset(&connection->session_token);
     }
+    if (conn_type == ANJAY_CONNECTION_PRIMARY && server->registration_restored) {
+        server->registration_info.session_token = connection->session_token;
+        server->registration_restored = false;
+    }
     anjay_log(INFO, session_resumed ? "resumed connection" : "reconnected");
     connection->state = ANJAY_SERVER_CONNECTION_FRESHLY_CONNECTED;
     connection->needs_observe_flush = true;
     return AVS_OK;
 }
 
+avs_error_t _anjay_connection_rebind(anjay_connection_ref_t conn_ref) {
+    anjay_server_connection_t *connection =
+            _anjay_get_server_connection(conn_ref);
+    avs_net_socket_t *socket =
+            _anjay_connection_internal_get_socket(connection);
+    avs_net_socket_opt_value_t connection_id_used;
+    if (!_anjay_connection_is_online(connection)
+            || avs_is_err(avs_net_socket_get_opt(
+                       socket, AVS_NET_SOCKET_OPT_CONNECTION_ID_USED,
+                       &connection_id_used))
+            || !connection_id_used.flag) {
+        return avs_errno(AVS_ENOTSUP);
+    }
+
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    char port[ANJAY_MAX_URL_PORT_SIZE];
+    avs_error_t err;
+    if (avs_is_err((err = avs_net_socket_get_remote_hostname(socket, host,
+                                                             sizeof(host))))
+            || avs_is_err((err = avs_net_socket_get_remote_port(
+                                   socket, port, sizeof(port))))
+            || avs_is_err((err = avs_net_socket_connect(socket, host, port)))) {
+        anjay_log(WARNING,
+                  _("could not rebind socket for SSID ") "%u" _(
+                          ", reconnecting"),
+                  conn_ref.server->ssid);
+        return err;
+    }
+
+    if (avs_is_err(avs_net_socket_get_local_port(
+                socket, connection->nontransient_state.last_local_port,
+                ANJAY_MAX_URL_PORT_SIZE))) {
+        connection->nontransient_state.last_local_port[0] = '\0';
+    }
+    anjay_log(INFO,
+              _("SSID ") "%u" _(": socket rebound, DTLS session continued with "
+                                "connection ID"),
+              conn_ref.server->ssid);
+    return AVS_OK;
+}
+
 static void connection_cleanup(anjay_unlocked_t *anjay,
                                anjay_server_connection_t *connection) {
     _anjay_connection_internal_clean_socket(anjay, connection);
@@ -215,7 +260,12 @@ recreate_socket(anjay_unlocked_t *anjay,
     socket_config.additional_configuration_clb =
             anjay->additional_tls_config_clb;
     socket_config.server_name_indication = inout_info->sni.sni;
-    socket_config.use_connection_id = anjay->use_connection_id;
+    socket_config.use_connection_id =
+            anjay->use_connection_id_clb
+                    ? anjay->use_connection_id_clb(
+                              inout_info->ssid,
+                              anjay->use_connection_id_clb_arg)
+                    : anjay->use_connection_id;
     socket_config.prng_ctx = anjay->prng_ctx.ctx;
 
     // At this point, inout_info has "global" settings filled,
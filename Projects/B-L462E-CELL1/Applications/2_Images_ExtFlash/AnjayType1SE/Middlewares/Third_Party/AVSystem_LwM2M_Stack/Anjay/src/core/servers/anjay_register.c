@@ -206,11 +206,11 @@ static int dm_payload_writer(size_t payload_offset,
                              void *state_) {
     anjay_registration_async_exchange_state_t *state =
             (anjay_registration_async_exchange_state_t *) state_;
-    size_t length = state->new_params.dm ? strlen(state->new_params.dm) : 0;
+    size_t length = state->new_params.dm ? state->new_params.dm->size : 0;
     assert(payload_offset <= length);
     if ((*out_payload_chunk_size =
                  AVS_MIN(length - payload_offset, payload_buf_size))) {
-        memcpy(payload_buf, &state->new_params.dm[payload_offset],
+        memcpy(payload_buf, &state->new_params.dm->data[payload_offset],
                *out_payload_chunk_size);
     }
     return 0;
@@ -313,8 +313,46 @@ static int query_dm_object(anjay_unlocked_t *anjay,
     return 0;
 }
 
-static int
-query_dm(anjay_unlocked_t *anjay, anjay_lwm2m_version_t version, char **out) {
+static anjay_registration_payload_t *
+registration_payload_ref(anjay_registration_payload_t *payload) {
+    if (payload) {
+        ++payload->refcount;
+    }
+    return payload;
+}
+
+static void
+registration_payload_unref(anjay_registration_payload_t **payload_ptr) {
+    if (*payload_ptr) {
+        assert((*payload_ptr)->refcount > 0);
+        if (!--(*payload_ptr)->refcount) {
+            avs_free(*payload_ptr);
+        }
+        *payload_ptr = NULL;
+    }
+}
+
+anjay_registration_payload_t *_anjay_registration_payload_new(const void *data,
+                                                               size_t size) {
+    anjay_registration_payload_t *payload =
+            (anjay_registration_payload_t *) avs_malloc(
+                    sizeof(anjay_registration_payload_t) + size + 1);
+    if (!payload) {
+        anjay_log(ERROR, _("out of memory"));
+        return NULL;
+    }
+    payload->refcount = 1;
+    payload->size = size;
+    if (size) {
+        memcpy(payload->data, data, size);
+    }
+    payload->data[size] = '\0';
+    return payload;
+}
+
+static int query_dm(anjay_unlocked_t *anjay,
+                    anjay_lwm2m_version_t version,
+                    anjay_registration_payload_t **out) {
     assert(out);
     assert(!*out);
     avs_stream_t *stream = avs_stream_membuf_create();
@@ -324,28 +362,80 @@ query_dm(anjay_unlocked_t *anjay, anjay_lwm2m_version_t version, char **out) {
     }
     int retval;
     void *data = NULL;
+    size_t size = 0;
     if ((retval = _anjay_dm_foreach_object(anjay, query_dm_object,
                                            &(query_dm_args_t) {
                                                .first = true,
                                                .stream = stream,
                                                .version = version
                                            }))
-            || (retval =
-                        (avs_is_ok(avs_stream_write(stream, "\0", 1)) ? 0 : -1))
             || (retval = (avs_is_ok(avs_stream_membuf_take_ownership(
-                                  stream, &data, NULL))
+                                  stream, &data, &size))
                                   ? 0
                                   : -1))) {
         anjay_log(ERROR, _("could not enumerate objects"));
     }
     avs_stream_cleanup(&stream);
-    *out = (char *) data;
+    if (!retval && !(*out = _anjay_registration_payload_new(data, size))) {
+        retval = -1;
+    }
+    avs_free(data);
     return retval;
 }
 
+static bool registration_payload_changes_pending(anjay_unlocked_t *anjay) {
+    return _anjay_notify_queue_instance_set_changed(
+                   anjay->scheduled_notify.queue)
+#ifdef ANJAY_WITH_BOOTSTRAP
+           || _anjay_notify_queue_instance_set_changed(
+                      anjay->bootstrap.notification_queue)
+#endif // ANJAY_WITH_BOOTSTRAP
+            ;
+}
+
+/**
+ * Returns a reference to the Registration payload describing the current state
+ * of the data model. The payload is only rebuilt using query_dm() if the set of
+ * Object Instances might have changed since it was last generated - which is
+ * tracked by _anjay_registration_payload_cache_invalidate() being called from
+ * the notification code - or if it was generated for a different LwM2M
+ * version, so the common case of a periodic Update does not need to walk the
+ * whole data model.
+ */
+static int get_registration_payload(anjay_unlocked_t *anjay,
+                                    anjay_lwm2m_version_t version,
+                                    anjay_registration_payload_t **out) {
+    assert(out);
+    assert(!*out);
+    anjay_registration_payload_cache_t *cache =
+            &anjay->registration_payload_cache;
+    if (registration_payload_changes_pending(anjay)) {
+        // Instance set changes not yet flushed - the cached payload may
+        // already be out of date, and the one built now will be invalidated
+        // once the notifications are performed
+        _anjay_registration_payload_cache_invalidate(anjay);
+    } else if (cache->payload && cache->version == version) {
+        ++cache->hits;
+        *out = registration_payload_ref(cache->payload);
+        return 0;
+    } else {
+        // e.g. servers registered with different LwM2M versions
+        _anjay_registration_payload_cache_invalidate(anjay);
+    }
+    int result = query_dm(anjay, version, &cache->payload);
+    if (!result) {
+        cache->version = version;
+        *out = registration_payload_ref(cache->payload);
+    }
+    return result;
+}
+
+void _anjay_registration_payload_cache_invalidate(anjay_unlocked_t *anjay) {
+    registration_payload_unref(&anjay->registration_payload_cache.payload);
+}
+
 static void update_parameters_cleanup(anjay_update_parameters_t *params) {
-    avs_free(params->dm);
-    params->dm = NULL;
+    registration_payload_unref(&params->dm);
 }
 
 static void
@@ -366,8 +456,9 @@ get_binding_mode_for_version(anjay_server_info_t *server,
 static int update_parameters_init(anjay_server_info_t *server,
                                   anjay_update_parameters_t *out_params) {
     memset(out_params, 0, sizeof(*out_params));
-    if (query_dm(server->anjay, server->registration_info.lwm2m_version,
-                 &out_params->dm)) {
+    if (get_registration_payload(server->anjay,
+                                 server->registration_info.lwm2m_version,
+                                 &out_params->dm)) {
         goto error;
     }
     if (get_server_lifetime(server->anjay, _anjay_server_ssid(server),
@@ -618,7 +709,7 @@ static void move_assign_update_params(anjay_update_parameters_t *out,
     assert(move_in);
     if (out != move_in) {
         if (move_in->dm) {
-            avs_free(out->dm);
+            registration_payload_unref(&out->dm);
             out->dm = move_in->dm;
             move_in->dm = NULL;
         }
@@ -720,8 +811,13 @@ static void do_register(anjay_server_info_t *server,
     register_with_version(server, attempted_version, move_params);
 }
 
-static inline bool dm_caches_equal(const char *left, const char *right) {
-    return strcmp(left ? left : "", right ? right : "") == 0;
+static inline bool
+dm_caches_equal(const anjay_registration_payload_t *left,
+                const anjay_registration_payload_t *right) {
+    // Payloads are shared while the data model does not change, so in the
+    // common case comparing the pointers is enough
+    return left == right
+           || strcmp(left ? left->data : "", right ? right->data : "") == 0;
 }
 
 static avs_error_t
@@ -1213,3 +1309,7 @@ bool anjay_ongoing_registration_exists(anjay_t *anjay_locked) {
     ANJAY_MUTEX_UNLOCK(anjay_locked);
     return result;
 }
+
+#ifdef ANJAY_TEST
+#    include "tests/core/servers/registration_payload.c"
+#endif // ANJAY_TEST
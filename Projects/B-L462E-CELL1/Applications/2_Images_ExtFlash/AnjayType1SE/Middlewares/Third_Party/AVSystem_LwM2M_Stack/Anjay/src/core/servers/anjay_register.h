@@ -29,6 +29,13 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 
 void _anjay_registration_info_cleanup(anjay_registration_info_t *info);
 
+/**
+ * Allocates a new Registration payload with reference count of 1, holding a
+ * copy of @p size bytes of @p data. Returns NULL on out-of-memory condition.
+ */
+anjay_registration_payload_t *_anjay_registration_payload_new(const void *data,
+                                                               size_t size);
+
 void _anjay_registration_exchange_state_cleanup(
         anjay_registration_async_exchange_state_t *state);
 
@@ -397,9 +397,12 @@ int anjay_transport_schedule_reconnect(anjay_t *anjay_locked,
                 };
                 anjay_server_connection_t *connection =
                         _anjay_get_server_connection(ref);
+                // sessions identified by a connection ID survive the change
+                // of the client address, there is no need to reconnect them
                 if (_anjay_connection_internal_get_socket(connection)
                         && _anjay_socket_transport_included(
-                                   transport_set, connection->transport)) {
+                                   transport_set, connection->transport)
+                        && avs_is_err(_anjay_connection_rebind(ref))) {
                     _anjay_connection_suspend(ref);
                 }
             }
@@ -161,6 +161,22 @@ struct anjay_server_info_struct {
      */
     bool refresh_failed;
 
+    /**
+     * True if the primary connection has been rebound by
+     * server_communication_error_job() instead of being closed, and no
+     * registration exchange succeeded since. Only one such attempt is made per
+     * failure, so that an unreachable server eventually gets deactivated.
+     */
+    bool connection_rebound;
+
+    /**
+     * True if registration_info has been loaded using
+     * anjay_registration_state_restore() and not yet bound to a session. The
+     * first session established with the server adopts it, so that the
+     * registration is confirmed with an Update instead of a new Register.
+     */
+    bool registration_restored;
+
     /**
      * Number of attempted (potentially) failed registrations. It is incremented
      * in send_register(), then compared (if non-zero) against "Communication
@@ -0,0 +1,357 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_init.h>
+
+#include <string.h>
+
+#include <avsystem/commons/avs_errno.h>
+#include <avsystem/commons/avs_list.h>
+#include <avsystem/commons/avs_memory.h>
+
+#define ANJAY_SERVERS_INTERNALS
+
+#include "../anjay_servers_inactive.h"
+#include "../anjay_servers_utils.h"
+#include "../observe/anjay_observe_core.h"
+
+#include "anjay_activate.h"
+#include "anjay_connections.h"
+#include "anjay_register.h"
+#include "anjay_servers_internal.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#define persistence_log(level, ...) \
+    _anjay_log(registration_persistence, level, __VA_ARGS__)
+
+#if defined(ANJAY_WITH_CORE_PERSISTENCE) \
+        && defined(AVS_COMMONS_WITH_AVS_PERSISTENCE)
+
+typedef enum {
+    PERSISTENCE_VERSION_0,
+    // DTLS session buffer removed; it holds the session master secret
+    PERSISTENCE_VERSION_1
+} registration_persistence_version_t;
+
+typedef char magic_t[4];
+static const magic_t MAGIC_V1 = { 'R', 'E', 'G', PERSISTENCE_VERSION_1 };
+
+// Only state that is not secret is kept, so that it may be stored in
+// unprotected memory. In particular, the DTLS session is not persisted: the
+// restored registration is confirmed with an Update over a new session.
+struct anjay_restored_registration_struct {
+    anjay_ssid_t ssid;
+    char last_local_port[ANJAY_MAX_URL_PORT_SIZE];
+    anjay_registration_info_t registration_info;
+};
+
+static avs_error_t
+endpoint_path_segment_persistence_handler(avs_persistence_context_t *ctx,
+                                          AVS_LIST(void) *element,
+                                          void *user_data) {
+    (void) user_data;
+    if (avs_persistence_direction(ctx) == AVS_PERSISTENCE_STORE) {
+        char *segment = (char *) (intptr_t) ((const anjay_string_t *) *element)
+                                ->c_str;
+        return avs_persistence_string(ctx, &segment);
+    }
+
+    char *segment = NULL;
+    avs_error_t err = avs_persistence_string(ctx, &segment);
+    if (avs_is_ok(err)) {
+        size_t size = strlen(segment) + 1;
+        if (!(*element = AVS_LIST_NEW_BUFFER(size))) {
+            persistence_log(ERROR, _("out of memory"));
+            err = avs_errno(AVS_ENOMEM);
+        } else {
+            memcpy(((anjay_string_t *) *element)->c_str, segment, size);
+        }
+    }
+    avs_free(segment);
+    return err;
+}
+
+static avs_error_t handle_expire_time(avs_persistence_context_t *ctx,
+                                      avs_time_real_t *expire_time) {
+    int64_t seconds = expire_time->since_real_epoch.seconds;
+    int32_t nanoseconds = expire_time->since_real_epoch.nanoseconds;
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_i64(ctx, &seconds)))
+            || avs_is_err((err = avs_persistence_i32(ctx, &nanoseconds))));
+    if (avs_is_ok(err)) {
+        expire_time->since_real_epoch.seconds = seconds;
+        expire_time->since_real_epoch.nanoseconds = nanoseconds;
+    }
+    return err;
+}
+
+static avs_error_t
+handle_registration_payload(avs_persistence_context_t *ctx,
+                            anjay_registration_payload_t **dm) {
+    if (avs_persistence_direction(ctx) == AVS_PERSISTENCE_STORE) {
+        void *data = *dm ? (*dm)->data : NULL;
+        size_t size = *dm ? (*dm)->size : 0;
+        return avs_persistence_sized_buffer(ctx, &data, &size);
+    }
+
+    void *data = NULL;
+    size_t size = 0;
+    avs_error_t err = avs_persistence_sized_buffer(ctx, &data, &size);
+    if (avs_is_ok(err) && data
+            && !(*dm = _anjay_registration_payload_new(data, size))) {
+        err = avs_errno(AVS_ENOMEM);
+    }
+    avs_free(data);
+    return err;
+}
+
+static avs_error_t handle_registration_info(avs_persistence_context_t *ctx,
+                                            anjay_registration_info_t *info) {
+    uint8_t lwm2m_version = (uint8_t) info->lwm2m_version;
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_custom_allocated_list(
+                                ctx, (AVS_LIST(void) *) &info->endpoint_path,
+                                endpoint_path_segment_persistence_handler, NULL,
+                                NULL)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &lwm2m_version)))
+            || avs_is_err((err = avs_persistence_bool(ctx, &info->queue_mode)))
+            || avs_is_err((err = handle_expire_time(ctx, &info->expire_time)))
+            || avs_is_err((err = avs_persistence_i64(
+                                   ctx, &info->last_update_params.lifetime_s)))
+            || avs_is_err((err = avs_persistence_bytes(
+                                   ctx,
+                                   info->last_update_params.binding_mode.data,
+                                   sizeof(info->last_update_params.binding_mode
+                                                  .data))))
+            || avs_is_err((err = handle_registration_payload(
+                                   ctx, &info->last_update_params.dm))));
+    if (avs_is_ok(err)
+            && avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE) {
+        // LwM2M 1.0 is the only version supported in this configuration
+        if (lwm2m_version == ANJAY_LWM2M_VERSION_1_0) {
+            info->lwm2m_version = ANJAY_LWM2M_VERSION_1_0;
+        } else {
+            persistence_log(WARNING, _("Unsupported LwM2M version: ") "%u",
+                            (unsigned) lwm2m_version);
+            err = avs_errno(AVS_EBADMSG);
+        }
+        if (!memchr(info->last_update_params.binding_mode.data, '\0',
+                    sizeof(info->last_update_params.binding_mode.data))) {
+            err = avs_errno(AVS_EBADMSG);
+        }
+    }
+    return err;
+}
+
+static avs_error_t handle_server(avs_persistence_context_t *ctx,
+                                 anjay_ssid_t *ssid,
+                                 char *last_local_port,
+                                 anjay_registration_info_t *info) {
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_u16(ctx, ssid)))
+            || avs_is_err((err = avs_persistence_bytes(
+                                   ctx, last_local_port,
+                                   ANJAY_MAX_URL_PORT_SIZE)))
+            || avs_is_err((err = handle_registration_info(ctx, info))));
+    if (avs_is_ok(err)
+            && avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE
+            && !memchr(last_local_port, '\0', ANJAY_MAX_URL_PORT_SIZE)) {
+        err = avs_errno(AVS_EBADMSG);
+    }
+    return err;
+}
+
+static bool should_persist(anjay_server_info_t *server) {
+    // Observations are not persisted. The server would not know that they
+    // have been lost unless the client registers anew, so the registration is
+    // only worth keeping if there are none.
+    return server->ssid != ANJAY_SSID_BOOTSTRAP && _anjay_server_active(server)
+           && !_anjay_server_registration_expired(server)
+           && !_anjay_observe_has_observations((anjay_connection_ref_t) {
+                  .server = server,
+                  .conn_type = ANJAY_CONNECTION_PRIMARY
+              });
+}
+
+static avs_error_t store_servers(avs_persistence_context_t *ctx,
+                                 anjay_unlocked_t *anjay) {
+    uint32_t count = 0;
+    AVS_LIST(anjay_server_info_t) server;
+    AVS_LIST_FOREACH(server, anjay->servers->servers) {
+        if (should_persist(server)) {
+            ++count;
+        }
+    }
+    avs_error_t err = avs_persistence_u32(ctx, &count);
+    AVS_LIST_FOREACH(server, anjay->servers->servers) {
+        if (avs_is_err(err)) {
+            break;
+        }
+        if (should_persist(server)) {
+            anjay_server_connection_t *connection =
+                    _anjay_connection_get(&server->connections,
+                                          ANJAY_CONNECTION_PRIMARY);
+            err = handle_server(ctx, &server->ssid,
+                                connection->nontransient_state.last_local_port,
+                                &server->registration_info);
+        }
+    }
+    return err;
+}
+
+static void
+restored_registration_cleanup(AVS_LIST(anjay_restored_registration_t) entry) {
+    _anjay_registration_info_cleanup(&entry->registration_info);
+}
+
+static avs_error_t
+restore_servers(avs_persistence_context_t *ctx,
+                AVS_LIST(anjay_restored_registration_t) *out_entries) {
+    uint32_t count = 0;
+    avs_error_t err = avs_persistence_u32(ctx, &count);
+    AVS_LIST(anjay_restored_registration_t) *tail_ptr = out_entries;
+    while (avs_is_ok(err) && count--) {
+        if (!(*tail_ptr =
+                      AVS_LIST_NEW_ELEMENT(anjay_restored_registration_t))) {
+            persistence_log(ERROR, _("out of memory"));
+            err = avs_errno(AVS_ENOMEM);
+        } else {
+            err = handle_server(ctx, &(*tail_ptr)->ssid,
+                                (*tail_ptr)->last_local_port,
+                                &(*tail_ptr)->registration_info);
+            AVS_LIST_ADVANCE_PTR(&tail_ptr);
+        }
+    }
+    if (avs_is_err(err)) {
+        AVS_LIST_CLEAR(out_entries) {
+            restored_registration_cleanup(*out_entries);
+        }
+    }
+    return err;
+}
+
+avs_error_t anjay_registration_state_persist(anjay_t *anjay_locked,
+                                             avs_stream_t *out_stream) {
+    assert(anjay_locked);
+    avs_error_t err = avs_errno(AVS_EINVAL);
+    ANJAY_MUTEX_LOCK(anjay, anjay_locked);
+    avs_persistence_context_t persist_ctx =
+            avs_persistence_store_context_create(out_stream);
+    if (avs_is_ok((err = avs_persistence_bytes(&persist_ctx,
+                                               (void *) (intptr_t) MAGIC_V1,
+                                               sizeof(MAGIC_V1))))
+            && avs_is_ok((err = store_servers(&persist_ctx, anjay)))) {
+        persistence_log(INFO, _("Registration state persisted"));
+    }
+    ANJAY_MUTEX_UNLOCK(anjay_locked);
+    return err;
+}
+
+avs_error_t anjay_registration_state_restore(anjay_t *anjay_locked,
+                                             avs_stream_t *in_stream) {
+    assert(anjay_locked);
+    avs_error_t err = avs_errno(AVS_EINVAL);
+    ANJAY_MUTEX_LOCK(anjay, anjay_locked);
+    if (anjay->servers->servers) {
+        persistence_log(ERROR, _("Registration state can only be restored "
+                                 "before any server is loaded"));
+        err = avs_errno(AVS_EBADF);
+    } else {
+        avs_persistence_context_t restore_ctx =
+                avs_persistence_restore_context_create(in_stream);
+        AVS_LIST(anjay_restored_registration_t) entries = NULL;
+        magic_t magic_header;
+        if (avs_is_err((err = avs_persistence_bytes(&restore_ctx, magic_header,
+                                                    sizeof(magic_header))))) {
+            persistence_log(WARNING,
+                            _("Could not read registration state header"));
+        } else if (memcmp(magic_header, MAGIC_V1, sizeof(magic_t))) {
+            persistence_log(WARNING, _("Header magic constant mismatch"));
+            err = avs_errno(AVS_EBADMSG);
+        } else if (avs_is_ok(
+                           (err = restore_servers(&restore_ctx, &entries)))) {
+            _anjay_restored_registrations_cleanup(anjay);
+            anjay->restored_registrations = entries;
+            persistence_log(INFO,
+                            _("Registration state restored for ") "%lu" _(
+                                    " server(s)"),
+                            (unsigned long) AVS_LIST_SIZE(entries));
+        }
+    }
+    ANJAY_MUTEX_UNLOCK(anjay_locked);
+    return err;
+}
+
+void _anjay_server_apply_restored_registration(anjay_server_info_t *server) {
+    AVS_LIST(anjay_restored_registration_t) *entry_ptr;
+    AVS_LIST_FOREACH_PTR(entry_ptr, &server->anjay->restored_registrations) {
+        if ((*entry_ptr)->ssid == server->ssid) {
+            break;
+        }
+    }
+    if (!entry_ptr || !*entry_ptr) {
+        return;
+    }
+
+    anjay_server_connection_t *connection =
+            _anjay_connection_get(&server->connections,
+                                  ANJAY_CONNECTION_PRIMARY);
+    memcpy(connection->nontransient_state.last_local_port,
+           (*entry_ptr)->last_local_port,
+           sizeof(connection->nontransient_state.last_local_port));
+
+    _anjay_registration_info_cleanup(&server->registration_info);
+    server->registration_info = (*entry_ptr)->registration_info;
+    // There is no session to resume, so the registration is bound to the
+    // first session established with the server, see
+    // _anjay_server_connection_internal_bring_online().
+    server->registration_restored = true;
+    // The server might have dropped the registration in the meantime, and the
+    // restored expiration time may be meaningless if the real-time clock has
+    // not been preserved, so confirm the registration with an Update.
+    server->registration_info.update_forced = true;
+    AVS_LIST_DELETE(entry_ptr);
+
+    persistence_log(INFO, _("Using restored registration for SSID ") "%u",
+                    server->ssid);
+}
+
+void _anjay_restored_registrations_cleanup(anjay_unlocked_t *anjay) {
+    AVS_LIST_CLEAR(&anjay->restored_registrations) {
+        restored_registration_cleanup(anjay->restored_registrations);
+    }
+}
+
+#else // ANJAY_WITH_CORE_PERSISTENCE && AVS_COMMONS_WITH_AVS_PERSISTENCE
+
+avs_error_t anjay_registration_state_persist(anjay_t *anjay,
+                                             avs_stream_t *out_stream) {
+    (void) anjay;
+    (void) out_stream;
+    persistence_log(ERROR, _("Persistence not compiled in"));
+    return avs_errno(AVS_ENOTSUP);
+}
+
+avs_error_t anjay_registration_state_restore(anjay_t *anjay,
+                                             avs_stream_t *in_stream) {
+    (void) anjay;
+    (void) in_stream;
+    persistence_log(ERROR, _("Persistence not compiled in"));
+    return avs_errno(AVS_ENOTSUP);
+}
+
+#endif // ANJAY_WITH_CORE_PERSISTENCE && AVS_COMMONS_WITH_AVS_PERSISTENCE
@@ -24,6 +24,8 @@
 
 #    include <anjay/access_control.h>
 
+#    include <anjay_modules/anjay_access_utils.h>
+
 #    include "anjay_mod_access_control.h"
 
 #    include <string.h>
@@ -201,6 +203,7 @@ avs_error_t anjay_access_control_restore(anjay_t *anjay_locked,
         err = avs_errno(AVS_EBADMSG);
     } else if (avs_is_ok((err = restore(anjay, ac, in)))) {
         _anjay_access_control_clear_modified(ac);
+        _anjay_acl_index_invalidate(anjay);
         ac_log(INFO, _("Access Control state restored"));
     }
     ANJAY_MUTEX_UNLOCK(anjay_locked);
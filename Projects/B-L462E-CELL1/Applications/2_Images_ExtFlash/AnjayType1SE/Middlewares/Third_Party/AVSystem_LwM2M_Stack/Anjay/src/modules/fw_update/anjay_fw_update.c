@@ -75,6 +75,12 @@ typedef struct fw_repr {
     const char *package_uri;
     bool retry_download_on_expired;
     anjay_download_handle_t download_handle;
+    // ETag of the current PULL download, needed to resume it
+    anjay_etag_t *download_etag;
+    // Set if a PULL download has been suspended and awaits
+    // anjay_fw_update_pull_reconnect(); the user stream is still open
+    bool download_suspended;
+    size_t resume_offset;
     avs_sched_handle_t update_job;
 } fw_repr_t;
 
@@ -217,9 +223,59 @@ static void reset_user_state(anjay_unlocked_t *anjay, fw_repr_t *fw) {
     fw->user_state.handlers->reset(fw->user_state.arg);
     ANJAY_MUTEX_LOCK_AFTER_CALLBACK(anjay_locked);
     set_user_state(&fw->user_state, UPDATE_STATE_IDLE);
+    fw->download_suspended = false;
+    avs_free(fw->download_etag);
+    fw->download_etag = NULL;
 }
 
 #    ifdef ANJAY_WITH_DOWNLOADER
+/**
+ * Returns 0 if the user stream has been left open for the download to be
+ * resumed from fw->resume_offset, or -1 if it has been closed.
+ */
+static int suspend_user_state(anjay_unlocked_t *anjay, fw_repr_t *fw) {
+    if (!fw->user_state.handlers->suspend || !fw->download_etag
+            || fw->user_state.state != UPDATE_STATE_DOWNLOADING) {
+        reset_user_state(anjay, fw);
+        return -1;
+    }
+    int result = -1;
+    size_t resume_offset = 0;
+    ANJAY_MUTEX_UNLOCK_FOR_CALLBACK(anjay_locked, anjay);
+    result = fw->user_state.handlers->suspend(fw->user_state.arg,
+                                              &resume_offset);
+    ANJAY_MUTEX_LOCK_AFTER_CALLBACK(anjay_locked);
+    if (result) {
+        set_user_state(&fw->user_state, UPDATE_STATE_IDLE);
+        avs_free(fw->download_etag);
+        fw->download_etag = NULL;
+        return -1;
+    }
+    fw->download_suspended = true;
+    fw->resume_offset = resume_offset;
+    return 0;
+}
+
+static int remember_etag(fw_repr_t *fw, const anjay_etag_t *etag) {
+    if (!etag) {
+        avs_free(fw->download_etag);
+        fw->download_etag = NULL;
+        return 0;
+    }
+    if (fw->download_etag && fw->download_etag->size == etag->size
+            && !memcmp(fw->download_etag->value, etag->value, etag->size)) {
+        return 0;
+    }
+    anjay_etag_t *copy = anjay_etag_clone(etag);
+    if (!copy) {
+        fw_log(ERROR, _("out of memory"));
+        return -1;
+    }
+    avs_free(fw->download_etag);
+    fw->download_etag = copy;
+    return 0;
+}
+
 static int get_security_config(anjay_unlocked_t *anjay,
                                fw_repr_t *fw,
                                anjay_security_config_t *out_security_config) {
@@ -449,6 +505,8 @@ static avs_error_t download_write_block(anjay_t *anjay_locked,
     int result = -1;
     ANJAY_MUTEX_LOCK(anjay, anjay_locked);
     fw_repr_t *fw = (fw_repr_t *) fw_;
+    // failing to keep the ETag only makes the download non-resumable
+    (void) remember_etag(fw, etag);
     result = user_state_ensure_stream_open(anjay, &fw->user_state,
                                            fw->package_uri, etag);
     if (!result && data_size > 0) {
@@ -503,8 +561,22 @@ static void download_finished(anjay_t *anjay_locked,
             // good enough.
             update_result = ANJAY_FW_UPDATE_RESULT_INVALID_URI;
         }
-        reset_user_state(anjay, fw);
-        if (fw->retry_download_on_expired
+        if (status.result == ANJAY_DOWNLOAD_ERR_FAILED
+                && update_result == ANJAY_FW_UPDATE_RESULT_CONNECTION_LOST) {
+            // network failure: the data downloaded so far is still valid
+            if (!suspend_user_state(anjay, fw)) {
+                // the object stays in the Downloading state
+                fw_log(INFO,
+                       _("download suspended at offset ") "%lu" _(
+                               ", waiting for reconnection"),
+                       (unsigned long) fw->resume_offset);
+            }
+        } else {
+            reset_user_state(anjay, fw);
+        }
+        if (fw->download_suspended) {
+            // resumed by anjay_fw_update_pull_reconnect()
+        } else if (fw->retry_download_on_expired
                 && status.result == ANJAY_DOWNLOAD_ERR_EXPIRED) {
             fw_log(INFO,
                    _("Could not resume firmware download (result = ") "%d" _(
@@ -692,7 +764,9 @@ static int write_firmware(anjay_unlocked_t *anjay,
 
 static void cancel_existing_download_if_in_progress(anjay_unlocked_t *anjay,
                                                     fw_repr_t *fw) {
-    if (fw->state == UPDATE_STATE_DOWNLOADING) {
+    // a suspended download has no handle; the user stream is closed by the
+    // reset that follows
+    if (fw->state == UPDATE_STATE_DOWNLOADING && !fw->download_suspended) {
         AVS_ASSERT(fw->download_handle,
                    "download_handle is NULL - another Write handler called "
                    "during a PUSH-mode download?!");
@@ -910,6 +984,7 @@ static void fw_delete(void *fw_) {
     fw_repr_t *fw = (fw_repr_t *) fw_;
     avs_sched_del(&fw->update_job);
     avs_free((void *) (intptr_t) fw->package_uri);
+    avs_free(fw->download_etag);
     // NOTE: fw itself will be freed when cleaning the objects list
 }
 
@@ -1082,4 +1157,41 @@ int anjay_fw_update_set_result(anjay_t *anjay_locked,
     return retval;
 }
 
+int anjay_fw_update_pull_reconnect(anjay_t *anjay_locked) {
+    assert(anjay_locked);
+    int retval = -1;
+    ANJAY_MUTEX_LOCK(anjay, anjay_locked);
+    const anjay_dm_installed_object_t *obj =
+            _anjay_dm_find_object_by_oid(anjay, ANJAY_DM_OID_FIRMWARE_UPDATE);
+    if (!obj) {
+        fw_log(WARNING, _("Firmware Update object not installed"));
+    } else {
+        fw_repr_t *fw = get_fw(*obj);
+        assert(fw);
+        retval = 0;
+#    ifdef ANJAY_WITH_DOWNLOADER
+        if (fw->download_suspended) {
+            assert(fw->state == UPDATE_STATE_DOWNLOADING);
+            assert(fw->download_etag);
+            fw->download_suspended = false;
+            fw_log(INFO, _("resuming download from offset ") "%lu",
+                   (unsigned long) fw->resume_offset);
+            // schedule_download() uses the ETag only to start the download;
+            // download_write_block() replaces fw->download_etag as needed
+            anjay_etag_t *etag = fw->download_etag;
+            fw->download_etag = NULL;
+            if (schedule_background_anjay_download(anjay, fw,
+                                                   fw->resume_offset, etag)) {
+                fw_log(WARNING, _("Could not resume firmware download"));
+                set_state(anjay, fw, UPDATE_STATE_IDLE);
+                retval = -1;
+            }
+            avs_free(etag);
+        }
+#    endif // ANJAY_WITH_DOWNLOADER
+    }
+    ANJAY_MUTEX_UNLOCK(anjay_locked);
+    return retval;
+}
+
 #endif // ANJAY_WITH_MODULE_FW_UPDATE
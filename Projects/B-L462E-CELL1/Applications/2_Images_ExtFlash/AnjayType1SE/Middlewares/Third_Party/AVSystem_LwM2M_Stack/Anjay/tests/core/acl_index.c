@@ -0,0 +1,254 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_unit_test.h>
+
+/*
+ * A user-implemented Access Control object, backed by g_acl_test, so that the
+ * ACL index can be compared against the direct reads it replaces.
+ */
+
+#define ACL_TEST_MAX_INSTANCES 8
+#define ACL_TEST_MAX_SSID 4
+#define ACL_TEST_TARGET_OID 1000
+
+typedef struct {
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    anjay_ssid_t owner;
+    // indexed by SSID, including ANJAY_SSID_ANY
+    bool acl_present[ACL_TEST_MAX_SSID + 1];
+    anjay_access_mask_t acl[ACL_TEST_MAX_SSID + 1];
+} acl_test_instance_t;
+
+static struct {
+    size_t instance_count;
+    acl_test_instance_t instances[ACL_TEST_MAX_INSTANCES];
+    uint32_t random;
+} g_acl_test;
+
+static uint32_t acl_test_random(uint32_t range) {
+    g_acl_test.random = g_acl_test.random * 1103515245u + 12345u;
+    return (g_acl_test.random >> 8) % range;
+}
+
+static int acl_test_list_instances(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj_ptr,
+                                   anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    for (size_t i = 0; i < g_acl_test.instance_count; ++i) {
+        anjay_dm_emit(ctx, (anjay_iid_t) i);
+    }
+    return 0;
+}
+
+static int acl_test_list_resources(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj_ptr,
+                                   anjay_iid_t iid,
+                                   anjay_dm_resource_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) iid;
+    anjay_dm_emit_res(ctx, ANJAY_DM_RID_ACCESS_CONTROL_OID, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, ANJAY_DM_RID_ACCESS_CONTROL_OIID, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, ANJAY_DM_RID_ACCESS_CONTROL_ACL, ANJAY_DM_RES_RWM,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, ANJAY_DM_RID_ACCESS_CONTROL_OWNER, ANJAY_DM_RES_RW,
+                      ANJAY_DM_RES_PRESENT);
+    return 0;
+}
+
+static int acl_test_resource_read(anjay_t *anjay,
+                                  const anjay_dm_object_def_t *const *obj_ptr,
+                                  anjay_iid_t iid,
+                                  anjay_rid_t rid,
+                                  anjay_riid_t riid,
+                                  anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    const acl_test_instance_t *inst = &g_acl_test.instances[iid];
+    switch (rid) {
+    case ANJAY_DM_RID_ACCESS_CONTROL_OID:
+        return anjay_ret_i64(ctx, inst->oid);
+    case ANJAY_DM_RID_ACCESS_CONTROL_OIID:
+        return anjay_ret_i64(ctx, inst->iid);
+    case ANJAY_DM_RID_ACCESS_CONTROL_ACL:
+        AVS_UNIT_ASSERT_TRUE(riid <= ACL_TEST_MAX_SSID);
+        AVS_UNIT_ASSERT_TRUE(inst->acl_present[riid]);
+        return anjay_ret_i64(ctx, inst->acl[riid]);
+    case ANJAY_DM_RID_ACCESS_CONTROL_OWNER:
+        return anjay_ret_i64(ctx, inst->owner);
+    default:
+        return ANJAY_ERR_NOT_FOUND;
+    }
+}
+
+static int
+acl_test_list_resource_instances(anjay_t *anjay,
+                                 const anjay_dm_object_def_t *const *obj_ptr,
+                                 anjay_iid_t iid,
+                                 anjay_rid_t rid,
+                                 anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    AVS_UNIT_ASSERT_EQUAL(rid, ANJAY_DM_RID_ACCESS_CONTROL_ACL);
+    for (anjay_ssid_t ssid = 0; ssid <= ACL_TEST_MAX_SSID; ++ssid) {
+        if (g_acl_test.instances[iid].acl_present[ssid]) {
+            anjay_dm_emit(ctx, ssid);
+        }
+    }
+    return 0;
+}
+
+static const anjay_dm_object_def_t ACL_TEST_OBJECT = {
+    .oid = ANJAY_DM_OID_ACCESS_CONTROL,
+    .handlers = {
+        .list_instances = acl_test_list_instances,
+        .list_resources = acl_test_list_resources,
+        .resource_read = acl_test_resource_read,
+        .list_resource_instances = acl_test_list_resource_instances
+    }
+};
+
+static const anjay_dm_object_def_t *const ACL_TEST_OBJECT_PTR =
+        &ACL_TEST_OBJECT;
+
+static anjay_t *acl_test_create(void) {
+    memset(&g_acl_test, 0, sizeof(g_acl_test));
+    const anjay_configuration_t config = {
+        .endpoint_name = "acl-index-test"
+    };
+    anjay_t *anjay = anjay_new(&config);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_register_object(anjay, &ACL_TEST_OBJECT_PTR));
+    // flush the notifications about the newly registered object
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_NULL(get_ac_notif_entry(anjay->scheduled_notify.queue));
+    return anjay;
+}
+
+// Few targets and SSIDs, so that duplicates, default entries, empty ACLs and
+// owners without entries all show up
+static void acl_test_randomize(void) {
+    g_acl_test.instance_count = 1 + acl_test_random(ACL_TEST_MAX_INSTANCES);
+    for (size_t i = 0; i < g_acl_test.instance_count; ++i) {
+        acl_test_instance_t *inst = &g_acl_test.instances[i];
+        memset(inst, 0, sizeof(*inst));
+        inst->oid = (anjay_oid_t) (ACL_TEST_TARGET_OID + acl_test_random(2));
+        inst->iid = (anjay_iid_t) acl_test_random(3);
+        inst->owner = (anjay_ssid_t) acl_test_random(ACL_TEST_MAX_SSID + 1);
+        for (anjay_ssid_t ssid = 0; ssid <= ACL_TEST_MAX_SSID; ++ssid) {
+            if (!acl_test_random(3)) {
+                inst->acl_present[ssid] = true;
+                inst->acl[ssid] = (anjay_access_mask_t) acl_test_random(
+                        ANJAY_ACCESS_MASK_FULL + 1);
+            }
+        }
+    }
+}
+
+// Compares every lookup with the result of reading the object directly
+static void acl_test_assert_index_matches(anjay_t *anjay) {
+    const anjay_dm_installed_object_t *ac_obj = get_access_control(anjay);
+    for (anjay_oid_t oid = ACL_TEST_TARGET_OID; oid < ACL_TEST_TARGET_OID + 3;
+         ++oid) {
+        for (anjay_iid_t iid = 0; iid < 4; ++iid) {
+            for (anjay_ssid_t ssid = 1; ssid <= ACL_TEST_MAX_SSID + 1; ++ssid) {
+                anjay_access_mask_t indexed =
+                        access_control_mask(anjay, oid, iid, ssid);
+                AVS_UNIT_ASSERT_EQUAL(anjay->acl_index.state,
+                                      ANJAY_ACL_INDEX_READY);
+
+                anjay->acl_index.state = ANJAY_ACL_INDEX_UNAVAILABLE;
+                AVS_UNIT_ASSERT_TRUE(anjay->acl_index.ac_obj == ac_obj);
+                anjay_access_mask_t direct =
+                        access_control_mask(anjay, oid, iid, ssid);
+                anjay->acl_index.state = ANJAY_ACL_INDEX_READY;
+
+                AVS_UNIT_ASSERT_EQUAL(indexed, direct);
+            }
+        }
+    }
+}
+
+AVS_UNIT_TEST(acl_index, matches_direct_reads) {
+    anjay_t *anjay = acl_test_create();
+    g_acl_test.random = 11;
+    for (unsigned i = 0; i < 500; ++i) {
+        acl_test_randomize();
+        _anjay_acl_index_invalidate(anjay);
+        acl_test_assert_index_matches(anjay);
+    }
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(acl_index, first_instance_for_a_target_wins) {
+    anjay_t *anjay = acl_test_create();
+    g_acl_test.instance_count = 2;
+    for (size_t i = 0; i < 2; ++i) {
+        g_acl_test.instances[i].oid = ACL_TEST_TARGET_OID;
+        g_acl_test.instances[i].iid = 0;
+    }
+    g_acl_test.instances[1].acl_present[1] = true;
+    g_acl_test.instances[1].acl[1] = ANJAY_ACCESS_MASK_READ;
+
+    // the first instance has an empty ACL and no valid owner, so it grants
+    // nothing, and the second one is never looked at
+    g_acl_test.instances[0].owner = ANJAY_SSID_ANY;
+    _anjay_acl_index_invalidate(anjay);
+    AVS_UNIT_ASSERT_EQUAL(access_control_mask(anjay, ACL_TEST_TARGET_OID, 0, 1),
+                          ANJAY_ACCESS_MASK_NONE);
+
+    g_acl_test.instances[0].owner = 1;
+    _anjay_acl_index_invalidate(anjay);
+    AVS_UNIT_ASSERT_EQUAL(access_control_mask(anjay, ACL_TEST_TARGET_OID, 0, 1),
+                          ANJAY_ACCESS_MASK_FULL & ~ANJAY_ACCESS_MASK_CREATE);
+    AVS_UNIT_ASSERT_EQUAL(access_control_mask(anjay, ACL_TEST_TARGET_OID, 0, 2),
+                          ANJAY_ACCESS_MASK_NONE);
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(acl_index, rebuilt_after_access_control_changes) {
+    anjay_t *anjay = acl_test_create();
+    g_acl_test.instance_count = 1;
+    g_acl_test.instances[0].oid = ACL_TEST_TARGET_OID;
+    g_acl_test.instances[0].owner = 2;
+    g_acl_test.instances[0].acl_present[ANJAY_SSID_ANY] = true;
+    g_acl_test.instances[0].acl[ANJAY_SSID_ANY] = ANJAY_ACCESS_MASK_READ;
+    _anjay_acl_index_invalidate(anjay);
+    AVS_UNIT_ASSERT_EQUAL(access_control_mask(anjay, ACL_TEST_TARGET_OID, 0, 1),
+                          ANJAY_ACCESS_MASK_READ);
+    AVS_UNIT_ASSERT_EQUAL(anjay->acl_index.state, ANJAY_ACL_INDEX_READY);
+
+    // the index is not used while the change waits in the notify queue...
+    g_acl_test.instances[0].acl[ANJAY_SSID_ANY] = ANJAY_ACCESS_MASK_WRITE;
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_notify_changed(anjay, ANJAY_DM_OID_ACCESS_CONTROL, 0,
+                                 ANJAY_DM_RID_ACCESS_CONTROL_ACL));
+    AVS_UNIT_ASSERT_EQUAL(access_control_mask(anjay, ACL_TEST_TARGET_OID, 0, 1),
+                          ANJAY_ACCESS_MASK_WRITE);
+
+    // ...and is rebuilt once the queue is flushed
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_EQUAL(anjay->acl_index.state, ANJAY_ACL_INDEX_INVALID);
+    AVS_UNIT_ASSERT_EQUAL(access_control_mask(anjay, ACL_TEST_TARGET_OID, 0, 1),
+                          ANJAY_ACCESS_MASK_WRITE);
+    AVS_UNIT_ASSERT_EQUAL(anjay->acl_index.state, ANJAY_ACL_INDEX_READY);
+    anjay_delete(anjay);
+}
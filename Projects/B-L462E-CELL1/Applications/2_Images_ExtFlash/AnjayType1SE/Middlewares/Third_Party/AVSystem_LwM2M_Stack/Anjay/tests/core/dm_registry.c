@@ -0,0 +1,181 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_unit_test.h>
+
+/*
+ * Checks the sorted object registry against a model of registered OIDs.
+ * Object IDs are picked from a range that Anjay does not register on its own.
+ */
+
+#define REGISTRY_TEST_OID_BASE 30000
+#define REGISTRY_TEST_OID_COUNT 128
+
+static struct {
+    anjay_dm_object_def_t defs[REGISTRY_TEST_OID_COUNT];
+    const anjay_dm_object_def_t *def_ptrs[REGISTRY_TEST_OID_COUNT];
+    // same OIDs as defs, to check that only the registered pointer is
+    // accepted for unregistration
+    anjay_dm_object_def_t other_defs[REGISTRY_TEST_OID_COUNT];
+    const anjay_dm_object_def_t *other_def_ptrs[REGISTRY_TEST_OID_COUNT];
+    bool registered[REGISTRY_TEST_OID_COUNT];
+    // objects registered when the test started
+    size_t initial_count;
+    uint32_t random;
+} g_registry_test;
+
+static uint32_t registry_test_random(uint32_t range) {
+    g_registry_test.random = g_registry_test.random * 1103515245u + 12345u;
+    return (g_registry_test.random >> 8) % range;
+}
+
+typedef struct {
+    anjay_oid_t last_oid;
+    size_t count;
+    size_t test_count;
+} registry_test_foreach_ctx_t;
+
+static int registry_test_foreach_clb(anjay_unlocked_t *anjay,
+                                     const anjay_dm_installed_object_t *obj,
+                                     void *ctx_) {
+    (void) anjay;
+    registry_test_foreach_ctx_t *ctx = (registry_test_foreach_ctx_t *) ctx_;
+    const anjay_oid_t oid = _anjay_dm_installed_object_oid(obj);
+    if (ctx->count) {
+        AVS_UNIT_ASSERT_TRUE(oid > ctx->last_oid);
+    }
+    ctx->last_oid = oid;
+    ++ctx->count;
+    if (oid >= REGISTRY_TEST_OID_BASE
+            && oid < REGISTRY_TEST_OID_BASE + REGISTRY_TEST_OID_COUNT) {
+        AVS_UNIT_ASSERT_TRUE(
+                g_registry_test.registered[oid - REGISTRY_TEST_OID_BASE]);
+        ++ctx->test_count;
+    }
+    return 0;
+}
+
+static size_t registry_test_foreach(anjay_t *anjay,
+                                    registry_test_foreach_ctx_t *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dm_foreach_object(anjay, registry_test_foreach_clb, ctx));
+    return ctx->count;
+}
+
+// Iteration is strictly ascending and lists exactly the registered objects,
+// and lookup finds each of them and nothing else
+static void assert_registry_valid(anjay_t *anjay) {
+    size_t registered = 0;
+    for (size_t i = 0; i < REGISTRY_TEST_OID_COUNT; ++i) {
+        const anjay_oid_t oid = (anjay_oid_t) (REGISTRY_TEST_OID_BASE + i);
+        const anjay_dm_installed_object_t *obj =
+                _anjay_dm_find_object_by_oid(anjay, oid);
+        if (g_registry_test.registered[i]) {
+            AVS_UNIT_ASSERT_NOT_NULL(obj);
+            AVS_UNIT_ASSERT_EQUAL(_anjay_dm_installed_object_oid(obj), oid);
+            ++registered;
+        } else {
+            AVS_UNIT_ASSERT_NULL(obj);
+        }
+    }
+    registry_test_foreach_ctx_t ctx;
+    AVS_UNIT_ASSERT_EQUAL(registry_test_foreach(anjay, &ctx),
+                          g_registry_test.initial_count + registered);
+    AVS_UNIT_ASSERT_EQUAL(ctx.test_count, registered);
+}
+
+static anjay_t *registry_test_create(uint32_t seed) {
+    memset(&g_registry_test, 0, sizeof(g_registry_test));
+    g_registry_test.random = seed;
+    for (size_t i = 0; i < REGISTRY_TEST_OID_COUNT; ++i) {
+        g_registry_test.defs[i].oid =
+                (anjay_oid_t) (REGISTRY_TEST_OID_BASE + i);
+        g_registry_test.def_ptrs[i] = &g_registry_test.defs[i];
+        g_registry_test.other_defs[i].oid =
+                (anjay_oid_t) (REGISTRY_TEST_OID_BASE + i);
+        g_registry_test.other_def_ptrs[i] = &g_registry_test.other_defs[i];
+    }
+    const anjay_configuration_t config = {
+        .endpoint_name = "dm-registry-test"
+    };
+    anjay_t *anjay = anjay_new(&config);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+    registry_test_foreach_ctx_t ctx;
+    g_registry_test.initial_count = registry_test_foreach(anjay, &ctx);
+    AVS_UNIT_ASSERT_EQUAL(ctx.test_count, 0);
+    return anjay;
+}
+
+AVS_UNIT_TEST(dm_registry, random_register_and_unregister) {
+    anjay_t *anjay = registry_test_create(7);
+    for (unsigned step = 0; step < 3000; ++step) {
+        const size_t i = registry_test_random(REGISTRY_TEST_OID_COUNT);
+        // register more often than unregister at first, so that the registry
+        // fills up, then the other way around
+        const bool do_register =
+                registry_test_random(4) < (step < 1500 ? 3 : 1);
+        if (do_register) {
+            int result = anjay_register_object(anjay,
+                                               &g_registry_test.def_ptrs[i]);
+            if (g_registry_test.registered[i]) {
+                AVS_UNIT_ASSERT_FAILED(result);
+            } else {
+                AVS_UNIT_ASSERT_SUCCESS(result);
+                g_registry_test.registered[i] = true;
+            }
+        } else {
+            AVS_UNIT_ASSERT_FAILED(anjay_unregister_object(
+                    anjay, &g_registry_test.other_def_ptrs[i]));
+            int result = anjay_unregister_object(anjay,
+                                                 &g_registry_test.def_ptrs[i]);
+            if (g_registry_test.registered[i]) {
+                AVS_UNIT_ASSERT_SUCCESS(result);
+                g_registry_test.registered[i] = false;
+            } else {
+                AVS_UNIT_ASSERT_FAILED(result);
+            }
+        }
+        assert_registry_valid(anjay);
+    }
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(dm_registry, ascending_and_descending_registration) {
+    anjay_t *anjay = registry_test_create(0);
+    // descending order inserts every object at the front
+    for (size_t i = REGISTRY_TEST_OID_COUNT; i-- > 0;) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                anjay_register_object(anjay, &g_registry_test.def_ptrs[i]));
+        g_registry_test.registered[i] = true;
+    }
+    assert_registry_valid(anjay);
+    // unregister the lowest ones first, from the front of the array
+    for (size_t i = 0; i < REGISTRY_TEST_OID_COUNT; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                anjay_unregister_object(anjay, &g_registry_test.def_ptrs[i]));
+        g_registry_test.registered[i] = false;
+        assert_registry_valid(anjay);
+    }
+    // ascending order appends at the end; anjay_delete() releases the rest
+    for (size_t i = 0; i < REGISTRY_TEST_OID_COUNT; i += 2) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                anjay_register_object(anjay, &g_registry_test.def_ptrs[i]));
+        g_registry_test.registered[i] = true;
+    }
+    assert_registry_valid(anjay);
+    anjay_delete(anjay);
+}
@@ -0,0 +1,409 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_stream_membuf.h>
+#include <avsystem/commons/avs_unit_test.h>
+
+/*
+ * Batches are filled with pseudo-random values of all types, two Resource
+ * Instances per Resource, so that split batches consist of two-entry parts.
+ * Values are only inspected after the builder has been freed, so anything
+ * not copied into the compiled block is caught by the address sanitizer.
+ */
+
+#define BATCH_TEST_OID 1000
+#define BATCH_TEST_MAX_LENGTH 40
+
+static uint32_t batch_test_random(uint32_t *state, uint32_t range) {
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 8) % range;
+}
+
+static void batch_test_emit(anjay_unlocked_output_ctx_t *out,
+                            uint32_t seed,
+                            size_t count) {
+    uint32_t random = seed;
+    for (size_t i = 0; i < count; ++i) {
+        const anjay_uri_path_t path =
+                MAKE_RESOURCE_INSTANCE_PATH(BATCH_TEST_OID, 0,
+                                            (anjay_rid_t) (i / 2),
+                                            (anjay_riid_t) (i % 2));
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_path(out, &path));
+
+        const uint32_t type = batch_test_random(&random, 6);
+        char data[BATCH_TEST_MAX_LENGTH + 1];
+        const size_t length =
+                batch_test_random(&random, BATCH_TEST_MAX_LENGTH + 1);
+        for (size_t j = 0; j < length; ++j) {
+            data[j] = (char) (type == 0 ? batch_test_random(&random, 256)
+                                        : 'a' + batch_test_random(&random, 26));
+        }
+        data[length] = '\0';
+
+        switch (type) {
+        case 0:
+            AVS_UNIT_ASSERT_SUCCESS(
+                    _anjay_ret_bytes_unlocked(out, data, length));
+            break;
+        case 1:
+            AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_string_unlocked(out, data));
+            break;
+        case 2:
+            AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_i64_unlocked(
+                    out, (int64_t) random - (int64_t) INT32_MAX));
+            break;
+        case 3:
+            AVS_UNIT_ASSERT_SUCCESS(
+                    _anjay_ret_double_unlocked(out, (double) random / 7.0));
+            break;
+        case 4:
+            AVS_UNIT_ASSERT_SUCCESS(
+                    _anjay_ret_bool_unlocked(out, random & 1));
+            break;
+        default:
+            AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_objlnk_unlocked(
+                    out, (anjay_oid_t) random, (anjay_iid_t) (random >> 16)));
+            break;
+        }
+    }
+}
+
+static builder_out_ctx_t batch_test_sink(anjay_batch_builder_t *builder) {
+    const avs_time_real_t no_timestamp = AVS_TIME_REAL_INVALID;
+    return builder_out_ctx_new(builder, &MAKE_ROOT_PATH(), &no_timestamp);
+}
+
+static anjay_batch_builder_t *batch_test_build(uint32_t seed, size_t count) {
+    anjay_batch_builder_t *builder = _anjay_batch_builder_new();
+    AVS_UNIT_ASSERT_NOT_NULL(builder);
+    builder_out_ctx_t ctx = batch_test_sink(builder);
+    batch_test_emit((anjay_unlocked_output_ctx_t *) &ctx, seed, count);
+    AVS_UNIT_ASSERT_SUCCESS(output_close((anjay_unlocked_output_ctx_t *) &ctx));
+    return builder;
+}
+
+static anjay_batch_t *batch_test_compile(uint32_t seed, size_t count) {
+    anjay_batch_builder_t *builder = batch_test_build(seed, count);
+    anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+    AVS_UNIT_ASSERT_NULL(builder);
+    return batch;
+}
+
+static anjay_batch_t *batch_test_compile_split(uint32_t seed, size_t count) {
+    anjay_batch_builder_t *builder = batch_test_build(seed, count);
+    anjay_batch_t *batch = _anjay_batch_builder_compile_split(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+    AVS_UNIT_ASSERT_NULL(builder);
+    return batch;
+}
+
+// Checks that the string and bytes values of a regular batch are stored one
+// after another right behind its entries
+static void assert_contiguous(const anjay_batch_t *batch) {
+    AVS_UNIT_ASSERT_EQUAL(batch->parts_count, 0);
+    const anjay_batch_entry_t *entries = batch_entries(batch);
+    AVS_UNIT_ASSERT_TRUE((const void *) (entries + batch->entries_count)
+                         == (const void *) batch_storage(batch));
+    size_t offset = 0;
+    for (size_t i = 0; i < batch->entries_count; ++i) {
+        const size_t size = entry_storage_size(&entries[i]);
+        if (!size) {
+            continue;
+        }
+        AVS_UNIT_ASSERT_EQUAL(entries[i].data.value.bytes.offset, offset);
+        if (entries[i].data.type == ANJAY_BATCH_DATA_STRING) {
+            AVS_UNIT_ASSERT_EQUAL(batch_storage(batch)[offset + size - 1],
+                                  '\0');
+        }
+        offset += size;
+    }
+}
+
+AVS_UNIT_TEST(batch_builder, single_block) {
+    for (uint32_t seed = 1; seed <= 4; ++seed) {
+        anjay_batch_t *batch = batch_test_compile(seed, 100);
+        AVS_UNIT_ASSERT_EQUAL(batch->entries_count, 100);
+        assert_contiguous(batch);
+
+        anjay_batch_t *split = batch_test_compile_split(seed, 100);
+        AVS_UNIT_ASSERT_EQUAL(_anjay_batch_parts_count(split), 50);
+        for (size_t i = 0; i < 50; ++i) {
+            const anjay_batch_t *part = _anjay_batch_part(split, i);
+            AVS_UNIT_ASSERT_EQUAL(part->entries_count, 2);
+            assert_contiguous(part);
+            const anjay_uri_path_t part_path = _anjay_batch_part_path(part);
+            AVS_UNIT_ASSERT_TRUE(_anjay_uri_path_equal(
+                    &part_path,
+                    &MAKE_RESOURCE_PATH(BATCH_TEST_OID, 0, (anjay_rid_t) i)));
+        }
+        AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(batch, split));
+        AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(split, batch));
+
+        _anjay_batch_release(&batch);
+        _anjay_batch_release(&split);
+    }
+
+    // a single part is not worth splitting
+    anjay_batch_t *single = batch_test_compile_split(5, 2);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_batch_parts_count(single), 0);
+    assert_contiguous(single);
+    _anjay_batch_release(&single);
+
+    anjay_batch_t *empty = batch_test_compile(5, 0);
+    AVS_UNIT_ASSERT_EQUAL(empty->entries_count, 0);
+    _anjay_batch_release(&empty);
+}
+
+AVS_UNIT_TEST(batch_builder, failed_add_leaves_builder_intact) {
+    anjay_batch_builder_t *builder = batch_test_build(1, 3);
+    const size_t entries_count = builder->entries_count;
+    const size_t storage_size = builder->storage_size;
+    const avs_time_real_t now = avs_time_real_now();
+
+    // values must pertain to a Resource
+    AVS_UNIT_ASSERT_FAILED(_anjay_batch_add_string(
+            builder, &MAKE_INSTANCE_PATH(BATCH_TEST_OID, 0), now, "value"));
+    AVS_UNIT_ASSERT_EQUAL(builder->entries_count, entries_count);
+    AVS_UNIT_ASSERT_EQUAL(builder->storage_size, storage_size);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_string(
+            builder, &MAKE_RESOURCE_PATH(BATCH_TEST_OID, 0, 9), now, "value"));
+    AVS_UNIT_ASSERT_EQUAL(builder->entries_count, entries_count + 1);
+    AVS_UNIT_ASSERT_EQUAL(builder->storage_size,
+                          storage_size + sizeof("value"));
+    _anjay_batch_builder_cleanup(&builder);
+    AVS_UNIT_ASSERT_NULL(builder);
+}
+
+static anjay_batch_t *batch_test_single(anjay_batch_builder_t *builder) {
+    anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+    return batch;
+}
+
+AVS_UNIT_TEST(batch_builder, values_equal) {
+    const anjay_uri_path_t path = MAKE_RESOURCE_PATH(BATCH_TEST_OID, 0, 1);
+    const avs_time_real_t now = avs_time_real_now();
+    anjay_batch_builder_t *builder;
+
+    builder = _anjay_batch_builder_new();
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_string(builder, &path, now, "ab"));
+    anjay_batch_t *string = batch_test_single(builder);
+
+    builder = _anjay_batch_builder_new();
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_string(builder, &path, now, "ac"));
+    anjay_batch_t *other_string = batch_test_single(builder);
+
+    builder = _anjay_batch_builder_new();
+    builder_out_ctx_t ctx = batch_test_sink(builder);
+    anjay_unlocked_output_ctx_t *out = (anjay_unlocked_output_ctx_t *) &ctx;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_path(out, &path));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_bytes_unlocked(out, "ab", 2));
+    anjay_batch_t *bytes = batch_test_single(builder);
+
+    builder = _anjay_batch_builder_new();
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(builder, &path, now, 42));
+    anjay_batch_t *integer = batch_test_single(builder);
+
+    builder = _anjay_batch_builder_new();
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_double(builder, &path, now, 42.0));
+    anjay_batch_t *floating = batch_test_single(builder);
+
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(string, other_string));
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(string, bytes));
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(integer, floating));
+    AVS_UNIT_ASSERT_EQUAL(_anjay_batch_data_numeric_value(integer), 42.0);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_batch_data_numeric_value(floating), 42.0);
+    AVS_UNIT_ASSERT_TRUE(isnan(_anjay_batch_data_numeric_value(string)));
+
+    // the same data built twice
+    anjay_batch_t *batch = batch_test_compile(7, 20);
+    anjay_batch_t *same = batch_test_compile(7, 20);
+    anjay_batch_t *different = batch_test_compile(8, 20);
+    anjay_batch_t *shorter = batch_test_compile(7, 19);
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(batch, same));
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(batch, different));
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(batch, shorter));
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(shorter, batch));
+
+    // parts shared between split and composed batches
+    anjay_batch_t *split = batch_test_compile_split(7, 20);
+    anjay_batch_t *other_split = batch_test_compile_split(8, 20);
+    anjay_batch_t *parts[10];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(parts); ++i) {
+        parts[i] = _anjay_batch_acquire(_anjay_batch_part(split, i));
+    }
+    anjay_batch_t *composed =
+            _anjay_batch_compose(parts, AVS_ARRAY_SIZE(parts));
+    AVS_UNIT_ASSERT_NOT_NULL(composed);
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(composed, split));
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(composed, batch));
+
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(parts); ++i) {
+        parts[i] = _anjay_batch_acquire(_anjay_batch_part(
+                i == 3 ? other_split : split, i));
+    }
+    anjay_batch_t *changed = _anjay_batch_compose(parts, AVS_ARRAY_SIZE(parts));
+    AVS_UNIT_ASSERT_NOT_NULL(changed);
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(
+            _anjay_batch_part(split, 3), _anjay_batch_part(other_split, 3)));
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(changed, split));
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(changed, batch));
+    // releasing the split batch does not free the parts still in use
+    _anjay_batch_release(&split);
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(composed, batch));
+
+    _anjay_batch_release(&string);
+    _anjay_batch_release(&other_string);
+    _anjay_batch_release(&bytes);
+    _anjay_batch_release(&integer);
+    _anjay_batch_release(&floating);
+    _anjay_batch_release(&batch);
+    _anjay_batch_release(&same);
+    _anjay_batch_release(&different);
+    _anjay_batch_release(&shorter);
+    _anjay_batch_release(&other_split);
+    _anjay_batch_release(&composed);
+    _anjay_batch_release(&changed);
+}
+
+static anjay_t *batch_test_anjay_create(void) {
+    const anjay_configuration_t config = {
+        .endpoint_name = "batch-builder-test"
+    };
+    anjay_t *anjay = anjay_new(&config);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+    return anjay;
+}
+
+AVS_UNIT_TEST(batch_builder, output_resumes_at_next_entry) {
+    anjay_t *anjay = batch_test_anjay_create();
+    anjay_batch_t *split = batch_test_compile_split(3, 30);
+
+    anjay_batch_builder_t *builder = _anjay_batch_builder_new();
+    AVS_UNIT_ASSERT_NOT_NULL(builder);
+    builder_out_ctx_t ctx = batch_test_sink(builder);
+    const avs_time_real_t serialization_time = avs_time_real_now();
+    anjay_batch_data_output_state_t state = {
+        .in_progress = false
+    };
+    size_t calls = 0;
+    do {
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_data_output_entry(
+                anjay, split, ANJAY_SSID_BOOTSTRAP, serialization_time, &state,
+                (anjay_unlocked_output_ctx_t *) &ctx));
+        ++calls;
+        if (state.in_progress) {
+            AVS_UNIT_ASSERT_EQUAL(state.part_index, calls / 2);
+            AVS_UNIT_ASSERT_EQUAL(state.entry_index, calls % 2);
+        }
+    } while (state.in_progress);
+    AVS_UNIT_ASSERT_EQUAL(calls, 30);
+    AVS_UNIT_ASSERT_SUCCESS(output_close((anjay_unlocked_output_ctx_t *) &ctx));
+
+    anjay_batch_t *copy = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(copy);
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(copy, split));
+
+    _anjay_batch_release(&copy);
+    _anjay_batch_release(&split);
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(batch_builder, security_entries_are_skipped) {
+    anjay_t *anjay = batch_test_anjay_create();
+    const avs_time_real_t now = avs_time_real_now();
+    anjay_batch_builder_t *builder = batch_test_build(4, 6);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_string(
+            builder, &MAKE_RESOURCE_PATH(ANJAY_DM_OID_SECURITY, 0, 0), now,
+            "coaps://server"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(
+            builder, &MAKE_RESOURCE_PATH(ANJAY_DM_OID_SECURITY, 0, 10), now,
+            1));
+    anjay_batch_t *batch = _anjay_batch_builder_compile_split(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+
+    builder = _anjay_batch_builder_new();
+    AVS_UNIT_ASSERT_NOT_NULL(builder);
+    builder_out_ctx_t ctx = batch_test_sink(builder);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_data_output(
+            anjay, batch, ANJAY_SSID_BOOTSTRAP,
+            (anjay_unlocked_output_ctx_t *) &ctx));
+    AVS_UNIT_ASSERT_SUCCESS(output_close((anjay_unlocked_output_ctx_t *) &ctx));
+    anjay_batch_t *copy = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(copy);
+
+    anjay_batch_t *expected = batch_test_compile(4, 6);
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(copy, expected));
+
+    _anjay_batch_release(&expected);
+    _anjay_batch_release(&copy);
+    _anjay_batch_release(&batch);
+    anjay_delete(anjay);
+}
+
+#ifdef ANJAY_WITH_CBOR
+static void batch_test_take_data(avs_stream_t **stream,
+                                 void **out_data,
+                                 size_t *out_size) {
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_membuf_take_ownership(*stream, out_data, out_size));
+    avs_stream_cleanup(stream);
+}
+
+AVS_UNIT_TEST(batch_builder, output_matches_direct_serialization) {
+    anjay_t *anjay = batch_test_anjay_create();
+    for (uint32_t seed = 1; seed <= 4; ++seed) {
+        const anjay_uri_path_t root = MAKE_OBJECT_PATH(BATCH_TEST_OID);
+
+        avs_stream_t *expected_stream = avs_stream_membuf_create();
+        AVS_UNIT_ASSERT_NOT_NULL(expected_stream);
+        anjay_unlocked_output_ctx_t *out = _anjay_output_senml_like_create(
+                expected_stream, &root, AVS_COAP_FORMAT_SENML_CBOR);
+        AVS_UNIT_ASSERT_NOT_NULL(out);
+        batch_test_emit(out, seed, 100);
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+        void *expected;
+        size_t expected_size;
+        batch_test_take_data(&expected_stream, &expected, &expected_size);
+
+        anjay_batch_t *batches[] = {
+            batch_test_compile(seed, 100),
+            batch_test_compile_split(seed, 100)
+        };
+        for (size_t i = 0; i < AVS_ARRAY_SIZE(batches); ++i) {
+            avs_stream_t *stream = avs_stream_membuf_create();
+            AVS_UNIT_ASSERT_NOT_NULL(stream);
+            out = _anjay_output_senml_like_create(stream, &root,
+                                                  AVS_COAP_FORMAT_SENML_CBOR);
+            AVS_UNIT_ASSERT_NOT_NULL(out);
+            AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_data_output(
+                    anjay, batches[i], ANJAY_SSID_BOOTSTRAP, out));
+            AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+            void *data;
+            size_t size;
+            batch_test_take_data(&stream, &data, &size);
+            AVS_UNIT_ASSERT_EQUAL(size, expected_size);
+            AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, expected, expected_size);
+            avs_free(data);
+            _anjay_batch_release(&batches[i]);
+        }
+        avs_free(expected);
+    }
+    anjay_delete(anjay);
+}
+#endif // ANJAY_WITH_CBOR
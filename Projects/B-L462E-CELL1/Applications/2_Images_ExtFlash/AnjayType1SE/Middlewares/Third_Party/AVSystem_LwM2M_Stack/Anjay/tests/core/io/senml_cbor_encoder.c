@@ -0,0 +1,190 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_stream_membuf.h>
+#include <avsystem/commons/avs_unit_test.h>
+
+/*
+ * SenML CBOR output is compared against hand-encoded records; labels are
+ * the RFC 8428 integer keys, e.g. 0x21 (-2) for Base Name.
+ */
+
+typedef struct {
+    avs_stream_t *stream;
+    anjay_unlocked_output_ctx_t *out;
+} senml_cbor_test_env_t;
+
+static senml_cbor_test_env_t senml_cbor_test_create(anjay_uri_path_t uri) {
+    senml_cbor_test_env_t env;
+    env.stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(env.stream);
+    env.out = _anjay_output_senml_like_create(env.stream, &uri,
+                                              AVS_COAP_FORMAT_SENML_CBOR);
+    AVS_UNIT_ASSERT_NOT_NULL(env.out);
+    return env;
+}
+
+static void senml_cbor_test_set_path(senml_cbor_test_env_t *env,
+                                     anjay_uri_path_t path) {
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_path(env->out, &path));
+}
+
+static void senml_cbor_test_verify(avs_stream_t **stream,
+                                   const void *expected,
+                                   size_t expected_size) {
+    void *data = NULL;
+    size_t size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_membuf_take_ownership(*stream, &data, &size));
+    AVS_UNIT_ASSERT_EQUAL(size, expected_size);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, expected, expected_size);
+    avs_free(data);
+    avs_stream_cleanup(stream);
+}
+
+#define SENML_CBOR_TEST_FINISH(Env, Expected)                             \
+    do {                                                                  \
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&(Env)->out));  \
+        senml_cbor_test_verify(&(Env)->stream, (Expected),                \
+                               sizeof(Expected) - 1);                     \
+    } while (0)
+
+AVS_UNIT_TEST(senml_cbor_encoder, empty) {
+    senml_cbor_test_env_t env =
+            senml_cbor_test_create(MAKE_INSTANCE_PATH(3303, 0));
+    SENML_CBOR_TEST_FINISH(&env, "\x9F\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_encoder, value_types) {
+    senml_cbor_test_env_t env =
+            senml_cbor_test_create(MAKE_INSTANCE_PATH(3303, 0));
+
+    senml_cbor_test_set_path(&env, MAKE_RESOURCE_PATH(3303, 0, 5700));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_double_unlocked(env.out, 21.5));
+    senml_cbor_test_set_path(&env, MAKE_RESOURCE_PATH(3303, 0, 5701));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_string_unlocked(env.out, "Cel"));
+    senml_cbor_test_set_path(&env, MAKE_RESOURCE_PATH(3303, 0, 5850));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_bool_unlocked(env.out, true));
+    senml_cbor_test_set_path(&env, MAKE_RESOURCE_PATH(3303, 0, 5601));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_i64_unlocked(env.out, -300));
+    senml_cbor_test_set_path(&env, MAKE_RESOURCE_PATH(3303, 0, 6));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_objlnk_unlocked(env.out, 1, 2));
+    senml_cbor_test_set_path(&env, MAKE_RESOURCE_PATH(3303, 0, 5602));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_double_unlocked(env.out, 0.1));
+    senml_cbor_test_set_path(&env,
+                             MAKE_RESOURCE_INSTANCE_PATH(3303, 0, 7, 1));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_ret_bytes_unlocked(env.out, "\x01\x02\x03", 3));
+
+    SENML_CBOR_TEST_FINISH(&env,
+                           "\x9F"
+                           // {bn: "/3303/0", n: "/5700", v: 21.5f}
+                           "\xA3\x21\x67/3303/0\x00\x65/5700"
+                           "\x02\xFA\x41\xAC\x00\x00"
+                           // {n: "/5701", vs: "Cel"}
+                           "\xA2\x00\x65/5701\x03\x63" "Cel"
+                           // {n: "/5850", vb: true}
+                           "\xA2\x00\x65/5850\x04\xF5"
+                           // {n: "/5601", v: -300}
+                           "\xA2\x00\x65/5601\x02\x39\x01\x2B"
+                           // {n: "/6", "vlo": "1:2"}
+                           "\xA2\x00\x62/6\x63vlo\x63" "1:2"
+                           // {n: "/5602", v: 0.1}, not representable as float
+                           "\xA2\x00\x65/5602"
+                           "\x02\xFB\x3F\xB9\x99\x99\x99\x99\x99\x9A"
+                           // {n: "/7/1", vd: h'010203'}
+                           "\xA2\x00\x64/7/1\x08\x43\x01\x02\x03"
+                           "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_encoder, times_relative_to_base_time) {
+    senml_cbor_test_env_t env =
+            senml_cbor_test_create(MAKE_INSTANCE_PATH(3303, 0));
+
+    senml_cbor_test_set_path(&env, MAKE_RESOURCE_PATH(3303, 0, 5700));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_time(env.out, 1600000000.0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_double_unlocked(env.out, 1.0));
+    senml_cbor_test_set_path(&env, MAKE_RESOURCE_PATH(3303, 0, 5701));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_time(env.out, 1600000005.0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_double_unlocked(env.out, 2.0));
+    senml_cbor_test_set_path(&env, MAKE_RESOURCE_PATH(3303, 0, 5702));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_time(env.out, 1600000000.25));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_double_unlocked(env.out, 3.0));
+    senml_cbor_test_set_path(&env, MAKE_RESOURCE_PATH(3303, 0, 5703));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_double_unlocked(env.out, 4.0));
+
+    SENML_CBOR_TEST_FINISH(&env,
+                           "\x9F"
+                           // {bn: "/3303/0", bt: 1600000000, n: "/5700",
+                           //  v: 1.0f}
+                           "\xA4\x21\x67/3303/0\x22\x1A\x5F\x5E\x10\x00"
+                           "\x00\x65/5700\x02\xFA\x3F\x80\x00\x00"
+                           // {n: "/5701", t: 5, v: 2.0f}
+                           "\xA3\x00\x65/5701\x06\x05"
+                           "\x02\xFA\x40\x00\x00\x00"
+                           // {n: "/5702", t: 0.25f, v: 3.0f}
+                           "\xA3\x00\x65/5702\x06\xFA\x3E\x80\x00\x00"
+                           "\x02\xFA\x40\x40\x00\x00"
+                           // no time: {n: "/5703", t: -1600000000, v: 4.0f},
+                           // so that it resolves to 0, i.e. "now"
+                           "\xA3\x00\x65/5703\x06\x3A\x5F\x5E\x0F\xFF"
+                           "\x02\xFA\x40\x80\x00\x00"
+                           "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_encoder, wide_integers) {
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    anjay_senml_like_encoder_t *encoder =
+            _anjay_senml_cbor_encoder_new(stream);
+    AVS_UNIT_ASSERT_NOT_NULL(encoder);
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_senml_like_element_begin(encoder, NULL, "/1", NAN));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_senml_like_encode_int(encoder, INT64_C(5000000000)));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_senml_like_element_end(encoder));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_senml_like_element_begin(encoder, NULL, "/2", NAN));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_senml_like_encode_int(encoder, INT64_MIN));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_senml_like_element_end(encoder));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_senml_like_element_begin(encoder, NULL, "/3", NAN));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_senml_like_encode_int(encoder, 65536));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_senml_like_element_end(encoder));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_senml_like_encoder_cleanup(&encoder));
+
+    static const char expected[] =
+            "\x9F"
+            "\xA2\x00\x62/1\x02\x1B\x00\x00\x00\x01\x2A\x05\xF2\x00"
+            "\xA2\x00\x62/2\x02\x3B\x7F\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+            "\xA2\x00\x62/3\x02\x1A\x00\x01\x00\x00"
+            "\xFF";
+    senml_cbor_test_verify(&stream, expected, sizeof(expected) - 1);
+}
+
+AVS_UNIT_TEST(senml_cbor_encoder, bytes_length_mismatch) {
+    senml_cbor_test_env_t env =
+            senml_cbor_test_create(MAKE_INSTANCE_PATH(3303, 0));
+    senml_cbor_test_set_path(&env, MAKE_RESOURCE_PATH(3303, 0, 7));
+    anjay_unlocked_ret_bytes_ctx_t *bytes =
+            _anjay_ret_bytes_begin_unlocked(env.out, 4);
+    AVS_UNIT_ASSERT_NOT_NULL(bytes);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_bytes_append_unlocked(bytes, "ab", 2));
+    AVS_UNIT_ASSERT_FAILED(_anjay_ret_bytes_append_unlocked(bytes, "cde", 3));
+    AVS_UNIT_ASSERT_FAILED(_anjay_output_ctx_destroy(&env.out));
+    avs_stream_cleanup(&env.stream);
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_stream_membuf.h>
+#include <avsystem/commons/avs_unit_test.h>
+
+/*
+ * Tests for serializing nested TLV levels through the shared buffer, i.e.
+ * Object and Object Instance reads, with entries whose headers are shorter
+ * than the space reserved for them.
+ */
+
+typedef struct {
+    avs_stream_t *stream;
+    anjay_unlocked_output_ctx_t *out;
+} tlv_buffer_test_env_t;
+
+static tlv_buffer_test_env_t tlv_buffer_test_create(anjay_uri_path_t uri) {
+    tlv_buffer_test_env_t env;
+    env.stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(env.stream);
+    env.out = _anjay_output_tlv_create(env.stream, &uri);
+    AVS_UNIT_ASSERT_NOT_NULL(env.out);
+    return env;
+}
+
+// Finishes serialization and checks that the result is exactly @p expected
+static void tlv_buffer_test_finish(tlv_buffer_test_env_t *env,
+                                   const void *expected,
+                                   size_t expected_size) {
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&env->out));
+    void *data = NULL;
+    size_t size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_membuf_take_ownership(env->stream, &data, &size));
+    AVS_UNIT_ASSERT_EQUAL(size, expected_size);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, expected, expected_size);
+    avs_free(data);
+    avs_stream_cleanup(&env->stream);
+}
+
+static void tlv_buffer_test_set_path(tlv_buffer_test_env_t *env,
+                                     anjay_uri_path_t path) {
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_path(env->out, &path));
+}
+
+#define TLV_BUFFER_TEST_FINISH(Env, Expected) \
+    tlv_buffer_test_finish((Env), (Expected), sizeof(Expected) - 1)
+
+AVS_UNIT_TEST(tlv_out_buffer, object_with_nested_levels) {
+    tlv_buffer_test_env_t env = tlv_buffer_test_create(MAKE_OBJECT_PATH(3));
+
+    tlv_buffer_test_set_path(&env, MAKE_RESOURCE_PATH(3, 0, 0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_string_unlocked(env.out, "ab"));
+    tlv_buffer_test_set_path(&env, MAKE_RESOURCE_INSTANCE_PATH(3, 0, 7, 0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_i64_unlocked(env.out, 1));
+    tlv_buffer_test_set_path(&env, MAKE_RESOURCE_INSTANCE_PATH(3, 0, 7, 1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_i64_unlocked(env.out, 300));
+    tlv_buffer_test_set_path(&env, MAKE_RESOURCE_PATH(3, 0, 8));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_start_aggregate(env.out));
+    tlv_buffer_test_set_path(&env, MAKE_RESOURCE_PATH(3, 0, 300));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_i64_unlocked(env.out, 5));
+    tlv_buffer_test_set_path(&env, MAKE_RESOURCE_PATH(3, 2, 1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_i64_unlocked(env.out, -1));
+
+    TLV_BUFFER_TEST_FINISH(&env,
+                           // Instance 0, 19 bytes
+                           "\x08\x00\x13"
+                           // Resource 0 = "ab"
+                           "\xC2\x00"
+                           "ab"
+                           // Resource 7, 7 bytes
+                           "\x87\x07"
+                           // Resource Instance 0 = 1
+                           "\x41\x00\x01"
+                           // Resource Instance 1 = 300
+                           "\x42\x01\x01\x2C"
+                           // Resource 8, no instances
+                           "\x80\x08"
+                           // Resource 300 = 5
+                           "\xE1\x01\x2C\x05"
+                           // Instance 2, 3 bytes
+                           "\x03\x02"
+                           // Resource 1 = -1
+                           "\xC1\x01\xFF");
+}
+
+AVS_UNIT_TEST(tlv_out_buffer, long_entries_use_wider_length_fields) {
+    static char data[70000];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (char) i;
+    }
+    tlv_buffer_test_env_t env = tlv_buffer_test_create(MAKE_OBJECT_PATH(5));
+
+    // 300 bytes, written in chunks
+    tlv_buffer_test_set_path(&env, MAKE_RESOURCE_PATH(5, 0, 1));
+    anjay_unlocked_ret_bytes_ctx_t *bytes =
+            _anjay_ret_bytes_begin_unlocked(env.out, 300);
+    AVS_UNIT_ASSERT_NOT_NULL(bytes);
+    for (size_t offset = 0; offset < 300; offset += 100) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                _anjay_ret_bytes_append_unlocked(bytes, &data[offset], 100));
+    }
+    // 70000 bytes, in a Multiple Resource
+    tlv_buffer_test_set_path(&env, MAKE_RESOURCE_INSTANCE_PATH(5, 0, 2, 256));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_ret_bytes_unlocked(env.out, data, sizeof(data)));
+
+    char *expected = (char *) avs_malloc(sizeof(data) + 320);
+    AVS_UNIT_ASSERT_NOT_NULL(expected);
+    char *ptr = expected;
+    // Instance 0: 304 + 70011 = 70315 bytes
+    memcpy(ptr, "\x18\x00\x01\x12\xAB", 5);
+    ptr += 5;
+    // Resource 1: 300 bytes
+    memcpy(ptr, "\xD0\x01\x01\x2C", 4);
+    ptr += 4;
+    memcpy(ptr, data, 300);
+    ptr += 300;
+    // Resource 2: 70000 + 6 bytes
+    memcpy(ptr, "\x98\x02\x01\x11\x76", 5);
+    ptr += 5;
+    // Resource Instance 256: 70000 bytes
+    memcpy(ptr, "\x78\x01\x00\x01\x11\x70", 6);
+    ptr += 6;
+    memcpy(ptr, data, sizeof(data));
+    ptr += sizeof(data);
+
+    tlv_buffer_test_finish(&env, expected, (size_t) (ptr - expected));
+    avs_free(expected);
+}
+
+AVS_UNIT_TEST(tlv_out_buffer, many_instances_reuse_the_buffer) {
+    tlv_buffer_test_env_t env = tlv_buffer_test_create(MAKE_OBJECT_PATH(3303));
+    for (anjay_iid_t iid = 0; iid < 64; ++iid) {
+        for (anjay_rid_t rid = 0; rid < 20; ++rid) {
+            tlv_buffer_test_set_path(&env,
+                                     MAKE_RESOURCE_PATH(3303, iid, rid));
+            AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_i64_unlocked(env.out, iid));
+        }
+    }
+
+    // every Instance: header (3 bytes) + 20 * Resource (3 bytes)
+    static char expected[64 * 63];
+    for (size_t iid = 0; iid < 64; ++iid) {
+        char *instance = &expected[iid * 63];
+        instance[0] = '\x08';
+        instance[1] = (char) iid;
+        instance[2] = 60;
+        for (size_t rid = 0; rid < 20; ++rid) {
+            instance[3 + 3 * rid] = '\xC1';
+            instance[4 + 3 * rid] = (char) rid;
+            instance[5 + 3 * rid] = (char) iid;
+        }
+    }
+    tlv_buffer_test_finish(&env, expected, sizeof(expected));
+}
+
+AVS_UNIT_TEST(tlv_out_buffer, incomplete_bytes_fail) {
+    tlv_buffer_test_env_t env =
+            tlv_buffer_test_create(MAKE_INSTANCE_PATH(3, 0));
+    tlv_buffer_test_set_path(&env, MAKE_RESOURCE_INSTANCE_PATH(3, 0, 1, 0));
+    anjay_unlocked_ret_bytes_ctx_t *bytes =
+            _anjay_ret_bytes_begin_unlocked(env.out, 4);
+    AVS_UNIT_ASSERT_NOT_NULL(bytes);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_ret_bytes_append_unlocked(bytes, "ab", 2));
+    AVS_UNIT_ASSERT_FAILED(_anjay_output_ctx_destroy(&env.out));
+    avs_stream_cleanup(&env.stream);
+}
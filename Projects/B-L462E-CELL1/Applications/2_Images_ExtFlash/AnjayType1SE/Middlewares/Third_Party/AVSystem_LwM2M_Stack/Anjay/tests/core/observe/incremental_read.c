@@ -0,0 +1,363 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_unit_test.h>
+
+/*
+ * Notifications are built with read_notification_path() the way
+ * update_notification_value() does, and compared against a full read of the
+ * data model, while counting which Resources have actually been read.
+ *
+ * Both test Objects have the same Instances and Resources; incremental reads
+ * are only enabled for the first one. Values read for an Object or Instance
+ * path are split into a part for each Instance entry and each Resource.
+ */
+
+#define INCREMENTAL_TEST_OID 30100
+#define INCREMENTAL_TEST_OTHER_OID 30101
+#define INCREMENTAL_TEST_INSTANCES 2
+#define INCREMENTAL_TEST_RESOURCES 6
+
+static struct {
+    int64_t values[INCREMENTAL_TEST_INSTANCES][INCREMENTAL_TEST_RESOURCES];
+    bool absent[INCREMENTAL_TEST_INSTANCES][INCREMENTAL_TEST_RESOURCES];
+    unsigned reads[INCREMENTAL_TEST_INSTANCES][INCREMENTAL_TEST_RESOURCES];
+} g_incremental_test;
+
+static int
+incremental_test_list_instances(anjay_t *anjay,
+                                const anjay_dm_object_def_t *const *obj,
+                                anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj;
+    for (anjay_iid_t iid = 0; iid < INCREMENTAL_TEST_INSTANCES; ++iid) {
+        anjay_dm_emit(ctx, iid);
+    }
+    return 0;
+}
+
+static int
+incremental_test_list_resources(anjay_t *anjay,
+                                const anjay_dm_object_def_t *const *obj,
+                                anjay_iid_t iid,
+                                anjay_dm_resource_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj;
+    for (anjay_rid_t rid = 0; rid < INCREMENTAL_TEST_RESOURCES; ++rid) {
+        anjay_dm_emit_res(ctx, rid, ANJAY_DM_RES_R,
+                          g_incremental_test.absent[iid][rid]
+                                  ? ANJAY_DM_RES_ABSENT
+                                  : ANJAY_DM_RES_PRESENT);
+    }
+    return 0;
+}
+
+static int
+incremental_test_resource_read(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *obj,
+                               anjay_iid_t iid,
+                               anjay_rid_t rid,
+                               anjay_riid_t riid,
+                               anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj;
+    (void) riid;
+    ++g_incremental_test.reads[iid][rid];
+    return anjay_ret_i64(ctx, g_incremental_test.values[iid][rid]);
+}
+
+#define INCREMENTAL_TEST_HANDLERS                             \
+    {                                                         \
+        .list_instances = incremental_test_list_instances,    \
+        .list_resources = incremental_test_list_resources,    \
+        .resource_read = incremental_test_resource_read       \
+    }
+
+static const anjay_dm_object_def_t INCREMENTAL_TEST_OBJECT = {
+    .oid = INCREMENTAL_TEST_OID,
+    .handlers = INCREMENTAL_TEST_HANDLERS
+};
+static const anjay_dm_object_def_t *const INCREMENTAL_TEST_OBJECT_PTR =
+        &INCREMENTAL_TEST_OBJECT;
+
+static const anjay_dm_object_def_t INCREMENTAL_TEST_OTHER_OBJECT = {
+    .oid = INCREMENTAL_TEST_OTHER_OID,
+    .handlers = INCREMENTAL_TEST_HANDLERS
+};
+static const anjay_dm_object_def_t *const INCREMENTAL_TEST_OTHER_OBJECT_PTR =
+        &INCREMENTAL_TEST_OTHER_OBJECT;
+
+static anjay_t *incremental_test_create(void) {
+    memset(&g_incremental_test, 0, sizeof(g_incremental_test));
+    for (size_t i = 0; i < INCREMENTAL_TEST_INSTANCES; ++i) {
+        for (size_t r = 0; r < INCREMENTAL_TEST_RESOURCES; ++r) {
+            g_incremental_test.values[i][r] = (int64_t) (100 * i + r);
+        }
+    }
+    const anjay_configuration_t config = {
+        .endpoint_name = "incremental-read-test"
+    };
+    anjay_t *anjay = anjay_new(&config);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_register_object(anjay, &INCREMENTAL_TEST_OBJECT_PTR));
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_register_object(anjay, &INCREMENTAL_TEST_OTHER_OBJECT_PTR));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_observe_incremental_read_enable(anjay,
+                                                   INCREMENTAL_TEST_OID));
+    return anjay;
+}
+
+static anjay_batch_t *incremental_test_full_read(anjay_t *anjay,
+                                                 anjay_uri_path_t path) {
+    anjay_batch_t *batch = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(read_observation_path(anjay, &path,
+                                                  ANJAY_ACTION_READ,
+                                                  ANJAY_SSID_BOOTSTRAP, NULL,
+                                                  &batch));
+    return batch;
+}
+
+static void incremental_test_set_value(anjay_observation_t *observation,
+                                       anjay_batch_t *batch) {
+    const anjay_msg_details_t details = {
+        .msg_code = AVS_COAP_CODE_CONTENT
+    };
+    const avs_time_real_t timestamp = avs_time_real_now();
+    if (observation->last_sent) {
+        delete_value(&observation->last_sent);
+    }
+    observation->last_sent = create_observation_value(
+            &details, AVS_COAP_NOTIFY_PREFER_NON_CONFIRMABLE, observation,
+            &timestamp, (const anjay_batch_t *const *) &batch, NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(observation->last_sent);
+    _anjay_batch_release(&batch);
+}
+
+static anjay_observation_t *incremental_test_observe(anjay_t *anjay,
+                                                     anjay_uri_path_t path) {
+    const avs_coap_token_t token = {
+        .size = 1,
+        .bytes = "t"
+    };
+    const paths_arg_t paths_arg = {
+        .type = PATHS_POINTER_ARRAY,
+        .paths = &path,
+        .count = 1
+    };
+    AVS_RBTREE_ELEM(anjay_observation_t) observation =
+            create_detached_observation(&token, ANJAY_ACTION_READ, &paths_arg);
+    AVS_UNIT_ASSERT_NOT_NULL(observation);
+    incremental_test_set_value(observation,
+                               incremental_test_full_read(anjay, path));
+    return observation;
+}
+
+static void incremental_test_cleanup(anjay_observation_t *observation) {
+    AVS_RBTREE_ELEM(anjay_observation_t) elem = observation;
+    delete_value(&elem->last_sent);
+    AVS_RBTREE_ELEM_DELETE_DETACHED(&elem);
+}
+
+static void incremental_test_change(anjay_observation_t *observation,
+                                    anjay_iid_t iid,
+                                    anjay_rid_t rid) {
+    const anjay_oid_t oid = observation->paths[0].ids[ANJAY_ID_OID];
+    g_incremental_test.values[iid][rid] += 1000;
+    mark_path_changed(observation, &MAKE_RESOURCE_PATH(oid, iid, rid));
+}
+
+static bool incremental_test_has_part(const anjay_batch_t *batch,
+                                      anjay_uri_path_t path) {
+    for (size_t i = 0; i < _anjay_batch_parts_count(batch); ++i) {
+        const anjay_uri_path_t part_path =
+                _anjay_batch_part_path(_anjay_batch_part(batch, i));
+        if (_anjay_uri_path_equal(&part_path, &path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static unsigned incremental_test_reads(anjay_iid_t iid, anjay_rid_t rid) {
+    return g_incremental_test.reads[iid][rid];
+}
+
+static unsigned incremental_test_total_reads(void) {
+    unsigned total = 0;
+    for (size_t i = 0; i < INCREMENTAL_TEST_INSTANCES; ++i) {
+        for (size_t r = 0; r < INCREMENTAL_TEST_RESOURCES; ++r) {
+            total += g_incremental_test.reads[i][r];
+        }
+    }
+    return total;
+}
+
+// Builds the next value of the observation, checks that it is the same as
+// a full read, and stores it as the newest one; read counters are left as
+// they were after building the value
+static void incremental_test_notify(anjay_t *anjay,
+                                    anjay_observation_t *observation,
+                                    bool full_read) {
+    memset(g_incremental_test.reads, 0, sizeof(g_incremental_test.reads));
+    const avs_time_real_t timestamp = avs_time_real_now();
+    anjay_batch_t *batch = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(read_notification_path(anjay, observation, 0,
+                                                   full_read,
+                                                   ANJAY_SSID_BOOTSTRAP,
+                                                   &timestamp, &batch));
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+
+    unsigned reads[INCREMENTAL_TEST_INSTANCES][INCREMENTAL_TEST_RESOURCES];
+    memcpy(reads, g_incremental_test.reads, sizeof(reads));
+    anjay_batch_t *expected =
+            incremental_test_full_read(anjay, observation->paths[0]);
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(batch, expected));
+    _anjay_batch_release(&expected);
+    memcpy(g_incremental_test.reads, reads, sizeof(reads));
+
+    forget_read_changes(observation, &batch, timestamp);
+    incremental_test_set_value(observation, batch);
+}
+
+AVS_UNIT_TEST(observe_incremental_read, rereads_only_changed_resources) {
+    anjay_t *anjay = incremental_test_create();
+    anjay_observation_t *observation =
+            incremental_test_observe(anjay,
+                                     MAKE_OBJECT_PATH(INCREMENTAL_TEST_OID));
+    const anjay_batch_t *previous = observation->last_sent->values[0];
+    AVS_UNIT_ASSERT_EQUAL(_anjay_batch_parts_count(previous),
+                          INCREMENTAL_TEST_INSTANCES
+                                  * (1 + INCREMENTAL_TEST_RESOURCES));
+    anjay_batch_t *previous_ref = _anjay_batch_acquire(previous);
+
+    incremental_test_change(observation, 0, 2);
+    incremental_test_change(observation, 1, 4);
+    incremental_test_notify(anjay, observation, false);
+    AVS_UNIT_ASSERT_EQUAL(incremental_test_reads(0, 2), 1);
+    AVS_UNIT_ASSERT_EQUAL(incremental_test_reads(1, 4), 1);
+    AVS_UNIT_ASSERT_EQUAL(incremental_test_total_reads(), 2);
+    AVS_UNIT_ASSERT_EQUAL(observation->changed_paths_count, 0);
+
+    // unchanged Resources are shared with the previous value
+    const anjay_batch_t *current = observation->last_sent->values[0];
+    AVS_UNIT_ASSERT_EQUAL(_anjay_batch_parts_count(current),
+                          _anjay_batch_parts_count(previous));
+    for (size_t i = 0; i < _anjay_batch_parts_count(current); ++i) {
+        const anjay_uri_path_t part_path =
+                _anjay_batch_part_path(_anjay_batch_part(current, i));
+        const bool changed =
+                _anjay_uri_path_equal(&part_path,
+                                      &MAKE_RESOURCE_PATH(INCREMENTAL_TEST_OID,
+                                                          0, 2))
+                || _anjay_uri_path_equal(
+                           &part_path,
+                           &MAKE_RESOURCE_PATH(INCREMENTAL_TEST_OID, 1, 4));
+        AVS_UNIT_ASSERT_TRUE((_anjay_batch_part(current, i)
+                              == _anjay_batch_part(previous, i))
+                             == !changed);
+    }
+    _anjay_batch_release(&previous_ref);
+
+    // with no recorded changes, e.g. on pmax, everything is read again
+    incremental_test_notify(anjay, observation, false);
+    AVS_UNIT_ASSERT_EQUAL(incremental_test_total_reads(),
+                          INCREMENTAL_TEST_INSTANCES
+                                  * INCREMENTAL_TEST_RESOURCES);
+    incremental_test_cleanup(observation);
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(observe_incremental_read, unchanged_path_is_not_read) {
+    anjay_t *anjay = incremental_test_create();
+    anjay_observation_t *observation = incremental_test_observe(
+            anjay, MAKE_INSTANCE_PATH(INCREMENTAL_TEST_OID, 0));
+    anjay_batch_t *previous =
+            _anjay_batch_acquire(observation->last_sent->values[0]);
+
+    // a change of another Instance does not concern this observation
+    incremental_test_change(observation, 1, 0);
+    incremental_test_notify(anjay, observation, false);
+    AVS_UNIT_ASSERT_EQUAL(incremental_test_total_reads(), 0);
+    AVS_UNIT_ASSERT_TRUE(observation->last_sent->values[0] == previous);
+    _anjay_batch_release(&previous);
+    incremental_test_cleanup(observation);
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(observe_incremental_read, full_read_fallbacks) {
+    anjay_t *anjay = incremental_test_create();
+    const anjay_uri_path_t path = MAKE_INSTANCE_PATH(INCREMENTAL_TEST_OID, 0);
+    anjay_observation_t *observation = incremental_test_observe(anjay, path);
+
+    // pmax expired
+    incremental_test_change(observation, 0, 1);
+    incremental_test_notify(anjay, observation, true);
+    AVS_UNIT_ASSERT_EQUAL(incremental_test_total_reads(),
+                          INCREMENTAL_TEST_RESOURCES);
+    AVS_UNIT_ASSERT_EQUAL(observation->changed_paths_count, 0);
+
+    // Instance set changed
+    mark_path_changed(observation, &MAKE_OBJECT_PATH(INCREMENTAL_TEST_OID));
+    AVS_UNIT_ASSERT_TRUE(observation->full_read_required);
+    incremental_test_notify(anjay, observation, false);
+    AVS_UNIT_ASSERT_EQUAL(incremental_test_total_reads(),
+                          INCREMENTAL_TEST_RESOURCES);
+    AVS_UNIT_ASSERT_FALSE(observation->full_read_required);
+
+    // more changes than can be tracked
+    for (anjay_rid_t rid = 0; rid <= ANJAY_OBSERVE_MAX_TRACKED_CHANGES;
+         ++rid) {
+        incremental_test_change(observation, 0, rid);
+    }
+    AVS_UNIT_ASSERT_TRUE(observation->full_read_required);
+    incremental_test_notify(anjay, observation, false);
+    AVS_UNIT_ASSERT_EQUAL(incremental_test_total_reads(),
+                          INCREMENTAL_TEST_RESOURCES);
+
+    // changed Resource missing from the previous value
+    g_incremental_test.absent[0][5] = true;
+    incremental_test_notify(anjay, observation, true);
+    g_incremental_test.absent[0][5] = false;
+    incremental_test_change(observation, 0, 5);
+    incremental_test_notify(anjay, observation, false);
+    AVS_UNIT_ASSERT_EQUAL(incremental_test_total_reads(),
+                          INCREMENTAL_TEST_RESOURCES);
+    AVS_UNIT_ASSERT_TRUE(incremental_test_has_part(
+            observation->last_sent->values[0],
+            MAKE_RESOURCE_PATH(INCREMENTAL_TEST_OID, 0, 5)));
+
+    // changed Resource no longer present
+    incremental_test_change(observation, 0, 3);
+    g_incremental_test.absent[0][3] = true;
+    incremental_test_notify(anjay, observation, false);
+    AVS_UNIT_ASSERT_FALSE(incremental_test_has_part(
+            observation->last_sent->values[0],
+            MAKE_RESOURCE_PATH(INCREMENTAL_TEST_OID, 0, 3)));
+    g_incremental_test.absent[0][3] = false;
+    incremental_test_cleanup(observation);
+
+    // Object for which incremental reads have not been enabled
+    observation = incremental_test_observe(
+            anjay, MAKE_INSTANCE_PATH(INCREMENTAL_TEST_OTHER_OID, 0));
+    incremental_test_change(observation, 0, 1);
+    incremental_test_notify(anjay, observation, false);
+    AVS_UNIT_ASSERT_EQUAL(incremental_test_total_reads(),
+                          INCREMENTAL_TEST_RESOURCES);
+    incremental_test_cleanup(observation);
+    anjay_delete(anjay);
+}
@@ -0,0 +1,381 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_unit_test.h>
+
+#include <anjay/stats.h>
+
+#include "src/core/servers/anjay_servers_internal.h"
+
+/*
+ * Checks that handling a whole notify queue at once schedules exactly the
+ * observations that _anjay_observe_notify() would schedule for each change
+ * separately, each of them once, with the smallest pmin of all matched paths.
+ *
+ * Observations are attached directly to the connection of a bare server
+ * entry. Objects below NOTIFY_QUEUE_TEST_OIDS - 1 are registered and report
+ * pmin that depends on the Object and Instance; the last one is not.
+ */
+
+#define NOTIFY_QUEUE_TEST_OID_BASE 30000
+#define NOTIFY_QUEUE_TEST_OIDS 4
+#define NOTIFY_QUEUE_TEST_IDS 3
+#define NOTIFY_QUEUE_TEST_OBSERVATIONS 24
+#define NOTIFY_QUEUE_TEST_MAX_PATHS 3
+#define NOTIFY_QUEUE_TEST_SSID 1
+
+static struct {
+    anjay_dm_object_def_t defs[NOTIFY_QUEUE_TEST_OIDS - 1];
+    const anjay_dm_object_def_t *def_ptrs[NOTIFY_QUEUE_TEST_OIDS - 1];
+    anjay_server_info_t server;
+    anjay_observe_connection_entry_t *connection;
+    avs_time_monotonic_t created;
+    // outcome computed with observe_for_each_matching()
+    uint64_t expected_matches;
+    bool expected_scheduled[NOTIFY_QUEUE_TEST_OBSERVATIONS];
+    int32_t expected_period[NOTIFY_QUEUE_TEST_OBSERVATIONS];
+    uint32_t random;
+} g_notify_queue_test;
+
+static uint32_t notify_queue_test_random(uint32_t range) {
+    g_notify_queue_test.random =
+            g_notify_queue_test.random * 1103515245u + 12345u;
+    return (g_notify_queue_test.random >> 8) % range;
+}
+
+static int
+notify_queue_test_list_instances(anjay_t *anjay,
+                                 const anjay_dm_object_def_t *const *obj,
+                                 anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj;
+    for (anjay_iid_t iid = 0; iid < NOTIFY_QUEUE_TEST_IDS; ++iid) {
+        anjay_dm_emit(ctx, iid);
+    }
+    return 0;
+}
+
+static int
+notify_queue_test_object_attrs(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *obj,
+                               anjay_ssid_t ssid,
+                               anjay_dm_oi_attributes_t *out) {
+    (void) anjay;
+    (void) ssid;
+    out->min_period = 2 + (*obj)->oid % 3;
+    out->max_period = 60;
+    return 0;
+}
+
+// Instance 1 inherits pmin from the Object
+static int
+notify_queue_test_instance_attrs(anjay_t *anjay,
+                                 const anjay_dm_object_def_t *const *obj,
+                                 anjay_iid_t iid,
+                                 anjay_ssid_t ssid,
+                                 anjay_dm_oi_attributes_t *out) {
+    (void) anjay;
+    (void) ssid;
+    if (iid != 1) {
+        out->min_period = (iid + (*obj)->oid) % 4;
+    }
+    return 0;
+}
+
+static size_t notify_queue_test_index(const anjay_observation_t *observation) {
+    uint32_t index;
+    AVS_UNIT_ASSERT_EQUAL(observation->token.size, sizeof(index));
+    memcpy(&index, observation->token.bytes, sizeof(index));
+    AVS_UNIT_ASSERT_TRUE(index < NOTIFY_QUEUE_TEST_OBSERVATIONS);
+    return index;
+}
+
+static anjay_uri_path_t notify_queue_test_random_path(void) {
+    const anjay_oid_t oid = (anjay_oid_t) (NOTIFY_QUEUE_TEST_OID_BASE
+                                           + notify_queue_test_random(
+                                                     NOTIFY_QUEUE_TEST_OIDS));
+    const anjay_iid_t iid =
+            (anjay_iid_t) notify_queue_test_random(NOTIFY_QUEUE_TEST_IDS);
+    const anjay_rid_t rid =
+            (anjay_rid_t) notify_queue_test_random(NOTIFY_QUEUE_TEST_IDS);
+    // the root path is observed rarely, so that most observations differ
+    const uint32_t kind = notify_queue_test_random(16);
+    if (kind < 1) {
+        return MAKE_ROOT_PATH();
+    } else if (kind < 4) {
+        return MAKE_OBJECT_PATH(oid);
+    } else if (kind < 9) {
+        return MAKE_INSTANCE_PATH(oid, iid);
+    } else if (kind < 15) {
+        return MAKE_RESOURCE_PATH(oid, iid, rid);
+    } else {
+        return MAKE_RESOURCE_INSTANCE_PATH(oid, iid, rid, 0);
+    }
+}
+
+static void notify_queue_test_add_observation(uint32_t index,
+                                              avs_time_real_t timestamp) {
+    AVS_LIST(anjay_uri_path_t) paths = NULL;
+    const size_t count =
+            1 + notify_queue_test_random(NOTIFY_QUEUE_TEST_MAX_PATHS);
+    for (size_t i = 0; i < count; ++i) {
+        AVS_LIST(anjay_uri_path_t) path =
+                AVS_LIST_NEW_ELEMENT(anjay_uri_path_t);
+        AVS_UNIT_ASSERT_NOT_NULL(path);
+        *path = notify_queue_test_random_path();
+        AVS_LIST_APPEND(&paths, path);
+    }
+    avs_coap_token_t token = {
+        .size = sizeof(index)
+    };
+    memcpy(token.bytes, &index, sizeof(index));
+    const paths_arg_t paths_arg = {
+        .type = PATHS_POINTER_LIST,
+        .paths = paths,
+        .count = count
+    };
+    AVS_RBTREE_ELEM(anjay_observation_t) observation =
+            create_detached_observation(&token, ANJAY_ACTION_READ, &paths_arg);
+    AVS_UNIT_ASSERT_NOT_NULL(observation);
+    AVS_LIST_CLEAR(&paths);
+    AVS_UNIT_ASSERT_SUCCESS(
+            attach_new_observation(g_notify_queue_test.connection,
+                                   observation));
+
+    // only the timestamp matters for scheduling
+    const anjay_msg_details_t details = {
+        .msg_code = AVS_COAP_CODE_NOT_FOUND
+    };
+    observation->last_sent = create_observation_value(
+            &details, AVS_COAP_NOTIFY_PREFER_NON_CONFIRMABLE, observation,
+            &timestamp, NULL, NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(observation->last_sent);
+}
+
+static anjay_t *notify_queue_test_create(uint32_t seed) {
+    memset(&g_notify_queue_test, 0, sizeof(g_notify_queue_test));
+    g_notify_queue_test.random = seed;
+    const anjay_configuration_t config = {
+        .endpoint_name = "notify-queue-test"
+    };
+    anjay_t *anjay = anjay_new(&config);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+    for (size_t i = 0; i < NOTIFY_QUEUE_TEST_OIDS - 1; ++i) {
+        anjay_dm_object_def_t *def = &g_notify_queue_test.defs[i];
+        def->oid = (anjay_oid_t) (NOTIFY_QUEUE_TEST_OID_BASE + i);
+        def->handlers.list_instances = notify_queue_test_list_instances;
+        def->handlers.object_read_default_attrs =
+                notify_queue_test_object_attrs;
+        def->handlers.instance_read_default_attrs =
+                notify_queue_test_instance_attrs;
+        g_notify_queue_test.def_ptrs[i] = def;
+        AVS_UNIT_ASSERT_SUCCESS(
+                anjay_register_object(anjay, &g_notify_queue_test.def_ptrs[i]));
+    }
+
+    g_notify_queue_test.server.anjay = anjay;
+    g_notify_queue_test.server.ssid = NOTIFY_QUEUE_TEST_SSID;
+    const anjay_connection_ref_t ref = {
+        .server = &g_notify_queue_test.server,
+        .conn_type = ANJAY_CONNECTION_PRIMARY
+    };
+    AVS_LIST(anjay_observe_connection_entry_t) *conn_ptr =
+            find_or_create_connection_state(ref);
+    AVS_UNIT_ASSERT_NOT_NULL(conn_ptr);
+    g_notify_queue_test.connection = *conn_ptr;
+
+    g_notify_queue_test.created = avs_time_monotonic_now();
+    const avs_time_real_t timestamp = avs_time_real_now();
+    for (uint32_t i = 0; i < NOTIFY_QUEUE_TEST_OBSERVATIONS; ++i) {
+        notify_queue_test_add_observation(i, timestamp);
+    }
+    return anjay;
+}
+
+static void notify_queue_test_delete(anjay_t *anjay) {
+    AVS_LIST(anjay_observe_connection_entry_t) *conn_ptr =
+            _anjay_observe_find_connection_state(
+                    g_notify_queue_test.connection->conn_ref);
+    AVS_UNIT_ASSERT_NOT_NULL(conn_ptr);
+    delete_connection(conn_ptr);
+    anjay_delete(anjay);
+}
+
+static anjay_notify_queue_t notify_queue_test_random_queue(void) {
+    anjay_notify_queue_t queue = NULL;
+    const uint32_t changes = 1 + notify_queue_test_random(12);
+    for (uint32_t i = 0; i < changes; ++i) {
+        const anjay_oid_t oid =
+                (anjay_oid_t) (NOTIFY_QUEUE_TEST_OID_BASE
+                               + notify_queue_test_random(
+                                         NOTIFY_QUEUE_TEST_OIDS));
+        if (!notify_queue_test_random(8)) {
+            AVS_UNIT_ASSERT_SUCCESS(
+                    _anjay_notify_queue_instance_set_unknown_change(&queue,
+                                                                    oid));
+        } else {
+            AVS_UNIT_ASSERT_SUCCESS(_anjay_notify_queue_resource_change(
+                    &queue, oid,
+                    (anjay_iid_t) notify_queue_test_random(
+                            NOTIFY_QUEUE_TEST_IDS),
+                    (anjay_rid_t) notify_queue_test_random(
+                            NOTIFY_QUEUE_TEST_IDS)));
+        }
+    }
+    return queue;
+}
+
+static int notify_queue_test_expect(anjay_observe_connection_entry_t *conn,
+                                    anjay_observe_path_entry_t *path_entry,
+                                    void *arg) {
+    (void) arg;
+    const int32_t period =
+            AVS_MAX(get_oi_attributes(conn, path_entry).min_period, 0);
+    AVS_LIST(AVS_RBTREE_ELEM(anjay_observation_t)) ref;
+    AVS_LIST_FOREACH(ref, path_entry->refs) {
+        const size_t i = notify_queue_test_index(*ref);
+        ++g_notify_queue_test.expected_matches;
+        if (!g_notify_queue_test.expected_scheduled[i]
+                || period < g_notify_queue_test.expected_period[i]) {
+            g_notify_queue_test.expected_period[i] = period;
+        }
+        g_notify_queue_test.expected_scheduled[i] = true;
+    }
+    return 0;
+}
+
+// What calling _anjay_observe_notify() for each change would schedule
+static size_t notify_queue_test_expect_queue(anjay_notify_queue_t queue) {
+    g_notify_queue_test.expected_matches = 0;
+    memset(g_notify_queue_test.expected_scheduled, 0,
+           sizeof(g_notify_queue_test.expected_scheduled));
+    anjay_observe_connection_entry_t *conn = g_notify_queue_test.connection;
+    AVS_LIST(anjay_notify_queue_object_entry_t) it;
+    AVS_LIST_FOREACH(it, queue) {
+        if (it->instance_set_changes.instance_set_changed) {
+            AVS_UNIT_ASSERT_SUCCESS(observe_for_each_matching(
+                    conn, &MAKE_OBJECT_PATH(it->oid), notify_queue_test_expect,
+                    NULL));
+            continue;
+        }
+        AVS_LIST(anjay_notify_queue_resource_entry_t) change;
+        AVS_LIST_FOREACH(change, it->resources_changed) {
+            AVS_UNIT_ASSERT_SUCCESS(observe_for_each_matching(
+                    conn,
+                    &MAKE_RESOURCE_PATH(it->oid, change->iid, change->rid),
+                    notify_queue_test_expect, NULL));
+        }
+    }
+    size_t expected_count = 0;
+    for (size_t i = 0; i < NOTIFY_QUEUE_TEST_OBSERVATIONS; ++i) {
+        expected_count += g_notify_queue_test.expected_scheduled[i];
+    }
+    return expected_count;
+}
+
+AVS_UNIT_TEST(observe_notify_queue, matches_same_observations) {
+    for (uint32_t seed = 1; seed <= 4; ++seed) {
+        anjay_t *anjay = notify_queue_test_create(seed);
+        for (unsigned step = 0; step < 100; ++step) {
+            anjay_notify_queue_t queue = notify_queue_test_random_queue();
+            notify_queue_test_expect_queue(queue);
+
+            notify_batch_t batch = {
+                .generation = ++anjay->observe.notify_batch_generation
+            };
+            notify_queue_for_connection(g_notify_queue_test.connection, queue,
+                                        &batch);
+            AVS_UNIT_ASSERT_EQUAL(batch.matches,
+                                  g_notify_queue_test.expected_matches);
+            bool scheduled[NOTIFY_QUEUE_TEST_OBSERVATIONS] = { false };
+            while (batch.pending) {
+                anjay_observation_t *observation = batch.pending;
+                batch.pending = observation->notify_batch_next;
+                observation->notify_batch_next = NULL;
+                const size_t i = notify_queue_test_index(observation);
+                AVS_UNIT_ASSERT_FALSE(scheduled[i]);
+                scheduled[i] = true;
+                AVS_UNIT_ASSERT_TRUE(g_notify_queue_test.expected_scheduled[i]);
+                AVS_UNIT_ASSERT_EQUAL(observation->notify_batch_period,
+                                      g_notify_queue_test.expected_period[i]);
+            }
+            for (size_t i = 0; i < NOTIFY_QUEUE_TEST_OBSERVATIONS; ++i) {
+                AVS_UNIT_ASSERT_TRUE(scheduled[i]
+                                     == g_notify_queue_test
+                                                .expected_scheduled[i]);
+            }
+            _anjay_notify_clear_queue(&queue);
+        }
+        notify_queue_test_delete(anjay);
+    }
+}
+
+AVS_UNIT_TEST(observe_notify_queue, schedules_each_observation_once) {
+    anjay_t *anjay = notify_queue_test_create(11);
+    // every Resource of every Object, so that observations of overlapping
+    // paths are matched many times
+    anjay_notify_queue_t queue = NULL;
+    for (anjay_oid_t i = 0; i < NOTIFY_QUEUE_TEST_OIDS; ++i) {
+        for (anjay_iid_t iid = 0; iid < NOTIFY_QUEUE_TEST_IDS; ++iid) {
+            for (anjay_rid_t rid = 0; rid < NOTIFY_QUEUE_TEST_IDS; ++rid) {
+                AVS_UNIT_ASSERT_SUCCESS(_anjay_notify_queue_resource_change(
+                        &queue, (anjay_oid_t) (NOTIFY_QUEUE_TEST_OID_BASE + i),
+                        iid, rid));
+            }
+        }
+    }
+    const size_t expected_count = notify_queue_test_expect_queue(queue);
+    AVS_UNIT_ASSERT_TRUE(g_notify_queue_test.expected_matches
+                         > expected_count);
+
+    // changes made by the server itself are not notified to it
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_notify_queue(
+            anjay, queue, NOTIFY_QUEUE_TEST_SSID, true));
+    AVS_RBTREE_ELEM(anjay_observation_t) observation;
+    AVS_RBTREE_FOREACH(observation,
+                       g_notify_queue_test.connection->observations) {
+        AVS_UNIT_ASSERT_NULL(observation->notify_task);
+    }
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_num_coalesced_notify_triggers(anjay), 0);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_notify_queue(
+            anjay, queue, NOTIFY_QUEUE_TEST_SSID, false));
+    AVS_RBTREE_FOREACH(observation,
+                       g_notify_queue_test.connection->observations) {
+        const size_t i = notify_queue_test_index(observation);
+        if (!g_notify_queue_test.expected_scheduled[i]) {
+            AVS_UNIT_ASSERT_NULL(observation->notify_task);
+            continue;
+        }
+        AVS_UNIT_ASSERT_NOT_NULL(observation->notify_task);
+        // pmin after the last value, which was taken when the test started
+        int64_t delay_ms;
+        AVS_UNIT_ASSERT_SUCCESS(avs_time_duration_to_scalar(
+                &delay_ms, AVS_TIME_MS,
+                avs_time_monotonic_diff(
+                        avs_sched_time(&observation->notify_task),
+                        g_notify_queue_test.created)));
+        const int64_t expected_ms =
+                1000 * (int64_t) g_notify_queue_test.expected_period[i];
+        AVS_UNIT_ASSERT_TRUE(delay_ms > expected_ms - 1000);
+        AVS_UNIT_ASSERT_TRUE(delay_ms < expected_ms + 1000);
+    }
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_num_coalesced_notify_triggers(anjay),
+                          g_notify_queue_test.expected_matches
+                                  - expected_count);
+    _anjay_notify_clear_queue(&queue);
+    notify_queue_test_delete(anjay);
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_unit_test.h>
+
+static anjay_t *sample_buffer_test_create(void) {
+    const anjay_configuration_t config = {
+        .endpoint_name = "sample-buffer-test"
+    };
+    anjay_t *anjay = anjay_new(&config);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+    return anjay;
+}
+
+static avs_time_real_t sample_buffer_test_time(int64_t s) {
+    return avs_time_real_from_scalar(s, AVS_TIME_S);
+}
+
+// Adds a sample taken at @p s seconds, with the value equal to @p s
+static void sample_buffer_test_add(anjay_t *anjay,
+                                   anjay_uri_path_t path,
+                                   int64_t s) {
+    const anjay_sample_t sample = {
+        .timestamp = sample_buffer_test_time(s),
+        .type = ANJAY_SAMPLE_INT,
+        .value.int_value = s
+    };
+    AVS_UNIT_ASSERT_SUCCESS(add_unlocked(anjay, &path, &sample));
+}
+
+static const anjay_sample_buffer_t *
+sample_buffer_test_get(anjay_t *anjay, anjay_uri_path_t path) {
+    AVS_LIST(anjay_sample_buffer_t) *buffer_ptr =
+            find_buffer_ptr(anjay, &path);
+    AVS_UNIT_ASSERT_NOT_NULL(*buffer_ptr);
+    AVS_UNIT_ASSERT_TRUE(_anjay_uri_path_equal(&(*buffer_ptr)->path, &path));
+    return *buffer_ptr;
+}
+
+// Checks that the ring holds exactly the samples taken at @p first_s ..
+// @p last_s seconds, oldest first
+static void assert_samples(anjay_t *anjay,
+                           anjay_uri_path_t path,
+                           int64_t first_s,
+                           int64_t last_s) {
+    const anjay_sample_buffer_t *buffer = sample_buffer_test_get(anjay, path);
+    AVS_UNIT_ASSERT_EQUAL(buffer->count, (size_t) (last_s - first_s + 1));
+    for (size_t i = 0; i < buffer->count; ++i) {
+        const anjay_sample_t *sample =
+                &buffer->samples[(buffer->first + i) % buffer->capacity];
+        AVS_UNIT_ASSERT_EQUAL(sample->value.int_value, first_s + (int64_t) i);
+    }
+}
+
+static size_t sample_buffer_test_collect(anjay_t *anjay,
+                                         anjay_uri_path_t path,
+                                         anjay_ssid_t ssid,
+                                         int64_t since_s,
+                                         int64_t until_s) {
+    anjay_batch_builder_t *builder = _anjay_batch_builder_new();
+    AVS_UNIT_ASSERT_NOT_NULL(builder);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sample_buffers_collect(
+            anjay, &path, ssid, sample_buffer_test_time(since_s),
+            sample_buffer_test_time(until_s), builder));
+    size_t count = builder->entries_count;
+    _anjay_batch_builder_cleanup(&builder);
+    return count;
+}
+
+AVS_UNIT_TEST(sample_buffer, ring_overwrites_oldest_samples) {
+    anjay_t *anjay = sample_buffer_test_create();
+    const anjay_uri_path_t path = MAKE_RESOURCE_PATH(3303, 0, 5700);
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_enable(anjay, 3303, 0, 5700, 4));
+
+    sample_buffer_test_add(anjay, path, 1);
+    sample_buffer_test_add(anjay, path, 2);
+    assert_samples(anjay, path, 1, 2);
+    for (int64_t s = 3; s <= 11; ++s) {
+        sample_buffer_test_add(anjay, path, s);
+        assert_samples(anjay, path, s < 4 ? 1 : s - 3, s);
+    }
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(sample_buffer, enable_and_disable) {
+    anjay_t *anjay = sample_buffer_test_create();
+    const anjay_uri_path_t path = MAKE_RESOURCE_PATH(3303, 0, 5700);
+    const anjay_sample_t sample = {
+        .type = ANJAY_SAMPLE_DOUBLE,
+        .value.double_value = 1.0
+    };
+    AVS_UNIT_ASSERT_FAILED(add_unlocked(anjay, &path, &sample));
+
+    // buffers are kept sorted by path, whatever the order of enabling
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_enable(anjay, 3303, 1, 5700, 2));
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_enable(anjay, 3303, 0, 5700, 2));
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_enable(anjay, 3303, 0, 5601, 2));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(anjay->observe.sample_buffers), 3);
+    AVS_LIST(anjay_sample_buffer_t) buffer;
+    AVS_LIST_FOREACH(buffer, anjay->observe.sample_buffers) {
+        if (AVS_LIST_NEXT(buffer)) {
+            AVS_UNIT_ASSERT_TRUE(_anjay_uri_path_compare(
+                                         &buffer->path,
+                                         &AVS_LIST_NEXT(buffer)->path)
+                                 < 0);
+        }
+    }
+
+    // enabling again drops the samples and changes the capacity
+    sample_buffer_test_add(anjay, path, 1);
+    sample_buffer_test_add(anjay, path, 2);
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_enable(anjay, 3303, 0, 5700, 8));
+    AVS_UNIT_ASSERT_EQUAL(sample_buffer_test_get(anjay, path)->count, 0);
+    AVS_UNIT_ASSERT_EQUAL(sample_buffer_test_get(anjay, path)->capacity, 8);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(anjay->observe.sample_buffers), 3);
+
+    // zero capacity disables the buffer
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_enable(anjay, 3303, 0, 5700, 0));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(anjay->observe.sample_buffers), 2);
+    AVS_UNIT_ASSERT_FAILED(add_unlocked(anjay, &path, &sample));
+    AVS_UNIT_ASSERT_FAILED(
+            anjay_sample_buffer_add_int(anjay, 3303, 0, 5700, 1));
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_add_int(anjay, 3303, 0, 5601, 1));
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(sample_buffer, pending_by_path) {
+    anjay_t *anjay = sample_buffer_test_create();
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_enable(anjay, 3303, 0, 5700, 2));
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_enable(anjay, 3303, 1, 5700, 2));
+
+    const anjay_uri_path_t object = MAKE_OBJECT_PATH(3303);
+    AVS_UNIT_ASSERT_FALSE(_anjay_sample_buffers_pending(anjay, &object));
+
+    sample_buffer_test_add(anjay, MAKE_RESOURCE_PATH(3303, 1, 5700), 1);
+    const anjay_uri_path_t pending[] = {
+        MAKE_ROOT_PATH(), object, MAKE_INSTANCE_PATH(3303, 1),
+        MAKE_RESOURCE_PATH(3303, 1, 5700)
+    };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(pending); ++i) {
+        AVS_UNIT_ASSERT_TRUE(_anjay_sample_buffers_pending(anjay, &pending[i]));
+    }
+    const anjay_uri_path_t not_pending[] = {
+        MAKE_OBJECT_PATH(3304), MAKE_INSTANCE_PATH(3303, 0),
+        MAKE_RESOURCE_PATH(3303, 1, 5701),
+        MAKE_RESOURCE_INSTANCE_PATH(3303, 1, 5700, 0)
+    };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(not_pending); ++i) {
+        AVS_UNIT_ASSERT_FALSE(
+                _anjay_sample_buffers_pending(anjay, &not_pending[i]));
+    }
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(sample_buffer, collect_time_window) {
+    anjay_t *anjay = sample_buffer_test_create();
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_enable(anjay, 3303, 0, 5700, 4));
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_enable(anjay, 3303, 1, 5700, 4));
+    // samples of the Security object are never reported
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_sample_buffer_enable(anjay, 0, 0, 1, 4));
+    for (int64_t s = 1; s <= 6; ++s) {
+        sample_buffer_test_add(anjay, MAKE_RESOURCE_PATH(3303, 0, 5700), s);
+        sample_buffer_test_add(anjay, MAKE_RESOURCE_PATH(0, 0, 1), s);
+    }
+    sample_buffer_test_add(anjay, MAKE_RESOURCE_PATH(3303, 1, 5700), 4);
+
+    // /3303/0/5700 holds samples taken at 3..6 seconds
+    const anjay_uri_path_t resource = MAKE_RESOURCE_PATH(3303, 0, 5700);
+    AVS_UNIT_ASSERT_EQUAL(sample_buffer_test_collect(anjay, resource, 1, 0, 10),
+                          4);
+    // taken after "since", but not after "until"
+    AVS_UNIT_ASSERT_EQUAL(sample_buffer_test_collect(anjay, resource, 1, 3, 5),
+                          2);
+    AVS_UNIT_ASSERT_EQUAL(sample_buffer_test_collect(anjay, resource, 1, 6, 10),
+                          0);
+    AVS_UNIT_ASSERT_EQUAL(sample_buffer_test_collect(anjay, resource, 1, 0, 2),
+                          0);
+    // the same samples can be collected again, e.g. by another observation
+    AVS_UNIT_ASSERT_EQUAL(sample_buffer_test_collect(anjay, resource, 2, 0, 10),
+                          4);
+
+    const anjay_uri_path_t object = MAKE_OBJECT_PATH(3303);
+    AVS_UNIT_ASSERT_EQUAL(sample_buffer_test_collect(anjay, object, 1, 0, 10),
+                          5);
+    const anjay_uri_path_t instance = MAKE_INSTANCE_PATH(3303, 1);
+    AVS_UNIT_ASSERT_EQUAL(sample_buffer_test_collect(anjay, instance, 1, 3, 10),
+                          1);
+    const anjay_uri_path_t root = MAKE_ROOT_PATH();
+    AVS_UNIT_ASSERT_EQUAL(sample_buffer_test_collect(anjay, root,
+                                                     ANJAY_SSID_BOOTSTRAP, 0,
+                                                     10),
+                          5);
+    anjay_delete(anjay);
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2017-2021 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/avs_unit_test.h>
+
+/*
+ * Checks the cached Registration payload against one built from scratch, for
+ * a user-implemented Object whose Instances are listed from
+ * g_payload_test.instances.
+ */
+
+#define PAYLOAD_TEST_MAX_INSTANCES 6
+
+static struct {
+    bool instances[PAYLOAD_TEST_MAX_INSTANCES];
+    // notifications about changes of the Instance set not performed yet
+    bool changes_pending;
+    // whether the cache holds a payload that is still up to date
+    bool cache_valid;
+    uint32_t random;
+} g_payload_test;
+
+static uint32_t payload_test_random(uint32_t range) {
+    g_payload_test.random = g_payload_test.random * 1103515245u + 12345u;
+    return (g_payload_test.random >> 8) % range;
+}
+
+static int payload_test_list_instances(anjay_t *anjay,
+                                       const anjay_dm_object_def_t *const *obj,
+                                       anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj;
+    for (size_t i = 0; i < PAYLOAD_TEST_MAX_INSTANCES; ++i) {
+        if (g_payload_test.instances[i]) {
+            anjay_dm_emit(ctx, (anjay_iid_t) i);
+        }
+    }
+    return 0;
+}
+
+static const anjay_dm_object_def_t PAYLOAD_TEST_OBJECT = {
+    .oid = 1000,
+    .handlers = {
+        .list_instances = payload_test_list_instances
+    }
+};
+static const anjay_dm_object_def_t *const PAYLOAD_TEST_OBJECT_PTR =
+        &PAYLOAD_TEST_OBJECT;
+
+static int
+payload_test_list_no_instances(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *obj,
+                               anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj;
+    (void) ctx;
+    return 0;
+}
+
+static const anjay_dm_object_def_t PAYLOAD_TEST_OTHER_OBJECT = {
+    .oid = 1001,
+    .version = "1.2",
+    .handlers = {
+        .list_instances = payload_test_list_no_instances
+    }
+};
+static const anjay_dm_object_def_t *const PAYLOAD_TEST_OTHER_OBJECT_PTR =
+        &PAYLOAD_TEST_OTHER_OBJECT;
+
+static anjay_t *payload_test_create(void) {
+    memset(&g_payload_test, 0, sizeof(g_payload_test));
+    const anjay_configuration_t config = {
+        .endpoint_name = "registration-payload-test"
+    };
+    anjay_t *anjay = anjay_new(&config);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_register_object(anjay, &PAYLOAD_TEST_OBJECT_PTR));
+    g_payload_test.changes_pending = true;
+    return anjay;
+}
+
+// Gets the payload as Register or Update would, and checks that it is exactly
+// what query_dm() returns, and that it has been taken from the cache if and
+// only if nothing changed since it was built
+static void payload_test_check(anjay_t *anjay) {
+    const uint64_t hits = anjay->registration_payload_cache.hits;
+    const anjay_registration_payload_t *cached =
+            anjay->registration_payload_cache.payload;
+    anjay_registration_payload_t *payload = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            get_registration_payload(anjay, ANJAY_LWM2M_VERSION_1_0, &payload));
+
+    const bool expect_hit =
+            !g_payload_test.changes_pending && g_payload_test.cache_valid;
+    AVS_UNIT_ASSERT_EQUAL(anjay->registration_payload_cache.hits,
+                          hits + expect_hit);
+    if (expect_hit) {
+        AVS_UNIT_ASSERT_TRUE(payload == cached);
+    }
+    g_payload_test.cache_valid = true;
+
+    anjay_registration_payload_t *expected = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            query_dm(anjay, ANJAY_LWM2M_VERSION_1_0, &expected));
+    AVS_UNIT_ASSERT_EQUAL(payload->size, expected->size);
+    AVS_UNIT_ASSERT_EQUAL_STRING(payload->data, expected->data);
+    registration_payload_unref(&expected);
+    registration_payload_unref(&payload);
+}
+
+static void payload_test_flush(anjay_t *anjay) {
+    anjay_sched_run(anjay);
+    if (g_payload_test.changes_pending) {
+        g_payload_test.changes_pending = false;
+        g_payload_test.cache_valid = false;
+    }
+}
+
+AVS_UNIT_TEST(registration_payload, matches_data_model) {
+    anjay_t *anjay = payload_test_create();
+    g_payload_test.random = 5;
+    payload_test_check(anjay);
+    for (unsigned step = 0; step < 400; ++step) {
+        switch (payload_test_random(5)) {
+        case 0: {
+            // Instance created or deleted
+            const uint32_t iid =
+                    payload_test_random(PAYLOAD_TEST_MAX_INSTANCES);
+            g_payload_test.instances[iid] = !g_payload_test.instances[iid];
+            AVS_UNIT_ASSERT_SUCCESS(anjay_notify_instances_changed(
+                    anjay, PAYLOAD_TEST_OBJECT.oid));
+            g_payload_test.changes_pending = true;
+            break;
+        }
+        case 1:
+            // a Resource value change does not affect the payload
+            AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(
+                    anjay, PAYLOAD_TEST_OBJECT.oid, 0, 1));
+            break;
+        case 2:
+            payload_test_flush(anjay);
+            break;
+        default:
+            break;
+        }
+        payload_test_check(anjay);
+    }
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(registration_payload, object_registration) {
+    anjay_t *anjay = payload_test_create();
+    g_payload_test.instances[2] = true;
+    payload_test_flush(anjay);
+    payload_test_check(anjay);
+    payload_test_check(anjay);
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_register_object(anjay, &PAYLOAD_TEST_OTHER_OBJECT_PTR));
+    g_payload_test.changes_pending = true;
+    payload_test_check(anjay);
+    payload_test_flush(anjay);
+    payload_test_check(anjay);
+    AVS_UNIT_ASSERT_NOT_NULL(
+            strstr(anjay->registration_payload_cache.payload->data,
+                   "</1000/2>,</1001>;ver=\"1.2\""));
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_unregister_object(anjay, &PAYLOAD_TEST_OTHER_OBJECT_PTR));
+    // unregistering invalidates the payload right away
+    g_payload_test.cache_valid = false;
+    payload_test_check(anjay);
+    AVS_UNIT_ASSERT_NULL(
+            strstr(anjay->registration_payload_cache.payload->data, "1001"));
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(registration_payload, shared_with_server_state) {
+    anjay_t *anjay = payload_test_create();
+    payload_test_flush(anjay);
+    anjay_registration_payload_t *first = NULL;
+    anjay_registration_payload_t *second = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            get_registration_payload(anjay, ANJAY_LWM2M_VERSION_1_0, &first));
+    AVS_UNIT_ASSERT_SUCCESS(
+            get_registration_payload(anjay, ANJAY_LWM2M_VERSION_1_0, &second));
+    AVS_UNIT_ASSERT_TRUE(first == second);
+    AVS_UNIT_ASSERT_EQUAL(first->refcount, 3);
+    AVS_UNIT_ASSERT_TRUE(dm_caches_equal(first, second));
+
+    // references held e.g. by last_update_params outlive the cache entry
+    _anjay_registration_payload_cache_invalidate(anjay);
+    AVS_UNIT_ASSERT_EQUAL(first->refcount, 2);
+    anjay_registration_payload_t *rebuilt = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(get_registration_payload(
+            anjay, ANJAY_LWM2M_VERSION_1_0, &rebuilt));
+    AVS_UNIT_ASSERT_TRUE(rebuilt != first);
+    AVS_UNIT_ASSERT_TRUE(dm_caches_equal(first, rebuilt));
+
+    registration_payload_unref(&first);
+    registration_payload_unref(&second);
+    registration_payload_unref(&rebuilt);
+    anjay_delete(anjay);
+}
@@ -33,6 +33,13 @@ partialsfb=$userAppBinary"/Partial"$execname".sfb"
 partialsfu=$userAppBinary"/Partial"$execname".sfu"
 partialsign=$userAppBinary"/Partial"$execname".sign"
 partialoffset=$userAppBinary"/Partial"$execname".offset"
+compressedbin=$userAppBinary"/Compressed"$execname".bin"
+compressedsfb=$userAppBinary"/Compressed"$execname".sfb"
+compressedsfu=$userAppBinary"/Compressed"$execname".sfu"
+deltabin=$userAppBinary"/Delta"$execname".bin"
+deltasfb=$userAppBinary"/Delta"$execname".sfb"
+deltasfu=$userAppBinary"/Delta"$execname".sfu"
+deltasign=$userAppBinary"/Delta"$execname".sign"
 ref_userapp=$projectdir"/RefUserApp.bin"
 offset=512
 alignment=16
@@ -113,6 +120,47 @@ if [ $ret -eq 0 ]; then
               fi
             fi
           fi
+          #Compressed image generation (compress command is only available with the python script)
+          if [ $ret -eq 0 ] && [ "$cmd" = "python" ]; then
+            echo "Generating the compressed image .sfb"
+            echo "Generating the compressed image .sfb" >> $projectdir"/output.txt"
+            command=$cmd" "$prepareimage" compress -a "$alignment" "$bin" "$compressedbin
+            $command >> $projectdir"/output.txt"
+            ret=$?
+            if [ $ret -eq 0 ]; then
+              command=$cmd" "$prepareimage" enc -k "$oemkey" -i "$iv" "$compressedbin" "$compressedsfu
+              $command >> $projectdir"/output.txt"
+              ret=$?
+              if [ $ret -eq 0 ]; then
+                command=$cmd" "$prepareimage" pack -m "$magic" -k "$ecckey" -r 28 -v "$version" -i "$iv" -f "$sfu" -t "$sign" -o "$offset" --cfw "$compressedsfu" "$compressedsfb
+                $command >> $projectdir"/output.txt"
+                ret=$?
+              fi
+            fi
+          fi
+          #Delta image generation if reference userapp exists (delta command is only available with the python script)
+          if [ $ret -eq 0 ] && [ -e "$ref_userapp" ] && [ "$cmd" = "python" ]; then
+            echo "Generating the delta image .sfb"
+            echo "Generating the delta image .sfb" >> $projectdir"/output.txt"
+            command=$cmd" "$prepareimage" delta -r "$ref_userapp" -o "$offset" -a "$alignment" "$bin" "$deltabin
+            $command >> $projectdir"/output.txt"
+            ret=$?
+            if [ $ret -eq 0 ]; then
+              command=$cmd" "$prepareimage" enc -k "$oemkey" -i "$iv" "$deltabin" "$deltasfu
+              $command >> $projectdir"/output.txt"
+              ret=$?
+              if [ $ret -eq 0 ]; then
+                command=$cmd" "$prepareimage" sha256 "$deltabin" "$deltasign
+                $command >> $projectdir"/output.txt"
+                ret=$?
+                if [ $ret -eq 0 ]; then
+                  command=$cmd" "$prepareimage" pack -m "$magic" -k "$ecckey" -r 28 -v "$version" -i "$iv" -f "$sfu" -t "$sign" -o "$offset" --dfw "$deltasfu" --dtag "$deltasign" "$deltasfb
+                  $command >> $projectdir"/output.txt"
+                  ret=$?
+                fi
+              fi
+            fi
+          fi
         if [ $ret -eq 0 ] && [ $# = 6 ]; then
           echo "Generating the global elf file SBSFU and userApp"
           echo "Generating the global elf file SBSFU and userApp" >> $projectdir"/output.txt"
@@ -149,6 +197,15 @@ if [ $ret -eq 0 ]; then
     rm $partialsign
     rm $partialoffset
   fi
+  if [ -e "$compressedsfu" ]; then
+    rm $compressedbin
+    rm $compressedsfu
+  fi
+  if [ -e "$deltasfu" ]; then
+    rm $deltabin
+    rm $deltasfu
+    rm $deltasign
+  fi
   exit 0
 else
   echo "$command : failed" >> $projectdir"/output.txt"
@@ -54,6 +54,19 @@
 /* Support for the LwM2M Information Reporting interface */
 #define ANJAY_WITH_OBSERVE
 
+/* Re-read only Resources reported as changed through anjay_notify_changed()
+ * when preparing notifications for Object and Object Instance observations,
+ * sharing the remaining data with the previously read value. Only applies to
+ * Objects declared with anjay_observe_incremental_read_enable() to report
+ * every change. All data is still re-read when pmax expires, or when a
+ * notification is triggered by anything other than a reported Resource
+ * change. */
+#define ANJAY_WITH_OBSERVE_INCREMENTAL_READ
+
+/* Per-Resource rings of timestamped samples, reported as additional SenML
+ * records in notifications; see anjay_sample_buffer_enable(). */
+#define ANJAY_WITH_OBSERVE_SAMPLE_BUFFER
+
 /* Enable attr_storage module */
 #define ANJAY_WITH_MODULE_ATTR_STORAGE
 
@@ -61,7 +74,7 @@
 #define ANJAY_COMPAT_TIME
 
 /* Enable support for CBOR and SenML CBOR formats, as specified in LwM2M TS 1.1 */
-/* #undef ANJAY_WITH_CBOR */
+#define ANJAY_WITH_CBOR
 
 /* Enable access_control module */
 #define ANJAY_WITH_MODULE_ACCESS_CONTROL
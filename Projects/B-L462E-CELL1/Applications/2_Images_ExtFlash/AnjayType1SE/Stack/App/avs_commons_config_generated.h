@@ -351,6 +351,21 @@
  */
 #define AVS_COMMONS_LOG_USE_GLOBAL_BUFFER
 
+/**
+ * Size, in bytes, of the ring buffer used by the deferred logging mode.
+ *
+ * If defined, avs_log does not format messages in the thread that logs them.
+ * Instead, the format string pointer and the binary values of the arguments
+ * are recorded in a lock-free ring buffer of this size, and formatted later by
+ * <c>avs_log_deferred_flush()</c>, which the application is expected to call
+ * periodically from a low-priority thread. Messages logged while the buffer is
+ * full are dropped and counted.
+ *
+ * If editing this file manually, <c>4096</c> shall be replaced with a power of
+ * two, large enough to hold at least a few dozen messages.
+ */
+#define AVS_COMMONS_LOG_DEFERRED_BUFFER_SIZE 4096
+
 /**
  * Provides a default avs_log handler that prints log messages on stderr.
  *
@@ -437,8 +452,12 @@
  * with a high degree of compatibility with standard BSD sockets with an
  * appropriate compatibility header (see @ref AVS_COMMONS_POSIX_COMPAT_HEADER) -
  * lwIP and Winsock are currently supported for this scenario.
+ *
+ * Disabled: the TCP and UDP sockets are implemented on top of the
+ * X-CUBE-CELLULAR com_sockets API instead, see
+ * Anjay/client/Src/compat/net/avs_com_sockets.c.
  */
-#define AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET
+/* #undef AVS_COMMONS_NET_WITH_POSIX_AVS_SOCKET */
 
 /**
  * If the TLS backend is either mbed TLS or OpenSSL, enables support of
@@ -552,6 +571,16 @@
  */
 /* #undef AVS_COMMONS_SCHED_THREAD_SAFE */
 
+/**
+ * Store avs_sched jobs in a binary min-heap instead of a sorted linked list.
+ *
+ * With this flag enabled, scheduling, rescheduling and cancelling a job take
+ * O(log n) time instead of O(n), at the cost of a single additional, growable
+ * array of job pointers per scheduler. Jobs scheduled for the same instant are
+ * still executed in the order in which they were scheduled.
+ */
+#define AVS_COMMONS_SCHED_WITH_HEAP
+
 /**
  * Enable support for file I/O in avs_stream.
  *
@@ -591,8 +620,13 @@
  *
  * You might disable this option if for any reason you need to use a custom
  * allocator.
+ *
+ * Disabled in this application in favor of the size-class pool allocator in
+ * client/Src/compat/memory/avs_pool_allocator.c, which keeps small, frequently
+ * reallocated objects out of the heap. See avs_pool_allocator.h for the
+ * configuration of size classes.
  */
-#define AVS_COMMONS_UTILS_WITH_STANDARD_ALLOCATOR
+/* #undef AVS_COMMONS_UTILS_WITH_STANDARD_ALLOCATOR */
 /**@}*/
 
 #endif /* AVS_COMMONS_CONFIG_GENERATED_H */